@@ -97,6 +97,12 @@ static const char USAGE[] = "\n"
 "        Results in <metric>_report.csv\n"
 " -s, --image-stats\n"
 "        Output stats for each input and output image.\n"
+" -t, --threads <n>\n"
+"        Number of codec threads used for each j2c decode, regardless of image size.\n"
+"        Default is 0 (single threaded).\n"
+" -bench, --benchmark <n>\n"
+"        Decode each j2c input <n> times, honoring -d and -r, and print decode timings\n"
+"        instead of converting. Output files and filters are ignored.\n"
 "\n";
 
 // true when all image loading is done. Used by metric logging thread to know when to stop the thread.
@@ -192,6 +198,44 @@ LLPointer<LLImageRaw> load_image(const std::string &src_filename, int discard_le
     return raw_image;
 }
 
+// Decode an in-memory j2c image repeatedly, returning the total decode time in seconds
+// and accumulating the number of pixels produced. Returns a negative time on failure.
+F64 benchmark_image(const std::string &src_filename, int discard_level, int* region, int iterations, S64 &pixels)
+{
+    LLPointer<LLImageFormatted> image = create_image(src_filename);
+    if (image.isNull() || (image->getCodec() != IMG_CODEC_J2C) || !image->load(src_filename))
+    {
+        return -1.0;
+    }
+
+    LLImageJ2C* j2c = (LLImageJ2C*)(image.get());
+    F64 total = 0.0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        LLPointer<LLImageRaw> raw_image = new LLImageRaw;
+        if ((discard_level != -1) || (region != NULL))
+        {
+            j2c->initDecode(*raw_image, discard_level, region);
+        }
+
+        LLTimer timer;
+        if (!j2c->decode(raw_image, 0.0f) || !raw_image->getData())
+        {
+            return -1.0;
+        }
+        total += timer.getElapsedTimeF64();
+        pixels += (S64)raw_image->getWidth() * raw_image->getHeight();
+
+        if (i == 0)
+        {
+            std::cout << src_filename << " : " << (int)image->getWidth() << "x" << (int)image->getHeight()
+                      << " -> " << (int)raw_image->getWidth() << "x" << (int)raw_image->getHeight();
+        }
+    }
+    std::cout << ", " << (total * 1000.0 / iterations) << " ms/decode" << std::endl;
+    return total;
+}
+
 // Save a raw image instance into a file
 bool save_image(const std::string &dest_filename, LLPointer<LLImageRaw> raw_image, int blocks_size, int precincts_size, int levels, bool reversible, bool output_stats)
 {
@@ -356,6 +400,8 @@ int main(int argc, char** argv)
     int blocks_size = -1;
     int levels = 0;
     bool reversible = false;
+    int codec_threads = 0;
+    int benchmark = 0;
     std::string filter_name = "";
 
     // Init whatever is necessary
@@ -557,6 +603,38 @@ int main(int argc, char** argv)
         {
             image_stats = true;
         }
+        else if (!strcmp(argv[arg], "--threads") || !strcmp(argv[arg], "-t"))
+        {
+            std::string value_str;
+            if ((arg + 1) < argc)
+            {
+                value_str = argv[arg+1];
+            }
+            if (((arg + 1) >= argc) || (value_str[0] == '-'))
+            {
+                std::cout << "No valid --threads argument given, decodes will be single threaded" << std::endl;
+            }
+            else
+            {
+                codec_threads = atoi(value_str.c_str());
+            }
+        }
+        else if (!strcmp(argv[arg], "--benchmark") || !strcmp(argv[arg], "-bench"))
+        {
+            std::string value_str;
+            if ((arg + 1) < argc)
+            {
+                value_str = argv[arg+1];
+            }
+            if (((arg + 1) >= argc) || (value_str[0] == '-'))
+            {
+                std::cout << "No valid --benchmark argument given, benchmark ignored" << std::endl;
+            }
+            else
+            {
+                benchmark = llmax(atoi(value_str.c_str()), 1);
+            }
+        }
     }
 
     // Check arguments consistency. Exit with proper message if inconsistent.
@@ -572,6 +650,37 @@ int main(int argc, char** argv)
     }
 
 
+    // Threads apply to every image here, small ones included
+    LLImageJ2C::setDecodeThreads(codec_threads, 0);
+
+    if (benchmark)
+    {
+        std::cout << "Benchmarking " << input_filenames.size() << " images, " << benchmark
+                  << " decodes each, " << codec_threads << " codec threads" << std::endl;
+        S64 pixels = 0;
+        F64 seconds = 0.0;
+        int decoded = 0;
+        for (const std::string& file_name : input_filenames)
+        {
+            F64 time = benchmark_image(file_name, discard_level, region, benchmark, pixels);
+            if (time < 0.0)
+            {
+                std::cout << "Error: Image " << file_name << " could not be decoded" << std::endl;
+                continue;
+            }
+            seconds += time;
+            ++decoded;
+        }
+        if (decoded && seconds > 0.0)
+        {
+            std::cout << "Decoded " << decoded << " images in " << seconds << " s, "
+                      << (seconds * 1000.0 / (decoded * benchmark)) << " ms/decode, "
+                      << (pixels / seconds / 1000000.0) << " Mpixels/s" << std::endl;
+        }
+        SUBSYSTEM_CLEANUP(LLImage);
+        return 0;
+    }
+
     // Create the logging thread if required
     if (LLFastTimer::sMetricLog)
     {
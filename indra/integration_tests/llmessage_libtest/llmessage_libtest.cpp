@@ -0,0 +1,150 @@
+/**
+ * @file llmessage_libtest.cpp
+ * @brief Replays a message capture through the message system
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llapr.h"
+#include "llfile.h"
+#include "llmessagereplay.h"
+#include "llsdserialize.h"
+#include "message.h"
+
+#include <iostream>
+
+static const char USAGE[] = "\n"
+"usage:\tllmessage_libtest [options] <capture file>\n"
+"\n"
+"Replays a capture written by the viewer's --capture option (or the\n"
+"MessageCaptureFile setting) through the message system with no network:\n"
+"inbound lludp packets are decoded by checkMessages() and event queue\n"
+"responses are dispatched as the viewer would.  Reports the number of\n"
+"messages decoded and how long it took.\n"
+"\n"
+"Options:\n"
+" -t, --template <file>     message_template.msg to decode with.\n"
+"                           Default:  ../scripts/messages/message_template.msg\n"
+" -w, --wall-clock          Follow the captured timing instead of replaying\n"
+"                           as fast as possible\n"
+" -o, --output <file>       LLSD XML of the replay statistics\n"
+" -h, --help                This help\n";
+
+// Never bound to the network in replay mode, but the message system wants one
+static const U32 REPLAY_PORT = 13050;
+
+int main(int argc, char** argv)
+{
+    std::string capture_file;
+    std::string template_file("../scripts/messages/message_template.msg");
+    std::string output_file;
+    LLMessageReplay::EPace pace(LLMessageReplay::PACE_MAX_SPEED);
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const std::string name(argv[arg]);
+        const bool has_value = arg + 1 < argc;
+        if (name == "-h" || name == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if ((name == "-t" || name == "--template") && has_value)
+        {
+            template_file = argv[++arg];
+        }
+        else if (name == "-w" || name == "--wall-clock")
+        {
+            pace = LLMessageReplay::PACE_WALL_CLOCK;
+        }
+        else if ((name == "-o" || name == "--output") && has_value)
+        {
+            output_file = argv[++arg];
+        }
+        else if (name[0] != '-' && capture_file.empty())
+        {
+            capture_file = name;
+        }
+        else
+        {
+            capture_file.clear();
+            break;
+        }
+    }
+
+    if (capture_file.empty())
+    {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+    ll_init_apr();
+
+    if (!start_messaging_system(template_file, REPLAY_PORT,
+                                1, 0, 0,
+                                FALSE,
+                                std::string(),
+                                NULL,
+                                false,
+                                5.f,
+                                100.f))
+    {
+        std::cerr << "Couldn't start the message system with '" << template_file << "'" << std::endl;
+        return 1;
+    }
+
+    LLSD stats;
+    {
+        LLMessageReplay replay(gMessageSystem, pace);
+        if (!replay.load(capture_file))
+        {
+            std::cerr << "Couldn't read '" << capture_file << "'" << std::endl;
+            end_messaging_system();
+            return 1;
+        }
+        replay.run();
+        stats = replay.getStats();
+    }
+
+    std::cout << "records:        " << stats["records"].asInteger() << "\n"
+              << "packets:        " << stats["packets"].asInteger() << "\n"
+              << "messages:       " << stats["messages"].asInteger() << "\n"
+              << "events:         " << stats["events"].asInteger() << "\n"
+              << "http responses: " << stats["http_responses"].asInteger() << "\n"
+              << "skipped:        " << stats["skipped"].asInteger() << "\n"
+              << "seconds:        " << stats["seconds"].asReal() << "\n"
+              << "messages/s:     " << stats["messages_per_second"].asReal() << std::endl;
+
+    if (!output_file.empty())
+    {
+        llofstream out(output_file.c_str());
+        if (!out.is_open())
+        {
+            std::cerr << "Couldn't write '" << output_file << "'" << std::endl;
+            end_messaging_system();
+            return 1;
+        }
+        LLSDSerialize::toPrettyXML(stats, out);
+    }
+
+    end_messaging_system();
+    return 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file llmodelimport_libtest.cpp
+ * @brief Times each phase of importing models for upload
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llapr.h"
+#include "lldaeloader.h"
+#include "lljoint.h"
+#include "llmeshoptimizer.h"
+#include "lltimer.h"
+
+#include <fstream>
+#include <iostream>
+
+static const char USAGE[] = "\n"
+"usage:\tllmodelimport_libtest [options] <file.dae>...\n"
+"\n"
+"Imports each COLLADA file the way the model uploader does, then\n"
+"simplifies every model to the medium, low and lowest LODs, and reports\n"
+"the time each phase took along with the model and triangle counts.\n"
+"\n"
+"Options:\n"
+" -t, --threads <n>         Import threads, 1 does everything on the\n"
+"                           loading thread.  Default:  4\n"
+" -o, --output <file>       Per phase CSV of the results\n"
+" -h, --help                This help\n";
+
+namespace
+{
+    struct ImportResult
+    {
+        std::string mFile;
+        bool mLoaded = false;
+        S32 mModels = 0;
+        S32 mTriangles = 0;
+        S32 mLODTriangles = 0;
+        LLModelLoader::phase_times_t mPhases;
+    };
+
+    void state_changed(U32 state, void* userdata)
+    {
+        *(U32*)userdata = state;
+    }
+
+    // Same decimation as LLModelPreview::genMeshOptimizerLODs() with its
+    // default of 3, per face to keep this independent of the preview
+    S32 generate_lods(const LLModelLoader::model_list& models)
+    {
+        std::vector<S32> triangles(models.size(), 0);
+        LLModelLoader::forEachParallel(models.size(), [&](size_t i)
+            {
+                const LLModel* model = models[i];
+                std::vector<U16> output;
+                for (S32 lod = LLModel::LOD_MEDIUM; lod >= LLModel::LOD_IMPOSTOR; --lod)
+                {
+                    const F32 decimator = pow(3.f, (F32)(LLModel::LOD_HIGH - lod));
+                    for (S32 face_idx = 0; face_idx < model->getNumVolumeFaces(); ++face_idx)
+                    {
+                        const LLVolumeFace& face = model->getVolumeFace(face_idx);
+                        if (face.mNumIndices < 3)
+                        {
+                            continue;
+                        }
+                        output.resize(face.mNumIndices);
+                        const S32 target = llclamp(llfloor(face.mNumIndices / decimator), 3, face.mNumIndices);
+                        const U64 count = LLMeshOptimizer::simplify(output.data(), face.mIndices, face.mNumIndices,
+                                                                    face.mPositions, face.mNumVertices, sizeof(LLVector4a),
+                                                                    target, 1.f, false, NULL);
+                        triangles[i] += (S32)(count / 3);
+                    }
+                }
+            });
+
+        S32 total(0);
+        for (S32 count : triangles)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+    ImportResult import_file(const std::string& filename)
+    {
+        ImportResult result;
+        result.mFile = filename;
+
+        JointTransformMap joint_transforms;
+        JointNameSet joints_from_nodes;
+        JointMap joint_aliases;
+        U32 state(LLModelLoader::STARTING);
+
+        LLDAELoader loader(filename, LLModel::LOD_HIGH,
+                           [](LLModelLoader::scene&, LLModelLoader::model_list&, S32, void*) {},
+                           [](const std::string&, void*) -> LLJoint* { return NULL; },
+                           [](LLImportMaterial&, void*) -> U32 { return 0; },
+                           state_changed, &state,
+                           joint_transforms, joints_from_nodes, joint_aliases,
+                           LL_MAX_JOINTS_PER_MESH_OBJECT, 1024, true);
+
+        result.mLoaded = loader.doLoadModel() && state < LLModelLoader::ERROR_PARSING;
+        result.mPhases = loader.getPhaseTimes();
+        if (!result.mLoaded)
+        {
+            return result;
+        }
+
+        result.mModels = (S32)loader.mModelList.size();
+        for (const LLPointer<LLModel>& model : loader.mModelList)
+        {
+            result.mTriangles += model->getNumTriangles();
+        }
+
+        LLTimer timer;
+        result.mLODTriangles = generate_lods(loader.mModelList);
+        result.mPhases.emplace_back("lods", timer.getElapsedTimeF64().value());
+        return result;
+    }
+
+    void report(std::ostream& out, const ImportResult& result)
+    {
+        out << result.mFile << ":  ";
+        if (!result.mLoaded)
+        {
+            out << "failed to load" << std::endl;
+            return;
+        }
+        out << result.mModels << " models, " << result.mTriangles << " triangles, "
+            << result.mLODTriangles << " in generated LODs" << std::endl;
+
+        F64 total(0.0);
+        for (const auto& phase : result.mPhases)
+        {
+            out << llformat("  %-12s %10.1f ms", phase.first.c_str(), phase.second * 1000.0) << std::endl;
+            total += phase.second;
+        }
+        out << llformat("  %-12s %10.1f ms", "total", total * 1000.0) << std::endl;
+    }
+
+    bool write_csv(const std::string& filename, const std::vector<ImportResult>& results, S32 threads)
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            return false;
+        }
+        out << "file,threads,models,triangles,lod_triangles,phase,ms" << std::endl;
+        for (const ImportResult& result : results)
+        {
+            for (const auto& phase : result.mPhases)
+            {
+                out << result.mFile << "," << threads << "," << result.mModels << "," << result.mTriangles << ","
+                    << result.mLODTriangles << "," << phase.first << "," << phase.second * 1000.0 << std::endl;
+            }
+        }
+        return true;
+    }
+}
+
+static bool parse_count(const char* arg, S32 min_value, S32 max_value, S32& value)
+{
+    char* end(nullptr);
+    const long parsed = strtol(arg, &end, 10);
+    if (*end != '\0' || parsed < min_value || parsed > max_value)
+    {
+        return false;
+    }
+    value = (S32)parsed;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> files;
+    std::string csv_file;
+    S32 threads(4);
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const std::string name(argv[arg]);
+        const bool has_value = arg + 1 < argc;
+        if (name == "-h" || name == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if ((name == "-t" || name == "--threads") && has_value)
+        {
+            if (!parse_count(argv[++arg], 1, 64, threads))
+            {
+                files.clear();
+                break;
+            }
+        }
+        else if ((name == "-o" || name == "--output") && has_value)
+        {
+            csv_file = argv[++arg];
+        }
+        else if (name[0] != '-')
+        {
+            files.push_back(name);
+            continue;
+        }
+        else
+        {
+            files.clear();
+            break;
+        }
+    }
+
+    if (files.empty())
+    {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+    ll_init_apr();
+    if (threads > 1)
+    {
+        LLModelLoader::startImportThreads(threads);
+    }
+
+    std::vector<ImportResult> results;
+    bool all_loaded(true);
+    for (const std::string& file : files)
+    {
+        results.push_back(import_file(file));
+        report(std::cout, results.back());
+        all_loaded = all_loaded && results.back().mLoaded;
+    }
+
+    LLModelLoader::stopImportThreads();
+    ll_cleanup_apr();
+
+    if (!csv_file.empty() && !write_csv(csv_file, results, threads))
+    {
+        std::cerr << "Couldn't write '" << csv_file << "'" << std::endl;
+        return 1;
+    }
+    return all_loaded ? 0 : 1;
+}
@@ -0,0 +1,684 @@
+/**
+ * @file lltexturefetch_libtest.cpp
+ * @brief Replays a texture request trace through LLTextureFetch
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltexturefetch_libtest.h"
+
+#include "llcommon.h"
+#include "lldir.h"
+#include "llimage.h"
+#include "llimageworker.h"
+#include "lllfsthread.h"
+#include "lltimer.h"
+#include "lltracerecording.h"
+
+#include "httpcommon.h"
+#include "httprequest.h"
+
+#include "lltexturecache.h"
+#include "lltexturefetch.h"
+#include "llviewercontrol.h"
+#include "llviewerstats.h"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const char USAGE[] = "\n"
+"usage:\tlltexturefetch_libtest [options] trace_file\n"
+"\n"
+"Replays a texture request trace through the viewer's LLTextureFetch,\n"
+"LLTextureCache and image decode thread, pointed at an HTTP texture\n"
+"service, and reports how long textures took to become visible.  Each\n"
+"texture is asked for the way the viewer does it: the lowest mip first,\n"
+"then the whole image once its size is known.  The texture cache lives\n"
+"in the cache directory so a second run measures a warm cache.\n"
+"\n"
+"The trace holds one request per line:  <ms> <uuid> <priority>\n"
+"meaning that <ms> milliseconds into the run the texture is wanted with\n"
+"that priority (0 drops it).  A line with just a uuid is wanted from the\n"
+"start with priority 1.  The viewer writes such traces when the\n"
+"TextureFetchTraceFile setting names a file.\n"
+"\n"
+"texture_server.py, next to this program's source, serves a directory\n"
+"of <uuid>.j2c files with the same range semantics as the grid.\n"
+"\n"
+"Options:\n"
+" -u, --url <format>        Texture URL, {id} (or %s) is replaced by the\n"
+"                           texture id and nothing else is interpreted.\n"
+"                           Default:  http://127.0.0.1:12046/texture?texture_id={id}\n"
+" -c, --connections <n>     HTTP connection limit.  Default:  8\n"
+" -p, --pipeline <depth>    HTTP pipelining depth, 0 for none.  Default:  0\n"
+" -2, --http2 <streams>     HTTP/2 streams per connection, 0 for none.  Default:  0\n"
+" -D, --decodes <n>         TextureFetchDecodeBudget.  Default:  32\n"
+" -C, --cache <dir>         Cache directory.  Default:  ./lltexturefetch_cache\n"
+" -M, --cache-size <MB>     TextureCacheSize.  Default:  1024\n"
+" -d, --decoded <MB>        TextureCacheDecodedSize, 0 for none.  Default:  0\n"
+" -S, --slabs               Turn on TextureCacheSlabStore\n"
+" -x, --clear-cache         Empty the texture cache first (cold run)\n"
+" -s, --speed <factor>      Replay the trace this many times faster.  Default:  1\n"
+" -t, --timeout <seconds>   Give up once nothing finished for this long after\n"
+"                           the end of the trace.  Default:  30\n"
+" -o, --output <file>       Per texture CSV of the timings\n"
+" -v, --verbose             Report progress while running\n"
+" -h, --help                This help\n";
+
+// Texture id token of --url
+static const std::string URL_ID_TOKEN("{id}");
+static const std::string URL_PRINTF_TOKEN("%s");
+
+namespace
+{
+    F64 to_ms(U64 usecs)
+    {
+        return (F64)usecs / 1000.0;
+    }
+
+    size_t count_tokens(const std::string& format, const std::string& token)
+    {
+        size_t count(0);
+        for (size_t at = format.find(token); at != std::string::npos; at = format.find(token, at + token.size()))
+        {
+            ++count;
+        }
+        return count;
+    }
+}
+
+FetchReplay::FetchReplay(const Options& options)
+    : mOptions(options),
+      mDecodeThread(nullptr),
+      mCache(nullptr),
+      mFetcher(nullptr),
+      mNextEvent(0),
+      mStartTime(0),
+      mEndTime(0),
+      mBytesOverWire(0.0),
+      mHttpRequests(0),
+      mCacheReads(0),
+      mCacheWrites(0),
+      mResourceWaits(0),
+      mCancels(0),
+      mTimedOut(false)
+{
+}
+
+//static
+bool FetchReplay::isValidUrlFormat(const std::string& format)
+{
+    return count_tokens(format, URL_ID_TOKEN) + count_tokens(format, URL_PRINTF_TOKEN) == 1;
+}
+
+//static
+std::string FetchReplay::makeUrl(const std::string& format, const std::string& id)
+{
+    std::string url(format);
+    size_t at = url.find(URL_ID_TOKEN);
+    if (at != std::string::npos)
+    {
+        return url.replace(at, URL_ID_TOKEN.size(), id);
+    }
+    at = url.find(URL_PRINTF_TOKEN);
+    if (at != std::string::npos)
+    {
+        return url.replace(at, URL_PRINTF_TOKEN.size(), id);
+    }
+    return url;
+}
+
+bool FetchReplay::loadTrace(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in)
+    {
+        std::cerr << "Couldn't open trace file '" << filename << "'" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#')
+        {
+            continue;
+        }
+
+        TraceEvent event;
+        if (LLUUID::validate(first))
+        {
+            event.mTime = 0;
+            event.mId.set(first);
+            event.mPriority = 1.f;
+        }
+        else
+        {
+            F64 ms = atof(first.c_str());
+            std::string id;
+            if (!(fields >> id >> event.mPriority) || !LLUUID::validate(id))
+            {
+                continue;
+            }
+            event.mId.set(id);
+            event.mTime = (U64)(llmax(ms, 0.0) * 1000.0 / mOptions.mSpeed);
+        }
+        mTrace.push_back(event);
+    }
+
+    // Stable, so same time events keep their recorded order
+    std::stable_sort(mTrace.begin(), mTrace.end(),
+                     [](const TraceEvent& a, const TraceEvent& b) { return a.mTime < b.mTime; });
+    return !mTrace.empty();
+}
+
+void FetchReplay::run()
+{
+    // Same order as LLAppViewer::initThreads() and initCache()
+    LLLFSThread::initClass(true);
+    mDecodeThread = new LLImageDecodeThread(true);
+    mCache = new LLTextureCache(true);
+    mFetcher = new LLTextureFetch(mCache, mDecodeThread, true, false);
+
+    mCache->setReadOnly(FALSE);
+    mCache->initCache(LL_PATH_CACHE, (S64)mOptions.mCacheMB * 1024 * 1024, mOptions.mClearCache);
+    mDecodeThread->setDecodedCache(mCache->getDecodedCache());
+
+    LLTrace::Recording recording;
+    recording.start();
+    mStartTime = totalTime();
+    U64 last_finished(0);
+    while (mNextEvent < mTrace.size() || isBusy())
+    {
+        const U64 now = totalTime() - mStartTime;
+        applyEvents(now);
+        startRequests();
+
+        // As LLAppViewer::updateTextureThreads()
+        mCache->update(1);
+        mDecodeThread->update(1);
+        mFetcher->update(1);
+        LLLFSThread::updateClass(0);
+
+        if (collectFinished(now) || mNextEvent < mTrace.size())
+        {
+            last_finished = now;
+        }
+        else if (now - last_finished > (U64)mOptions.mIdleSeconds * 1000000)
+        {
+            mTimedOut = true;
+            break;
+        }
+
+        if (mOptions.mVerbose)
+        {
+            reportProgress(now);
+        }
+        ms_sleep(1);
+    }
+    mEndTime = totalTime() - mStartTime;
+    recording.stop();
+
+    mBytesOverWire = F64Bytes(recording.getSum(LLStatViewer::TEXTURE_NETWORK_DATA_RECEIVED)).value();
+    mHttpRequests = mFetcher->getTotalNumHTTPRequests();
+    mFetcher->getStateStats(&mCacheReads, &mCacheWrites, &mResourceWaits);
+
+    for (auto& it : mTextures)
+    {
+        if (it.second.mState == Texture::FETCHING)
+        {
+            mFetcher->deleteRequest(it.first, true);
+        }
+    }
+
+    // Same order as LLAppViewer::cleanup()
+    mFetcher->shutdown();
+    mCache->shutdown();
+    mDecodeThread->shutdown();
+    mFetcher->shutDownTextureCacheThread();
+    LLLFSThread::sLocal->shutdown();
+
+    delete mCache;
+    mCache = nullptr;
+    mFetcher->shutdown();
+    mFetcher->waitOnPending();
+    delete mFetcher;
+    mFetcher = nullptr;
+    delete mDecodeThread;
+    mDecodeThread = nullptr;
+    LLLFSThread::cleanupClass();
+}
+
+bool FetchReplay::isBusy() const
+{
+    for (const auto& it : mTextures)
+    {
+        const Texture& tex = it.second;
+        if ((tex.mState == Texture::PENDING || tex.mState == Texture::FETCHING) && tex.mPriority > 0.f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FetchReplay::applyEvents(U64 now)
+{
+    for (; mNextEvent < mTrace.size() && mTrace[mNextEvent].mTime <= now; ++mNextEvent)
+    {
+        const TraceEvent& event = mTrace[mNextEvent];
+        Texture& tex = mTextures[event.mId];
+        if (tex.mId.isNull())
+        {
+            tex.mId = event.mId;
+            tex.mRequestTime = event.mTime;
+        }
+        tex.mPriority = event.mPriority;
+
+        if (event.mPriority <= 0.f)
+        {
+            // Dropped, as when a texture leaves the view
+            if (tex.mState == Texture::FETCHING)
+            {
+                mFetcher->deleteRequest(tex.mId, true);
+            }
+            if (tex.mState == Texture::PENDING || tex.mState == Texture::FETCHING)
+            {
+                tex.mState = Texture::IDLE;
+                ++mCancels;
+            }
+        }
+        else if (tex.mState == Texture::IDLE)
+        {
+            tex.mState = Texture::PENDING;
+        }
+        else if (tex.mState == Texture::FETCHING)
+        {
+            mFetcher->updateRequestPriority(tex.mId, tex.mPriority);
+        }
+    }
+}
+
+void FetchReplay::startRequests()
+{
+    for (auto& it : mTextures)
+    {
+        Texture& tex = it.second;
+        if (tex.mState != Texture::PENDING)
+        {
+            continue;
+        }
+
+        // Without dimensions the fetcher goes for the first packet and the
+        // lowest mip, as for a texture the viewer hasn't seen yet
+        const std::string url = makeUrl(mOptions.mUrlFormat, tex.mId.asString());
+        S32 desired = tex.mWantFull
+            ? mFetcher->createRequest(FTT_DEFAULT, url, tex.mId, LLHost(), tex.mPriority,
+                                      tex.mFullWidth, tex.mFullHeight, tex.mComponents, 0, false, true)
+            : mFetcher->createRequest(FTT_DEFAULT, url, tex.mId, LLHost(), tex.mPriority,
+                                      0, 0, 0, MAX_DISCARD_LEVEL, false, true);
+        if (desired >= 0)
+        {
+            tex.mState = Texture::FETCHING;
+        }
+        // else a cancelled request of it is still winding down, try again
+    }
+}
+
+bool FetchReplay::collectFinished(U64 now)
+{
+    bool any(false);
+    for (auto& it : mTextures)
+    {
+        Texture& tex = it.second;
+        if (tex.mState != Texture::FETCHING)
+        {
+            continue;
+        }
+
+        S32 discard(-1);
+        LLPointer<LLImageRaw> raw;
+        LLPointer<LLImageRaw> aux;
+        LLCore::HttpStatus status;
+        if (!mFetcher->getRequestFinished(tex.mId, discard, raw, aux, status))
+        {
+            continue;
+        }
+        any = true;
+
+        if (discard < 0 || raw.isNull())
+        {
+            tex.mState = Texture::FAILED;
+            mFetcher->deleteRequest(tex.mId, true);
+            if (mOptions.mVerbose)
+            {
+                std::cout << tex.mId << ":  failed, " << status.toString() << std::endl;
+            }
+            continue;
+        }
+
+        if (!tex.mFirstMipTime)
+        {
+            tex.mFirstMipTime = now;
+        }
+        tex.mDiscard = discard;
+        if (discard == 0 || tex.mWantFull)
+        {
+            // Either all of it or all the fetcher could get
+            if (discard == 0)
+            {
+                tex.mFullTime = now;
+            }
+            tex.mState = Texture::DONE;
+            mFetcher->deleteRequest(tex.mId, false);
+        }
+        else
+        {
+            // Now that the size is known, ask for the whole image
+            tex.mWantFull = true;
+            tex.mFullWidth = raw->getWidth() << discard;
+            tex.mFullHeight = raw->getHeight() << discard;
+            tex.mComponents = raw->getComponents();
+            tex.mState = Texture::PENDING;
+        }
+    }
+    return any;
+}
+
+void FetchReplay::reportProgress(U64 now)
+{
+    static U64 last_report(0);
+    if (now - last_report < 1000000)
+    {
+        return;
+    }
+    last_report = now;
+
+    S32 done(0), fetching(0);
+    for (const auto& it : mTextures)
+    {
+        done += it.second.mState == Texture::DONE;
+        fetching += it.second.mState == Texture::FETCHING;
+    }
+    std::cout << llformat("%6.1fs  textures %d/%d  fetching %d  http %d",
+                          (F32)now / 1000000.f, done, (S32)mTextures.size(),
+                          fetching, mFetcher->getNumHTTPRequests())
+              << std::endl;
+}
+
+//static
+void FetchReplay::percentiles(std::ostream& out, const char* label, std::vector<U64>& times)
+{
+    out << label;
+    if (times.empty())
+    {
+        out << "  (none)" << std::endl;
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    auto at = [&times](F32 fraction) { return to_ms(times[llmin((size_t)(fraction * times.size()), times.size() - 1)]); };
+    out << llformat("  p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f  ms (%d)",
+                    at(0.5f), at(0.9f), at(0.99f), to_ms(times.back()), (S32)times.size())
+        << std::endl;
+}
+
+void FetchReplay::report(std::ostream& out)
+{
+    std::vector<U64> first_mip, full_res;
+    S32 done(0), failed(0), unfinished(0);
+    for (const auto& it : mTextures)
+    {
+        const Texture& tex = it.second;
+        if (tex.mFirstMipTime)
+        {
+            first_mip.push_back(tex.mFirstMipTime - tex.mRequestTime);
+        }
+        if (tex.mFullTime)
+        {
+            full_res.push_back(tex.mFullTime - tex.mRequestTime);
+        }
+        done += tex.mState == Texture::DONE;
+        failed += tex.mState == Texture::FAILED;
+        unfinished += tex.mState != Texture::DONE && tex.mState != Texture::FAILED;
+    }
+
+    out << "Textures:  " << mTextures.size() << "  complete:  " << done << "  failed:  " << failed
+        << "  unfinished:  " << unfinished << "  cancellations:  " << mCancels << std::endl;
+    percentiles(out, "Time to first mip:", first_mip);
+    percentiles(out, "Time to full res: ", full_res);
+    out << llformat("Bytes over the wire:  %.0f in %u requests", mBytesOverWire, mHttpRequests) << std::endl;
+    out << "Cache reads:  " << mCacheReads << "  cache writes:  " << mCacheWrites
+        << "  HTTP resource waits:  " << mResourceWaits << std::endl;
+    out << llformat("Wall time:  %.1f ms", to_ms(mEndTime)) << std::endl;
+    if (mTimedOut)
+    {
+        out << "Stopped after " << mOptions.mIdleSeconds << " seconds without a texture finishing" << std::endl;
+    }
+}
+
+bool FetchReplay::writeCSV(const std::string& filename)
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        return false;
+    }
+    out << "id,priority,requested_ms,first_mip_ms,full_res_ms,discard,state" << std::endl;
+    for (const auto& it : mTextures)
+    {
+        const Texture& tex = it.second;
+        out << tex.mId << "," << tex.mPriority << "," << to_ms(tex.mRequestTime) << ","
+            << (tex.mFirstMipTime ? to_ms(tex.mFirstMipTime - tex.mRequestTime) : -1.0) << ","
+            << (tex.mFullTime ? to_ms(tex.mFullTime - tex.mRequestTime) : -1.0) << ","
+            << tex.mDiscard << "," << (S32)tex.mState << std::endl;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+static bool parse_count(const char* arg, S32 min_value, S32 max_value, S32& value)
+{
+    char* end(nullptr);
+    const long parsed = strtol(arg, &end, 10);
+    if (*end != '\0' || parsed < min_value || parsed > max_value)
+    {
+        return false;
+    }
+    value = (S32)parsed;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    FetchReplay::Options options;
+    std::string trace_file;
+    std::string csv_file;
+    std::string cache_dir("lltexturefetch_cache");
+    S32 connections(8);
+    S32 pipeline_depth(0);
+    S32 http2_streams(0);
+    S32 decodes(32);
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const std::string name(argv[arg]);
+        const bool has_value = arg + 1 < argc;
+        if (name == "-h" || name == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if ((name == "-u" || name == "--url") && has_value)
+        {
+            options.mUrlFormat = argv[++arg];
+            if (!FetchReplay::isValidUrlFormat(options.mUrlFormat))
+            {
+                std::cerr << "The URL needs exactly one {id} or %s:  " << options.mUrlFormat << std::endl;
+                return 1;
+            }
+        }
+        else if ((name == "-c" || name == "--connections") && has_value)
+        {
+            if (!parse_count(argv[++arg], 1, 100, connections)) break;
+        }
+        else if ((name == "-p" || name == "--pipeline") && has_value)
+        {
+            if (!parse_count(argv[++arg], 0, 100, pipeline_depth)) break;
+        }
+        else if ((name == "-2" || name == "--http2") && has_value)
+        {
+            if (!parse_count(argv[++arg], 0, 256, http2_streams)) break;
+        }
+        else if ((name == "-D" || name == "--decodes") && has_value)
+        {
+            if (!parse_count(argv[++arg], 1, 1000, decodes)) break;
+        }
+        else if ((name == "-C" || name == "--cache") && has_value)
+        {
+            cache_dir = argv[++arg];
+        }
+        else if ((name == "-M" || name == "--cache-size") && has_value)
+        {
+            if (!parse_count(argv[++arg], 64, 16384, options.mCacheMB)) break;
+        }
+        else if ((name == "-d" || name == "--decoded") && has_value)
+        {
+            if (!parse_count(argv[++arg], 0, 16384, options.mDecodedCacheMB)) break;
+        }
+        else if (name == "-S" || name == "--slabs")
+        {
+            options.mSlabStore = true;
+        }
+        else if (name == "-x" || name == "--clear-cache")
+        {
+            options.mClearCache = true;
+        }
+        else if ((name == "-s" || name == "--speed") && has_value)
+        {
+            options.mSpeed = (F32)atof(argv[++arg]);
+            if (options.mSpeed <= 0.f) break;
+        }
+        else if ((name == "-t" || name == "--timeout") && has_value)
+        {
+            if (!parse_count(argv[++arg], 1, 3600, options.mIdleSeconds)) break;
+        }
+        else if ((name == "-o" || name == "--output") && has_value)
+        {
+            csv_file = argv[++arg];
+        }
+        else if (name == "-v" || name == "--verbose")
+        {
+            options.mVerbose = true;
+        }
+        else if (name[0] != '-' && trace_file.empty())
+        {
+            trace_file = name;
+            continue;
+        }
+        else
+        {
+            trace_file.clear();
+            break;
+        }
+    }
+
+    if (trace_file.empty())
+    {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+    LLCommon::initClass();
+    LLImage::initClass();
+    if (!gDirUtilp->setCacheDir(cache_dir))
+    {
+        std::cerr << "Couldn't use '" << cache_dir << "' as the cache directory" << std::endl;
+        return 1;
+    }
+
+    // The settings the fetcher and cache read outright, the rest are
+    // LLCachedControls that fall back on the viewer's defaults
+    gSavedSettings.declareF32("ThrottleBandwidthKBPS", 3000.f, "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareString("TextureFetchTraceFile", "", "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareBOOL("QAModeMetrics", FALSE, "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareBOOL("TextureCacheSlabStore", options.mSlabStore, "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareU32("TextureCacheDecodedSize", options.mDecodedCacheMB, "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareU32("CacheValidateCounter", 0, "", LLControlVariable::PERSIST_NO);
+    gSavedSettings.declareU32("TextureFetchDecodeBudget", decodes, "", LLControlVariable::PERSIST_NO);
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    // Without the viewer's LLAppCoreHttp the fetcher uses the default policy
+    LLCore::HttpRequest::createService();
+    const LLCore::HttpRequest::policy_t policy = LLCore::HttpRequest::DEFAULT_POLICY_ID;
+    LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT, policy,
+                                               connections, NULL);
+    LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, policy,
+                                               connections, NULL);
+    if (pipeline_depth)
+    {
+        LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PIPELINING_DEPTH, policy,
+                                                   pipeline_depth, NULL);
+    }
+    if (http2_streams)
+    {
+        LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAM_LIMIT, policy,
+                                                   http2_streams, NULL);
+    }
+    LLCore::HttpRequest::startThread();
+
+    int result = 0;
+    {
+        FetchReplay replay(options);
+        if (!replay.loadTrace(trace_file))
+        {
+            std::cerr << "No texture requests in '" << trace_file << "'" << std::endl;
+            result = 1;
+        }
+        else
+        {
+            replay.run();
+            replay.report(std::cout);
+            if (!csv_file.empty() && !replay.writeCSV(csv_file))
+            {
+                std::cerr << "Couldn't write '" << csv_file << "'" << std::endl;
+                result = 1;
+            }
+        }
+    }
+
+    LLCore::HttpRequest* stopper = new LLCore::HttpRequest;
+    stopper->requestStopThread(LLCore::HttpHandler::ptr_t());
+    ms_sleep(1000);
+    delete stopper;
+    LLCore::HttpRequest::destroyService();
+    curl_global_cleanup();
+    LLImage::cleanupClass();
+    LLCommon::cleanupClass();
+    return result;
+}
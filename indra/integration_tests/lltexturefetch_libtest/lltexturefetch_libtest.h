@@ -0,0 +1,130 @@
+/**
+ * @file lltexturefetch_libtest.h
+ * @brief Replays a texture request trace through LLTextureFetch
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+#ifndef LLTEXTUREFETCH_LIBTEST_H
+#define LLTEXTUREFETCH_LIBTEST_H
+
+#include "lluuid.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class LLImageDecodeThread;
+class LLTextureCache;
+class LLTextureFetch;
+
+// Replays a trace of texture requests through the viewer's own
+// LLTextureFetch, LLTextureCache and LLImageDecodeThread, asking for
+// textures the way LLViewerFetchedTexture does: the lowest mip first,
+// then the whole image once its dimensions are known.  Requests, their
+// priorities and the thread updates all come from the thread calling
+// run(), standing in for the viewer's main loop.
+class FetchReplay
+{
+public:
+    struct Options
+    {
+        std::string mUrlFormat = "http://127.0.0.1:12046/texture?texture_id={id}";
+        S32 mCacheMB = 1024;
+        S32 mDecodedCacheMB = 0;
+        bool mSlabStore = false;
+        bool mClearCache = false;
+        F32 mSpeed = 1.f;
+        S32 mIdleSeconds = 30;
+        bool mVerbose = false;
+    };
+
+    FetchReplay(const Options& options);
+
+    // True if format holds exactly one texture id token, {id} or %s.
+    // Nothing else in it is interpreted.
+    static bool isValidUrlFormat(const std::string& format);
+    static std::string makeUrl(const std::string& format, const std::string& id);
+
+    bool loadTrace(const std::string& filename);
+    void run();
+
+    void report(std::ostream& out);
+    bool writeCSV(const std::string& filename);
+
+private:
+    struct TraceEvent
+    {
+        U64 mTime;      // usecs from the start of the run
+        LLUUID mId;
+        F32 mPriority;
+    };
+
+    struct Texture
+    {
+        enum EState
+        {
+            IDLE,           // not wanted
+            PENDING,        // wanted, the fetcher hasn't taken the request yet
+            FETCHING,
+            DONE,
+            FAILED
+        };
+
+        LLUUID mId;
+        F32 mPriority = 0.f;
+        EState mState = IDLE;
+        S32 mDiscard = -1;          // best decoded so far
+        bool mWantFull = false;     // dimensions known, asking for discard 0
+        S32 mFullWidth = 0;
+        S32 mFullHeight = 0;
+        S32 mComponents = 0;
+        U64 mRequestTime = 0;
+        U64 mFirstMipTime = 0;
+        U64 mFullTime = 0;
+    };
+
+    bool isBusy() const;
+    void applyEvents(U64 now);
+    void startRequests();
+    bool collectFinished(U64 now);
+    void reportProgress(U64 now);
+    static void percentiles(std::ostream& out, const char* label, std::vector<U64>& times);
+
+    Options mOptions;
+    std::vector<TraceEvent> mTrace;
+    std::map<LLUUID, Texture> mTextures;
+
+    LLImageDecodeThread* mDecodeThread;
+    LLTextureCache* mCache;
+    LLTextureFetch* mFetcher;
+
+    size_t mNextEvent;
+    U64 mStartTime;
+    U64 mEndTime;
+    F64 mBytesOverWire;
+    U32 mHttpRequests;
+    U32 mCacheReads;
+    U32 mCacheWrites;
+    U32 mResourceWaits;
+    S32 mCancels;
+    bool mTimedOut;
+};
+
+#endif // LLTEXTUREFETCH_LIBTEST_H
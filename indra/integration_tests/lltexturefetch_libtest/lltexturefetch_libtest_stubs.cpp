@@ -0,0 +1,94 @@
+/**
+ * @file lltexturefetch_libtest_stubs.cpp
+ * @brief The viewer that LLTextureFetch and LLTextureCache expect around them
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+// The fetcher and the cache are compiled from newview as they are.  What
+// they reach for outside of them is stood in for here, the way the
+// newview unit tests do it: no viewer, no agent, no region, so every
+// request must carry its own URL.
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llagent.h"
+#include "llappviewer.h"
+#include "lltextureinfo.h"
+#include "llviewerassetstats.h"
+#include "llviewercontrol.h"
+#include "llviewerregion.h"
+#include "llviewerstats.h"
+#include "llviewerstatsrecorder.h"
+#include "llviewertexture.h"
+#include "llworld.h"
+
+LLControlGroup gSavedSettings("Global");
+
+LLAppViewer* LLAppViewer::sInstance = NULL;
+void LLAppViewer::pauseMainloopTimeout() { }
+void LLAppViewer::resumeMainloopTimeout(const std::string& state, F32 secs) { }
+
+LLAgent gAgent;
+LLAgent::LLAgent() : mAgentAccess(NULL) { }
+LLAgent::~LLAgent() { }
+LLViewerRegion* LLAgent::getRegion() const { return NULL; }
+
+LLViewerRegion* LLWorld::getRegion(const LLHost& host) { return NULL; }
+const LLUUID& LLViewerRegion::getRegionID() const { return LLUUID::null; }
+
+// Nothing is on screen to account the fetched bytes to
+void LLViewerTextureManager::findTextures(const LLUUID& id, std::vector<LLViewerTexture*>& output) { }
+U64Bytes gTotalTextureBytesPerBoostLevel[LLViewerTexture::MAX_GL_IMAGE_CATEGORY];
+
+namespace LLStatViewer
+{
+    LLTrace::CountStatHandle<F64Kilobytes> TEXTURE_NETWORK_DATA_RECEIVED("texturedatareceived", "Network data received for textures");
+}
+
+LLViewerStatsRecorder::LLViewerStatsRecorder()
+    : mStatsFile(NULL),
+      mEnableStatsRecording(false),
+      mEnableStatsLogging(false),
+      mTextureFetchCount(0)
+{
+}
+LLViewerStatsRecorder::~LLViewerStatsRecorder() { }
+
+namespace LLViewerAssetStatsFF
+{
+    void set_region(LLViewerAssetStats::region_handle_t region_handle) { }
+    void record_enqueue(LLViewerAssetType::EType at, bool with_http, bool is_temp) { }
+    void record_dequeue(LLViewerAssetType::EType at, bool with_http, bool is_temp) { }
+    void record_response(LLViewerAssetType::EType at, bool with_http, bool is_temp,
+                         LLViewerAssetStats::duration_t duration, F64 bytes) { }
+}
+
+void dump_sequential_xml(const std::string outprefix, const LLSD& content) { }
+
+LLTextureInfo::LLTextureInfo(bool postponeStartRecoreder) { }
+LLTextureInfo::~LLTextureInfo() { }
+void LLTextureInfo::setLogging(bool log_info) { }
+void LLTextureInfo::setRequestStartTime(const LLUUID& id, U64 startTime) { }
+void LLTextureInfo::setRequestSize(const LLUUID& id, U32 size) { }
+void LLTextureInfo::setRequestOffset(const LLUUID& id, U32 offset) { }
+void LLTextureInfo::setRequestType(const LLUUID& id, LLTextureInfoDetails::LLRequestType type) { }
+void LLTextureInfo::setRequestCompleteTimeAndLog(const LLUUID& id, U64Microseconds completeTime) { }
+void LLTextureInfo::startRecording() { }
+void LLTextureInfo::stopRecording() { }
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""\
+@file   texture_server.py
+@brief  Local stand-in for the texture CDN, used by lltexturefetch_libtest.
+
+Serves <dir>/<uuid>.j2c for GET /texture?texture_id=<uuid> (and for
+GET /<uuid>.j2c), honouring single Range: headers the way the grid's
+texture service does: 206 with Content-Range for satisfiable ranges,
+416 for ranges starting past the end, 404 for unknown ids.
+
+--latency adds a fixed delay before each response and --rate caps the
+per-connection send rate so runs can approximate a distant CDN.
+
+$LicenseInfo:firstyear=2024&license=viewerlgpl$
+Second Life Viewer Source Code
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+$/LicenseInfo$
+"""
+
+import argparse
+import os
+import re
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+UUID_RE = re.compile(r'^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$')
+RANGE_RE = re.compile(r'^bytes=(\d+)-(\d*)$')
+SEND_CHUNK = 16 * 1024
+
+
+class TextureRequestHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def texture_id(self):
+        url = urlparse(self.path)
+        ids = parse_qs(url.query).get('texture_id')
+        if ids:
+            return ids[0]
+        name = os.path.basename(url.path)
+        if name.endswith('.j2c'):
+            return name[:-4]
+        return None
+
+    def do_HEAD(self):
+        self.do_GET(withdata=False)
+
+    def do_GET(self, withdata=True):
+        server = self.server
+        if server.latency:
+            time.sleep(server.latency)
+
+        tid = self.texture_id()
+        path = os.path.join(server.directory, tid + '.j2c') if tid and UUID_RE.match(tid) else None
+        if not path or not os.path.isfile(path):
+            self.send_error(404)
+            return
+
+        size = os.path.getsize(path)
+        first, last = 0, size - 1
+        status = 200
+        byte_range = self.headers.get('Range')
+        if byte_range:
+            match = RANGE_RE.match(byte_range.strip())
+            if not match:
+                self.send_error(400)
+                return
+            first = int(match.group(1))
+            if match.group(2):
+                last = min(int(match.group(2)), size - 1)
+            if first >= size:
+                self.send_response(416)
+                self.send_header('Content-Range', 'bytes */%d' % size)
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return
+            status = 206
+
+        length = last - first + 1
+        self.send_response(status)
+        self.send_header('Content-Type', 'image/x-j2c')
+        self.send_header('Content-Length', str(length))
+        if status == 206:
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (first, last, size))
+        self.end_headers()
+        if not withdata:
+            return
+
+        with open(path, 'rb') as f:
+            f.seek(first)
+            remaining = length
+            while remaining > 0:
+                chunk = f.read(min(SEND_CHUNK, remaining))
+                if not chunk:
+                    break
+                self.wfile.write(chunk)
+                remaining -= len(chunk)
+                if server.rate:
+                    time.sleep(len(chunk) / server.rate)
+        server.bytes_sent += length
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            BaseHTTPRequestHandler.log_message(self, format, *args)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Serve J2C textures for lltexturefetch_libtest.')
+    parser.add_argument('directory', help='directory holding <uuid>.j2c files')
+    parser.add_argument('--port', type=int, default=12046)
+    parser.add_argument('--latency', type=float, default=0.0, help='milliseconds added to each response')
+    parser.add_argument('--rate', type=float, default=0.0, help='KB/s per connection, 0 for unlimited')
+    parser.add_argument('--verbose', action='store_true')
+    args = parser.parse_args(argv)
+
+    server = ThreadingHTTPServer(('127.0.0.1', args.port), TextureRequestHandler)
+    server.daemon_threads = True
+    server.directory = args.directory
+    server.latency = args.latency / 1000.0
+    server.rate = args.rate * 1024.0
+    server.verbose = args.verbose
+    server.bytes_sent = 0
+    print('Serving %s on http://127.0.0.1:%d/texture?texture_id={id}' % (args.directory, args.port))
+    sys.stdout.flush()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print('Bytes sent: %d' % server.bytes_sent)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,329 @@
+/**
+ * @file lltextureupload_libtest.cpp
+ * @brief Checks staged texture uploads and times their frame cost
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llgl.h"
+#include "llimage.h"
+#include "llimagegl.h"
+#include "llrender.h"
+#include "lltextureuploadring.h"
+#include "lltimer.h"
+#include "llwindow.h"
+#include "llwindowcallbacks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+static const char USAGE[] = "\n"
+"usage:\tlltextureupload_libtest [options]\n"
+"\n"
+"Creates a small window, checks that textures uploaded from the upload\n"
+"ring hold the pixels they were staged from, then uploads the same\n"
+"stream of textures with and without the ring and reports the mean,\n"
+"standard deviation and worst frame time of each.\n"
+"\n"
+"On Linux it asks Mesa for llvmpipe so the numbers don't depend on the\n"
+"GPU; for a machine without a display run it under xvfb-run.  Exits with\n"
+"1 if a check fails.\n"
+"\n"
+"Options:\n"
+" -f, --frames <count>      Frames to time per mode.  Default:  300\n"
+" -u, --uploads <count>     Textures created per frame.  Default:  8\n"
+" -s, --size <pixels>       Width and height of each texture.  Default:  512\n"
+" -m, --ring <MB>           Upload ring size.  Default:  64\n"
+" -c, --check-only          Run the checks, skip the timing\n"
+"     --hardware            Use the system's GL driver instead of llvmpipe\n"
+" -h, --help                This help\n";
+
+// Frames a texture lives before it's deleted, like a short lived object
+static const size_t TEXTURE_LIFETIME_FRAMES = 4;
+
+namespace
+{
+    LLPointer<LLImageRaw> make_image(S32 size, U32 seed)
+    {
+        LLPointer<LLImageRaw> raw = new LLImageRaw(size, size, 4);
+        U8* data = raw->getData();
+        for (S32 i = 0; i < raw->getDataSize(); ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            data[i] = (U8)(seed >> 16);
+        }
+        return raw;
+    }
+
+    // Uploads raw, from region if it's valid, and returns the texture
+    LLPointer<LLImageGL> upload(const LLImageRaw* raw, const LLTextureUploadRing::Region& region,
+                                LLImageRaw* staged_from)
+    {
+        LLPointer<LLImageGL> image = new LLImageGL(FALSE);
+        image->setAllowCompression(false);
+        if (region.isValid())
+        {
+            image->setStagedUpload(region, staged_from);
+        }
+        image->createGLTexture(0, raw);
+        return image;
+    }
+
+    bool same_pixels(const LLImageGL* image, const LLImageRaw* expected)
+    {
+        LLPointer<LLImageRaw> readback = new LLImageRaw;
+        return image->readBackRaw(0, readback, false)
+            && readback->getWidth() == expected->getWidth()
+            && readback->getHeight() == expected->getHeight()
+            && readback->getComponents() == expected->getComponents()
+            && memcmp(readback->getData(), expected->getData(), expected->getDataSize()) == 0;
+    }
+
+    bool check(const char* name, bool ok)
+    {
+        std::cout << (ok ? "pass  " : "FAIL  ") << name << std::endl;
+        return ok;
+    }
+
+    bool run_checks()
+    {
+        LLTextureUploadRing* ring = LLTextureUploadRing::getInstance();
+        bool ok = true;
+
+        // Staged copy of the image being uploaded
+        LLPointer<LLImageRaw> raw = make_image(256, 1);
+        LLTextureUploadRing::Region region = ring->stage(raw->getData(), raw->getDataSize());
+        ok = check("stage", region.isValid()) && ok;
+        LLPointer<LLImageGL> image = upload(raw, region, raw);
+        ok = check("staged upload keeps its pixels", same_pixels(image, raw)) && ok;
+
+        // The staged image goes away before creation, as in
+        // LLViewerFetchedTexture::stageUpload.  Whatever gets allocated next
+        // must not be mistaken for it even if it lands at the same address.
+        raw = make_image(256, 2);
+        region = ring->stage(raw->getData(), raw->getDataSize());
+        image = new LLImageGL(FALSE);
+        image->setAllowCompression(false);
+        image->setStagedUpload(region, raw);
+        raw = NULL;
+        LLPointer<LLImageRaw> other = make_image(256, 3);
+        image->createGLTexture(0, other);
+        ok = check("released source isn't reused", same_pixels(image, other)) && ok;
+
+        // Staged at one size, uploaded at another
+        raw = make_image(256, 4);
+        region = ring->stage(raw->getData(), raw->getDataSize());
+        LLPointer<LLImageRaw> smaller = make_image(128, 5);
+        image = upload(smaller, region, raw);
+        ok = check("size mismatch uploads directly", same_pixels(image, smaller)) && ok;
+
+        image = NULL;
+        ring->update();
+        return ok;
+    }
+
+    struct FrameStats
+    {
+        F64 mMean = 0.0;
+        F64 mStdDev = 0.0;
+        F64 mMedian = 0.0;
+        F64 mMax = 0.0;
+    };
+
+    FrameStats time_frames(LLWindow* window, bool staged, S32 frames, S32 uploads, S32 size)
+    {
+        LLTextureUploadRing* ring = LLTextureUploadRing::getInstance();
+        std::vector<LLPointer<LLImageRaw> > rasters;
+        for (S32 i = 0; i < uploads; ++i)
+        {
+            rasters.push_back(make_image(size, i + 1));
+        }
+
+        std::deque<std::vector<LLPointer<LLImageGL> > > live;
+        std::vector<F64> times;
+        std::vector<LLTextureUploadRing::Region> regions(uploads);
+        for (S32 frame = 0; frame < frames; ++frame)
+        {
+            // The viewer stages on the "General" pool, off the frame
+            if (staged)
+            {
+                for (S32 i = 0; i < uploads; ++i)
+                {
+                    regions[i] = ring->stage(rasters[i]->getData(), rasters[i]->getDataSize());
+                }
+            }
+
+            LLTimer timer;
+            live.emplace_back();
+            for (S32 i = 0; i < uploads; ++i)
+            {
+                live.back().push_back(upload(rasters[i], regions[i], rasters[i]));
+                regions[i] = LLTextureUploadRing::Region();
+            }
+            if (live.size() > TEXTURE_LIFETIME_FRAMES)
+            {
+                live.pop_front();
+            }
+            ring->update();
+            window->swapBuffers();
+            times.push_back(timer.getElapsedTimeF64() * 1000.0);
+        }
+
+        FrameStats stats;
+        for (F64 t : times)
+        {
+            stats.mMean += t;
+            stats.mMax = llmax(stats.mMax, t);
+        }
+        stats.mMean /= times.size();
+        for (F64 t : times)
+        {
+            stats.mStdDev += (t - stats.mMean) * (t - stats.mMean);
+        }
+        stats.mStdDev = sqrt(stats.mStdDev / times.size());
+        std::sort(times.begin(), times.end());
+        stats.mMedian = times[times.size() / 2];
+        return stats;
+    }
+
+    void report(const char* name, const FrameStats& stats)
+    {
+        std::cout << name << "  mean " << stats.mMean << " ms, stddev " << stats.mStdDev
+                  << " ms, median " << stats.mMedian << " ms, worst " << stats.mMax << " ms" << std::endl;
+    }
+}
+
+static bool parse_count(const char* arg, S32 min_value, S32 max_value, S32& value)
+{
+    char* end(nullptr);
+    const long parsed = strtol(arg, &end, 10);
+    if (*end != '\0' || parsed < min_value || parsed > max_value)
+    {
+        return false;
+    }
+    value = (S32)parsed;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    S32 frames(300);
+    S32 uploads(8);
+    S32 size(512);
+    S32 ring_mb(64);
+    bool check_only(false);
+    bool hardware(false);
+    bool valid(true);
+
+    for (int arg = 1; arg < argc && valid; ++arg)
+    {
+        const std::string name(argv[arg]);
+        const bool has_value = arg + 1 < argc;
+        if (name == "-h" || name == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if ((name == "-f" || name == "--frames") && has_value)
+        {
+            valid = parse_count(argv[++arg], 1, 100000, frames);
+        }
+        else if ((name == "-u" || name == "--uploads") && has_value)
+        {
+            valid = parse_count(argv[++arg], 1, 256, uploads);
+        }
+        else if ((name == "-s" || name == "--size") && has_value)
+        {
+            valid = parse_count(argv[++arg], 16, 2048, size);
+        }
+        else if ((name == "-m" || name == "--ring") && has_value)
+        {
+            valid = parse_count(argv[++arg], 1, 1024, ring_mb);
+        }
+        else if (name == "-c" || name == "--check-only")
+        {
+            check_only = true;
+        }
+        else if (name == "--hardware")
+        {
+            hardware = true;
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+#if LL_LINUX
+    if (!hardware)
+    {
+        // Don't override an explicit choice from the environment
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+        setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+    }
+#endif
+
+    LLWindowCallbacks callbacks;
+    LLWindow* window = LLWindowManager::createWindow(&callbacks,
+        "lltextureupload_libtest", "lltextureupload_libtest", 0, 0, 256, 256);
+    if (!window)
+    {
+        std::cerr << "Couldn't create a GL window" << std::endl;
+        return 1;
+    }
+    std::cout << "GL renderer: " << gGLManager.getRawGLString() << std::endl;
+
+    gGL.init(false);
+    LLImageGL::sUploadRingBytes = (U32)ring_mb << 20;
+    LLImageGL::initClass(window, 1);
+    LLImageGL::sAllowReadBackRaw = TRUE;
+
+    int result = 0;
+    if (!LLTextureUploadRing::instanceExists())
+    {
+        std::cerr << "The upload ring needs glBufferStorage (GL 4.4)" << std::endl;
+        result = 1;
+    }
+    else if (!run_checks())
+    {
+        result = 1;
+    }
+    else if (!check_only)
+    {
+        std::cout << frames << " frames of " << uploads << " " << size << "x" << size << " uploads" << std::endl;
+        report("direct", time_frames(window, false, frames, uploads, size));
+        report("staged", time_frames(window, true, frames, uploads, size));
+    }
+
+    LLImageGL::cleanupClass();
+    gGL.shutdown();
+    LLWindowManager::destroyWindow(window);
+    return result;
+}
@@ -0,0 +1,674 @@
+/**
+ * @file llvolume_libtest.cpp
+ * @brief Times each stage of building volume geometry
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llmeshoptimizer.h"
+#include "llpointer.h"
+#include "llsdserialize.h"
+#include "lltimer.h"
+#include "llvolume.h"
+#include "llvolumemgr.h"
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+static const char USAGE[] = "\n"
+"usage:\tllvolume_libtest [options] [<file or directory>...]\n"
+"\n"
+"Times the stages of building volume geometry:  generating a fixed set of\n"
+"prims and sculpts at the highest LOD, and unpacking and optimizing every\n"
+"LOD of the given mesh assets and .slm files.  Each case is run several\n"
+"times and its stage times summed per run, the table reports the mean\n"
+"and fastest run.  Files that aren't mesh assets or .slm are skipped.\n"
+"\n"
+"For the mesh LODs it also reports the post-transform vertex cache\n"
+"efficiency (ACMR:  vertices transformed per triangle) of the faces as\n"
+"stored in the asset and after LLVolume::cacheOptimize().\n"
+"\n"
+"Options:\n"
+" -r, --runs <n>            Runs per case.  Default:  10\n"
+" -c, --cache-size <n>      FIFO vertex cache size for ACMR.  Default:  16\n"
+" -o, --output <file>       CSV of the results\n"
+" -a, --acmr <file>         Per model and LOD CSV of the ACMR results\n"
+" -b, --baseline <file>     CSV from an earlier run to compare against\n"
+" -h, --help                This help\n";
+
+namespace
+{
+    const S32 NUM_LODS = 4;
+    const char* LOD_NAMES[NUM_LODS] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+
+    const S32 SCULPT_SIZE = 64;
+
+    struct StageResult
+    {
+        std::string mCase;
+        std::string mStage;
+        S32 mTriangles = 0;
+        std::vector<F64> mRuns;     // seconds
+
+        F64 getMeanMs() const
+        {
+            F64 sum(0.0);
+            for (F64 run : mRuns)
+            {
+                sum += run;
+            }
+            return mRuns.empty() ? 0.0 : sum * 1000.0 / mRuns.size();
+        }
+
+        F64 getMinMs() const
+        {
+            return mRuns.empty() ? 0.0 : *std::min_element(mRuns.begin(), mRuns.end()) * 1000.0;
+        }
+    };
+
+    // Stages of one case, in the order they first ran
+    class CaseTimes
+    {
+    public:
+        CaseTimes(const std::string& name) : mName(name) {}
+
+        // Adds seconds to the stage for the current run
+        void add(const std::string& stage, F64 seconds, S32 triangles = 0)
+        {
+            StageResult& result = get(stage);
+            if (result.mRuns.size() <= mRun)
+            {
+                result.mRuns.resize(mRun + 1, 0.0);
+            }
+            result.mRuns[mRun] += seconds;
+            if (mRun == 0)
+            {
+                result.mTriangles += triangles;
+            }
+        }
+
+        void nextRun() { ++mRun; }
+
+        void appendTo(std::vector<StageResult>& results) const
+        {
+            results.insert(results.end(), mStages.begin(), mStages.end());
+        }
+
+    private:
+        StageResult& get(const std::string& stage)
+        {
+            for (StageResult& result : mStages)
+            {
+                if (result.mStage == stage)
+                {
+                    return result;
+                }
+            }
+            mStages.emplace_back();
+            mStages.back().mCase = mName;
+            mStages.back().mStage = stage;
+            return mStages.back();
+        }
+
+        std::string mName;
+        std::vector<StageResult> mStages;
+        size_t mRun = 0;
+    };
+
+    S32 count_triangles(const LLVolume* volume)
+    {
+        S32 triangles(0);
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            triangles += volume->getVolumeFace(i).mNumIndices / 3;
+        }
+        return triangles;
+    }
+
+    // Stages every volume goes through once its faces exist
+    void time_face_stages(LLVolume* volume, CaseTimes& times, bool legacy_tangents)
+    {
+        LLTimer timer;
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            volume->getVolumeFace(i).createOctree();
+        }
+        times.add("octree", timer.getElapsedTimeAndResetF64().value());
+
+        if (legacy_tangents)
+        {
+            for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+            {
+                volume->genTangents(i);
+            }
+            times.add("tangents", timer.getElapsedTimeAndResetF64().value());
+        }
+    }
+
+    struct PrimCase
+    {
+        const char* mName;
+        U8 mProfile;
+        U8 mPath;
+        F32 mHollow;
+        F32 mTwist;
+        U8 mSculptType;
+    };
+
+    const PrimCase PRIM_CASES[] =
+    {
+        { "box",            LL_PCODE_PROFILE_SQUARE,        LL_PCODE_PATH_LINE,     0.f,    0.f,    LL_SCULPT_TYPE_NONE },
+        { "box_hollow",     LL_PCODE_PROFILE_SQUARE,        LL_PCODE_PATH_LINE,     0.5f,   0.f,    LL_SCULPT_TYPE_NONE },
+        { "box_twisted",    LL_PCODE_PROFILE_SQUARE,        LL_PCODE_PATH_LINE,     0.f,    0.5f,   LL_SCULPT_TYPE_NONE },
+        { "prism",          LL_PCODE_PROFILE_EQUALTRI,      LL_PCODE_PATH_LINE,     0.f,    0.f,    LL_SCULPT_TYPE_NONE },
+        { "cylinder",       LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_LINE,     0.f,    0.f,    LL_SCULPT_TYPE_NONE },
+        { "sphere",         LL_PCODE_PROFILE_CIRCLE_HALF,   LL_PCODE_PATH_CIRCLE,   0.f,    0.f,    LL_SCULPT_TYPE_NONE },
+        { "torus",          LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_CIRCLE,   0.f,    0.f,    LL_SCULPT_TYPE_NONE },
+        { "tube_twisted",   LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_CIRCLE,   0.5f,   1.f,    LL_SCULPT_TYPE_NONE },
+        { "sculpt_sphere",  LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_CIRCLE,   0.f,    0.f,    LL_SCULPT_TYPE_SPHERE },
+        { "sculpt_torus",   LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_CIRCLE,   0.f,    0.f,    LL_SCULPT_TYPE_TORUS },
+        { "sculpt_plane",   LL_PCODE_PROFILE_CIRCLE,        LL_PCODE_PATH_CIRCLE,   0.f,    0.f,    LL_SCULPT_TYPE_PLANE },
+    };
+
+    // RGB sculpt map of a lumpy sphere, so every sculpt type has something
+    // that isn't degenerate to stitch
+    std::vector<U8> make_sculpt_map()
+    {
+        std::vector<U8> data(SCULPT_SIZE * SCULPT_SIZE * 3);
+        for (S32 t = 0; t < SCULPT_SIZE; ++t)
+        {
+            const F32 phi = F_PI * t / (SCULPT_SIZE - 1);
+            for (S32 s = 0; s < SCULPT_SIZE; ++s)
+            {
+                const F32 theta = F_TWO_PI * s / SCULPT_SIZE;
+                const F32 radius = 0.4f + 0.1f * sinf(theta * 5.f) * sinf(phi * 3.f);
+                U8* pixel = &data[(t * SCULPT_SIZE + s) * 3];
+                pixel[0] = (U8)llclamp(ll_round((0.5f + radius * sinf(phi) * cosf(theta)) * 255.f), 0, 255);
+                pixel[1] = (U8)llclamp(ll_round((0.5f + radius * sinf(phi) * sinf(theta)) * 255.f), 0, 255);
+                pixel[2] = (U8)llclamp(ll_round((0.5f + radius * cosf(phi)) * 255.f), 0, 255);
+            }
+        }
+        return data;
+    }
+
+    void run_prim_case(const PrimCase& prim, S32 runs, const std::vector<U8>& sculpt_map, std::vector<StageResult>& results)
+    {
+        LLVolumeParams params;
+        params.setType(prim.mProfile, prim.mPath);
+        params.setHollow(prim.mHollow);
+        params.setTwistEnd(prim.mTwist);
+        if (prim.mSculptType != LL_SCULPT_TYPE_NONE)
+        {
+            params.setSculptID(LLUUID::generateNewID(), prim.mSculptType);
+        }
+
+        const F32 detail = LLVolumeLODGroup::getVolumeScaleFromDetail(NUM_LODS - 1);
+
+        CaseTimes times(prim.mName);
+        for (S32 run = 0; run < runs; ++run)
+        {
+            LLTimer timer;
+            LLPointer<LLVolume> volume = new LLVolume(params, detail);
+            if (prim.mSculptType != LL_SCULPT_TYPE_NONE)
+            {
+                volume->sculpt(SCULPT_SIZE, SCULPT_SIZE, 3, sculpt_map.data(), 0, false);
+            }
+            times.add(prim.mSculptType != LL_SCULPT_TYPE_NONE ? "sculpt" : "generate",
+                      timer.getElapsedTimeF64().value(), count_triangles(volume));
+
+            time_face_stages(volume, times, true);
+            times.nextRun();
+        }
+        times.appendTo(results);
+    }
+
+    bool load_file(const std::string& filename, std::vector<U8>& data)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !data.empty();
+    }
+
+    // LOD blocks of a mesh asset as offset and size into data
+    struct MeshAsset
+    {
+        std::string mName;
+        std::vector<U8> mData;
+        S64 mOffset[NUM_LODS];
+        S64 mSize[NUM_LODS];
+    };
+
+    bool parse_asset(std::vector<U8>&& data, MeshAsset& asset)
+    {
+        llssize size = data.size();
+        llssize header_size = 0;
+        char* start = strip_deprecated_header((char*)data.data(), size, &header_size);
+
+        LLSD header;
+        {
+            boost::iostreams::stream<boost::iostreams::array_source> stream(start, size);
+            if (!LLSDSerialize::fromBinary(header, stream, size) || !header.isMap())
+            {
+                return false;
+            }
+            header_size += stream.tellg();
+        }
+
+        bool found = false;
+        for (S32 lod = 0; lod < NUM_LODS; ++lod)
+        {
+            const LLSD& block = header[LOD_NAMES[lod]];
+            const S64 offset = block["offset"].asInteger();
+            const S64 block_size = block["size"].asInteger();
+            asset.mOffset[lod] = header_size + offset;
+            asset.mSize[lod] = 0;
+            if (offset >= 0 && block_size > 0 && header_size + offset + block_size <= (S64)data.size())
+            {
+                asset.mSize[lod] = block_size;
+                found = true;
+            }
+        }
+        asset.mData = std::move(data);
+        return found;
+    }
+
+    // A mesh asset, or every model of an .slm, none if it's neither
+    void load_assets(const std::string& filename, std::vector<MeshAsset>& assets)
+    {
+        std::vector<U8> data;
+        if (!load_file(filename, data))
+        {
+            return;
+        }
+
+        // .slm files hold each model in mesh asset form
+        if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".slm") == 0)
+        {
+            LLSD slm;
+            boost::iostreams::stream<boost::iostreams::array_source> stream((const char*)data.data(), data.size());
+            if (!LLSDSerialize::fromBinary(slm, stream, data.size()) || !slm["mesh"].isArray())
+            {
+                return;
+            }
+            S32 index(0);
+            for (const LLSD& model : llsd::inArray(slm["mesh"]))
+            {
+                const std::string& blob = model.asStringRef();
+                MeshAsset asset;
+                asset.mName = llformat("%s#%d", filename.c_str(), index++);
+                if (parse_asset(std::vector<U8>(blob.begin(), blob.end()), asset))
+                {
+                    assets.push_back(std::move(asset));
+                }
+            }
+            return;
+        }
+
+        MeshAsset asset;
+        asset.mName = filename;
+        if (parse_asset(std::move(data), asset))
+        {
+            assets.push_back(std::move(asset));
+        }
+    }
+
+    struct ACMRResult
+    {
+        std::string mAsset;
+        S32 mLOD = 0;
+        S32 mFaces = 0;
+        S32 mTriangles = 0;
+        S32 mVerticesBefore = 0;
+        S32 mVerticesAfter = 0;
+        // ACMR weighted by triangles
+        F64 mACMRBefore = 0.0;
+        F64 mACMRAfter = 0.0;
+    };
+
+    // Triangle weighted ACMR over all faces of volume
+    F64 get_acmr(const LLVolume* volume, U32 cache_size, S32& triangles, S32& vertices)
+    {
+        F64 acmr(0.0);
+        triangles = 0;
+        vertices = 0;
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& face = volume->getVolumeFace(i);
+            const S32 face_triangles = face.mNumIndices / 3;
+            acmr += (F64)LLMeshOptimizer::getVertexCacheACMRU16(face.mIndices, face_triangles * 3,
+                                                               face.mNumVertices, cache_size) * face_triangles;
+            triangles += face_triangles;
+            vertices += face.mNumVertices;
+        }
+        return triangles ? acmr / triangles : 0.0;
+    }
+
+    // All assets make up one run of each LOD.  The first run also measures
+    // the ACMR of each LOD, outside of the stage times.
+    void run_mesh_cases(std::vector<MeshAsset>& assets, S32 runs, U32 cache_size,
+                        std::vector<StageResult>& results, std::vector<ACMRResult>& acmr_results)
+    {
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+
+        for (S32 lod = NUM_LODS - 1; lod >= 0; --lod)
+        {
+            CaseTimes times(std::string("mesh_") + LOD_NAMES[lod]);
+            for (S32 run = 0; run < runs; ++run)
+            {
+                for (MeshAsset& asset : assets)
+                {
+                    if (!asset.mSize[lod])
+                    {
+                        continue;
+                    }
+
+                    LLTimer timer;
+                    LLPointer<LLVolume> volume = new LLVolume(params, 1.f);
+                    if (!volume->unpackVolumeFaces(asset.mData.data() + asset.mOffset[lod], (S32)asset.mSize[lod], false))
+                    {
+                        continue;
+                    }
+                    times.add("unpack", timer.getElapsedTimeF64().value(), count_triangles(volume));
+
+                    ACMRResult acmr;
+                    if (run == 0)
+                    {
+                        acmr.mAsset = asset.mName;
+                        acmr.mLOD = lod;
+                        acmr.mFaces = volume->getNumVolumeFaces();
+                        acmr.mACMRBefore = get_acmr(volume, cache_size, acmr.mTriangles, acmr.mVerticesBefore);
+                    }
+
+                    // What the mesh repository does with every LOD, tangents included
+                    timer.reset();
+                    const bool optimized = volume->cacheOptimize(true);
+                    times.add("optimize", timer.getElapsedTimeF64().value());
+
+                    if (run == 0 && optimized)
+                    {
+                        S32 triangles;
+                        acmr.mACMRAfter = get_acmr(volume, cache_size, triangles, acmr.mVerticesAfter);
+                        acmr_results.push_back(acmr);
+                    }
+
+                    time_face_stages(volume, times, false);
+                }
+                times.nextRun();
+            }
+            times.appendTo(results);
+        }
+    }
+
+    void report(std::ostream& out, const std::vector<StageResult>& results, const std::map<std::string, F64>& baseline)
+    {
+        out << "case                 stage       runs    triangles     mean ms      min ms";
+        out << (baseline.empty() ? "" : "   vs baseline") << std::endl;
+        for (const StageResult& result : results)
+        {
+            out << llformat("%-20s %-10s %5d  %11d  %10.3f  %10.3f", result.mCase.c_str(), result.mStage.c_str(),
+                            (S32)result.mRuns.size(), result.mTriangles, result.getMeanMs(), result.getMinMs());
+            auto base = baseline.find(result.mCase + "," + result.mStage);
+            if (base != baseline.end() && base->second > 0.0)
+            {
+                out << llformat("   %+10.1f%%", (result.getMeanMs() / base->second - 1.0) * 100.0);
+            }
+            out << std::endl;
+        }
+    }
+
+    void report_acmr(std::ostream& out, const std::vector<ACMRResult>& results)
+    {
+        out << "LOD          faces   triangles   vertices before/after   ACMR before   ACMR after" << std::endl;
+        for (S32 lod = 0; lod <= NUM_LODS; ++lod)
+        {
+            // NUM_LODS is the total line
+            ACMRResult sum;
+            F64 acmr_before(0.0), acmr_after(0.0);
+            for (const ACMRResult& result : results)
+            {
+                if (lod != NUM_LODS && result.mLOD != lod)
+                {
+                    continue;
+                }
+                sum.mFaces += result.mFaces;
+                sum.mTriangles += result.mTriangles;
+                sum.mVerticesBefore += result.mVerticesBefore;
+                sum.mVerticesAfter += result.mVerticesAfter;
+                acmr_before += result.mACMRBefore * result.mTriangles;
+                acmr_after += result.mACMRAfter * result.mTriangles;
+            }
+            if (!sum.mTriangles)
+            {
+                continue;
+            }
+            out << llformat("%-11s %6d  %10d  %10d / %-10d  %11.3f  %11.3f",
+                            lod == NUM_LODS ? "total" : LOD_NAMES[lod], sum.mFaces, sum.mTriangles,
+                            sum.mVerticesBefore, sum.mVerticesAfter,
+                            acmr_before / sum.mTriangles, acmr_after / sum.mTriangles)
+                << std::endl;
+        }
+    }
+
+    bool write_acmr_csv(const std::string& filename, const std::vector<ACMRResult>& results)
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            return false;
+        }
+        out << "model,lod,faces,triangles,vertices_before,vertices_after,acmr_before,acmr_after" << std::endl;
+        for (const ACMRResult& result : results)
+        {
+            out << result.mAsset << "," << LOD_NAMES[result.mLOD] << "," << result.mFaces << ","
+                << result.mTriangles << "," << result.mVerticesBefore << "," << result.mVerticesAfter << ","
+                << result.mACMRBefore << "," << result.mACMRAfter << std::endl;
+        }
+        return true;
+    }
+
+    bool write_csv(const std::string& filename, const std::vector<StageResult>& results)
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            return false;
+        }
+        out << "case,stage,runs,triangles,mean_ms,min_ms" << std::endl;
+        for (const StageResult& result : results)
+        {
+            out << result.mCase << "," << result.mStage << "," << result.mRuns.size() << "," << result.mTriangles
+                << "," << result.getMeanMs() << "," << result.getMinMs() << std::endl;
+        }
+        return true;
+    }
+
+    // Mean ms by "case,stage" from a CSV written by write_csv()
+    bool read_baseline(const std::string& filename, std::map<std::string, F64>& baseline)
+    {
+        std::ifstream in(filename);
+        if (!in)
+        {
+            return false;
+        }
+        std::string line;
+        std::getline(in, line); // column names
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields;
+            std::stringstream fields_stream(line);
+            std::string field;
+            while (std::getline(fields_stream, field, ','))
+            {
+                fields.push_back(field);
+            }
+            if (fields.size() >= 5)
+            {
+                baseline[fields[0] + "," + fields[1]] = atof(fields[4].c_str());
+            }
+        }
+        return true;
+    }
+}
+
+static bool parse_count(const char* arg, S32 min_value, S32 max_value, S32& value)
+{
+    char* end(nullptr);
+    const long parsed = strtol(arg, &end, 10);
+    if (*end != '\0' || parsed < min_value || parsed > max_value)
+    {
+        return false;
+    }
+    value = (S32)parsed;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> inputs;
+    std::string csv_file;
+    std::string acmr_file;
+    std::string baseline_file;
+    S32 runs(10);
+    S32 cache_size(16);
+    bool valid(true);
+
+    for (int arg = 1; arg < argc && valid; ++arg)
+    {
+        const std::string name(argv[arg]);
+        const bool has_value = arg + 1 < argc;
+        if (name == "-h" || name == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if ((name == "-r" || name == "--runs") && has_value)
+        {
+            valid = parse_count(argv[++arg], 1, 100000, runs);
+        }
+        else if ((name == "-c" || name == "--cache-size") && has_value)
+        {
+            valid = parse_count(argv[++arg], 3, 1024, cache_size);
+        }
+        else if ((name == "-o" || name == "--output") && has_value)
+        {
+            csv_file = argv[++arg];
+        }
+        else if ((name == "-a" || name == "--acmr") && has_value)
+        {
+            acmr_file = argv[++arg];
+        }
+        else if ((name == "-b" || name == "--baseline") && has_value)
+        {
+            baseline_file = argv[++arg];
+        }
+        else if (name[0] != '-')
+        {
+            inputs.push_back(name);
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, F64> baseline;
+    if (!baseline_file.empty() && !read_baseline(baseline_file, baseline))
+    {
+        std::cerr << "Couldn't read '" << baseline_file << "'" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    for (const std::string& input : inputs)
+    {
+        if (LLFile::isdir(input))
+        {
+            LLDirIterator iter(input, "*");
+            std::string name;
+            while (iter.next(name))
+            {
+                files.push_back(input + "/" + name);
+            }
+        }
+        else
+        {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<MeshAsset> assets;
+    for (const std::string& file : files)
+    {
+        load_assets(file, assets);
+    }
+
+    std::vector<StageResult> results;
+    std::vector<ACMRResult> acmr_results;
+    const std::vector<U8> sculpt_map = make_sculpt_map();
+    for (const PrimCase& prim : PRIM_CASES)
+    {
+        run_prim_case(prim, runs, sculpt_map, results);
+    }
+    if (!assets.empty())
+    {
+        run_mesh_cases(assets, runs, (U32)cache_size, results, acmr_results);
+    }
+
+    std::cout << "Mesh models:  " << assets.size() << "  from " << files.size() << " files" << std::endl;
+    report(std::cout, results, baseline);
+    if (!acmr_results.empty())
+    {
+        std::cout << std::endl;
+        report_acmr(std::cout, acmr_results);
+    }
+
+    if (!csv_file.empty() && !write_csv(csv_file, results))
+    {
+        std::cerr << "Couldn't write '" << csv_file << "'" << std::endl;
+        return 1;
+    }
+    if (!acmr_file.empty() && !write_acmr_csv(acmr_file, acmr_results))
+    {
+        std::cerr << "Couldn't write '" << acmr_file << "'" << std::endl;
+        return 1;
+    }
+    return 0;
+}
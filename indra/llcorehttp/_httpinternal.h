@@ -99,6 +99,18 @@
 
 #define LLCORE_HTTP_READY_QUEUE_IGNORES_PRIORITY        1
 
+// If '1', the transport drives libcurl with curl_multi_socket_action()
+// and the worker thread blocks in epoll on libcurl's sockets, its
+// timers and an eventfd signalled by the request queue.  Otherwise
+// the worker polls curl_multi_perform() with short sleeps.  Only
+// Linux has the event loop implemented at this time.
+
+#if LL_LINUX
+#define LLCORE_HTTP_EVENT_LOOP                          1
+#else
+#define LLCORE_HTTP_EVENT_LOOP                          0
+#endif
+
 
 namespace LLCore
 {
@@ -153,6 +165,16 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 multiplexing limits.  Servers commonly advertise
+// SETTINGS_MAX_CONCURRENT_STREAMS of 100 or more.
+const long HTTP_HTTP2_STREAMS_DEFAULT = 0L;
+const long HTTP_HTTP2_STREAMS_MAX = 100L;
+
+// HTTP/2 stream weights (RFC 7540 5.3.2)
+const int HTTP_STREAM_WEIGHT_MIN = 1;
+const int HTTP_STREAM_WEIGHT_DEFAULT = 16;
+const int HTTP_STREAM_WEIGHT_MAX = 256;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
@@ -163,9 +185,18 @@ const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 // request, ready and active queues.
 const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Upper bound on a single blocking wait for transport activity
+// when using the event loop.  libcurl normally provides a timer
+// well before this; it's only a backstop against lost wakeups.
+const int HTTP_SERVICE_LOOP_WAIT_MAX_MS = 1000;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
+// Largest response body, by Content-Length, that will be received
+// into a single contiguous allocation rather than BufferArray blocks.
+const size_t HTTP_CONTIGUOUS_BODY_MAX = 64U * 1024U * 1024U;
+
 }  // end namespace LLCore
 
 #endif  // _LLCORE_HTTP_INTERNAL_H_
@@ -32,6 +32,14 @@
 #include "_httppolicy.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
+
+#if LLCORE_HTTP_EVENT_LOOP
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 namespace
 {
@@ -65,13 +73,46 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
       mMultiHandles(NULL),
       mActiveHandles(NULL),
       mDirtyPolicy(NULL)
-{}
+#if LLCORE_HTTP_EVENT_LOOP
+      , mClassContexts(NULL),
+      mEpollFd(-1),
+      mWakeupFd(-1)
+#endif
+{
+#if LLCORE_HTTP_EVENT_LOOP
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mWakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mEpollFd < 0 || mWakeupFd < 0)
+    {
+        LL_ERRS(LOG_CORE) << "Failed to create epoll or eventfd descriptors for libcurl transport.  Errno:  "
+                          << errno << LL_ENDL;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = mWakeupFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeupFd, &event);
+#endif
+}
 
 
 HttpLibcurl::~HttpLibcurl()
 {
     shutdown();
 
+#if LLCORE_HTTP_EVENT_LOOP
+    if (mWakeupFd >= 0)
+    {
+        close(mWakeupFd);
+        mWakeupFd = -1;
+    }
+    if (mEpollFd >= 0)
+    {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+#endif
+
     mService = NULL;
 }
 
@@ -105,7 +146,23 @@ void HttpLibcurl::shutdown()
 
         delete [] mDirtyPolicy;
         mDirtyPolicy = NULL;
+
+#if LLCORE_HTTP_EVENT_LOOP
+        delete [] mClassContexts;
+        mClassContexts = NULL;
+#endif
+    }
+
+#if LLCORE_HTTP_EVENT_LOOP
+    // Cleanup of the multi handles will have removed all sockets
+    // but be thorough about what remains in the epoll set.
+    for (socket_map_t::iterator it(mSockets.begin()); mSockets.end() != it; ++it)
+    {
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, it->first, NULL);
     }
+    mSockets.clear();
+    mSocketEvents.clear();
+#endif
 
     mPolicyCount = 0;
 }
@@ -121,6 +178,9 @@ void HttpLibcurl::start(int policy_count)
     mMultiHandles = new CURLM * [mPolicyCount];
     mActiveHandles = new int [mPolicyCount];
     mDirtyPolicy = new bool [mPolicyCount];
+#if LLCORE_HTTP_EVENT_LOOP
+    mClassContexts = new ClassContext [mPolicyCount];
+#endif
 
     for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
     {
@@ -131,6 +191,17 @@ void HttpLibcurl::start(int policy_count)
         }
         mActiveHandles[policy_class] = 0;
         mDirtyPolicy[policy_class] = false;
+#if LLCORE_HTTP_EVENT_LOOP
+        ClassContext & context(mClassContexts[policy_class]);
+        context.mTransport = this;
+        context.mPolicyClass = policy_class;
+        context.mTimerDeadline = 0;
+
+        check_curl_multi_setopt(mMultiHandles[policy_class], CURLMOPT_SOCKETFUNCTION, &HttpLibcurl::socketCallback);
+        check_curl_multi_setopt(mMultiHandles[policy_class], CURLMOPT_SOCKETDATA, static_cast<void *>(&context));
+        check_curl_multi_setopt(mMultiHandles[policy_class], CURLMOPT_TIMERFUNCTION, &HttpLibcurl::timerCallback);
+        check_curl_multi_setopt(mMultiHandles[policy_class], CURLMOPT_TIMERDATA, static_cast<void *>(&context));
+#endif
         policyUpdated(policy_class);
     }
 }
@@ -147,6 +218,11 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
     HttpService::ELoopSpeed ret(HttpService::REQUEST_SLEEP);
 
+#if LLCORE_HTTP_EVENT_LOOP
+    // Let libcurl act on whatever the last wait found ready
+    dispatchSocketActions();
+#endif
+
     // Give libcurl some cycles to do I/O & callbacks
     for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
     {
@@ -166,6 +242,7 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
             continue;
         }
 
+#if ! LLCORE_HTTP_EVENT_LOOP
         int running(0);
         CURLMcode status(CURLM_CALL_MULTI_PERFORM);
         do
@@ -175,6 +252,7 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
             status = curl_multi_perform(mMultiHandles[policy_class], &running);
         }
         while (0 != running && CURLM_CALL_MULTI_PERFORM == status);
+#endif
 
         // Run completion on anything done
         CURLMsg * msg(NULL);
@@ -211,12 +289,195 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
     if (! mActiveOps.empty())
     {
+#if LLCORE_HTTP_EVENT_LOOP
+        // Active requests only need attention when libcurl says so
+        ret = (std::min)(ret, HttpService::TRANSPORT_WAIT);
+#else
         ret = HttpService::NORMAL;
+#endif
     }
     return ret;
 }
 
 
+void HttpLibcurl::waitForActivity(int timeout_ms)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+#if LLCORE_HTTP_EVENT_LOOP
+    // Shorten the wait to the earliest libcurl timer
+    const HttpTime now(totalTime());
+    for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+    {
+        const HttpTime deadline(mClassContexts[policy_class].mTimerDeadline);
+        if (deadline && mActiveHandles[policy_class])
+        {
+            const int timer_ms(deadline > now ? int((deadline - now + 999) / 1000) : 0);
+            timeout_ms = (std::min)(timeout_ms, timer_ms);
+        }
+    }
+    if (! mSocketEvents.empty())
+    {
+        // Undispatched readiness, don't block
+        timeout_ms = 0;
+    }
+
+    static const int EVENT_BATCH_SIZE = 64;
+    struct epoll_event events[EVENT_BATCH_SIZE];
+    const int count(epoll_wait(mEpollFd, events, EVENT_BATCH_SIZE, timeout_ms));
+    for (int i(0); i < count; ++i)
+    {
+        if (events[i].data.fd == mWakeupFd)
+        {
+            // Drain the eventfd counter
+            uint64_t value(0);
+            while (read(mWakeupFd, &value, sizeof(value)) > 0)
+                ;
+            continue;
+        }
+
+        SocketEvent socket_event;
+        socket_event.mSocket = curl_socket_t(events[i].data.fd);
+        socket_event.mAction = 0;
+        if (events[i].events & EPOLLIN)
+        {
+            socket_event.mAction |= CURL_CSELECT_IN;
+        }
+        if (events[i].events & EPOLLOUT)
+        {
+            socket_event.mAction |= CURL_CSELECT_OUT;
+        }
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+            socket_event.mAction |= CURL_CSELECT_ERR;
+        }
+        mSocketEvents.push_back(socket_event);
+    }
+#else
+    ms_sleep((std::min)(timeout_ms, HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+#endif
+}
+
+
+void HttpLibcurl::wakeup()
+{
+#if LLCORE_HTTP_EVENT_LOOP
+    if (mWakeupFd >= 0)
+    {
+        const uint64_t value(1);
+        ssize_t ignored(write(mWakeupFd, &value, sizeof(value)));
+        (void) ignored;
+    }
+#endif
+}
+
+
+#if LLCORE_HTTP_EVENT_LOOP
+
+void HttpLibcurl::dispatchSocketActions()
+{
+    LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("httppt - curl_multi_socket_action");
+
+    // Socket readiness first.  Actions can close sockets so look
+    // each one up again rather than trusting the recorded event.
+    socket_event_list_t socket_events;
+    socket_events.swap(mSocketEvents);
+    for (socket_event_list_t::const_iterator it(socket_events.begin()); socket_events.end() != it; ++it)
+    {
+        socket_map_t::const_iterator found(mSockets.find(it->mSocket));
+        if (mSockets.end() == found)
+        {
+            continue;
+        }
+
+        int running(0);
+        CURLMcode status(curl_multi_socket_action(mMultiHandles[found->second],
+                                                  it->mSocket,
+                                                  it->mAction,
+                                                  &running));
+        check_curl_multi_code(status);
+    }
+
+    // Then expired timers
+    const HttpTime now(totalTime());
+    for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+    {
+        ClassContext & context(mClassContexts[policy_class]);
+        if (! mMultiHandles[policy_class] || ! context.mTimerDeadline || context.mTimerDeadline > now)
+        {
+            continue;
+        }
+
+        // libcurl will re-arm through timerCallback if needed
+        context.mTimerDeadline = 0;
+
+        int running(0);
+        CURLMcode status(curl_multi_socket_action(mMultiHandles[policy_class],
+                                                  CURL_SOCKET_TIMEOUT,
+                                                  0,
+                                                  &running));
+        check_curl_multi_code(status);
+    }
+}
+
+
+int HttpLibcurl::socketCallback(CURL * handle, curl_socket_t sock, int what, void * userp, void * socketp)
+{
+    ClassContext * context(static_cast<ClassContext *>(userp));
+    HttpLibcurl * transport(context->mTransport);
+
+    if (CURL_POLL_REMOVE == what)
+    {
+        epoll_ctl(transport->mEpollFd, EPOLL_CTL_DEL, sock, NULL);
+        transport->mSockets.erase(sock);
+        return 0;
+    }
+
+    struct epoll_event event = {};
+    event.data.fd = sock;
+    if (what & CURL_POLL_IN)
+    {
+        event.events |= EPOLLIN;
+    }
+    if (what & CURL_POLL_OUT)
+    {
+        event.events |= EPOLLOUT;
+    }
+
+    std::pair<socket_map_t::iterator, bool> inserted(transport->mSockets.insert(socket_map_t::value_type(sock, context->mPolicyClass)));
+    if (! inserted.second)
+    {
+        inserted.first->second = context->mPolicyClass;
+    }
+    if (epoll_ctl(transport->mEpollFd, inserted.second ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, sock, &event) < 0)
+    {
+        LL_WARNS(LOG_CORE) << "Unable to register libcurl socket with epoll.  Errno:  "
+                           << errno << LL_ENDL;
+    }
+    return 0;
+}
+
+
+int HttpLibcurl::timerCallback(CURLM * multi_handle, long timeout_ms, void * userp)
+{
+    ClassContext * context(static_cast<ClassContext *>(userp));
+
+    if (timeout_ms < 0)
+    {
+        // Timer deleted
+        context->mTimerDeadline = 0;
+    }
+    else
+    {
+        // Zero is valid and means 'act as soon as possible'.  Keep
+        // the deadline non-zero so that it isn't read as 'no timer'.
+        context->mTimerDeadline = (std::max)(totalTime() + HttpTime(timeout_ms) * 1000, HttpTime(1));
+    }
+    return 0;
+}
+
+#endif  // LLCORE_HTTP_EVENT_LOOP
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -487,7 +748,33 @@ void HttpLibcurl::policyUpdated(int policy_class)
         policy.stallPolicy(policy_class, false);
         mDirtyPolicy[policy_class] = false;
 
-        if (options.mPipelining > 1)
+        if (options.mHttp2Streams > 0)
+        {
+            // HTTP/2 multiplexing.  Libcurl manages connections and
+            // places new streams on existing connections; requests
+            // ask to wait for a multiplexable connection rather than
+            // open new ones (see HttpOpRequest::prepareRequest()).
+            // Stream count is limited by policy, libcurl of this
+            // vintage has no per-connection stream limit option.
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_PIPELINING,
+                                     (options.mPipelining > 1
+                                      ? (CURLPIPE_HTTP1 | CURLPIPE_MULTIPLEX)
+                                      : CURLPIPE_MULTIPLEX));
+            if (options.mPipelining > 1)
+            {
+                check_curl_multi_setopt(multi_handle,
+                                         CURLMOPT_MAX_PIPELINE_LENGTH,
+                                         long(options.mPipelining));
+            }
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_MAX_HOST_CONNECTIONS,
+                                     long(options.mPerHostConnectionLimit));
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                                     long(options.mConnectionLimit));
+        }
+        else if (options.mPipelining > 1)
         {
             // We'll try to do pipelining on this multihandle
             check_curl_multi_setopt(multi_handle,
@@ -32,7 +32,9 @@
 #include <curl/curl.h>
 #include <curl/multi.h>
 
+#include <map>
 #include <set>
+#include <vector>
 
 #include "httprequest.h"
 #include "_httpservice.h"
@@ -75,6 +77,21 @@ class HttpLibcurl
     /// Threading:  called by worker thread.
     HttpService::ELoopSpeed processTransport();
 
+    /// Block the worker until libcurl reports socket activity, a
+    /// libcurl timer expires, wakeup() is called or @timeout_ms
+    /// milliseconds pass.  Socket readiness is recorded and acted
+    /// upon by the next processTransport() call.  Without the event
+    /// loop (see LLCORE_HTTP_EVENT_LOOP), this is a short sleep.
+    ///
+    /// Threading:  called by worker thread.
+    void waitForActivity(int timeout_ms);
+
+    /// Interrupt a waitForActivity() call in progress or make
+    /// the next one return immediately.
+    ///
+    /// Threading:  callable by any thread.
+    void wakeup();
+
     /// Add request to the active list.  Caller is expected to have
     /// provided us with a reference count on the op to hold the
     /// request.  (No additional references will be added.)
@@ -150,9 +167,40 @@ class HttpLibcurl
     /// and destroy.
     void cancelRequest(const opReqPtr_t &op);
 
+#if LLCORE_HTTP_EVENT_LOOP
+    /// libcurl CURLMOPT_SOCKETFUNCTION and CURLMOPT_TIMERFUNCTION
+    /// callbacks.  @userp is the ClassContext of the multi handle.
+    static int socketCallback(CURL * handle, curl_socket_t sock, int what, void * userp, void * socketp);
+    static int timerCallback(CURLM * multi_handle, long timeout_ms, void * userp);
+
+    /// Run curl_multi_socket_action() for sockets found ready
+    /// by waitForActivity() and for expired libcurl timers.
+    void dispatchSocketActions();
+#endif
+
 protected:
     typedef std::set<opReqPtr_t> active_set_t;
 
+#if LLCORE_HTTP_EVENT_LOOP
+    // Per-policy-class data handed to libcurl callbacks
+    struct ClassContext
+    {
+        HttpLibcurl *   mTransport;
+        int             mPolicyClass;
+        HttpTime        mTimerDeadline;     // Absolute time of libcurl timeout, 0 if none
+    };
+
+    // Ready socket recorded by waitForActivity()
+    struct SocketEvent
+    {
+        curl_socket_t   mSocket;
+        int             mAction;            // CURL_CSELECT_* bits
+    };
+
+    typedef std::map<curl_socket_t, int> socket_map_t;     // Socket -> policy class
+    typedef std::vector<SocketEvent> socket_event_list_t;
+#endif
+
     /// Simple request handle cache for libcurl.
     ///
     /// Handle creation is somewhat slow and chunky in libcurl and there's
@@ -213,6 +261,13 @@ class HttpLibcurl
     CURLM **            mMultiHandles;      // One handle per policy class
     int *               mActiveHandles;     // Active count per policy class
     bool *              mDirtyPolicy;       // Dirty policy update waiting for stall (per pc)
+#if LLCORE_HTTP_EVENT_LOOP
+    ClassContext *      mClassContexts;     // Callback context (per pc)
+    socket_map_t        mSockets;           // Sockets libcurl asked us to watch
+    socket_event_list_t mSocketEvents;      // Readiness waiting for dispatch
+    int                 mEpollFd;
+    int                 mWakeupFd;          // eventfd, written by wakeup()
+#endif
 
 }; // end class HttpLibcurl
 
@@ -562,6 +562,21 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 
     check_curl_easy_setopt(mCurlHandle, CURLOPT_NOBODY, nobody);
 
+    if (cpolicy.mHttp2Streams > 0L)
+    {
+        // Negotiate h2 via ALPN on https: URLs, plain HTTP/1.1 otherwise.
+        // Prefer waiting for a multiplexable connection over opening
+        // another one and weight the stream by the request's priority.
+        long stream_weight(HTTP_STREAM_WEIGHT_DEFAULT);
+        if (mReqOptions)
+        {
+            stream_weight = mReqOptions->getStreamWeight();
+        }
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_STREAM_WEIGHT, stream_weight);
+    }
+
     // The Linksys WRT54G V5 router has an issue with frequent
     // DNS lookups from LAN machines.  If they happen too often,
     // like for every HTTP request, the router gets annoyed after
@@ -791,6 +806,17 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
     if (! op->mReplyBody)
     {
         op->mReplyBody = new BufferArray();
+
+        // Headers are complete by the first body write.  If the
+        // server told us the length, collect the body into a single
+        // block that consumers can use in place or take over.
+        double content_length(-1.0);
+        if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &content_length)
+            && content_length > 0.0
+            && content_length <= double(HTTP_CONTIGUOUS_BODY_MAX))
+        {
+            op->mReplyBody->reserveContiguous(size_t(content_length));
+        }
     }
     const size_t req_size(size * nmemb);
     const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
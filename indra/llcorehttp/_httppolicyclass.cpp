@@ -37,7 +37,8 @@ HttpPolicyClass::HttpPolicyClass()
     : mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
       mPerHostConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
       mPipelining(HTTP_PIPELINING_DEFAULT),
-      mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT)
+      mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT),
+      mHttp2Streams(HTTP_HTTP2_STREAMS_DEFAULT)
 {}
 
 
@@ -61,6 +62,10 @@ HttpStatus HttpPolicyClass::set(HttpRequest::EPolicyOption opt, long value)
         mThrottleRate = llclamp(value, 0L, 1000000L);
         break;
 
+    case HttpRequest::PO_HTTP2_STREAM_LIMIT:
+        mHttp2Streams = llclamp(value, 0L, HTTP_HTTP2_STREAMS_MAX);
+        break;
+
     default:
         return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
     }
@@ -89,6 +94,10 @@ HttpStatus HttpPolicyClass::get(HttpRequest::EPolicyOption opt, long * value) co
         *value = mThrottleRate;
         break;
 
+    case HttpRequest::PO_HTTP2_STREAM_LIMIT:
+        *value = mHttp2Streams;
+        break;
+
     default:
         return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
     }
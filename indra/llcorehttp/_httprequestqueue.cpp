@@ -83,6 +83,10 @@ HttpStatus HttpRequestQueue::addOp(const HttpRequestQueue::opPtr_t &op, bool log
         if (loggable && sMessageLogFunc != nullptr ) { sMessageLogFunc(op); }
         wake = mQueue.empty();
         mQueue.push_back(op);
+        if (wake && mWakeupFunc)
+        {
+            mWakeupFunc();
+        }
     }
     if (wake)
     {
@@ -144,11 +148,23 @@ void HttpRequestQueue::wakeAll()
 }
 
 
+void HttpRequestQueue::setWakeupFunc(std::function<void()> func)
+{
+    HttpScopedLock lock(mQueueMutex);
+
+    mWakeupFunc = func;
+}
+
+
 bool HttpRequestQueue::stopQueue()
 {
     {
         HttpScopedLock lock(mQueueMutex);
 
+        if (mWakeupFunc)
+        {
+            mWakeupFunc();
+        }
         if (!mQueueStopped)
         {
             mQueueStopped = true;
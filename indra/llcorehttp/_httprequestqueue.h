@@ -28,6 +28,7 @@
 #define _LLCORE_HTTP_REQUEST_QUEUE_H_
 
 
+#include <functional>
 #include <vector>
 
 #include "httpcommon.h"
@@ -126,6 +127,15 @@ class HttpRequestQueue final : public LLCoreInt::RefCounted
     /// Threading:  callable by any thread.
     bool stopQueue();
 
+    /// Install a function to be invoked, with the queue lock held,
+    /// whenever an operation is queued or the queue is stopped.
+    /// Used by the service to interrupt a worker thread that is
+    /// blocked on something other than this queue's condition
+    /// variable.  Pass an empty function to remove.
+    ///
+    /// Threading:  callable by any thread.
+    void setWakeupFunc(std::function<void()> func);
+
     static void setMessageLogFunc(std::function<void(const HttpRequestQueue::opPtr_t &)> func) { sMessageLogFunc = func;}
 
 protected:
@@ -137,6 +147,7 @@ class HttpRequestQueue final : public LLCoreInt::RefCounted
     LLCoreInt::HttpMutex                mQueueMutex;
     LLCoreInt::HttpConditionVariable    mQueueCV;
     bool                                mQueueStopped;
+    std::function<void()>               mWakeupFunc;
 
 }; // end class HttpRequestQueue
 
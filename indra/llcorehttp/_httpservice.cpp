@@ -64,7 +64,8 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
     {   true,       true,       false,      true,       false   },      // PO_ENABLE_PIPELINING
     {   true,       true,       false,      true,       false   },      // PO_THROTTLE_RATE
     {   false,      false,      true,       false,      true    },      // PO_SSL_VERIFY_CALLBACK
-    {   false,      false,      true,       false,      false   }       // PO_USER_AGENT
+    {   false,      false,      true,       false,      false   },      // PO_USER_AGENT
+    {   true,       true,       false,      true,       false   }       // PO_HTTP2_STREAM_LIMIT
 };
 HttpService * HttpService::sInstance(NULL);
 volatile HttpService::EState HttpService::sState(NOT_INITIALIZED);
@@ -105,6 +106,7 @@ HttpService::~HttpService()
 
     if (mRequestQueue)
     {
+        mRequestQueue->setWakeupFunc(nullptr);
         mRequestQueue->release();
         mRequestQueue = NULL;
     }
@@ -128,6 +130,10 @@ void HttpService::init(HttpRequestQueue * queue)
     sInstance->mRequestQueue = queue;
     sInstance->mPolicy = new HttpPolicy(sInstance);
     sInstance->mTransport = new HttpLibcurl(sInstance);
+
+    // New requests must interrupt a transport wait on the worker thread
+    HttpLibcurl * transport(sInstance->mTransport);
+    queue->setWakeupFunc([transport]() { transport->wakeup(); });
     sState = INITIALIZED;
 }
 
@@ -288,10 +294,17 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
             new_loop = mTransport->processTransport();
             loop = (std::min)(loop, new_loop);
 
-            // Determine whether to spin, sleep briefly or sleep for next request
-            if (REQUEST_SLEEP != loop)
+            // Determine whether to spin, sleep briefly, wait on the
+            // transport or sleep for next request.  Transport waits
+            // are ended early by socket activity, libcurl timers or
+            // a write to the request queue.
+            if (NORMAL == loop)
+            {
+                mTransport->waitForActivity(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+            }
+            else if (TRANSPORT_WAIT == loop)
             {
-                ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+                mTransport->waitForActivity(HTTP_SERVICE_LOOP_WAIT_MAX_MS);
             }
         }
         catch (const LLContinueError&)
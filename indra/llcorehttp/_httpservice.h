@@ -105,6 +105,7 @@ class HttpService
     enum ELoopSpeed
     {
         NORMAL,                 ///< continuous polling of request, ready, active queues
+        TRANSPORT_WAIT,         ///< can block waiting for transport activity or request queue write
         REQUEST_SLEEP           ///< can sleep indefinitely waiting for request queue write
     };
 
@@ -59,6 +59,7 @@ class BufferArray::Block
 
 protected:
     Block(size_t len);
+    Block(char * external, size_t len);
 
     Block(const Block &);                       // Not defined
     void operator=(const Block &);              // Not defined
@@ -68,17 +69,27 @@ class BufferArray::Block
     void * operator new(size_t len, size_t addl_len);
 
 public:
-    // Only public entry to get a block.
+    // Only public entries to get a block.
     static Block * alloc(size_t len);
 
+    // Block whose data lives in a separate 16-byte aligned
+    // allocation which can later be handed off by detach().
+    static Block * allocExternal(size_t len);
+
+    // Give up ownership of external data.  Returns NULL for
+    // blocks with inline data.
+    char * detach();
+
 public:
     size_t mUsed;
     size_t mAlloced;
+    char * mData;               // Points at mStorage or external allocation
+    bool mExternal;
 
     // *NOTE:  Must be last member of the object.  We'll
     // overallocate as requested via operator new and index
     // into the array at will.
-    char mData[1];
+    char mStorage[1];
 };
 
 
@@ -184,6 +195,63 @@ void * BufferArray::appendBufferAlloc(size_t len)
 }
 
 
+bool BufferArray::reserveContiguous(size_t len)
+{
+    if (! mBlocks.empty() || 0 == len)
+    {
+        return false;
+    }
+
+    Block * block(Block::allocExternal(len));
+    if (! block)
+    {
+        return false;
+    }
+    mBlocks.push_back(block);
+    return true;
+}
+
+
+char * BufferArray::contiguousData()
+{
+    // Reserved or spilled blocks may be empty, look for the
+    // one block actually holding data.
+    char * result(NULL);
+    for (container_t::iterator it(mBlocks.begin()); mBlocks.end() != it; ++it)
+    {
+        if ((*it)->mUsed)
+        {
+            if (result)
+            {
+                return NULL;
+            }
+            result = (*it)->mData;
+        }
+    }
+    return result;
+}
+
+
+char * BufferArray::detachContiguous(size_t * len)
+{
+    *len = 0;
+    if (mBlocks.empty() || ! mBlocks.front()->mExternal || mBlocks.front()->mUsed != mLen)
+    {
+        return NULL;
+    }
+
+    char * result(mBlocks.front()->detach());
+    *len = mLen;
+    for (container_t::iterator it(mBlocks.begin()); it != mBlocks.end(); ++it)
+    {
+        delete *it;
+    }
+    mBlocks.clear();
+    mLen = 0;
+    return result;
+}
+
+
 size_t BufferArray::read(size_t pos, void * dst, size_t len)
 {
     char * c_dst(static_cast<char *>(dst));
@@ -325,14 +393,29 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 
 BufferArray::Block::Block(size_t len)
     : mUsed(0),
-      mAlloced(len)
+      mAlloced(len),
+      mData(mStorage),
+      mExternal(false)
 {
     memset(mData, 0, len);
 }
 
 
+BufferArray::Block::Block(char * external, size_t len)
+    : mUsed(0),
+      mAlloced(len),
+      mData(external),
+      mExternal(true)
+{}
+
+
 BufferArray::Block::~Block()
 {
+    if (mExternal && mData)
+    {
+        ll_aligned_free_16(mData);
+    }
+    mData = NULL;
     mUsed = 0;
     mAlloced = 0;
 }
@@ -365,4 +448,31 @@ BufferArray::Block * BufferArray::Block::alloc(size_t len)
 }
 
 
+BufferArray::Block * BufferArray::Block::allocExternal(size_t len)
+{
+    char * data(static_cast<char *>(ll_aligned_malloc_16(len)));
+    if (! data)
+    {
+        return NULL;
+    }
+    Block * block = new (0) Block(data, len);
+    return block;
+}
+
+
+char * BufferArray::Block::detach()
+{
+    if (! mExternal)
+    {
+        return NULL;
+    }
+    char * result(mData);
+    mData = NULL;
+    mExternal = false;
+    mUsed = 0;
+    mAlloced = 0;
+    return result;
+}
+
+
 }  // end namespace LLCore
@@ -59,6 +59,12 @@ class BufferArrayStreamBuf;
 /// write and append operations and beyond which the current position
 /// cannot be set.
 ///
+/// When the final size is known in advance (e.g. from a Content-Length
+/// header), reserveContiguous() arranges for the data to land in one
+/// aligned allocation.  Consumers can then read it in place with
+/// contiguousData() or take ownership of it with detachContiguous()
+/// instead of copying the body out with read().
+///
 /// Threading:  not thread-safe
 ///
 /// Allocation:  Refcounted, heap only.  Caller of the constructor
@@ -121,6 +127,36 @@ class BufferArray final : public LLCoreInt::RefCounted
     /// size of the instance or do a mix of both.
     size_t write(size_t pos, const void * src, size_t len);
 
+    /// Prepare an empty instance to receive 'len' bytes in
+    /// a single contiguous, 16-byte aligned allocation.  Appends
+    /// fill this block first and spill into ordinary blocks
+    /// should more data arrive than was reserved.
+    ///
+    /// @return         True if the block was reserved.  False
+    ///                 if the instance isn't empty or allocation
+    ///                 failed, in which case behavior is unchanged.
+    bool reserveContiguous(size_t len);
+
+    /// If all data in the instance is held in a single block,
+    /// returns a pointer to it for in-place use.  Pointer is
+    /// valid until the next modifying call or release.
+    ///
+    /// @return         Pointer to first byte of data or NULL
+    ///                 if the instance is empty or fragmented.
+    char * contiguousData();
+
+    /// Transfer ownership of a reserved contiguous block to
+    /// the caller, leaving the instance empty.  Only possible
+    /// when the data is held entirely in a block obtained
+    /// with reserveContiguous().  Memory must be released with
+    /// ll_aligned_free_16() and is suitable for handing to
+    /// LLImageBase::setData().
+    ///
+    /// @return         Pointer to data or NULL if the data
+    ///                 isn't held in a detachable block.
+    ///                 'len' receives the data length.
+    char * detachContiguous(size_t * len);
+
 protected:
     int findBlock(size_t pos, size_t * ret_offset);
 
@@ -47,7 +47,8 @@ HttpOptions::HttpOptions() :
     mVerifyPeer(sDefaultVerifyPeer),
     mVerifyHost(false),
     mDNSCacheTimeout(-1L),
-    mNoBody(false)
+    mNoBody(false),
+    mStreamWeight(HTTP_STREAM_WEIGHT_DEFAULT)
 {}
 
 
@@ -125,6 +126,11 @@ void HttpOptions::setHeadersOnly(bool nobody)
     }
 }
 
+void HttpOptions::setStreamWeight(int weight)
+{
+    mStreamWeight = llclamp(weight, HTTP_STREAM_WEIGHT_MIN, HTTP_STREAM_WEIGHT_MAX);
+}
+
 void HttpOptions::setDefaultSSLVerifyPeer(bool verify)
 {
     sDefaultVerifyPeer = verify;
@@ -175,6 +175,17 @@ class HttpOptions : private boost::noncopyable
         return mNoBody;
     }
 
+    /// Relative weight of the request when it is carried as an
+    /// HTTP/2 stream (see HttpRequest::PO_HTTP2_STREAM_LIMIT).  Streams
+    /// sharing a connection receive bandwidth in proportion to their
+    /// weights.  Clamped to [1, 256], ignored for HTTP/1.x requests.
+    /// Default: 16
+    void                setStreamWeight(int weight);
+    int                 getStreamWeight() const
+    {
+        return mStreamWeight;
+    }
+
     /// Sets default behavior for verifying that the name in the
     /// security certificate matches the name of the host contacted.
     /// Defaults false if not set, but should be set according to
@@ -196,6 +207,7 @@ class HttpOptions : private boost::noncopyable
     bool                mVerifyHost;
     int                 mDNSCacheTimeout;
     bool                mNoBody;
+    int                 mStreamWeight;
 
     static bool         sDefaultVerifyPeer;
 }; // end class HttpOptions
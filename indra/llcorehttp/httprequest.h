@@ -236,6 +236,20 @@ class HttpRequest
         /// Global only
         PO_USER_AGENT,
 
+        /// If greater than 0, requests in the class negotiate HTTP/2
+        /// over TLS and are multiplexed as streams on shared
+        /// connections.  Value gives the maximum number of concurrent
+        /// streams on a connection.  Connections are then managed by
+        /// libcurl and the in-flight request limit becomes
+        /// PO_PER_HOST_CONNECTION_LIMIT times this value, replacing
+        /// both PO_CONNECTION_LIMIT and PO_PIPELINING_DEPTH as the
+        /// concurrency control.  Servers that don't offer h2 fall
+        /// back to HTTP/1.1 on the same connection limits.  A value
+        /// of zero, the default, disables HTTP/2.
+        ///
+        /// Per-class only
+        PO_HTTP2_STREAM_LIMIT,
+
         PO_LAST  // Always at end
     };
 
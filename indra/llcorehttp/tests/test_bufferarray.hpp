@@ -27,6 +27,7 @@
 #define TEST_LLCORE_BUFFER_ARRAY_H_
 
 #include "bufferarray.h"
+#include "llmemory.h"
 
 #include <iostream>
 
@@ -374,6 +375,57 @@ void BufferArrayTestObjectType::test<8>()
     ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+    set_test_name("BufferArray contiguous reservation and detach");
+
+    // create a new ref counted object with an implicit reference
+    BufferArray * ba = new BufferArray();
+
+    char str1[] = "abcdefghij";
+    size_t str1_len(strlen(str1));
+
+    ensure("Empty instance has no contiguous data", NULL == ba->contiguousData());
+    ensure("Reservation on empty instance", ba->reserveContiguous(2 * str1_len));
+    ensure("Second reservation refused", ! ba->reserveContiguous(2 * str1_len));
+
+    // Fill the reservation in two appends
+    size_t len = ba->append(str1, str1_len);
+    len += ba->append(str1, str1_len);
+    ensure("Appended length correct", (2 * str1_len) == len);
+
+    char * data(ba->contiguousData());
+    ensure("Contiguous data available", NULL != data);
+    ensure("Contiguous content correct.1", 0 == strncmp(data, str1, str1_len));
+    ensure("Contiguous content correct.2", 0 == strncmp(data + str1_len, str1, str1_len));
+
+    size_t detached_len(0);
+    char * detached(ba->detachContiguous(&detached_len));
+    ensure("Detached block", detached == data);
+    ensure("Detached length correct", (2 * str1_len) == detached_len);
+    ensure("Instance empty after detach", 0 == ba->size());
+    ll_aligned_free_16(detached);
+
+    // Overrun spills into ordinary blocks and can't be detached
+    ensure("Reservation after detach", ba->reserveContiguous(str1_len));
+    len = ba->append(str1, str1_len);
+    len += ba->append(str1, str1_len);
+    ensure("Spilled length correct", (2 * str1_len) == ba->size());
+    ensure("Spilled data not contiguous", NULL == ba->contiguousData());
+    ensure("Spilled data not detachable", NULL == ba->detachContiguous(&detached_len));
+
+    char buffer[256];
+    memset(buffer, 'X', sizeof(buffer));
+    len = ba->read(0, buffer, sizeof(buffer));
+    ensure("Spilled read length correct", (2 * str1_len) == len);
+    ensure("Spilled content correct.1", 0 == strncmp(buffer, str1, str1_len));
+    ensure("Spilled content correct.2", 0 == strncmp(buffer + str1_len, str1, str1_len));
+
+    // release the implicit reference, causing the object to be released
+    ba->release();
+}
+
 }  // end namespace tut
 
 
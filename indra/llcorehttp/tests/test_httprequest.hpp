@@ -3012,6 +3012,137 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+    ScopedCurlInit ready;
+
+    set_test_name("HttpRequest concurrent GETs on HTTP/2 multiplexed policy class");
+
+    // The test peer speaks plain HTTP/1.1 so this exercises the
+    // stream-limited policy and libcurl's fallback from h2
+    // negotiation.  Against an h2-capable server the same requests
+    // share a single connection.  Elapsed time is reported so the
+    // two transports can be compared.
+
+    // Handler can be stack-allocated *if* there are no dangling
+    // references to it after completion of this method.
+    TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+    std::string url_base(get_base_url());
+    mHandlerCalls = 0;
+
+    HttpRequest * req = NULL;
+    HttpOptions::ptr_t opts;
+
+    try
+    {
+        // Get singletons created
+        HttpRequest::createService();
+
+        // Stream limited class, one connection per host
+        HttpRequest::policy_t policy_class(HttpRequest::createPolicyClass());
+        long value(0);
+        HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                             policy_class,
+                                                             16,
+                                                             &value));
+        ensure("HTTP/2 stream limit accepted", bool(status));
+        ensure("HTTP/2 stream limit read back", 16 == value);
+        status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+                                                    policy_class,
+                                                    1,
+                                                    NULL);
+        ensure("Per-host limit accepted", bool(status));
+
+        status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                    HttpRequest::GLOBAL_POLICY_ID,
+                                                    16,
+                                                    NULL);
+        ensure("HTTP/2 stream limit is not a global option", ! status);
+
+        // Start threading early so that thread memory is invariant
+        // over the test.
+        HttpRequest::startThread();
+
+        // create a new ref counted object with an implicit reference
+        req = new HttpRequest();
+
+        opts = HttpOptions::ptr_t(new HttpOptions());
+        opts->setStreamWeight(1000);
+        ensure("Stream weight clamped", 256 == opts->getStreamWeight());
+
+        // Issue a burst of GETs
+        mStatus = HttpStatus(200);
+        const int url_limit(32);
+        for (int i(0); i < url_limit; ++i)
+        {
+            HttpHandle handle = req->requestGet(policy_class,
+                                                url_base,
+                                                opts,
+                                                HttpHeaders::ptr_t(),
+                                                handlerp);
+            ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+        }
+
+        // Run the notification pump.
+        int count(0);
+        int limit(LOOP_COUNT_LONG);
+        while (count++ < limit && mHandlerCalls < url_limit)
+        {
+            req->update(0);
+            usleep(LOOP_SLEEP_INTERVAL / 10);
+        }
+        ensure("Requests executed in reasonable time", count < limit);
+        ensure("One handler invocation per request", mHandlerCalls == url_limit);
+
+        // Okay, request a shutdown of the servicing thread
+        mStatus = HttpStatus();
+        mHandlerCalls = 0;
+        HttpHandle handle = req->requestStopThread(handlerp);
+        ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+        // Run the notification pump again
+        count = 0;
+        limit = LOOP_COUNT_LONG;
+        while (count++ < limit && mHandlerCalls < 1)
+        {
+            req->update(1000000);
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Second request executed in reasonable time", count < limit);
+        ensure("Second handler invocation", mHandlerCalls == 1);
+
+        // See that we actually shutdown the thread
+        count = 0;
+        limit = LOOP_COUNT_SHORT;
+        while (count++ < limit && ! HttpService::isStopped())
+        {
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Thread actually stopped running", HttpService::isStopped());
+
+        // release options
+        opts.reset();
+
+        // release the request object
+        delete req;
+        req = NULL;
+
+        // Shut down service
+        HttpRequest::destroyService();
+    }
+    catch (...)
+    {
+        stop_thread(req);
+        opts.reset();
+        delete req;
+        HttpRequest::destroyService();
+        throw;
+    }
+}
+
+
 }  // end namespace tut
 
 namespace
@@ -151,6 +151,43 @@ void HttpRequestqueueTestObjectType::test<4>()
     }
 }
 
+template <> template <>
+void HttpRequestqueueTestObjectType::test<5>()
+{
+    set_test_name("HttpRequestQueue wakeup function");
+
+    // create a new ref counted object with an implicit reference
+    HttpRequestQueue::init();
+
+    HttpRequestQueue * rq = HttpRequestQueue::instanceOf();
+
+    int wakeups(0);
+    rq->setWakeupFunc([&wakeups]() { ++wakeups; });
+
+    HttpOperation::ptr_t op(new HttpOpNull());
+    rq->addOp(op);      // transfer my refcount
+    ensure("Wakeup on first queued op", 1 == wakeups);
+
+    op.reset(new HttpOpNull());
+    rq->addOp(op);      // transfer my refcount
+    ensure("No wakeup when queue already non-empty", 1 == wakeups);
+
+    {
+        HttpRequestQueue::OpContainer ops;
+        rq->fetchAll(false, ops);
+        ensure("Two go in, two come out", 2 == ops.size());
+    }
+    op.reset();
+
+    rq->stopQueue();
+    ensure("Wakeup on queue stop", 2 == wakeups);
+
+    rq->setWakeupFunc(nullptr);
+
+    // release the singleton, hold on to the object
+    HttpRequestQueue::term();
+}
+
 }  // end namespace tut
 
 
@@ -28,6 +28,7 @@
 
 #include "llimageworker.h"
 #include "llimage.h"
+#include "llimagedatapool.h"
 
 #include "llmath.h"
 #include "v4coloru.h"
@@ -40,549 +41,11 @@
 #include "llimagepng.h"
 #include "llimagewebp.h"
 #include "llimagedxt.h"
+#include "llimageresample.h"
 #include "llmemory.h"
 
-#include <boost/preprocessor.hpp>
-
 #include <array>
 
-//..................................................................................
-//..................................................................................
-// Helper macrose's for generate cycle unwrap templates
-//..................................................................................
-#define _UNROL_GEN_TPL_arg_0(arg)
-#define _UNROL_GEN_TPL_arg_1(arg) arg
-
-#define _UNROL_GEN_TPL_comma_0
-#define _UNROL_GEN_TPL_comma_1 BOOST_PP_COMMA()
-//..................................................................................
-#define _UNROL_GEN_TPL_ARGS_macro(z,n,seq) \
-    BOOST_PP_CAT(_UNROL_GEN_TPL_arg_, BOOST_PP_MOD(n, 2))(BOOST_PP_SEQ_ELEM(n, seq)) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
-
-#define _UNROL_GEN_TPL_ARGS(seq) \
-    BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_ARGS_macro, seq)
-//..................................................................................
-
-#define _UNROL_GEN_TPL_TYPE_ARGS_macro(z,n,seq) \
-    BOOST_PP_SEQ_ELEM(n, seq) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
-
-#define _UNROL_GEN_TPL_TYPE_ARGS(seq) \
-    BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_TYPE_ARGS_macro, seq)
-//..................................................................................
-#define _UNROLL_GEN_TPL_foreach_ee(z, n, seq) \
-    executor<n>(_UNROL_GEN_TPL_ARGS(seq));
-
-#define _UNROLL_GEN_TPL(name, args_seq, operation, spec) \
-    template<> struct name<spec> { \
-    private: \
-        template<S32 _idx> inline void executor(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
-            BOOST_PP_SEQ_ENUM(operation) ; \
-        } \
-    public: \
-        inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
-            BOOST_PP_REPEAT(spec, _UNROLL_GEN_TPL_foreach_ee, args_seq) \
-        } \
-};
-//..................................................................................
-#define _UNROLL_GEN_TPL_foreach_seq_macro(r, data, elem) \
-    _UNROLL_GEN_TPL(BOOST_PP_SEQ_ELEM(0, data), BOOST_PP_SEQ_ELEM(1, data), BOOST_PP_SEQ_ELEM(2, data), elem)
-
-#define UNROLL_GEN_TPL(name, args_seq, operation, spec_seq) \
-    /*general specialization - should not be implemented!*/ \
-    template<U8> struct name { inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { /*static_assert(!"Should not be instantiated.");*/  } }; \
-    BOOST_PP_SEQ_FOR_EACH(_UNROLL_GEN_TPL_foreach_seq_macro, (name)(args_seq)(operation), spec_seq)
-//..................................................................................
-//..................................................................................
-
-
-//..................................................................................
-// Generated unrolling loop templates with specializations
-//..................................................................................
-//example: for(c = 0; c < ch; ++c) comp[c] = cx[0] = 0;
-UNROLL_GEN_TPL(uroll_zeroze_cx_comp, (S32 *)(cx)(S32 *)(comp), (cx[_idx] = comp[_idx] = 0), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] >>= 4;
-UNROLL_GEN_TPL(uroll_comp_rshftasgn_constval, (S32 *)(comp)(const S32)(cval), (comp[_idx] >>= cval), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
-UNROLL_GEN_TPL(uroll_comp_asgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] = (cx[_idx] >> cval) * val), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
-UNROLL_GEN_TPL(uroll_comp_plusasgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] += (cx[_idx] >> cval) * val), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
-UNROLL_GEN_TPL(uroll_inp_plusasgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] += pix[_idx] * val), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
-UNROLL_GEN_TPL(uroll_inp_asgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] = pix[_idx] * val), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
-UNROLL_GEN_TPL(uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r, (S32 *)(comp)(S32 *)(cx)(S32)(apoint), (comp[_idx] = ((cx[_idx] * apoint) + (comp[_idx] * (256 - apoint))) >> 16), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
-UNROLL_GEN_TPL(uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r, (S32 *)(comp)(const U8 *)(pix)(S32)(apoint), (comp[_idx] = (comp[_idx] + pix[_idx] * apoint) >> 8), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
-UNROLL_GEN_TPL(uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r, (S32 *)(comp)(S32)(apoint)(S32 *)(cx), (comp[_idx] = ((comp[_idx] * (256-apoint)) + (cx[_idx] * apoint)) >> 12), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) *dptr++ = comp[c]&0xff;
-UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_and_ff, (U8 *&)(dptr)(S32 *)(comp), (*dptr++ = comp[_idx]&0xff), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
-UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff, (U8 *&)(dptr)(const U8 *)(sptr)(S32)(apoint), (*dptr++ = sptr[apoint + _idx]&0xff), (1)(3)(4));
-//example: for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
-UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff, (U8 *&)(dptr)(S32 *)(comp)(const S32)(cval), (*dptr++ = (comp[_idx]>>cval)&0xff), (1)(3)(4));
-//..................................................................................
-
-
-template<U8 ch>
-struct scale_info
-{
-public:
-    std::vector<S32> xpoints;
-    std::vector<const U8*> ystrides;
-    std::vector<S32> xapoints, yapoints;
-    S32 xup_yup;
-
-public:
-    //unrolling loop types declaration
-    typedef uroll_zeroze_cx_comp<ch>                                                        uroll_zeroze_cx_comp_t;
-    typedef uroll_comp_rshftasgn_constval<ch>                                               uroll_comp_rshftasgn_constval_t;
-    typedef uroll_comp_asgn_cx_rshft_cval_all_mul_val<ch>                                   uroll_comp_asgn_cx_rshft_cval_all_mul_val_t;
-    typedef uroll_comp_plusasgn_cx_rshft_cval_all_mul_val<ch>                               uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t;
-    typedef uroll_inp_plusasgn_pix_mul_val<ch>                                              uroll_inp_plusasgn_pix_mul_val_t;
-    typedef uroll_inp_asgn_pix_mul_val<ch>                                                  uroll_inp_asgn_pix_mul_val_t;
-    typedef uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r<ch>      uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t;
-    typedef uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r<ch>                     uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t;
-    typedef uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r<ch>      uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t;
-    typedef uroll_uref_dptr_inc_asgn_comp_and_ff<ch>                                        uroll_uref_dptr_inc_asgn_comp_and_ff_t;
-    typedef uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff<ch>                     uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t;
-    typedef uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff<ch>                             uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t;
-
-public:
-    scale_info(const U8 *src, U32 srcW, U32 srcH, U32 dstW, U32 dstH, U32 srcStride)
-        : xup_yup((dstW >= srcW) + ((dstH >= srcH) << 1))
-    {
-        calc_x_points(srcW, dstW);
-        calc_y_strides(src, srcStride, srcH, dstH);
-        calc_aa_points(srcW, dstW, xup_yup&1, xapoints);
-        calc_aa_points(srcH, dstH, xup_yup&2, yapoints);
-    }
-
-private:
-    //...........................................................................................
-    void calc_x_points(U32 srcW, U32 dstW)
-    {
-        xpoints.resize(dstW+1);
-
-        S32 val = dstW >= srcW ? 0x8000 * srcW / dstW - 0x8000 : 0;
-        S32 inc = (srcW << 16) / dstW;
-
-        for(U32 i = 0, j = 0; i < dstW; ++i, ++j, val += inc)
-        {
-            xpoints[j] = llmax(0, val >> 16);
-        }
-    }
-    //...........................................................................................
-    void calc_y_strides(const U8 *src, U32 srcStride, U32 srcH, U32 dstH)
-    {
-        ystrides.resize(dstH+1);
-
-        S32 val = dstH >= srcH ? 0x8000 * srcH / dstH - 0x8000 : 0;
-        S32 inc = (srcH << 16) / dstH;
-
-        for(U32 i = 0, j = 0; i < dstH; ++i, ++j, val += inc)
-        {
-            ystrides[j] = src + llmax(0, val >> 16) * srcStride;
-        }
-    }
-    //...........................................................................................
-    void calc_aa_points(U32 srcSz, U32 dstSz, bool scale_up, std::vector<S32> &vp)
-    {
-        vp.resize(dstSz);
-
-        if(scale_up)
-        {
-            S32 val = 0x8000 * srcSz / dstSz - 0x8000;
-            S32 inc = (srcSz << 16) / dstSz;
-            U32 pos;
-
-            for(U32 i = 0, j = 0; i < dstSz; ++i, ++j, val += inc)
-            {
-                pos = val >> 16;
-
-                if (pos >= (srcSz - 1))
-                    vp[j] = 0;
-                else
-                    vp[j] = (val >> 8) - ((val >> 8) & 0xffffff00);
-            }
-        }
-        else
-        {
-            S32 inc = (srcSz << 16) / dstSz;
-            S32 Cp = ((dstSz << 14) / srcSz) + 1;
-            S32 ap;
-
-            for(U32 i = 0, j = 0, val = 0; i < dstSz; ++i, ++j, val += inc)
-            {
-                ap = ((0x100 - ((val >> 8) & 0xff)) * Cp) >> 8;
-                vp[j] = ap | (Cp << 16);
-            }
-        }
-    }
-};
-
-
-template<U8 ch>
-inline void bilinear_scale(
-    const U8 *src, U32 srcW, U32 srcH, U32 srcStride
-    , U8 *dst, U32 dstW, U32 dstH, U32 dstStride
-    )
-{
-    typedef scale_info<ch> scale_info_t;
-
-    scale_info_t info(src, srcW, srcH, dstW, dstH, srcStride);
-
-    const U8 *sptr;
-    U8 *dptr;
-    U32 x, y;
-    const U8 *pix;
-
-    S32 cx[ch], comp[ch];
-
-
-    if(3 == info.xup_yup)
-    { //scale x/y - up
-        for(y = 0; y < dstH; ++y)
-        {
-            dptr = dst + (y * dstStride);
-            sptr = info.ystrides[y];
-
-            if(0 < info.yapoints[y])
-            {
-                for(x = 0; x < dstW; ++x)
-                {
-                    //for(c = 0; c < ch; ++c) cx[c] = comp[c] = 0;
-                    typename scale_info_t::uroll_zeroze_cx_comp_t()(cx, comp);
-
-                    if(0 < info.xapoints[x])
-                    {
-                        pix = info.ystrides[y] + info.xpoints[x] * ch;
-
-                        //for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.xapoints[x]);
-                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
-
-                        pix += ch;
-
-                        //for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, info.xapoints[x]);
-
-                        pix += srcStride;
-
-                        //for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
-                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, info.xapoints[x]);
-
-                        pix -= ch;
-
-                        //for(c = 0; c < ch; ++c) {
-                        //  cx[c] += pix[c] * (256 - info.xapoints[x]);
-                        //  comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
-                        //  *dptr++ = comp[c]&0xff;
-                        //}
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, 256 - info.xapoints[x]);
-                        typename scale_info_t::uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t()(comp, cx, info.yapoints[y]);
-                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
-                    }
-                    else
-                    {
-                        pix = info.ystrides[y] + info.xpoints[x] * ch;
-
-                        //for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.yapoints[y]);
-                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256-info.yapoints[y]);
-
-                        pix += srcStride;
-
-                        //for(c = 0; c < ch; ++c) {
-                        //  comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
-                        //  *dptr++ = comp[c]&0xff;
-                        //}
-                        typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.yapoints[y]);
-                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
-                    }
-                }
-            }
-            else
-            {
-                for(x = 0; x < dstW; ++x)
-                {
-                    if(0 < info.xapoints[x])
-                    {
-                        pix = info.ystrides[y] + info.xpoints[x] * ch;
-
-                        //for(c = 0; c < ch; ++c) {
-                        //  comp[c] = pix[c] * (256 - info.xapoints[x]);
-                        //  comp[c] = (comp[c] + pix[c] * info.xapoints[x]) >> 8;
-                        //  *dptr++ = comp[c]&0xff;
-                        //}
-                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
-                        typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.xapoints[x]);
-                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
-                    }
-                    else
-                    {
-                        //for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
-                        typename scale_info_t::uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t()(dptr, sptr, info.xpoints[x]*ch);
-                    }
-                }
-            }
-        }
-    }
-    else if(info.xup_yup == 1)
-    { //scaling down vertically
-        S32 Cy, j;
-        S32 yap;
-
-        for(y = 0; y < dstH; y++)
-        {
-            Cy = info.yapoints[y] >> 16;
-            yap = info.yapoints[y] & 0xffff;
-
-            dptr = dst + (y * dstStride);
-
-            for(x = 0; x < dstW; x++)
-            {
-                pix = info.ystrides[y] + info.xpoints[x] * ch;
-
-                //for(c = 0; c < ch; ++c) comp[c] = pix[c] * yap;
-                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, yap);
-
-                pix += srcStride;
-
-                for(j = (1 << 14) - yap; j > Cy; j -= Cy, pix += srcStride)
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cy;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cy);
-                }
-
-                if(j > 0)
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
-                }
-
-                if(info.xapoints[x] > 0)
-                {
-                    pix = info.ystrides[y] + info.xpoints[x]*ch + ch;
-                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * yap;
-                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, yap);
-
-                    pix += srcStride;
-                    for(j = (1 << 14) - yap; j > Cy; j -= Cy)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cy;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cy);
-                        pix += srcStride;
-                    }
-
-                    if(j > 0)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
-                    }
-
-                    //for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
-                    typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.xapoints[x], cx);
-                }
-                else
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] >>= 4;
-                    typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
-                }
-
-                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
-                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
-            }
-        }
-    }
-    else if(info.xup_yup == 2)
-    { // scaling down horizontally
-        S32 Cx, j;
-        S32 xap;
-
-        for(y = 0; y < dstH; y++)
-        {
-            dptr = dst + (y * dstStride);
-
-            for(x = 0; x < dstW; x++)
-            {
-                Cx = info.xapoints[x] >> 16;
-                xap = info.xapoints[x] & 0xffff;
-
-                pix = info.ystrides[y] + info.xpoints[x] * ch;
-
-                //for(c = 0; c < ch; ++c) comp[c] = pix[c] * xap;
-                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, xap);
-
-                pix+=ch;
-                for(j = (1 << 14) - xap; j > Cx; j -= Cx)
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cx;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cx);
-                    pix+=ch;
-                }
-
-                if(j > 0)
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
-                }
-
-                if(info.yapoints[y] > 0)
-                {
-                    pix = info.ystrides[y] + info.xpoints[x]*ch + srcStride;
-                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
-                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
-
-                    pix+=ch;
-                    for(j = (1 << 14) - xap; j > Cx; j -= Cx)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
-                        pix+=ch;
-                    }
-
-                    if(j > 0)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
-                    }
-
-                    //for(c = 0; c < ch; ++c) comp[c] = ((comp[c] * (256 - info.yapoints[y])) + ((cx[c] * info.yapoints[y]))) >> 12;
-                    typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.yapoints[y], cx);
-                }
-                else
-                {
-                    //for(c = 0; c < ch; ++c) comp[c] >>= 4;
-                    typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
-                }
-
-                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
-                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
-            }
-        }
-    }
-    else
-    { //scale x/y - down
-        S32 Cx, Cy, i, j;
-        S32 xap, yap;
-
-        for(y = 0; y < dstH; y++)
-        {
-            Cy = info.yapoints[y] >> 16;
-            yap = info.yapoints[y] & 0xffff;
-
-            dptr = dst + (y * dstStride);
-            for(x = 0; x < dstW; x++)
-            {
-                Cx = info.xapoints[x] >> 16;
-                xap = info.xapoints[x] & 0xffff;
-
-                sptr = info.ystrides[y] + info.xpoints[x] * ch;
-                pix = sptr;
-                sptr += srcStride;
-
-                //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
-                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
-
-                pix+=ch;
-                for(i = (1 << 14) - xap; i > Cx; i -= Cx)
-                {
-                    //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
-                    pix+=ch;
-                }
-
-                if(i > 0)
-                {
-                    //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
-                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
-                }
-
-                //for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
-                typename scale_info_t::uroll_comp_asgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, yap);
-
-                for(j = (1 << 14) - yap; j > Cy; j -= Cy)
-                {
-                    pix = sptr;
-                    sptr += srcStride;
-
-                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
-                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
-
-                    pix+=ch;
-                    for(i = (1 << 14) - xap; i > Cx; i -= Cx)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
-                        pix+=ch;
-                    }
-
-                    if(i > 0)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
-                    }
-
-                    //for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
-                    typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, Cy);
-                }
-
-                if(j > 0)
-                {
-                    pix = sptr;
-                    sptr += srcStride;
-
-                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
-                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
-
-                    pix+=ch;
-                    for(i = (1 << 14) - xap; i > Cx; i -= Cx)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
-                        pix+=ch;
-                    }
-
-                    if(i > 0)
-                    {
-                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
-                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
-                    }
-
-                    //for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * j;
-                    typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, j);
-                }
-
-                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>23)&0xff;
-                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 23);
-            }
-        }
-    } //else
-}
-
-//wrapper
-static void bilinear_scale(const U8 *src, U32 srcW, U32 srcH, U32 srcCh, U32 srcStride, U8 *dst, U32 dstW, U32 dstH, U32 dstCh, U32 dstStride)
-{
-    llassert(srcCh == dstCh);
-
-    switch(srcCh)
-    {
-    case 1:
-        bilinear_scale<1>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
-        break;
-    case 3:
-        bilinear_scale<3>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
-        break;
-    case 4:
-        bilinear_scale<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
-        break;
-    default:
-        llassert(!"Implement if need");
-        break;
-    }
-
-}
-
 //---------------------------------------------------------------------------
 // LLImage
 //---------------------------------------------------------------------------
@@ -602,6 +65,7 @@ void LLImage::initClass(bool use_new_byte_range, S32 minimal_reverse_byte_range_
 //static
 void LLImage::cleanupClass()
 {
+    LLImageDataPool::trim();
 }
 
 //static
@@ -628,7 +92,8 @@ LLImageBase::LLImageBase()
     mHeight(0),
     mComponents(0),
     mBadBufferAllocation(false),
-    mAllowOverSize(false)
+    mAllowOverSize(false),
+    mDataPooled(false)
 {}
 
 // virtual
@@ -670,11 +135,24 @@ void LLImageBase::sanityCheck()
 // virtual
 void LLImageBase::deleteData()
 {
-    ll_aligned_free_16(mData);
+    freeData();
     mDataSize = 0;
     mData = NULL;
 }
 
+void LLImageBase::freeData()
+{
+    if (mDataPooled)
+    {
+        LLImageDataPool::release(mData, mDataSize);
+        mDataPooled = false;
+    }
+    else
+    {
+        ll_aligned_free_16(mData);
+    }
+}
+
 // virtual
 U8* LLImageBase::allocateData(S32 size)
 {
@@ -709,7 +187,8 @@ U8* LLImageBase::allocateData(S32 size)
     if (!mBadBufferAllocation && (!mData || size != mDataSize))
     {
         deleteData(); // virtual
-        mData = (U8*)ll_aligned_malloc_16(size);
+        mData = LLImageDataPool::allocate(size);
+        mDataPooled = mData != NULL;
         if (!mData)
         {
             LL_WARNS() << "Failed to allocate image data size [" << size << "]" << LL_ENDL;
@@ -735,7 +214,16 @@ U8* LLImageBase::allocateData(S32 size)
 // virtual
 U8* LLImageBase::reallocateData(S32 size)
 {
-    U8 *new_datap = (U8*)ll_aligned_malloc_16(size);
+    if (mData && mDataPooled && size > 0 && LLImageDataPool::isSameClass(size, mDataSize))
+    {
+        // The buffer already has room, appending a few packets of
+        // formatted data doesn't need a copy
+        mDataSize = size;
+        mBadBufferAllocation = false;
+        return mData;
+    }
+
+    U8 *new_datap = LLImageDataPool::allocate(size);
     if (!new_datap)
     {
         LL_WARNS() << "Out of memory in LLImageBase::reallocateData" << LL_ENDL;
@@ -745,9 +233,10 @@ U8* LLImageBase::reallocateData(S32 size)
     {
         S32 bytes = llmin(mDataSize, size);
         memcpy(new_datap, mData, bytes);    /* Flawfinder: ignore */
-        ll_aligned_free_16(mData) ;
+        freeData();
     }
     mData = new_datap;
+    mDataPooled = true;
     mDataSize = size;
     mBadBufferAllocation = false;
     return mData;
@@ -876,7 +365,7 @@ void LLImageRaw::deleteData()
     LLImageBase::deleteData();
 }
 
-void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components)
+void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components, bool pooled)
 {
     if(data == getData())
     {
@@ -886,7 +375,7 @@ void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components)
     deleteData();
 
     LLImageBase::setSize(width, height, components) ;
-    LLImageBase::setDataAndSize(data, width * height * components) ;
+    LLImageBase::setDataAndSize(data, width * height * components, pooled) ;
 }
 
 bool LLImageRaw::resize(U16 width, U16 height, S8 components)
@@ -1027,7 +516,7 @@ bool LLImageRaw::optimizeAwayAlpha()
         }
 
         // alpha channel is all 255, make a new copy of data without alpha channel
-        U8* new_data = (U8*) ll_aligned_malloc_16(getWidth() * getHeight() * 3);
+        U8* new_data = LLImageDataPool::allocate(getWidth() * getHeight() * 3);
 
         for (U32 i = 0; i < pixels; ++i)
         {
@@ -1039,7 +528,7 @@ bool LLImageRaw::optimizeAwayAlpha()
             }
         }
 
-        setDataAndSize(new_data, getWidth(), getHeight(), 3);
+        setDataAndSize(new_data, getWidth(), getHeight(), 3, true);
 
         return true;
     }
@@ -1200,21 +689,14 @@ void LLImageRaw::compositeScaled4onto3(LLImageRaw* src)
 
     llassert( (4 == src->getComponents()) && (3 == dst->getComponents()) );
 
-    S32 temp_data_size = src->getWidth() * dst->getHeight() * src->getComponents();
-    llassert(temp_data_size > 0);
-    std::vector<U8> temp_buffer(temp_data_size);
-
-    // Vertical: scale but no composite
-    for( S32 col = 0; col < src->getWidth(); col++ )
+    // Area average the source to the destination size, then blend
+    LLPointer<LLImageRaw> scaled_src = src->scaled(dst->getWidth(), dst->getHeight(), LLImageResample::BOX);
+    if (scaled_src.isNull() || scaled_src->isBufferInvalid())
     {
-        copyLineScaled( src->getData() + (src->getComponents() * col), &temp_buffer[0] + (src->getComponents() * col), src->getHeight(), dst->getHeight(), src->getWidth(), src->getWidth() );
-    }
-
-    // Horizontal: scale and composite
-    for( S32 row = 0; row < dst->getHeight(); row++ )
-    {
-        compositeRowScaled4onto3( &temp_buffer[0] + (src->getComponents() * src->getWidth() * row), dst->getData() + (dst->getComponents() * dst->getWidth() * row), src->getWidth(), dst->getWidth() );
+        LL_WARNS() << "Failed to scale source image" << LL_ENDL;
+        return;
     }
+    compositeUnscaled4onto3(scaled_src);
 }
 
 
@@ -1522,32 +1004,14 @@ void LLImageRaw::copyScaled( LLImageRaw* src )
         return;
     }
 
-    bilinear_scale(
-            src->getData(), src->getWidth(), src->getHeight(), src->getComponents(), src->getWidth()*src->getComponents()
-        ,   dst->getData(), dst->getWidth(), dst->getHeight(), dst->getComponents(), dst->getWidth()*dst->getComponents()
-    );
-
-    /*
-    S32 temp_data_size = src->getWidth() * dst->getHeight() * getComponents();
-    llassert_always(temp_data_size > 0);
-    std::vector<U8> temp_buffer(temp_data_size);
-
-    // Vertical
-    for( S32 col = 0; col < src->getWidth(); col++ )
-    {
-        copyLineScaled( src->getData() + (getComponents() * col), &temp_buffer[0] + (getComponents() * col), src->getHeight(), dst->getHeight(), src->getWidth(), src->getWidth() );
-    }
-
-    // Horizontal
-    for( S32 row = 0; row < dst->getHeight(); row++ )
-    {
-        copyLineScaled( &temp_buffer[0] + (getComponents() * src->getWidth() * row), dst->getData() + (getComponents() * dst->getWidth() * row), src->getWidth(), dst->getWidth(), 1, 1 );
-    }
-    */
+    LLImageResample::resample(LLImageResample::BILINEAR,
+        src->getData(), src->getWidth(), src->getHeight(), src->getWidth() * src->getComponents(),
+        dst->getData(), dst->getWidth(), dst->getHeight(), dst->getWidth() * dst->getComponents(),
+        dst->getComponents());
 }
 
 
-bool LLImageRaw::scale( S32 new_width, S32 new_height, bool scale_image_data )
+bool LLImageRaw::scale( S32 new_width, S32 new_height, bool scale_image_data, LLImageResample::EFilter filter )
 {
     S32 components = getComponents();
     if (components != 1 && components != 3 && components != 4)
@@ -1578,14 +1042,14 @@ bool LLImageRaw::scale( S32 new_width, S32 new_height, bool scale_image_data )
 
         if (new_data_size > 0)
         {
-            U8 *new_data = (U8*)ll_aligned_malloc_16(new_data_size);
+            U8 *new_data = LLImageDataPool::allocate(new_data_size);
             if(NULL == new_data)
             {
                 return false;
             }
 
-            bilinear_scale(getData(), old_width, old_height, components, old_width*components, new_data, new_width, new_height, components, new_width*components);
-            setDataAndSize(new_data, new_width, new_height, components);
+            LLImageResample::resample(filter, getData(), old_width, old_height, old_width*components, new_data, new_width, new_height, new_width*components, components);
+            setDataAndSize(new_data, new_width, new_height, components, true);
         }
     }
     else
@@ -1634,7 +1098,7 @@ bool LLImageRaw::scale( S32 new_width, S32 new_height, bool scale_image_data )
     return true ;
 }
 
-LLPointer<LLImageRaw> LLImageRaw::scaled(S32 new_width, S32 new_height)
+LLPointer<LLImageRaw> LLImageRaw::scaled(S32 new_width, S32 new_height, LLImageResample::EFilter filter)
 {
     LLPointer<LLImageRaw> result;
 
@@ -1676,225 +1140,13 @@ LLPointer<LLImageRaw> LLImageRaw::scaled(S32 new_width, S32 new_height)
                 LL_WARNS() << "Failed to allocate new image" << LL_ENDL;
                 return result;
             }
-            bilinear_scale(getData(), old_width, old_height, components, old_width*components, result->getData(), new_width, new_height, components, new_width*components);
+            LLImageResample::resample(filter, getData(), old_width, old_height, old_width*components, result->getData(), new_width, new_height, new_width*components, components);
         }
     }
 
     return result;
 }
 
-void LLImageRaw::copyLineScaled( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step )
-{
-    const S32 components = getComponents();
-    llassert( components >= 1 && components <= 4 );
-
-    const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
-    const F32 norm_factor = 1.f / ratio;
-
-    S32 goff = components >= 2 ? 1 : 0;
-    S32 boff = components >= 3 ? 2 : 0;
-    for( S32 x = 0; x < out_pixel_len; x++ )
-    {
-        // Sample input pixels in range from sample0 to sample1.
-        // Avoid floating point accumulation error... don't just add ratio each time.  JC
-        const F32 sample0 = x * ratio;
-        const F32 sample1 = (x+1) * ratio;
-        const S32 index0 = llfloor(sample0);            // left integer (floor)
-        const S32 index1 = llfloor(sample1);            // right integer (floor)
-        const F32 fract0 = 1.f - (sample0 - F32(index0));   // spill over on left
-        const F32 fract1 = sample1 - F32(index1);           // spill-over on right
-
-        if( index0 == index1 )
-        {
-            // Interval is embedded in one input pixel
-            S32 t0 = x * out_pixel_step * components;
-            S32 t1 = index0 * in_pixel_step * components;
-            U8* outp = out + t0;
-            U8* inp = in + t1;
-            for (S32 i = 0; i < components; ++i)
-            {
-                *outp = *inp;
-                ++outp;
-                ++inp;
-            }
-        }
-        else
-        {
-            // Left straddle
-            S32 t1 = index0 * in_pixel_step * components;
-            F32 r = in[t1 + 0] * fract0;
-            F32 g = in[t1 + goff] * fract0;
-            F32 b = in[t1 + boff] * fract0;
-            F32 a = 0;
-            if( components == 4)
-            {
-                a = in[t1 + 3] * fract0;
-            }
-
-            // Central interval
-            if (components < 4)
-            {
-                for( S32 u = index0 + 1; u < index1; u++ )
-                {
-                    S32 t2 = u * in_pixel_step * components;
-                    r += in[t2 + 0];
-                    g += in[t2 + goff];
-                    b += in[t2 + boff];
-                }
-            }
-            else
-            {
-                for( S32 u = index0 + 1; u < index1; u++ )
-                {
-                    S32 t2 = u * in_pixel_step * components;
-                    r += in[t2 + 0];
-                    g += in[t2 + 1];
-                    b += in[t2 + 2];
-                    a += in[t2 + 3];
-                }
-            }
-
-            // right straddle
-            // Watch out for reading off of end of input array.
-            if( fract1 && index1 < in_pixel_len )
-            {
-                S32 t3 = index1 * in_pixel_step * components;
-                if (components < 4)
-                {
-                    U8 in0 = in[t3 + 0];
-                    U8 in1 = in[t3 + goff];
-                    U8 in2 = in[t3 + boff];
-                    r += in0 * fract1;
-                    g += in1 * fract1;
-                    b += in2 * fract1;
-                }
-                else
-                {
-                    U8 in0 = in[t3 + 0];
-                    U8 in1 = in[t3 + 1];
-                    U8 in2 = in[t3 + 2];
-                    U8 in3 = in[t3 + 3];
-                    r += in0 * fract1;
-                    g += in1 * fract1;
-                    b += in2 * fract1;
-                    a += in3 * fract1;
-                }
-            }
-
-            r *= norm_factor;
-            g *= norm_factor;
-            b *= norm_factor;
-            a *= norm_factor;  // skip conditional
-
-            S32 t4 = x * out_pixel_step * components;
-            out[t4 + 0] = U8(ll_round(r));
-            if (components >= 2)
-                out[t4 + 1] = U8(ll_round(g));
-            if (components >= 3)
-                out[t4 + 2] = U8(ll_round(b));
-            if( components == 4)
-                out[t4 + 3] = U8(ll_round(a));
-        }
-    }
-}
-
-void LLImageRaw::compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len )
-{
-    llassert( getComponents() == 3 );
-
-    const S32 IN_COMPONENTS = 4;
-    const S32 OUT_COMPONENTS = 3;
-
-    const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
-    const F32 norm_factor = 1.f / ratio;
-
-    for( S32 x = 0; x < out_pixel_len; x++ )
-    {
-        // Sample input pixels in range from sample0 to sample1.
-        // Avoid floating point accumulation error... don't just add ratio each time.  JC
-        const F32 sample0 = x * ratio;
-        const F32 sample1 = (x+1) * ratio;
-        const S32 index0 = S32(sample0);            // left integer (floor)
-        const S32 index1 = S32(sample1);            // right integer (floor)
-        const F32 fract0 = 1.f - (sample0 - F32(index0));   // spill over on left
-        const F32 fract1 = sample1 - F32(index1);           // spill-over on right
-
-        U8 in_scaled_r;
-        U8 in_scaled_g;
-        U8 in_scaled_b;
-        U8 in_scaled_a;
-
-        if( index0 == index1 )
-        {
-            // Interval is embedded in one input pixel
-            S32 t1 = index0 * IN_COMPONENTS;
-            in_scaled_r = in[t1 + 0];
-            in_scaled_g = in[t1 + 0];
-            in_scaled_b = in[t1 + 0];
-            in_scaled_a = in[t1 + 0];
-        }
-        else
-        {
-            // Left straddle
-            S32 t1 = index0 * IN_COMPONENTS;
-            F32 r = in[t1 + 0] * fract0;
-            F32 g = in[t1 + 1] * fract0;
-            F32 b = in[t1 + 2] * fract0;
-            F32 a = in[t1 + 3] * fract0;
-
-            // Central interval
-            for( S32 u = index0 + 1; u < index1; u++ )
-            {
-                S32 t2 = u * IN_COMPONENTS;
-                r += in[t2 + 0];
-                g += in[t2 + 1];
-                b += in[t2 + 2];
-                a += in[t2 + 3];
-            }
-
-            // right straddle
-            // Watch out for reading off of end of input array.
-            if( fract1 && index1 < in_pixel_len )
-            {
-                S32 t3 = index1 * IN_COMPONENTS;
-                r += in[t3 + 0] * fract1;
-                g += in[t3 + 1] * fract1;
-                b += in[t3 + 2] * fract1;
-                a += in[t3 + 3] * fract1;
-            }
-
-            r *= norm_factor;
-            g *= norm_factor;
-            b *= norm_factor;
-            a *= norm_factor;
-
-            in_scaled_r = U8(ll_round(r));
-            in_scaled_g = U8(ll_round(g));
-            in_scaled_b = U8(ll_round(b));
-            in_scaled_a = U8(ll_round(a));
-        }
-
-        if( in_scaled_a )
-        {
-            if( 255 == in_scaled_a )
-            {
-                out[0] = in_scaled_r;
-                out[1] = in_scaled_g;
-                out[2] = in_scaled_b;
-            }
-            else
-            {
-                U8 transparency = 255 - in_scaled_a;
-                out[0] = fastFractionalMult( out[0], transparency ) + fastFractionalMult( in_scaled_r, in_scaled_a );
-                out[1] = fastFractionalMult( out[1], transparency ) + fastFractionalMult( in_scaled_g, in_scaled_a );
-                out[2] = fastFractionalMult( out[2], transparency ) + fastFractionalMult( in_scaled_b, in_scaled_a );
-            }
-        }
-        out += OUT_COMPONENTS;
-    }
-}
-
-
 void LLImageRaw::addEmissive(LLImageRaw* src)
 {
     LLImageRaw* dst = this;  // Just for clarity.
@@ -2429,66 +1681,23 @@ S8 LLImageFormatted::getCodec() const
     return mCodec;
 }
 
-static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-    dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
-    dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
-}
-
-static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-    dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
-}
-
-static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-}
-
-void LLImageBase::setDataAndSize(U8 *data, S32 size)
+void LLImageBase::setDataAndSize(U8 *data, S32 size, bool pooled)
 {
     ll_assert_aligned(data, 16);
     mData = data;
     mDataSize = size;
+    mDataPooled = pooled && data;
 }
 
 //static
 void LLImageBase::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
 {
     llassert(width > 0 && height > 0);
-    U8* data = mipdata;
-    S32 in_width = width*2;
-    for (S32 h=0; h<height; h++)
+    if (nchannels < 1 || nchannels > 4)
     {
-        for (S32 w=0; w<width; w++)
-        {
-            switch(nchannels)
-            {
-              case 4:
-                avg4_colors4(indata, indata+4, indata+4*in_width, indata+4*in_width+4, data);
-                break;
-              case 3:
-                avg4_colors3(indata, indata+3, indata+3*in_width, indata+3*in_width+3, data);
-                break;
-              case 2:
-                avg4_colors2(indata, indata+2, indata+2*in_width, indata+2*in_width+2, data);
-                break;
-              case 1:
-                *(U8*)data = (U8)(((U32)(indata[0]) + indata[1] + indata[in_width] + indata[in_width+1])>>2);
-                break;
-              default:
-                LL_ERRS() << "generateMmip called with bad num channels" << LL_ENDL;
-            }
-            indata += nchannels*2;
-            data += nchannels;
-        }
-        indata += nchannels*in_width; // skip odd lines
+        LL_ERRS() << "generateMmip called with bad num channels" << LL_ENDL;
     }
+    LLImageResample::generateMip(indata, mipdata, width, height, nchannels);
 }
 
 
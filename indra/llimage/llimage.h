@@ -31,6 +31,7 @@
 #include "llstring.h"
 #include "llpointer.h"
 #include "lltrace.h"
+#include "llimageresample.h"
 
 const S32 MIN_IMAGE_MIP =  2; // 4x4, only used for expand/contract power of 2
 const S32 MAX_IMAGE_MIP = 12; // 4096x4096
@@ -150,7 +151,12 @@ class LLImageBase
 
 protected:
     // special accessor to allow direct setting of mData and mDataSize by LLImageFormatted
-    void setDataAndSize(U8 *data, S32 size);
+    // pooled means data came from LLImageDataPool::allocate(size)
+    void setDataAndSize(U8 *data, S32 size, bool pooled = false);
+
+private:
+    // Frees mData however it was allocated, leaves the pointer alone
+    void freeData();
 
 public:
     static void generateMip(const U8 *indata, U8* mipdata, int width, int height, S32 nchannels);
@@ -172,6 +178,7 @@ class LLImageBase
 
     bool mBadBufferAllocation ;
     bool mAllowOverSize ;
+    bool mDataPooled;   // mData goes back to LLImageDataPool
 };
 
 // Raw representation of an image (used for textures, and other uncompressed formats
@@ -222,8 +229,8 @@ class LLImageRaw final : public LLImageBase
     void expandToPowerOfTwo(S32 max_dim = MAX_IMAGE_SIZE, bool scale_image = true);
     void contractToPowerOfTwo(S32 max_dim = MAX_IMAGE_SIZE, bool scale_image = true);
     void biasedScaleToPowerOfTwo(S32 max_dim = MAX_IMAGE_SIZE);
-    bool scale(S32 new_width, S32 new_height, bool scale_image = true);
-    LLPointer<LLImageRaw> scaled(S32 new_width, S32 new_height);
+    bool scale(S32 new_width, S32 new_height, bool scale_image = true, LLImageResample::EFilter filter = LLImageResample::BILINEAR);
+    LLPointer<LLImageRaw> scaled(S32 new_width, S32 new_height, LLImageResample::EFilter filter = LLImageResample::BILINEAR);
 
     // Fill the buffer with a constant color
     void fill( const LLColor4U& color );
@@ -287,12 +294,9 @@ class LLImageRaw final : public LLImageBase
     // Create an image from a local file (generally used in tools)
     //bool createFromFile(const std::string& filename, bool j2c_lowest_mip_only = false);
 
-    void copyLineScaled( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step );
-    void compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len );
-
     U8  fastFractionalMult(U8 a,U8 b);
 
-    void setDataAndSize(U8 *data, S32 width, S32 height, S8 components) ;
+    void setDataAndSize(U8 *data, S32 width, S32 height, S8 components, bool pooled = false) ;
 
 public:
     static S32 sRawImageCount;
@@ -0,0 +1,524 @@
+/**
+ * @file llimagebc.cpp
+ * @brief CPU block compression (BC1/BC3) of raw image data
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagebc.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+namespace
+{
+    // Pull the bounding box in by 1/16th of its size for colour and 1/32nd
+    // for alpha; the extremes of a block are rarely worth an exact match.
+    constexpr S32 COLOR_INSET_SHIFT = 4;
+    constexpr S32 ALPHA_INSET_SHIFT = 5;
+
+    inline U16 to_565(const U8* c)
+    {
+        U32 r = (c[0] * 31 + 127) / 255;
+        U32 g = (c[1] * 63 + 127) / 255;
+        U32 b = (c[2] * 31 + 127) / 255;
+        return (U16)((r << 11) | (g << 5) | b);
+    }
+
+    inline void from_565(U16 v, U8* c)
+    {
+        U8 r = (v >> 11) & 0x1f;
+        U8 g = (v >> 5) & 0x3f;
+        U8 b = v & 0x1f;
+        c[0] = (U8)((r << 3) | (r >> 2));
+        c[1] = (U8)((g << 2) | (g >> 4));
+        c[2] = (U8)((b << 3) | (b >> 2));
+        c[3] = 0;
+    }
+
+    inline void put_u16(U8* dst, U16 v)
+    {
+        dst[0] = (U8)(v & 0xff);
+        dst[1] = (U8)(v >> 8);
+    }
+
+    inline U16 get_u16(const U8* src)
+    {
+        return (U16)(src[0] | (src[1] << 8));
+    }
+
+    inline U32 pack_rgb(const U8* c)
+    {
+        return (U32)c[0] | ((U32)c[1] << 8) | ((U32)c[2] << 16);
+    }
+
+    inline __m128i select(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    // Squared RGB distance from four pixels to one colour, one per lane.
+    // Alpha must already be cleared in both arguments.
+    inline __m128i color_distances(__m128i pixels, __m128i color)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(color, zero));
+        __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(color, zero));
+        lo = _mm_madd_epi16(lo, lo);
+        hi = _mm_madd_epi16(hi, hi);
+        __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+    }
+
+    void get_min_max(const U8* rgba, U8* min_color, U8* max_color)
+    {
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(rgba));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(rgba + 16));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(rgba + 32));
+        __m128i r3 = _mm_loadu_si128((const __m128i*)(rgba + 48));
+
+        __m128i mn = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+        __m128i mx = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+        mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+        mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+        mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+        mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        U32 packed_min = (U32)_mm_cvtsi128_si32(mn);
+        U32 packed_max = (U32)_mm_cvtsi128_si32(mx);
+        memcpy(min_color, &packed_min, 4);
+        memcpy(max_color, &packed_max, 4);
+    }
+
+    // Flip the bounding box diagonal on the channels that run against the
+    // one with the widest range, so gradients like red to green get an
+    // endpoint pair that actually lies along them.
+    void select_diagonal(const U8* rgba, U8* min_color, U8* max_color)
+    {
+        S32 axis = 0;
+        for (S32 c = 1; c < 3; ++c)
+        {
+            if (max_color[c] - min_color[c] > max_color[axis] - min_color[axis])
+            {
+                axis = c;
+            }
+        }
+
+        S32 center[3];
+        for (S32 c = 0; c < 3; ++c)
+        {
+            center[c] = (min_color[c] + max_color[c] + 1) >> 1;
+        }
+
+        S32 cov[3] = { 0, 0, 0 };
+        for (S32 i = 0; i < 16; ++i)
+        {
+            const U8* p = rgba + i * 4;
+            S32 d = p[axis] - center[axis];
+            for (S32 c = 0; c < 3; ++c)
+            {
+                cov[c] += (p[c] - center[c]) * d;
+            }
+        }
+
+        for (S32 c = 0; c < 3; ++c)
+        {
+            if (c != axis && cov[c] < 0)
+            {
+                std::swap(min_color[c], max_color[c]);
+            }
+        }
+    }
+
+    // Writes the 8 byte colour half of a BC1 or BC3 block, always in four
+    // colour mode.
+    void encode_color_block(const U8* rgba, U8* dst)
+    {
+        U8 min_color[4];
+        U8 max_color[4];
+        get_min_max(rgba, min_color, max_color);
+
+        for (S32 c = 0; c < 3; ++c)
+        {
+            U8 inset = (U8)((max_color[c] - min_color[c]) >> COLOR_INSET_SHIFT);
+            min_color[c] += inset;
+            max_color[c] -= inset;
+        }
+        select_diagonal(rgba, min_color, max_color);
+
+        U16 c0 = to_565(max_color);
+        U16 c1 = to_565(min_color);
+        if (c0 == c1)
+        {
+            put_u16(dst, c0);
+            put_u16(dst + 2, c1);
+            memset(dst + 4, 0, 4);
+            return;
+        }
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+        }
+
+        U8 palette[4][4];
+        from_565(c0, palette[0]);
+        from_565(c1, palette[1]);
+        for (S32 c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (U8)((2 * palette[0][c] + palette[1][c]) / 3);
+            palette[3][c] = (U8)((palette[0][c] + 2 * palette[1][c]) / 3);
+        }
+        palette[2][3] = palette[3][3] = 0;
+
+        __m128i colors[4];
+        for (S32 k = 0; k < 4; ++k)
+        {
+            colors[k] = _mm_set1_epi32((S32)pack_rgb(palette[k]));
+        }
+
+        const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+        U32 indices = 0;
+        for (S32 row = 0; row < 4; ++row)
+        {
+            __m128i pixels = _mm_and_si128(_mm_loadu_si128((const __m128i*)(rgba + row * 16)), rgb_mask);
+
+            __m128i best = color_distances(pixels, colors[0]);
+            __m128i index = _mm_setzero_si128();
+            for (S32 k = 1; k < 4; ++k)
+            {
+                __m128i dist = color_distances(pixels, colors[k]);
+                __m128i closer = _mm_cmplt_epi32(dist, best);
+                best = select(closer, dist, best);
+                index = select(closer, _mm_set1_epi32(k), index);
+            }
+
+            // Fold lanes 1 and 3 onto 0 and 2, then join the two nibbles
+            index = _mm_or_si128(index, _mm_srli_epi64(index, 30));
+            U32 lo = (U32)_mm_cvtsi128_si32(index) & 0xf;
+            U32 hi = (U32)_mm_cvtsi128_si32(_mm_srli_si128(index, 8)) & 0xf;
+            indices |= (lo | (hi << 4)) << (row * 8);
+        }
+
+        put_u16(dst, c0);
+        put_u16(dst + 2, c1);
+        dst[4] = (U8)(indices & 0xff);
+        dst[5] = (U8)((indices >> 8) & 0xff);
+        dst[6] = (U8)((indices >> 16) & 0xff);
+        dst[7] = (U8)(indices >> 24);
+    }
+
+    void alpha_palette(U8 a0, U8 a1, U8* palette)
+    {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+        {
+            for (S32 i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = (U8)(((7 - i) * a0 + i * a1) / 7);
+            }
+        }
+        else
+        {
+            for (S32 i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = (U8)(((5 - i) * a0 + i * a1) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    inline __m128i load_alpha(const U8* rgba)
+    {
+        __m128i r0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(rgba)), 24);
+        __m128i r1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(rgba + 16)), 24);
+        __m128i r2 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(rgba + 32)), 24);
+        __m128i r3 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(rgba + 48)), 24);
+        return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+    }
+
+    // Nearest palette entry for all 16 alphas at once.  Returns the summed
+    // absolute error.
+    U32 fit_alpha(__m128i alpha, const U8* palette, U8* indices)
+    {
+        __m128i value = _mm_set1_epi8((char)palette[0]);
+        __m128i best = _mm_or_si128(_mm_subs_epu8(alpha, value), _mm_subs_epu8(value, alpha));
+        __m128i index = _mm_setzero_si128();
+        for (S32 k = 1; k < 8; ++k)
+        {
+            value = _mm_set1_epi8((char)palette[k]);
+            __m128i dist = _mm_or_si128(_mm_subs_epu8(alpha, value), _mm_subs_epu8(value, alpha));
+            __m128i not_closer = _mm_cmpeq_epi8(_mm_min_epu8(dist, best), best);
+            best = _mm_min_epu8(dist, best);
+            index = select(not_closer, index, _mm_set1_epi8((char)k));
+        }
+        _mm_storeu_si128((__m128i*)indices, index);
+
+        __m128i sad = _mm_sad_epu8(best, _mm_setzero_si128());
+        return (U32)_mm_cvtsi128_si32(sad) + (U32)_mm_cvtsi128_si32(_mm_srli_si128(sad, 8));
+    }
+
+    // Writes the 8 byte alpha half of a BC3 block.  Blocks holding fully
+    // transparent or opaque pixels are also tried in six value mode, which
+    // keeps 0 and 255 exact for cutouts.
+    void encode_alpha_block(const U8* rgba, U8* dst)
+    {
+        U8 amin = 255, amax = 0;
+        U8 inner_min = 255, inner_max = 0;
+        bool has_extremes = false;
+        for (S32 i = 0; i < 16; ++i)
+        {
+            U8 a = rgba[i * 4 + 3];
+            amin = llmin(amin, a);
+            amax = llmax(amax, a);
+            if (a == 0 || a == 255)
+            {
+                has_extremes = true;
+            }
+            else
+            {
+                inner_min = llmin(inner_min, a);
+                inner_max = llmax(inner_max, a);
+            }
+        }
+
+        U8 inset = (U8)((amax - amin) >> ALPHA_INSET_SHIFT);
+        U8 a0 = amax - inset;
+        U8 a1 = amin + inset;
+        if (a0 == a1 && amax != amin)
+        {
+            a0 = amax;
+            a1 = amin;
+        }
+
+        __m128i alpha = load_alpha(rgba);
+        U8 palette[8];
+        alignas(16) U8 indices[16];
+        alpha_palette(a0, a1, palette);
+        U32 error = fit_alpha(alpha, palette, indices);
+
+        if (has_extremes && error > 0)
+        {
+            U8 b0 = inner_min <= inner_max ? inner_min : 0;
+            U8 b1 = inner_min <= inner_max ? inner_max : 0;
+            U8 alt_palette[8];
+            alignas(16) U8 alt_indices[16];
+            alpha_palette(b0, b1, alt_palette);
+            if (fit_alpha(alpha, alt_palette, alt_indices) < error)
+            {
+                a0 = b0;
+                a1 = b1;
+                memcpy(indices, alt_indices, sizeof(indices));
+            }
+        }
+
+        dst[0] = a0;
+        dst[1] = a1;
+        U64 bits = 0;
+        for (S32 i = 0; i < 16; ++i)
+        {
+            bits |= (U64)indices[i] << (3 * i);
+        }
+        for (S32 i = 0; i < 6; ++i)
+        {
+            dst[2 + i] = (U8)((bits >> (8 * i)) & 0xff);
+        }
+    }
+
+    void decode_color_block(const U8* src, U8* rgba, bool four_color)
+    {
+        U16 c0 = get_u16(src);
+        U16 c1 = get_u16(src + 2);
+        U8 palette[4][4];
+        from_565(c0, palette[0]);
+        from_565(c1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+        if (four_color || c0 > c1)
+        {
+            for (S32 c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (U8)((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = (U8)((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            palette[2][3] = palette[3][3] = 255;
+        }
+        else
+        {
+            for (S32 c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (U8)((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        U32 indices = (U32)src[4] | ((U32)src[5] << 8) | ((U32)src[6] << 16) | ((U32)src[7] << 24);
+        for (S32 i = 0; i < 16; ++i)
+        {
+            memcpy(rgba + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+        }
+    }
+
+    template<typename ENCODE>
+    void encode_blocks(const U8* src, S32 width, S32 height, S32 components, U8* dst, S32 block_bytes, ENCODE encode)
+    {
+        alignas(16) U8 block[64];
+        const S32 stride = width * components;
+        for (S32 by = 0; by < height; by += 4)
+        {
+            for (S32 bx = 0; bx < width; bx += 4)
+            {
+                for (S32 y = 0; y < 4; ++y)
+                {
+                    const U8* row = src + llmin(by + y, height - 1) * stride;
+                    U8* out = block + y * 16;
+                    if (components == 4 && bx + 4 <= width)
+                    {
+                        memcpy(out, row + bx * 4, 16);
+                        continue;
+                    }
+                    for (S32 x = 0; x < 4; ++x)
+                    {
+                        const U8* p = row + llmin(bx + x, width - 1) * components;
+                        out[x * 4 + 0] = p[0];
+                        out[x * 4 + 1] = p[1];
+                        out[x * 4 + 2] = p[2];
+                        out[x * 4 + 3] = components == 4 ? p[3] : 255;
+                    }
+                }
+                encode(block, dst);
+                dst += block_bytes;
+            }
+        }
+    }
+}
+
+//static
+S32 LLImageBC::getCompressedSize(EFormat format, S32 width, S32 height)
+{
+    S32 blocks = ((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == BC1 ? 8 : 16);
+}
+
+//static
+bool LLImageBC::hasAlpha(const U8* src, S32 width, S32 height, S32 components)
+{
+    if (components != 4)
+    {
+        return false;
+    }
+    const S32 pixels = width * height;
+    for (S32 i = 0; i < pixels; ++i)
+    {
+        if (src[i * 4 + 3] != 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//static
+bool LLImageBC::compress(EFormat format, const U8* src, S32 width, S32 height, S32 components, U8* dst)
+{
+    if (!src || !dst || width <= 0 || height <= 0 || components < 3 || components > 4)
+    {
+        return false;
+    }
+
+    if (format == BC1)
+    {
+        encode_blocks(src, width, height, components, dst, 8, compressBlockBC1);
+    }
+    else
+    {
+        encode_blocks(src, width, height, components, dst, 16, compressBlockBC3);
+    }
+    return true;
+}
+
+//static
+void LLImageBC::decompress(EFormat format, const U8* src, S32 width, S32 height, U8* dst)
+{
+    U8 block[64];
+    const S32 block_bytes = format == BC1 ? 8 : 16;
+    for (S32 by = 0; by < height; by += 4)
+    {
+        for (S32 bx = 0; bx < width; bx += 4)
+        {
+            if (format == BC1)
+            {
+                decompressBlockBC1(src, block);
+            }
+            else
+            {
+                decompressBlockBC3(src, block);
+            }
+            src += block_bytes;
+
+            for (S32 y = 0; y < 4 && by + y < height; ++y)
+            {
+                S32 count = llmin(4, width - bx);
+                memcpy(dst + ((by + y) * width + bx) * 4, block + y * 16, count * 4);
+            }
+        }
+    }
+}
+
+//static
+void LLImageBC::compressBlockBC1(const U8* rgba, U8* dst)
+{
+    encode_color_block(rgba, dst);
+}
+
+//static
+void LLImageBC::compressBlockBC3(const U8* rgba, U8* dst)
+{
+    encode_alpha_block(rgba, dst);
+    encode_color_block(rgba, dst + 8);
+}
+
+//static
+void LLImageBC::decompressBlockBC1(const U8* src, U8* rgba)
+{
+    decode_color_block(src, rgba, false);
+}
+
+//static
+void LLImageBC::decompressBlockBC3(const U8* src, U8* rgba)
+{
+    decode_color_block(src + 8, rgba, true);
+
+    U8 palette[8];
+    alpha_palette(src[0], src[1], palette);
+    U64 bits = 0;
+    for (S32 i = 0; i < 6; ++i)
+    {
+        bits |= (U64)src[2 + i] << (8 * i);
+    }
+    for (S32 i = 0; i < 16; ++i)
+    {
+        rgba[i * 4 + 3] = palette[(bits >> (3 * i)) & 7];
+    }
+}
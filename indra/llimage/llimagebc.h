@@ -0,0 +1,62 @@
+/**
+ * @file llimagebc.h
+ * @brief CPU block compression (BC1/BC3) of raw image data
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEBC_H
+#define LL_LLIMAGEBC_H
+
+// Real time BC1 (DXT1) and BC3 (DXT5) encoder for 3 and 4 component
+// images, used to block compress textures before they are uploaded.
+// Colour endpoints come from the inset bounding box of each 4x4 block
+// with the diagonal picked from the sign of the colour covariance, and
+// indices are chosen by nearest distance using SSE2.  Quality is below
+// an offline encoder but it runs at hundreds of megapixels a second.
+class LLImageBC
+{
+public:
+    enum EFormat
+    {
+        BC1,    // opaque colour, 8 bytes per block
+        BC3,    // colour with interpolated alpha, 16 bytes per block
+    };
+
+    // Bytes needed for a width x height image, rounded up to whole blocks
+    static S32 getCompressedSize(EFormat format, S32 width, S32 height);
+
+    // True if any pixel of a 4 component image is not fully opaque
+    static bool hasAlpha(const U8* src, S32 width, S32 height, S32 components);
+
+    // Compress a tightly packed image of 3 or 4 components into dst, which
+    // must hold getCompressedSize() bytes.  Partial edge blocks repeat the
+    // last row and column.
+    static bool compress(EFormat format, const U8* src, S32 width, S32 height, S32 components, U8* dst);
+
+    // Expand compressed blocks back to width x height RGBA pixels.
+    static void decompress(EFormat format, const U8* src, S32 width, S32 height, U8* dst);
+
+    static void compressBlockBC1(const U8* rgba, U8* dst);
+    static void compressBlockBC3(const U8* rgba, U8* dst);
+    static void decompressBlockBC1(const U8* src, U8* rgba);
+    static void decompressBlockBC3(const U8* src, U8* rgba);
+};
+
+#endif // LL_LLIMAGEBC_H
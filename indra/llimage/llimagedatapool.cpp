@@ -0,0 +1,291 @@
+/**
+ * @file llimagedatapool.cpp
+ * @brief Size classed recycling of image data buffers
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagedatapool.h"
+
+#include "llmemory.h"
+#include "llmutex.h"
+
+#include <atomic>
+#include <vector>
+
+namespace
+{
+    const S32 CLASSES_PER_OCTAVE = 4;
+    const S32 MIN_SHIFT = 13;   // MIN_POOLED_SIZE - 1 == 1 << 13
+    const S32 MAX_SHIFT = 25;   // MAX_POOLED_SIZE == 2 << 25
+    const S32 NUM_CLASSES = (MAX_SHIFT - MIN_SHIFT + 1) * CLASSES_PER_OCTAVE;
+
+    // What a thread keeps for itself.  Decoders allocate and the main
+    // thread frees after upload, so most buffers pass through the shared
+    // cache anyway; the thread caches catch scratch buffers and the
+    // allocate/free pairs of scaling.
+    const size_t THREAD_BLOCKS_PER_CLASS = 4;
+    const U64 THREAD_MAX_BYTES = 8 * 1024 * 1024;
+
+    const U64 DEFAULT_MAX_BYTES = 128 * 1024 * 1024;
+
+    std::atomic<U64> sHits(0);
+    std::atomic<U64> sMisses(0);
+
+    inline bool is_pooled(S32 size)
+    {
+        return size >= LLImageDataPool::MIN_POOLED_SIZE && size <= LLImageDataPool::MAX_POOLED_SIZE;
+    }
+
+    // A size in (2^b, 2^(b+1)] rounds up to a multiple of 2^(b-2)
+    inline S32 class_index(S32 size, S32& capacity)
+    {
+        U32 rest = (U32)(size - 1);
+        S32 b = 0;
+        while (rest >>= 1)
+        {
+            ++b;
+        }
+        const S32 step_shift = b - 2;
+        const S32 steps = ((size - 1) >> step_shift) + 1;   // 5 to 8
+        capacity = steps << step_shift;
+        return (b - MIN_SHIFT) * CLASSES_PER_OCTAVE + steps - 5;
+    }
+
+    struct BlockCache
+    {
+        std::vector<U8*> mBlocks[NUM_CLASSES];
+        U64 mBytes = 0;
+
+        U8* pop(S32 index, S32 capacity)
+        {
+            std::vector<U8*>& blocks = mBlocks[index];
+            if (blocks.empty())
+            {
+                return nullptr;
+            }
+            U8* data = blocks.back();
+            blocks.pop_back();
+            mBytes -= capacity;
+            return data;
+        }
+
+        void push(S32 index, S32 capacity, U8* data)
+        {
+            mBlocks[index].push_back(data);
+            mBytes += capacity;
+        }
+
+        // Largest first, until at most max_bytes are left
+        void shrink(U64 max_bytes)
+        {
+            for (S32 index = NUM_CLASSES - 1; index >= 0 && mBytes > max_bytes; --index)
+            {
+                const S32 capacity = classSize(index);
+                std::vector<U8*>& blocks = mBlocks[index];
+                while (!blocks.empty() && mBytes > max_bytes)
+                {
+                    ll_aligned_free_16(blocks.back());
+                    blocks.pop_back();
+                    mBytes -= capacity;
+                }
+            }
+        }
+
+        static S32 classSize(S32 index)
+        {
+            const S32 b = index / CLASSES_PER_OCTAVE + MIN_SHIFT;
+            return (index % CLASSES_PER_OCTAVE + 5) << (b - 2);
+        }
+    };
+
+    struct SharedCache : public BlockCache
+    {
+        LLMutex mMutex;
+        U64 mMaxBytes = DEFAULT_MAX_BYTES;
+    };
+
+    // Never destroyed, images freed by static destructors still come here
+    SharedCache& shared_cache()
+    {
+        static SharedCache* cache = new SharedCache;
+        return *cache;
+    }
+
+    struct ThreadCache : public BlockCache
+    {
+        ~ThreadCache();
+    };
+
+    // Trivially destructible, so still readable after tThreadCache is gone
+    thread_local bool tThreadCacheGone = false;
+    thread_local ThreadCache tThreadCache;
+
+    ThreadCache::~ThreadCache()
+    {
+        tThreadCacheGone = true;
+        SharedCache& cache = shared_cache();
+        LLMutexLock lock(&cache.mMutex);
+        for (S32 index = 0; index < NUM_CLASSES; ++index)
+        {
+            const S32 capacity = BlockCache::classSize(index);
+            for (U8* data : mBlocks[index])
+            {
+                if (cache.mBytes + capacity <= cache.mMaxBytes)
+                {
+                    cache.push(index, capacity, data);
+                }
+                else
+                {
+                    ll_aligned_free_16(data);
+                }
+            }
+            mBlocks[index].clear();
+        }
+        mBytes = 0;
+    }
+}
+
+//static
+U8* LLImageDataPool::allocate(S32 size)
+{
+    if (!is_pooled(size))
+    {
+        return (U8*)ll_aligned_malloc_16(size);
+    }
+
+    S32 capacity;
+    const S32 index = class_index(size, capacity);
+    U8* data = tThreadCacheGone ? nullptr : tThreadCache.pop(index, capacity);
+    if (!data)
+    {
+        SharedCache& cache = shared_cache();
+        LLMutexLock lock(&cache.mMutex);
+        data = cache.pop(index, capacity);
+    }
+    if (data)
+    {
+        sHits.fetch_add(1, std::memory_order_relaxed);
+        return data;
+    }
+
+    sMisses.fetch_add(1, std::memory_order_relaxed);
+    return (U8*)ll_aligned_malloc_16(capacity);
+}
+
+//static
+void LLImageDataPool::release(U8* data, S32 size)
+{
+    if (!data)
+    {
+        return;
+    }
+    if (!is_pooled(size))
+    {
+        ll_aligned_free_16(data);
+        return;
+    }
+
+    S32 capacity;
+    const S32 index = class_index(size, capacity);
+    if (!tThreadCacheGone
+        && tThreadCache.mBlocks[index].size() < THREAD_BLOCKS_PER_CLASS
+        && tThreadCache.mBytes + capacity <= THREAD_MAX_BYTES)
+    {
+        tThreadCache.push(index, capacity, data);
+        return;
+    }
+
+    {
+        SharedCache& cache = shared_cache();
+        LLMutexLock lock(&cache.mMutex);
+        if (cache.mBytes + capacity <= cache.mMaxBytes)
+        {
+            cache.push(index, capacity, data);
+            return;
+        }
+    }
+    ll_aligned_free_16(data);
+}
+
+//static
+S32 LLImageDataPool::getCapacity(S32 size)
+{
+    if (!is_pooled(size))
+    {
+        return size;
+    }
+    S32 capacity;
+    class_index(size, capacity);
+    return capacity;
+}
+
+//static
+bool LLImageDataPool::isSameClass(S32 size_a, S32 size_b)
+{
+    if (!is_pooled(size_a) || !is_pooled(size_b))
+    {
+        return size_a == size_b;
+    }
+    S32 capacity;
+    return class_index(size_a, capacity) == class_index(size_b, capacity);
+}
+
+//static
+void LLImageDataPool::setMaxBytes(U64 bytes)
+{
+    SharedCache& cache = shared_cache();
+    LLMutexLock lock(&cache.mMutex);
+    cache.mMaxBytes = bytes;
+    cache.shrink(bytes);
+}
+
+//static
+void LLImageDataPool::trim()
+{
+    if (!tThreadCacheGone)
+    {
+        tThreadCache.shrink(0);
+    }
+    SharedCache& cache = shared_cache();
+    LLMutexLock lock(&cache.mMutex);
+    cache.shrink(0);
+}
+
+//static
+U64 LLImageDataPool::getCachedBytes()
+{
+    SharedCache& cache = shared_cache();
+    LLMutexLock lock(&cache.mMutex);
+    return cache.mBytes;
+}
+
+//static
+U64 LLImageDataPool::getHitCount()
+{
+    return sHits.load(std::memory_order_relaxed);
+}
+
+//static
+U64 LLImageDataPool::getMissCount()
+{
+    return sMisses.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file llimagedatapool.h
+ * @brief Size classed recycling of image data buffers
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEDATAPOOL_H
+#define LL_LLIMAGEDATAPOOL_H
+
+// Keeps freed image buffers for reuse instead of handing multi-megabyte
+// blocks back to the heap after every decode, scale and upload.
+//
+// Sizes between MIN_POOLED_SIZE and MAX_POOLED_SIZE are rounded up to one
+// of four classes per power of two (at most 25% slack), so a 512x512x3
+// buffer can be reused for any image of that or a slightly smaller size.
+// Each thread keeps a few buffers of its own and the rest go to a shared
+// cache bounded by setMaxBytes().  Other sizes go straight to the heap.
+//
+// Buffers are ordinary ll_aligned_malloc_16() blocks, so one that leaves
+// the pool (LLImageRaw::releaseData()) can still be ll_aligned_free_16()'d.
+class LLImageDataPool
+{
+public:
+    static const S32 MIN_POOLED_SIZE = 8 * 1024 + 1;
+    static const S32 MAX_POOLED_SIZE = 64 * 1024 * 1024;
+
+    // 16 byte aligned, at least size bytes.  Thread safe.
+    static U8* allocate(S32 size);
+
+    // Hand back a buffer from allocate(), size must be the size it was
+    // allocated with or any other size of the same class.  Thread safe.
+    static void release(U8* data, S32 size);
+
+    // Bytes a buffer allocated with size actually holds
+    static S32 getCapacity(S32 size);
+
+    // True if both sizes give buffers of the same class, so a buffer of
+    // one can stand in for the other without reallocating
+    static bool isSameClass(S32 size_a, S32 size_b);
+
+    // Most bytes the shared cache holds on to
+    static void setMaxBytes(U64 bytes);
+
+    // Free everything cached by the shared cache and the calling thread
+    static void trim();
+
+    // Bytes held by the shared cache, and how often allocate() found a
+    // buffer to reuse
+    static U64 getCachedBytes();
+    static U64 getHitCount();
+    static U64 getMissCount();
+};
+
+#endif // LL_LLIMAGEDATAPOOL_H
@@ -35,6 +35,248 @@
 #include "v3math.h"
 #include "llsdserialize.h"
 #include "llstring.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <emmintrin.h>
+#include <functional>
+#include <mutex>
+
+namespace
+{
+    // Filters run over bands of whole rows about this big, so that a chain
+    // of point-wise operations finds its band still in cache.
+    constexpr S32 TILE_BYTES = 128 * 1024;
+    // Smaller images are not worth handing to the thread pool
+    constexpr S32 MIN_PARALLEL_PIXELS = 256 * 256;
+
+    S32 get_tile_rows(S32 row_bytes, S32 height)
+    {
+        return llclamp(TILE_BYTES / llmax(row_bytes, 1), 1, llmax(height, 1));
+    }
+
+    // Tiles are claimed from a shared counter by the calling thread and by
+    // helpers posted to the "General" pool.  The caller only waits for tiles
+    // others have claimed, so a helper that never gets scheduled, or a
+    // caller that is itself on the pool, cannot stall the filter.
+    struct TileJob
+    {
+        TileJob(S32 count, const std::function<void(S32)>& func)
+            : mCount(count), mFunc(func)
+        {
+        }
+
+        void run()
+        {
+            S32 tile;
+            while ((tile = mNext++) < mCount)
+            {
+                mFunc(tile);
+                if (++mDone == mCount)
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mCondition.notify_all();
+                }
+            }
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mDone == mCount; });
+        }
+
+        const S32 mCount;
+        std::atomic<S32> mNext{ 0 };
+        std::atomic<S32> mDone{ 0 };
+        std::function<void(S32)> mFunc;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
+
+    void run_tiles(S32 tiles, bool parallel, const std::function<void(S32)>& func)
+    {
+        size_t helpers = 0;
+        LL::WorkQueue::ptr_t queue;
+        if (parallel && tiles > 1)
+        {
+            queue = LL::WorkQueue::getInstance("General");
+            const LL::ThreadPool::ptr_t pool = LL::ThreadPool::getInstance("General");
+            if (queue && pool && !queue->isClosed())
+            {
+                helpers = llmin((size_t)(tiles - 1), pool->getWidth());
+            }
+        }
+
+        if (!helpers)
+        {
+            for (S32 tile = 0; tile < tiles; ++tile)
+            {
+                func(tile);
+            }
+            return;
+        }
+
+        auto job = std::make_shared<TileJob>(tiles, func);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            if (!queue->tryPost([job]() { job->run(); }))
+            {
+                break;
+            }
+        }
+        job->run();
+        job->wait();
+    }
+
+    // Loads one 3 or 4 component pixel as four floats.  The last pixel of
+    // a 3 component row is read bytewise so as not to run off the image.
+    inline __m128 load_pixel(const U8* pixel, S32 components, bool last)
+    {
+        S32 value = 0;
+        if (components == 3 && last)
+        {
+            memcpy(&value, pixel, 3);
+        }
+        else
+        {
+            memcpy(&value, pixel, 4);
+        }
+        const __m128i zero = _mm_setzero_si128();
+        __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+    }
+
+    // Clamp to [0, 255] and truncate, as the scalar code did on its way to U8
+    inline S32 store_pixel(__m128 v)
+    {
+        v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.f));
+        __m128i i = _mm_cvttps_epi32(v);
+        i = _mm_packs_epi32(i, i);
+        return _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+    }
+
+    // Row vector times matrix, out = r * M[0] + g * M[1] + b * M[2].  The
+    // effect row must have room for 4 bytes at the last pixel.
+    void transform_row(const U8* row, U8* effect, S32 width, S32 components, const F32 (&m)[3][3])
+    {
+        const __m128 m0 = _mm_setr_ps(m[0][0], m[0][1], m[0][2], 0.f);
+        const __m128 m1 = _mm_setr_ps(m[1][0], m[1][1], m[1][2], 0.f);
+        const __m128 m2 = _mm_setr_ps(m[2][0], m[2][1], m[2][2], 0.f);
+        for (S32 i = 0; i < width; ++i)
+        {
+            const __m128 src = load_pixel(row + i * components, components, i == width - 1);
+            __m128 dst = _mm_mul_ps(_mm_shuffle_ps(src, src, _MM_SHUFFLE(0, 0, 0, 0)), m0);
+            dst = _mm_add_ps(dst, _mm_mul_ps(_mm_shuffle_ps(src, src, _MM_SHUFFLE(1, 1, 1, 1)), m1));
+            dst = _mm_add_ps(dst, _mm_mul_ps(_mm_shuffle_ps(src, src, _MM_SHUFFLE(2, 2, 2, 2)), m2));
+            const S32 out = store_pixel(dst);
+            memcpy(effect + i * components, &out, 4);
+        }
+    }
+
+    struct ConvolveKernel
+    {
+        F32 mWeights[3][3];
+        bool mAbsValue;
+        bool mNormalize;
+        F32 mMin;
+        F32 mRange;
+    };
+
+    // Adds weight times the sixteen bytes at p, widened to floats, into sum
+    inline void accumulate(const U8* p, __m128 weight, __m128& sum0, __m128& sum1, __m128& sum2, __m128& sum3)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i v = _mm_loadu_si128((const __m128i*)p);
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero))));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero))));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero))));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))));
+    }
+
+    inline __m128i finish_sum(__m128 sum, const ConvolveKernel& kernel)
+    {
+        if (kernel.mAbsValue)
+        {
+            sum = _mm_andnot_ps(_mm_set1_ps(-0.f), sum);
+        }
+        if (kernel.mNormalize)
+        {
+            sum = _mm_div_ps(_mm_sub_ps(sum, _mm_set1_ps(kernel.mMin)), _mm_set1_ps(kernel.mRange));
+        }
+        sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(255.f));
+        return _mm_cvttps_epi32(sum);
+    }
+
+    // 3x3 convolution of the interior pixels of a row.  Each byte only
+    // mixes with the same component of its neighbours, so the row is
+    // treated as a flat run of bytes, sixteen at a time, with the taps one
+    // pixel apart.  Edge pixels are left black.
+    void convolve_row(const U8* north, const U8* center, const U8* south, U8* effect,
+                      S32 width, S32 components, const ConvolveKernel& kernel)
+    {
+        const S32 row_bytes = width * components;
+        memset(effect, 0, row_bytes);
+        if (width < 3)
+        {
+            return;
+        }
+
+        const U8* rows[3] = { north, center, south };
+        __m128 weights[3][3];
+        for (S32 r = 0; r < 3; ++r)
+        {
+            for (S32 c = 0; c < 3; ++c)
+            {
+                weights[r][c] = _mm_set1_ps(kernel.mWeights[r][c]);
+            }
+        }
+
+        const S32 end = row_bytes - components;
+        S32 b = components;
+        for (; b + 16 <= end; b += 16)
+        {
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = sum0;
+            __m128 sum2 = sum0;
+            __m128 sum3 = sum0;
+            for (S32 r = 0; r < 3; ++r)
+            {
+                const U8* p = rows[r] + b;
+                accumulate(p - components, weights[r][0], sum0, sum1, sum2, sum3);
+                accumulate(p, weights[r][1], sum0, sum1, sum2, sum3);
+                accumulate(p + components, weights[r][2], sum0, sum1, sum2, sum3);
+            }
+            const __m128i lo = _mm_packs_epi32(finish_sum(sum0, kernel), finish_sum(sum1, kernel));
+            const __m128i hi = _mm_packs_epi32(finish_sum(sum2, kernel), finish_sum(sum3, kernel));
+            _mm_storeu_si128((__m128i*)(effect + b), _mm_packus_epi16(lo, hi));
+        }
+        for (; b < end; ++b)
+        {
+            F32 sum = 0.f;
+            for (S32 r = 0; r < 3; ++r)
+            {
+                for (S32 c = 0; c < 3; ++c)
+                {
+                    sum += kernel.mWeights[r][c] * rows[r][b + (c - 1) * components];
+                }
+            }
+            if (kernel.mAbsValue)
+            {
+                sum = llabs(sum);
+            }
+            if (kernel.mNormalize)
+            {
+                sum = (sum - kernel.mMin) / kernel.mRange;
+            }
+            effect[b] = (U8)llclamp(sum, 0.f, 255.f);
+        }
+    }
+}
 
 //---------------------------------------------------------------------------
 // LLImageFilter
@@ -76,7 +318,6 @@ LLImageFilter::~LLImageFilter()
 /*
  *TODO
  * Rename stencil to mask
- * Improve perf: use LUT for alpha blending in uniform case
  * Add gradient coloring as a filter
  */
 
@@ -87,6 +328,13 @@ LLImageFilter::~LLImageFilter()
 void LLImageFilter::executeFilter(LLPointer<LLImageRaw> raw_image)
 {
     mImage = raw_image;
+    mPointOps.clear();
+
+    if (mImage.isNull() || mImage->isBufferInvalid() || mImage->getComponents() < 3)
+    {
+        LL_WARNS() << "Filters need an RGB or RGBA image" << LL_ENDL;
+        return;
+    }
 
     //std::cout << "Filter : size = " << mFilterData.size() << std::endl;
     for (S32 i = 0; i < mFilterData.size(); ++i)
@@ -148,7 +396,8 @@ void LLImageFilter::executeFilter(LLPointer<LLImageRaw> raw_image)
             {
                 params[j-5] = (F32)(mFilterData[i][j].asReal());
             }
-            // Set the stencil
+            // Set the stencil, queued operations use the previous one
+            flushPointOps();
             setStencil(shape,mode,min,max,params);
         }
         else if (filter_name == "sepia")
@@ -269,93 +518,233 @@ void LLImageFilter::executeFilter(LLPointer<LLImageRaw> raw_image)
             LL_WARNS() << "Filter unknown, cannot execute filter command : " << filter_name << LL_ENDL;
         }
     }
+    flushPointOps();
 }
 
 //============================================================================
 // Filter Primitives
 //============================================================================
 
-void LLImageFilter::blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue)
+void LLImageFilter::blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue) const
+{
+    pixel[VRED]   = blendStencilChannel(alpha, pixel[VRED], red);
+    pixel[VGREEN] = blendStencilChannel(alpha, pixel[VGREEN], green);
+    pixel[VBLUE]  = blendStencilChannel(alpha, pixel[VBLUE], blue);
+}
+
+U8 LLImageFilter::blendStencilChannel(F32 alpha, U8 pixel, U8 value) const
 {
     F32 inv_alpha = 1.0 - alpha;
     switch (mStencilBlendMode)
     {
         case STENCIL_BLEND_MODE_BLEND:
             // Classic blend of incoming color with the background image
-            pixel[VRED]   = inv_alpha * pixel[VRED]   + alpha * red;
-            pixel[VGREEN] = inv_alpha * pixel[VGREEN] + alpha * green;
-            pixel[VBLUE]  = inv_alpha * pixel[VBLUE]  + alpha * blue;
-            break;
+            return (U8)(inv_alpha * pixel + alpha * value);
         case STENCIL_BLEND_MODE_ADD:
             // Add incoming color to the background image
-            pixel[VRED]   = llclampb(pixel[VRED]   + alpha * red);
-            pixel[VGREEN] = llclampb(pixel[VGREEN] + alpha * green);
-            pixel[VBLUE]  = llclampb(pixel[VBLUE]  + alpha * blue);
-            break;
+            return (U8)llclampb(pixel + alpha * value);
         case STENCIL_BLEND_MODE_ABACK:
             // Add back background image to the incoming color
-            pixel[VRED]   = llclampb(inv_alpha * pixel[VRED]   + red);
-            pixel[VGREEN] = llclampb(inv_alpha * pixel[VGREEN] + green);
-            pixel[VBLUE]  = llclampb(inv_alpha * pixel[VBLUE]  + blue);
-            break;
+            return (U8)llclampb(inv_alpha * pixel + value);
         case STENCIL_BLEND_MODE_FADE:
             // Fade incoming color to black
-            pixel[VRED]   = alpha * red;
-            pixel[VGREEN] = alpha * green;
-            pixel[VBLUE]  = alpha * blue;
-            break;
+            return (U8)(alpha * value);
     }
+    return pixel;
 }
 
-void LLImageFilter::colorCorrect(const U8* lut_red, const U8* lut_green, const U8* lut_blue)
+// Blend a row of computed colors, laid out like the image row, through the stencil
+void LLImageFilter::blendRow(S32 j, U8* row, const U8* effect) const
 {
     const S32 components = mImage->getComponents();
-    llassert( components >= 1 && components <= 4 );
+    const S32 width = mImage->getWidth();
+    if (mStencilShape == STENCIL_SHAPE_UNIFORM && mStencilBlendMode == STENCIL_BLEND_MODE_BLEND && getStencilAlpha(0, 0) == 1.f)
+    {
+        // Fully opaque stencil: the result simply replaces the color
+        if (components == 3)
+        {
+            memcpy(row, effect, width * 3);
+        }
+        else
+        {
+            for (S32 i = 0; i < width; i++)
+            {
+                memcpy(row + i * components, effect + i * components, 3);
+            }
+        }
+        return;
+    }
 
-    S32 width  = mImage->getWidth();
-    S32 height = mImage->getHeight();
+    for (S32 i = 0; i < width; i++)
+    {
+        const U8* color = effect + i * components;
+        blendStencil(getStencilAlpha(i,j), row + i * components, color[VRED], color[VGREEN], color[VBLUE]);
+    }
+}
 
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
+//============================================================================
+// Point-wise operations
+//============================================================================
+
+void LLImageFilter::queuePointOp(const PointOp& op)
+{
+    if (op.mType == PointOp::LUT && mStencilShape == STENCIL_SHAPE_UNIFORM)
     {
-        for (S32 i = 0; i < width; i++)
+        // A uniform stencil blends each channel the same everywhere, so it
+        // can be baked into the table, and consecutive baked tables compose.
+        PointOp baked = op;
+        const F32 alpha = getStencilAlpha(0, 0);
+        for (S32 c = 0; c < 3; c++)
+        {
+            for (S32 v = 0; v < 256; v++)
+            {
+                baked.mLUT[c][v] = blendStencilChannel(alpha, (U8)v, op.mLUT[c][v]);
+            }
+        }
+        baked.mStencilApplied = true;
+
+        if (!mPointOps.empty() && mPointOps.back().mType == PointOp::LUT && mPointOps.back().mStencilApplied)
         {
-            // Blend LUT value
-            blendStencil(getStencilAlpha(i,j), dst_data, lut_red[dst_data[VRED]], lut_green[dst_data[VGREEN]], lut_blue[dst_data[VBLUE]]);
-            dst_data += components;
+            PointOp& previous = mPointOps.back();
+            for (S32 c = 0; c < 3; c++)
+            {
+                for (S32 v = 0; v < 256; v++)
+                {
+                    previous.mLUT[c][v] = baked.mLUT[c][previous.mLUT[c][v]];
+                }
+            }
+            return;
         }
+        mPointOps.push_back(baked);
+        return;
     }
+    mPointOps.push_back(op);
 }
 
-void LLImageFilter::colorTransform(const LLMatrix3 &transform)
+void LLImageFilter::flushPointOps()
 {
-    const S32 components = mImage->getComponents();
-    llassert( components >= 1 && components <= 4 );
+    if (mPointOps.empty())
+    {
+        return;
+    }
 
-    S32 width  = mImage->getWidth();
-    S32 height = mImage->getHeight();
+    const S32 width = mImage->getWidth();
+    const S32 height = mImage->getHeight();
+    const S32 row_bytes = width * mImage->getComponents();
+    const S32 tile_rows = get_tile_rows(row_bytes, height);
+    const S32 tiles = (height + tile_rows - 1) / tile_rows;
 
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
+    run_tiles(tiles, width * height >= MIN_PARALLEL_PIXELS, [&](S32 tile)
     {
-        for (S32 i = 0; i < width; i++)
+        const S32 first_row = tile * tile_rows;
+        const S32 last_row = llmin(first_row + tile_rows, height);
+        std::vector<U8> effect(row_bytes + 4);
+        for (const PointOp& op : mPointOps)
         {
-            // Compute transform
-            LLVector3 src((F32)(dst_data[VRED]),(F32)(dst_data[VGREEN]),(F32)(dst_data[VBLUE]));
-            LLVector3 dst = src * transform;
-            dst.clamp(0.0f,255.0f);
+            applyPointOp(op, first_row, last_row, effect.data());
+        }
+    });
+
+    mPointOps.clear();
+}
+
+void LLImageFilter::applyPointOp(const PointOp& op, S32 first_row, S32 last_row, U8* effect) const
+{
+    const S32 components = mImage->getComponents();
+    const S32 width = mImage->getWidth();
+    const S32 row_bytes = width * components;
+    U8* data = mImage->getData();
 
-            // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, dst.mV[VRED], dst.mV[VGREEN], dst.mV[VBLUE]);
-            dst_data += components;
+    for (S32 j = first_row; j < last_row; j++)
+    {
+        U8* row = data + j * row_bytes;
+        switch (op.mType)
+        {
+            case PointOp::LUT:
+                if (op.mStencilApplied)
+                {
+                    for (U8* pixel = row; pixel < row + row_bytes; pixel += components)
+                    {
+                        pixel[VRED]   = op.mLUT[VRED][pixel[VRED]];
+                        pixel[VGREEN] = op.mLUT[VGREEN][pixel[VGREEN]];
+                        pixel[VBLUE]  = op.mLUT[VBLUE][pixel[VBLUE]];
+                    }
+                }
+                else
+                {
+                    U8* pixel = row;
+                    for (S32 i = 0; i < width; i++)
+                    {
+                        // Blend LUT value
+                        blendStencil(getStencilAlpha(i,j), pixel, op.mLUT[VRED][pixel[VRED]], op.mLUT[VGREEN][pixel[VGREEN]], op.mLUT[VBLUE][pixel[VBLUE]]);
+                        pixel += components;
+                    }
+                }
+                break;
+            case PointOp::TRANSFORM:
+                transform_row(row, effect, width, components, op.mTransform);
+                blendRow(j, row, effect);
+                break;
+            case PointOp::SCREEN:
+            {
+                U8* pixel = row;
+                for (S32 i = 0; i < width; i++)
+                {
+                    // Compute screen value
+                    F32 value = 0.0;
+                    F32 di = 0.0;
+                    F32 dj = 0.0;
+                    switch (op.mScreenMode)
+                    {
+                        case SCREEN_MODE_2DSINE:
+                            di =  op.mCosine*i + op.mSine*j;
+                            dj = -op.mSine*i + op.mCosine*j;
+                            value = (sinf(2*F_PI*di/op.mWaveLengthPixels)*sinf(2*F_PI*dj/op.mWaveLengthPixels)+1.0)*255.0/2.0;
+                            break;
+                        case SCREEN_MODE_LINE:
+                            dj = op.mSine*i - op.mCosine*j;
+                            value = (sinf(2*F_PI*dj/op.mWaveLengthPixels)+1.0)*255.0/2.0;
+                            break;
+                    }
+                    U8 dst_value = (pixel[VRED] >= (U8)(value) ? op.mLUT[0][pixel[VRED] - (U8)(value)] : 0);
+
+                    // Blend result
+                    blendStencil(getStencilAlpha(i,j), pixel, dst_value, dst_value, dst_value);
+                    pixel += components;
+                }
+                break;
+            }
         }
     }
 }
 
+void LLImageFilter::colorCorrect(const U8* lut_red, const U8* lut_green, const U8* lut_blue)
+{
+    PointOp op;
+    op.mType = PointOp::LUT;
+    op.mStencilApplied = false;
+    memcpy(op.mLUT[VRED], lut_red, 256);
+    memcpy(op.mLUT[VGREEN], lut_green, 256);
+    memcpy(op.mLUT[VBLUE], lut_blue, 256);
+    queuePointOp(op);
+}
+
+void LLImageFilter::colorTransform(const LLMatrix3 &transform)
+{
+    PointOp op;
+    op.mType = PointOp::TRANSFORM;
+    op.mStencilApplied = false;
+    memcpy(op.mTransform, transform.mMatrix, sizeof(op.mTransform));
+    queuePointOp(op);
+}
+
 void LLImageFilter::convolve(const LLMatrix3 &kernel, bool normalize, bool abs_value)
 {
+    // The kernel reads neighbours, so everything queued has to land first
+    flushPointOps();
+
     const S32 components = mImage->getComponents();
-    llassert( components >= 1 && components <= 4 );
+    llassert( components >= 3 && components <= 4 );
 
     // Compute normalization factors
     F32 kernel_min = 0.0;
@@ -377,166 +766,86 @@ void LLImageFilter::convolve(const LLMatrix3 &kernel, bool normalize, bool abs_v
         kernel_max = llmax(kernel_max,kernel_min);
         kernel_min = 0.0;
     }
-    F32 kernel_range = kernel_max - kernel_min;
 
-    // Allocate temporary buffers and initialize algorithm's data
+    ConvolveKernel conv;
+    memcpy(conv.mWeights, kernel.mMatrix, sizeof(conv.mWeights));
+    conv.mAbsValue = abs_value;
+    conv.mNormalize = normalize;
+    conv.mMin = kernel_min;
+    conv.mRange = kernel_max - kernel_min;
+
     S32 width  = mImage->getWidth();
     S32 height = mImage->getHeight();
-
-    U8* dst_data = mImage->getData();
-
-    S32 buffer_size = width * components;
-    llassert(buffer_size > 0);
-    std::vector<U8> even_buffer(buffer_size);
-    std::vector<U8> odd_buffer(buffer_size);
-
-    U8* south_data = dst_data + buffer_size;
-    U8* east_west_data;
-    U8* north_data;
-
-    // Line 0 : we set the line to 0 (debatable)
-    memcpy( &even_buffer[0], dst_data, buffer_size );   /* Flawfinder: ignore */
-    for (S32 i = 0; i < width; i++)
-    {
-        blendStencil(getStencilAlpha(i,0), dst_data, 0, 0, 0);
-        dst_data += components;
-    }
-    south_data += buffer_size;
-
-    // All other lines
-    for (S32 j = 1; j < (height-1); j++)
+    S32 row_bytes = width * components;
+    llassert(row_bytes > 0);
+    U8* data = mImage->getData();
+
+    // Tiles write in place, so the rows just outside each tile are saved
+    // before any of them start.
+    const S32 tile_rows = get_tile_rows(row_bytes, height);
+    const S32 tiles = (height + tile_rows - 1) / tile_rows;
+    std::vector<U8> halos((size_t)tiles * 2 * row_bytes);
+    for (S32 tile = 0; tile < tiles; tile++)
     {
-        // We need to buffer 2 lines. We flip north and east-west (current) to avoid moving too much memory around
-        if (j % 2)
+        const S32 first_row = tile * tile_rows;
+        const S32 last_row = llmin(first_row + tile_rows, height);
+        if (first_row > 0)
         {
-            memcpy( &odd_buffer[0], dst_data, buffer_size );    /* Flawfinder: ignore */
-            east_west_data = &odd_buffer[0];
-            north_data = &even_buffer[0];
+            memcpy(&halos[(size_t)tile * 2 * row_bytes], data + (size_t)(first_row - 1) * row_bytes, row_bytes);
         }
-        else
+        if (last_row < height)
         {
-            memcpy( &even_buffer[0], dst_data, buffer_size );   /* Flawfinder: ignore */
-            east_west_data = &even_buffer[0];
-            north_data = &odd_buffer[0];
+            memcpy(&halos[((size_t)tile * 2 + 1) * row_bytes], data + (size_t)last_row * row_bytes, row_bytes);
         }
-        // First pixel : set to 0
-        blendStencil(getStencilAlpha(0,j), dst_data, 0, 0, 0);
-        dst_data += components;
-        // Set pointers to kernel
-        U8* NW = north_data;
-        U8* N = NW+components;
-        U8* NE = N+components;
-        U8* W = east_west_data;
-        U8* C = W+components;
-        U8* E = C+components;
-        U8* SW = south_data;
-        U8* S = SW+components;
-        U8* SE = S+components;
-        // All other pixels
-        for (S32 i = 1; i < (width-1); i++)
-        {
-            // Compute convolution
-            LLVector3 dst;
-            dst.mV[VRED] = (kernel.mMatrix[0][0]*NW[VRED] + kernel.mMatrix[0][1]*N[VRED] + kernel.mMatrix[0][2]*NE[VRED] +
-                            kernel.mMatrix[1][0]*W[VRED]  + kernel.mMatrix[1][1]*C[VRED] + kernel.mMatrix[1][2]*E[VRED] +
-                            kernel.mMatrix[2][0]*SW[VRED] + kernel.mMatrix[2][1]*S[VRED] + kernel.mMatrix[2][2]*SE[VRED]);
-            dst.mV[VGREEN] = (kernel.mMatrix[0][0]*NW[VGREEN] + kernel.mMatrix[0][1]*N[VGREEN] + kernel.mMatrix[0][2]*NE[VGREEN] +
-                              kernel.mMatrix[1][0]*W[VGREEN]  + kernel.mMatrix[1][1]*C[VGREEN] + kernel.mMatrix[1][2]*E[VGREEN] +
-                              kernel.mMatrix[2][0]*SW[VGREEN] + kernel.mMatrix[2][1]*S[VGREEN] + kernel.mMatrix[2][2]*SE[VGREEN]);
-            dst.mV[VBLUE] = (kernel.mMatrix[0][0]*NW[VBLUE] + kernel.mMatrix[0][1]*N[VBLUE] + kernel.mMatrix[0][2]*NE[VBLUE] +
-                             kernel.mMatrix[1][0]*W[VBLUE]  + kernel.mMatrix[1][1]*C[VBLUE] + kernel.mMatrix[1][2]*E[VBLUE] +
-                             kernel.mMatrix[2][0]*SW[VBLUE] + kernel.mMatrix[2][1]*S[VBLUE] + kernel.mMatrix[2][2]*SE[VBLUE]);
-            if (abs_value)
+    }
+
+    run_tiles(tiles, width * height >= MIN_PARALLEL_PIXELS, [&](S32 tile)
+    {
+        const S32 first_row = tile * tile_rows;
+        const S32 last_row = llmin(first_row + tile_rows, height);
+        const S32 rows = last_row - first_row;
+
+        // Source rows first_row - 1 to last_row, unfiltered
+        std::vector<U8> source((size_t)(rows + 2) * row_bytes);
+        memcpy(&source[0], &halos[(size_t)tile * 2 * row_bytes], row_bytes);
+        memcpy(&source[row_bytes], data + (size_t)first_row * row_bytes, (size_t)rows * row_bytes);
+        memcpy(&source[(size_t)(rows + 1) * row_bytes], &halos[((size_t)tile * 2 + 1) * row_bytes], row_bytes);
+
+        std::vector<U8> effect(row_bytes, 0);
+        for (S32 j = first_row; j < last_row; j++)
+        {
+            if (j == 0 || j == height - 1)
             {
-                dst.mV[VRED]   = llabs(dst.mV[VRED]);
-                dst.mV[VGREEN] = llabs(dst.mV[VGREEN]);
-                dst.mV[VBLUE]  = llabs(dst.mV[VBLUE]);
+                // First and last lines : we set the line to 0 (debatable)
+                memset(&effect[0], 0, row_bytes);
             }
-            if (normalize)
+            else
             {
-                dst.mV[VRED]   = (dst.mV[VRED] - kernel_min)/kernel_range;
-                dst.mV[VGREEN] = (dst.mV[VGREEN] - kernel_min)/kernel_range;
-                dst.mV[VBLUE]  = (dst.mV[VBLUE] - kernel_min)/kernel_range;
+                const U8* center = &source[(size_t)(j - first_row + 1) * row_bytes];
+                convolve_row(center - row_bytes, center, center + row_bytes, &effect[0], width, components, conv);
             }
-            dst.clamp(0.0f,255.0f);
-
-            // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, dst.mV[VRED], dst.mV[VGREEN], dst.mV[VBLUE]);
-
-            // Next pixel
-            dst_data += components;
-            NW += components;
-            N += components;
-            NE += components;
-            W += components;
-            C += components;
-            E += components;
-            SW += components;
-            S += components;
-            SE += components;
-        }
-        // Last pixel : set to 0
-        blendStencil(getStencilAlpha(width-1,j), dst_data, 0, 0, 0);
-        dst_data += components;
-        south_data += buffer_size;
-    }
-
-    // Last line
-    for (S32 i = 0; i < width; i++)
-    {
-        blendStencil(getStencilAlpha(i,0), dst_data, 0, 0, 0);
-        dst_data += components;
-    }
+            blendRow(j, data + (size_t)j * row_bytes, &effect[0]);
+        }
+    });
 }
 
 void LLImageFilter::filterScreen(EScreenMode mode, const F32 wave_length, const F32 angle)
 {
-    const S32 components = mImage->getComponents();
-    llassert( components >= 1 && components <= 4 );
-
-    S32 width  = mImage->getWidth();
-    S32 height = mImage->getHeight();
-
-    F32 wave_length_pixels = wave_length * (F32)(height) / 2.0;
-    F32 sin = sinf(angle*DEG_TO_RAD);
-    F32 cos = cosf(angle*DEG_TO_RAD);
+    PointOp op;
+    op.mType = PointOp::SCREEN;
+    op.mStencilApplied = false;
+    op.mScreenMode = mode;
+    op.mWaveLengthPixels = wave_length * (F32)(mImage->getHeight()) / 2.0;
+    op.mSine = sinf(angle*DEG_TO_RAD);
+    op.mCosine = cosf(angle*DEG_TO_RAD);
 
     // Precompute the gamma table : gives us the gray level to use when cutting outside the screen (prevents strong aliasing on the screen)
-    U8 gamma[256];
     for (S32 i = 0; i < 256; i++)
     {
         F32 gamma_i = llclampf((float)(powf((float)(i)/255.0,1.0/4.0)));
-        gamma[i] = (U8)(255.0 * gamma_i);
-    }
-
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
-    {
-        for (S32 i = 0; i < width; i++)
-        {
-            // Compute screen value
-            F32 value = 0.0;
-            F32 di = 0.0;
-            F32 dj = 0.0;
-            switch (mode)
-            {
-                case SCREEN_MODE_2DSINE:
-                    di =  cos*i + sin*j;
-                    dj = -sin*i + cos*j;
-                    value = (sinf(2*F_PI*di/wave_length_pixels)*sinf(2*F_PI*dj/wave_length_pixels)+1.0)*255.0/2.0;
-                    break;
-                case SCREEN_MODE_LINE:
-                    dj = sin*i - cos*j;
-                    value = (sinf(2*F_PI*dj/wave_length_pixels)+1.0)*255.0/2.0;
-                    break;
-            }
-            U8 dst_value = (dst_data[VRED] >= (U8)(value) ? gamma[dst_data[VRED] - (U8)(value)] : 0);
-
-            // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, dst_value, dst_value, dst_value);
-            dst_data += components;
-        }
+        op.mLUT[0][i] = (U8)(255.0 * gamma_i);
     }
+    queuePointOp(op);
 }
 
 //============================================================================
@@ -569,7 +878,7 @@ void LLImageFilter::setStencil(EStencilShape shape, EStencilBlendMode mode, F32
     mStencilGradN  = mStencilGradX*mStencilGradX + mStencilGradY*mStencilGradY;
 }
 
-F32 LLImageFilter::getStencilAlpha(S32 i, S32 j)
+F32 LLImageFilter::getStencilAlpha(S32 i, S32 j) const
 {
     F32 alpha = 1.0;    // That init actually takes care of the STENCIL_SHAPE_UNIFORM case...
     if (mStencilShape == STENCIL_SHAPE_VIGNETTE)
@@ -610,6 +919,9 @@ U32* LLImageFilter::getBrightnessHistogram()
 
 void LLImageFilter::computeHistograms()
 {
+    // Histograms are of the image as filtered so far
+    flushPointOps();
+
     const S32 components = mImage->getComponents();
     llassert( components >= 1 && components <= 4 );
 
@@ -30,6 +30,8 @@
 #include "llsd.h"
 #include "llimage.h"
 
+#include <vector>
+
 class LLImageRaw;
 class LLColor4U;
 class LLColor3;
@@ -91,12 +93,38 @@ class LLImageFilter
     void colorTransform(const LLMatrix3 &transform);
     void colorCorrect(const U8* lut_red, const U8* lut_green, const U8* lut_blue);
     void filterScreen(EScreenMode mode, const F32 wave_length, const F32 angle);
-    void blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue);
+    void blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue) const;
+    U8 blendStencilChannel(F32 alpha, U8 pixel, U8 value) const;
+    void blendRow(S32 j, U8* row, const U8* effect) const;
     void convolve(const LLMatrix3 &kernel, bool normalize, bool abs_value);
 
+    // Point-wise operations (LUTs, color matrices, screens) are queued and
+    // run back to back on each tile of rows while it is in cache.  Anything
+    // needing the whole image or a new stencil flushes the queue first.
+    struct PointOp
+    {
+        enum EType
+        {
+            LUT,
+            TRANSFORM,
+            SCREEN
+        };
+        EType mType;
+        bool mStencilApplied;       // uniform stencil already folded into mLUT
+        U8 mLUT[3][256];            // per channel tables, or the screen gamma table
+        F32 mTransform[3][3];
+        EScreenMode mScreenMode;
+        F32 mWaveLengthPixels;
+        F32 mSine;
+        F32 mCosine;
+    };
+    void queuePointOp(const PointOp& op);
+    void flushPointOps();
+    void applyPointOp(const PointOp& op, S32 first_row, S32 last_row, U8* effect) const;
+
     // Procedural Stencils
     void setStencil(EStencilShape shape, EStencilBlendMode mode, F32 min, F32 max, F32* params);
-    F32 getStencilAlpha(S32 i, S32 j);
+    F32 getStencilAlpha(S32 i, S32 j) const;
 
     // Histograms
     U32* getBrightnessHistogram();
@@ -104,6 +132,7 @@ class LLImageFilter
 
     LLSD mFilterData;
     LLPointer<LLImageRaw> mImage;
+    std::vector<PointOp> mPointOps;
 
     // Histograms (if we ever happen to need them)
     U32 *mHistoRed;
@@ -42,6 +42,16 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+std::atomic<S32> LLImageJ2C::sDecodeThreads(0);
+std::atomic<S32> LLImageJ2C::sDecodeThreadsMinArea(LLImageJ2C::DEFAULT_DECODE_THREADS_MIN_AREA);
+
+//static
+void LLImageJ2C::setDecodeThreads(S32 threads, S32 min_area)
+{
+    sDecodeThreads = llmax(threads, 0);
+    sDecodeThreadsMinArea = llmax(min_area, 0);
+}
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -31,6 +31,8 @@
 #include "llassettype.h"
 #include "llmetricperformancetester.h"
 
+#include <atomic>
+
 // JPEG2000 : compression rate used in j2c conversion.
 const F32 DEFAULT_COMPRESSION_RATE = 1.f/8.f;
 
@@ -78,6 +80,16 @@ class LLImageJ2C final : public LLImageFormatted
 
     static std::string getEngineInfo();
 
+    // Codec worker threads used for a single decode whose output is at
+    // least min_area pixels.  0 or 1 keeps every decode single-threaded.
+    // These threads are in addition to the caller's, so callers running
+    // several decodes at once should divide their cores accordingly.
+    static void setDecodeThreads(S32 threads, S32 min_area = DEFAULT_DECODE_THREADS_MIN_AREA);
+    static S32 getDecodeThreads() { return sDecodeThreads; }
+    static S32 getDecodeThreadsMinArea() { return sDecodeThreadsMinArea; }
+
+    static const S32 DEFAULT_DECODE_THREADS_MIN_AREA = 1024 * 1024;
+
 protected:
     friend class LLImageJ2CImpl;
     friend class LLImageJ2COJ;
@@ -99,6 +111,9 @@ class LLImageJ2C final : public LLImageFormatted
 
     // Image compression/decompression tester
     static LLImageCompressionTester* sTesterp;
+
+    static std::atomic<S32> sDecodeThreads;
+    static std::atomic<S32> sDecodeThreadsMinArea;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -121,6 +136,11 @@ class LLImageJ2CImpl
     virtual bool decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count) = 0;
     virtual bool encodeImpl(LLImageJ2C &base, const LLImageRaw &raw_image, const char* comment_text, F32 encode_time=0.0,
                             bool reversible=false) = 0;
+    // Restrict subsequent decodes to a discard level and/or a region given
+    // as { x0, y0, x1, y1 } in full resolution pixels.
+    // Return value:
+    // true: the restriction will be honored by decodeImpl()
+    // false: not supported, decodes stay full frame
     virtual bool initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level = -1, int* region = NULL) = 0;
     virtual bool initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size = -1, int precincts_size = -1, int levels = 0) = 0;
 
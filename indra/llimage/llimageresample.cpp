@@ -0,0 +1,645 @@
+/**
+ * @file llimageresample.cpp
+ * @brief SIMD image resampling and mip chain generation
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimageresample.h"
+
+#include "llmath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <vector>
+
+namespace
+{
+    // Weights are S16 for _mm_madd_epi16.  The precision is picked per
+    // kernel so the largest weight still fits, capped where a full sum of
+    // 255 * weight could overflow the 32 bit accumulators.
+    constexpr S32 MAX_PRECISION = 22;
+    constexpr F64 MAX_WEIGHT = 32000.0;
+
+    F64 sinc(F64 x)
+    {
+        if (x == 0.0)
+        {
+            return 1.0;
+        }
+        x *= F_PI;
+        return sin(x) / x;
+    }
+
+    F64 filter_box(F64 x)
+    {
+        return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    }
+
+    F64 filter_bilinear(F64 x)
+    {
+        x = fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+
+    F64 filter_lanczos3(F64 x)
+    {
+        return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+    }
+
+    // Weights of every output pixel along one axis.  Output i reads
+    // mCount[i] inputs starting at mStart[i], with weights at
+    // mWeights[i * mTaps].
+    struct Kernel
+    {
+        S32 mPrecision = 0;
+        S32 mTaps = 0;
+        std::vector<S32> mStart;
+        std::vector<S32> mCount;
+        std::vector<S16> mWeights;
+
+        void build(LLImageResample::EFilter filter, S32 in_size, S32 out_size)
+        {
+            F64 (*func)(F64) = filter_bilinear;
+            F64 support = 1.0;
+            switch (filter)
+            {
+            case LLImageResample::BOX:
+                func = filter_box;
+                support = 0.5;
+                break;
+            case LLImageResample::LANCZOS3:
+                func = filter_lanczos3;
+                support = 3.0;
+                break;
+            default:
+                break;
+            }
+
+            const F64 scale = (F64)in_size / out_size;
+            const F64 filter_scale = llmax(scale, 1.0);
+            const F64 inv_filter_scale = 1.0 / filter_scale;
+            support *= filter_scale;
+
+            mTaps = (S32)ceil(support) * 2 + 1;
+            mStart.resize(out_size);
+            mCount.resize(out_size);
+            std::vector<F64> weights((size_t)out_size * mTaps, 0.0);
+
+            F64 max_weight = 0.0;
+            for (S32 i = 0; i < out_size; ++i)
+            {
+                const F64 center = (i + 0.5) * scale;
+                S32 first = llmax((S32)(center - support + 0.5), 0);
+                S32 last = llmin((S32)(center + support + 0.5), in_size);
+                S32 count = llmin(last - first, mTaps);
+
+                F64* w = &weights[(size_t)i * mTaps];
+                F64 total = 0.0;
+                for (S32 k = 0; k < count; ++k)
+                {
+                    w[k] = func((k + first - center + 0.5) * inv_filter_scale);
+                    total += w[k];
+                }
+                if (total == 0.0)
+                {
+                    // Only possible for a box landing between pixels
+                    w[0] = 1.0;
+                    total = 1.0;
+                    count = llmax(count, 1);
+                }
+                for (S32 k = 0; k < count; ++k)
+                {
+                    w[k] /= total;
+                    max_weight = llmax(max_weight, fabs(w[k]));
+                }
+
+                // Drop zero weights at the ends, they only cost loads
+                while (count > 1 && w[count - 1] == 0.0)
+                {
+                    --count;
+                }
+                S32 skip = 0;
+                while (skip < count - 1 && w[skip] == 0.0)
+                {
+                    ++skip;
+                }
+                if (skip)
+                {
+                    std::copy(w + skip, w + count, w);
+                    std::fill(w + count - skip, w + count, 0.0);
+                    first += skip;
+                    count -= skip;
+                }
+
+                mStart[i] = first;
+                mCount[i] = count;
+            }
+
+            mPrecision = MAX_PRECISION;
+            while (mPrecision > 0 && max_weight * (1 << mPrecision) > MAX_WEIGHT)
+            {
+                --mPrecision;
+            }
+
+            // Round to fixed point, then push the rounding error into the
+            // heaviest tap so that flat areas stay exactly flat.
+            const S32 one = 1 << mPrecision;
+            mWeights.assign((size_t)out_size * mTaps, 0);
+            for (S32 i = 0; i < out_size; ++i)
+            {
+                const F64* w = &weights[(size_t)i * mTaps];
+                S16* q = &mWeights[(size_t)i * mTaps];
+                S32 total = 0;
+                S32 heaviest = 0;
+                for (S32 k = 0; k < mCount[i]; ++k)
+                {
+                    q[k] = (S16)lltrunc(w[k] * one + (w[k] < 0.0 ? -0.5 : 0.5));
+                    total += q[k];
+                    if (q[k] > q[heaviest])
+                    {
+                        heaviest = k;
+                    }
+                }
+                q[heaviest] = (S16)(q[heaviest] + one - total);
+            }
+        }
+    };
+
+    inline U8 clamp_u8(S32 v)
+    {
+        return (U8)llclamp(v, 0, 255);
+    }
+
+    inline __m128i pair_weights(S16 first, S16 second)
+    {
+        return _mm_set1_epi32((S32)(((U32)(U16)second << 16) | (U16)first));
+    }
+
+    // One row, four components.  Two taps per _mm_madd_epi16: the pixels
+    // are interleaved to r0 r1 g0 g1 b0 b1 a0 a1 and multiplied by w0 w1.
+    void filter_row_rgba(const Kernel& kernel, const U8* in, U8* out, S32 out_width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(kernel.mPrecision ? 1 << (kernel.mPrecision - 1) : 0);
+        for (S32 x = 0; x < out_width; ++x)
+        {
+            const U8* pix = in + kernel.mStart[x] * 4;
+            const S16* w = &kernel.mWeights[(size_t)x * kernel.mTaps];
+            const S32 count = kernel.mCount[x];
+            __m128i acc = round;
+            S32 k = 0;
+            for (; k + 2 <= count; k += 2, pix += 8)
+            {
+                __m128i p = _mm_loadl_epi64((const __m128i*)pix);
+                p = _mm_unpacklo_epi8(p, _mm_srli_si128(p, 4));
+                p = _mm_unpacklo_epi8(p, zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(p, pair_weights(w[k], w[k + 1])));
+            }
+            if (k < count)
+            {
+                S32 v;
+                memcpy(&v, pix, 4);
+                __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+                p = _mm_unpacklo_epi16(p, zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(p, pair_weights(w[k], 0)));
+            }
+            acc = _mm_srai_epi32(acc, kernel.mPrecision);
+            acc = _mm_packs_epi32(acc, acc);
+            acc = _mm_packus_epi16(acc, acc);
+            S32 result = _mm_cvtsi128_si32(acc);
+            memcpy(out + x * 4, &result, 4);
+        }
+    }
+
+    void filter_row_scalar(const Kernel& kernel, const U8* in, U8* out, S32 out_width, S32 components)
+    {
+        const S32 round = kernel.mPrecision ? 1 << (kernel.mPrecision - 1) : 0;
+        for (S32 x = 0; x < out_width; ++x)
+        {
+            const U8* pix = in + kernel.mStart[x] * components;
+            const S16* w = &kernel.mWeights[(size_t)x * kernel.mTaps];
+            for (S32 c = 0; c < components; ++c)
+            {
+                S32 acc = round;
+                for (S32 k = 0; k < kernel.mCount[x]; ++k)
+                {
+                    acc += pix[k * components + c] * w[k];
+                }
+                out[x * components + c] = clamp_u8(acc >> kernel.mPrecision);
+            }
+        }
+    }
+
+    void horizontal_pass(const Kernel& kernel, const U8* src, S32 src_width, S32 src_stride,
+                         U8* dst, S32 dst_width, S32 dst_stride, S32 rows, S32 components)
+    {
+        if (components == 4)
+        {
+            for (S32 y = 0; y < rows; ++y)
+            {
+                filter_row_rgba(kernel, src + (size_t)y * src_stride, dst + (size_t)y * dst_stride, dst_width);
+            }
+        }
+        else if (components == 3)
+        {
+            // Widen each row to four components so it takes the SIMD path
+            std::vector<U8> in(src_width * 4 + 4, 0);
+            std::vector<U8> out(dst_width * 4);
+            for (S32 y = 0; y < rows; ++y)
+            {
+                const U8* s = src + (size_t)y * src_stride;
+                for (S32 x = 0; x < src_width; ++x)
+                {
+                    in[x * 4 + 0] = s[x * 3 + 0];
+                    in[x * 4 + 1] = s[x * 3 + 1];
+                    in[x * 4 + 2] = s[x * 3 + 2];
+                }
+                filter_row_rgba(kernel, in.data(), out.data(), dst_width);
+                U8* d = dst + (size_t)y * dst_stride;
+                for (S32 x = 0; x < dst_width; ++x)
+                {
+                    d[x * 3 + 0] = out[x * 4 + 0];
+                    d[x * 3 + 1] = out[x * 4 + 1];
+                    d[x * 3 + 2] = out[x * 4 + 2];
+                }
+            }
+        }
+        else
+        {
+            for (S32 y = 0; y < rows; ++y)
+            {
+                filter_row_scalar(kernel, src + (size_t)y * src_stride, dst + (size_t)y * dst_stride, dst_width, components);
+            }
+        }
+    }
+
+    // Vertical filtering is independent of the component count: sixteen
+    // bytes at a time, with the same byte of two rows paired for the
+    // multiply-add.
+    void vertical_pass(const Kernel& kernel, const U8* src, S32 src_stride,
+                       U8* dst, S32 dst_height, S32 dst_stride, S32 row_bytes)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const S32 round_value = kernel.mPrecision ? 1 << (kernel.mPrecision - 1) : 0;
+        const __m128i round = _mm_set1_epi32(round_value);
+        for (S32 y = 0; y < dst_height; ++y)
+        {
+            const U8* rows = src + (size_t)kernel.mStart[y] * src_stride;
+            const S16* w = &kernel.mWeights[(size_t)y * kernel.mTaps];
+            const S32 count = kernel.mCount[y];
+            U8* out = dst + (size_t)y * dst_stride;
+
+            S32 x = 0;
+            for (; x + 16 <= row_bytes; x += 16)
+            {
+                __m128i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+                const U8* pix = rows + x;
+                S32 k = 0;
+                for (; k + 2 <= count; k += 2, pix += 2 * (size_t)src_stride)
+                {
+                    const __m128i weights = pair_weights(w[k], w[k + 1]);
+                    const __m128i a = _mm_loadu_si128((const __m128i*)pix);
+                    const __m128i b = _mm_loadu_si128((const __m128i*)(pix + src_stride));
+                    const __m128i lo = _mm_unpacklo_epi8(a, b);
+                    const __m128i hi = _mm_unpackhi_epi8(a, b);
+                    acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weights));
+                    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weights));
+                    acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weights));
+                    acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weights));
+                }
+                if (k < count)
+                {
+                    const __m128i weights = pair_weights(w[k], 0);
+                    const __m128i a = _mm_loadu_si128((const __m128i*)pix);
+                    const __m128i lo = _mm_unpacklo_epi8(a, zero);
+                    const __m128i hi = _mm_unpackhi_epi8(a, zero);
+                    acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weights));
+                    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weights));
+                    acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weights));
+                    acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weights));
+                }
+                acc0 = _mm_srai_epi32(acc0, kernel.mPrecision);
+                acc1 = _mm_srai_epi32(acc1, kernel.mPrecision);
+                acc2 = _mm_srai_epi32(acc2, kernel.mPrecision);
+                acc3 = _mm_srai_epi32(acc3, kernel.mPrecision);
+                const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc0, acc1), _mm_packs_epi32(acc2, acc3));
+                _mm_storeu_si128((__m128i*)(out + x), packed);
+            }
+            for (; x < row_bytes; ++x)
+            {
+                S32 acc = round_value;
+                for (S32 k = 0; k < count; ++k)
+                {
+                    acc += rows[(size_t)k * src_stride + x] * w[k];
+                }
+                out[x] = clamp_u8(acc >> kernel.mPrecision);
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // 2x2 box mips.  Each helper averages one output row from the two
+    // source rows a and b, 2 * width pixels long.
+
+    inline void mip_pixels(const U8* a, const U8* b, U8* out, S32 first, S32 last, S32 components)
+    {
+        for (S32 x = first; x < last; ++x)
+        {
+            const U8* pa = a + x * 2 * components;
+            const U8* pb = b + x * 2 * components;
+            for (S32 c = 0; c < components; ++c)
+            {
+                out[x * components + c] = (U8)(((U32)pa[c] + pa[c + components] + pb[c] + pb[c + components]) >> 2);
+            }
+        }
+    }
+
+    // 16 source bytes of each row, one component: four U16 lane pairs
+    // summed by _mm_madd_epi16 against ones.
+    inline __m128i mip_half_1(const U8* a, const U8* b, __m128i zero, __m128i ones)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i*)a);
+        const __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        const __m128i sum = _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones));
+        return _mm_srli_epi16(sum, 2);
+    }
+
+    // 16 source bytes of each row, two components: four pixels to two
+    inline __m128i mip_half_2(const U8* a, const U8* b, __m128i zero)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i*)a);
+        const __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_epi64(lo, 32));
+        hi = _mm_add_epi16(hi, _mm_srli_epi64(hi, 32));
+        lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+        hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+        return _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+    }
+
+    // 16 source bytes of each row, four components: four pixels to two
+    inline __m128i mip_half_4(const U8* a, const U8* b, __m128i zero)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i*)a);
+        const __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        return _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+    }
+
+    void mip_row(const U8* a, const U8* b, U8* out, S32 width, S32 components)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        S32 x = 0;
+        switch (components)
+        {
+        case 1:
+        {
+            const __m128i ones = _mm_set1_epi16(1);
+            for (; x + 16 <= width; x += 16)
+            {
+                const __m128i r0 = mip_half_1(a + x * 2, b + x * 2, zero, ones);
+                const __m128i r1 = mip_half_1(a + x * 2 + 16, b + x * 2 + 16, zero, ones);
+                _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(r0, r1));
+            }
+            break;
+        }
+        case 2:
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m128i r0 = mip_half_2(a + x * 4, b + x * 4, zero);
+                const __m128i r1 = mip_half_2(a + x * 4 + 16, b + x * 4 + 16, zero);
+                _mm_storeu_si128((__m128i*)(out + x * 2), _mm_packus_epi16(r0, r1));
+            }
+            break;
+        case 3:
+            // Four source pixels are twelve bytes; summing the row with
+            // itself shifted by one pixel puts the two outputs at bytes 0
+            // and 6.  The loads and the overlapping 4 byte stores stay one
+            // pixel short of the row ends.
+            for (; x + 3 <= width; x += 2)
+            {
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + x * 6));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + x * 6));
+                const __m128i sa = _mm_srli_si128(va, 3);
+                const __m128i sb = _mm_srli_si128(vb, 3);
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+                lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_unpacklo_epi8(sa, zero), _mm_unpacklo_epi8(sb, zero)));
+                hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_unpackhi_epi8(sa, zero), _mm_unpackhi_epi8(sb, zero)));
+                const __m128i packed = _mm_packus_epi16(_mm_srli_epi16(lo, 2), _mm_srli_epi16(hi, 2));
+                const S32 first = _mm_cvtsi128_si32(packed);
+                const S32 second = _mm_cvtsi128_si32(_mm_srli_si128(packed, 6));
+                memcpy(out + x * 3, &first, 4);
+                memcpy(out + x * 3 + 3, &second, 4);
+            }
+            break;
+        case 4:
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i r0 = mip_half_4(a + x * 8, b + x * 8, zero);
+                const __m128i r1 = mip_half_4(a + x * 8 + 16, b + x * 8 + 16, zero);
+                _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(r0, r1));
+            }
+            break;
+        default:
+            break;
+        }
+        mip_pixels(a, b, out, x, width, components);
+    }
+
+    // Mip row where the source is not exactly twice the size, which happens
+    // once one side of a non square image has reached a single pixel.
+    void mip_row_clamped(const U8* a, const U8* b, U8* out, S32 src_width, S32 width, S32 components)
+    {
+        for (S32 x = 0; x < width; ++x)
+        {
+            const U8* a0 = a + x * 2 * components;
+            const U8* b0 = b + x * 2 * components;
+            const S32 step = (x * 2 + 1 < src_width) ? components : 0;
+            for (S32 c = 0; c < components; ++c)
+            {
+                out[x * components + c] = (U8)(((U32)a0[c] + a0[c + step] + b0[c] + b0[c + step]) >> 2);
+            }
+        }
+    }
+
+    struct MipLevel
+    {
+        U8* mData;
+        S32 mWidth;
+        S32 mHeight;
+    };
+
+    // Row j of level l has just been written; build the row of level l + 1
+    // it completes, if any, and carry on down the chain.
+    void emit_mip_row(std::vector<MipLevel>& levels, S32 level, S32 row, S32 components)
+    {
+        while (level + 1 < (S32)levels.size())
+        {
+            const MipLevel& src = levels[level];
+            const MipLevel& dst = levels[level + 1];
+            const S32 dst_row = row >> 1;
+            if (dst_row >= dst.mHeight || row != llmin(dst_row * 2 + 1, src.mHeight - 1))
+            {
+                return;
+            }
+
+            const S32 src_stride = src.mWidth * components;
+            const U8* a = src.mData + (size_t)(dst_row * 2) * src_stride;
+            const U8* b = src.mData + (size_t)row * src_stride;
+            U8* out = dst.mData + (size_t)dst_row * dst.mWidth * components;
+            if (src.mWidth == dst.mWidth * 2)
+            {
+                mip_row(a, b, out, dst.mWidth, components);
+            }
+            else
+            {
+                mip_row_clamped(a, b, out, src.mWidth, dst.mWidth, components);
+            }
+
+            ++level;
+            row = dst_row;
+        }
+    }
+}
+
+//static
+bool LLImageResample::resample(EFilter filter,
+                               const U8* src, S32 src_width, S32 src_height, S32 src_stride,
+                               U8* dst, S32 dst_width, S32 dst_height, S32 dst_stride,
+                               S32 components)
+{
+    if (!src || !dst || components < 1 || components > 4
+        || src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0)
+    {
+        return false;
+    }
+
+    const S32 row_bytes = dst_width * components;
+    if (src_width == dst_width && src_height == dst_height)
+    {
+        for (S32 y = 0; y < dst_height; ++y)
+        {
+            memcpy(dst + (size_t)y * dst_stride, src + (size_t)y * src_stride, row_bytes);
+        }
+        return true;
+    }
+
+    if (src_height == dst_height)
+    {
+        Kernel horizontal;
+        horizontal.build(filter, src_width, dst_width);
+        horizontal_pass(horizontal, src, src_width, src_stride, dst, dst_width, dst_stride, dst_height, components);
+        return true;
+    }
+
+    Kernel vertical;
+    vertical.build(filter, src_height, dst_height);
+    if (src_width == dst_width)
+    {
+        vertical_pass(vertical, src, src_stride, dst, dst_height, dst_stride, row_bytes);
+        return true;
+    }
+
+    // Only the source rows the vertical kernel touches need filtering
+    const S32 first_row = vertical.mStart[0];
+    const S32 last_row = vertical.mStart[dst_height - 1] + vertical.mCount[dst_height - 1];
+    for (S32 y = 0; y < dst_height; ++y)
+    {
+        vertical.mStart[y] -= first_row;
+    }
+
+    Kernel horizontal;
+    horizontal.build(filter, src_width, dst_width);
+    std::vector<U8> temp((size_t)row_bytes * (last_row - first_row));
+    horizontal_pass(horizontal, src + (size_t)first_row * src_stride, src_width, src_stride,
+                    temp.data(), dst_width, row_bytes, last_row - first_row, components);
+    vertical_pass(vertical, temp.data(), row_bytes, dst, dst_height, dst_stride, row_bytes);
+    return true;
+}
+
+//static
+void LLImageResample::generateMip(const U8* src, U8* dst, S32 width, S32 height, S32 components)
+{
+    llassert(width > 0 && height > 0);
+    const S32 src_stride = width * 2 * components;
+    for (S32 y = 0; y < height; ++y)
+    {
+        const U8* a = src + (size_t)y * 2 * src_stride;
+        mip_row(a, a + src_stride, dst + (size_t)y * width * components, width, components);
+    }
+}
+
+//static
+S32 LLImageResample::getMipLevelCount(S32 width, S32 height)
+{
+    S32 levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = llmax(width >> 1, 1);
+        height = llmax(height >> 1, 1);
+        ++levels;
+    }
+    return levels;
+}
+
+//static
+S32 LLImageResample::getMipChainSize(S32 width, S32 height, S32 components, S32 levels)
+{
+    S32 size = 0;
+    for (S32 l = 1; l < levels; ++l)
+    {
+        size += llmax(width >> l, 1) * llmax(height >> l, 1) * components;
+    }
+    return size;
+}
+
+//static
+void LLImageResample::generateMipChain(const U8* src, S32 width, S32 height, S32 components, U8* dst, S32 levels)
+{
+    llassert(width > 0 && height > 0 && levels <= getMipLevelCount(width, height));
+    if (levels < 2)
+    {
+        return;
+    }
+
+    std::vector<MipLevel> chain(levels);
+    chain[0] = { const_cast<U8*>(src), width, height };
+    for (S32 l = 1; l < levels; ++l)
+    {
+        chain[l] = { dst, llmax(width >> l, 1), llmax(height >> l, 1) };
+        dst += (size_t)chain[l].mWidth * chain[l].mHeight * components;
+    }
+
+    for (S32 y = 0; y < height; ++y)
+    {
+        emit_mip_row(chain, 0, y, components);
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file llimageresample.h
+ * @brief SIMD image resampling and mip chain generation
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGERESAMPLE_H
+#define LL_LLIMAGERESAMPLE_H
+
+// Separable resampling of 8 bit images with 1 to 4 interleaved components.
+// Each output row or column is a weighted sum of the input under a filter
+// kernel that widens with the downscale factor, so shrinking is properly
+// antialiased.  Weights are fixed point and summed with SSE2 multiply-add,
+// horizontally first and then vertically.
+class LLImageResample
+{
+public:
+    enum EFilter
+    {
+        BOX,        // area average when shrinking, nearest pixel when growing
+        BILINEAR,   // triangle filter
+        LANCZOS3,   // windowed sinc, sharpest but may ring at hard edges
+    };
+
+    // Resample src into dst.  Strides are in bytes.  Returns false for
+    // unsupported component counts or empty images.
+    static bool resample(EFilter filter,
+                         const U8* src, S32 src_width, S32 src_height, S32 src_stride,
+                         U8* dst, S32 dst_width, S32 dst_height, S32 dst_stride,
+                         S32 components);
+
+    // 2x2 box filter of a (2 * width) x (2 * height) image into a width x
+    // height one.  The average is truncated, as it always has been.
+    static void generateMip(const U8* src, U8* dst, S32 width, S32 height, S32 components);
+
+    // Number of levels down to 1x1, counting the full size image
+    static S32 getMipLevelCount(S32 width, S32 height);
+
+    // Bytes needed to hold levels 1 to levels - 1 of a width x height image,
+    // tightly packed one after another.
+    static S32 getMipChainSize(S32 width, S32 height, S32 components, S32 levels);
+
+    // Fill dst with levels 1 to levels - 1 of src, each max(1, dim >> level)
+    // on a side.  All levels are produced in a single walk over src, a row
+    // of each level being emitted as soon as the two rows under it exist.
+    static void generateMipChain(const U8* src, S32 width, S32 height, S32 components, U8* dst, S32 levels);
+};
+
+#endif // LL_LLIMAGERESAMPLE_H
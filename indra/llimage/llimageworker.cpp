@@ -38,7 +38,9 @@ class ImageRequest
                  S32 discard,
                  BOOL needs_aux,
                  const LLPointer<LLImageDecodeThread::Responder>& responder,
-                 U32 request_id);
+                 U32 request_id,
+                 LLImageDecodeThread::DecodedCache* cache,
+                 const LLUUID& cache_id);
     virtual ~ImageRequest();
 
     /*virtual*/ bool processRequest();
@@ -52,6 +54,8 @@ class ImageRequest
     S32 mDiscardLevel;
     U32 mRequestId;
     BOOL mNeedsAux;
+    LLImageDecodeThread::DecodedCache* mDecodedCache;
+    LLUUID mCacheID;
     // output
     LLPointer<LLImageRaw> mDecodedImageRaw;
     LLPointer<LLImageRaw> mDecodedImageAux;
@@ -66,7 +70,8 @@ class ImageRequest
 
 // MAIN THREAD
 LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
-    : mDecodeCount(0)
+    : mDecodeCount(0),
+      mDecodedCache(nullptr)
 {
     mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
     mThreadPool->start();
@@ -93,14 +98,15 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     const LLPointer<LLImageFormatted>& image,
     S32 discard,
     BOOL needs_aux,
-    const LLPointer<LLImageDecodeThread::Responder>& responder)
+    const LLPointer<LLImageDecodeThread::Responder>& responder,
+    const LLUUID& cache_id)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
     U32 decode_id = ++mDecodeCount;
     // Instantiate the ImageRequest right in the lambda, why not?
     bool posted = mThreadPool->getQueue().post(
-        [req = ImageRequest(image, discard, needs_aux, responder, decode_id)]
+        [req = ImageRequest(image, discard, needs_aux, responder, decode_id, mDecodedCache, cache_id)]
         () mutable
         {
             auto done = req.processRequest();
@@ -130,10 +136,14 @@ ImageRequest::ImageRequest(const LLPointer<LLImageFormatted>& image,
                            S32 discard,
                            BOOL needs_aux,
                            const LLPointer<LLImageDecodeThread::Responder>& responder,
-                           U32 request_id)
+                           U32 request_id,
+                           LLImageDecodeThread::DecodedCache* cache,
+                           const LLUUID& cache_id)
     : mFormattedImage(image),
       mDiscardLevel(discard),
       mNeedsAux(needs_aux),
+      mDecodedCache(cache),
+      mCacheID(cache_id),
       mDecodedRaw(FALSE),
       mDecodedAux(FALSE),
       mResponder(responder),
@@ -158,6 +168,27 @@ bool ImageRequest::processRequest()
     const F32 decode_time_slice = 0.f; //disable time slicing
     bool done = true;
     mErrorString.clear();
+    // Aux channels aren't cached, and without an explicit discard level
+    // there's no key to look up.
+    const bool use_cache = mDecodedCache && mCacheID.notNull() && !mNeedsAux && mDiscardLevel >= 0
+                           && mFormattedImage.notNull();
+    if (use_cache && !mDecodedRaw)
+    {
+        LLPointer<LLImageRaw> raw = mDecodedCache->load(mCacheID, mDiscardLevel, mFormattedImage->getDataSize());
+        if (raw.notNull())
+        {
+            mFormattedImage->setDiscardLevel(mDiscardLevel);
+            mDecodedImageRaw = raw;
+            mDecodedRaw = TRUE;
+            return true;
+        }
+        if (!mFormattedImage->getDataSize())
+        {
+            // Cache only request and the record went away meanwhile
+            mErrorString = "Not in decoded cache";
+            return true; // done (failed)
+        }
+    }
     if (!mDecodedRaw && mFormattedImage.notNull())
     {
         // Decode primary channels
@@ -189,6 +220,12 @@ bool ImageRequest::processRequest()
 
         // Pick up errors from decoding
         mErrorString = LLImage::getLastThreadError();
+
+        if (use_cache && mDecodedRaw)
+        {
+            mDecodedCache->store(mCacheID, mFormattedImage->getDiscardLevel(), mFormattedImage->getDataSize(),
+                                 mDecodedImageRaw);
+        }
     }
     if (done && mNeedsAux && !mDecodedAux && mFormattedImage.notNull())
     {
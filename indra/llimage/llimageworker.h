@@ -29,8 +29,11 @@
 
 #include "llimage.h"
 #include "llpointer.h"
+#include "lluuid.h"
 #include "threadpool_fwd.h"
 
+#include <atomic>
+
 class LLImageDecodeThread
 {
 public:
@@ -42,15 +45,34 @@ class LLImageDecodeThread
         virtual void completed(bool success, const std::string& error_message, LLImageRaw* raw, LLImageRaw* aux, U32 request_id) = 0;
     };
 
+    // Second cache tier holding already decoded pixels.  Requests that
+    // carry an id consult it before decoding and feed it afterwards.
+    // Called from the decode pool, implementations must be thread safe.
+    class DecodedCache
+    {
+    public:
+        virtual ~DecodedCache() {}
+        // Pixels for id at discard decoded from at least data_size bytes
+        // of codestream, or null.
+        virtual LLPointer<LLImageRaw> load(const LLUUID& id, S32 discard, S32 data_size) = 0;
+        virtual void store(const LLUUID& id, S32 discard, S32 data_size, const LLImageRaw* raw) = 0;
+    };
+
 public:
     LLImageDecodeThread(bool threaded = true);
     virtual ~LLImageDecodeThread();
 
     // meant to resemble LLQueuedThread::handle_t
     typedef U32 handle_t;
+    // A non null cache_id makes the request use the decoded cache, if any.
+    // With a cache_id, an image with no data yet only asks the cache and
+    // fails on a miss.
     handle_t decodeImage(const LLPointer<LLImageFormatted>& image,
                          S32 discard, BOOL needs_aux,
-                         const LLPointer<Responder>& responder);
+                         const LLPointer<Responder>& responder,
+                         const LLUUID& cache_id = LLUUID::null);
+    // The cache must outlive the decode pool (see shutdown()).
+    void setDecodedCache(DecodedCache* cache) { mDecodedCache = cache; }
     size_t getPending();
     size_t update(F32 max_time_ms);
     S32 getTotalDecodeCount() { return mDecodeCount; }
@@ -62,6 +84,7 @@ class LLImageDecodeThread
     // "ImageDecode" ThreadPool.
     std::unique_ptr<LL::ThreadPool> mThreadPool;
     LLAtomicU32 mDecodeCount;
+    std::atomic<DecodedCache*> mDecodedCache;
 };
 
 #endif
@@ -0,0 +1,203 @@
+/**
+ * @file llimagebc_test.cpp
+ * @brief Quality and throughput tests for the BC1/BC3 block compressor
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimagebc.h"
+
+#include "lltimer.h"
+#include "../test/lltut.h"
+
+#include <cmath>
+#include <vector>
+
+namespace tut
+{
+    struct imagebc_data
+    {
+        // Smooth colour gradients with a low frequency wave on blue, and a
+        // soft alpha ramp; roughly what photographic diffuse maps look like.
+        std::vector<U8> makeImage(S32 width, S32 height, S32 components)
+        {
+            std::vector<U8> image(width * height * components);
+            for (S32 y = 0; y < height; ++y)
+            {
+                for (S32 x = 0; x < width; ++x)
+                {
+                    U8* p = &image[(y * width + x) * components];
+                    p[0] = (U8)(x * 255 / llmax(width - 1, 1));
+                    p[1] = (U8)(y * 255 / llmax(height - 1, 1));
+                    p[2] = (U8)(128.f + 100.f * sinf(x * 0.05f) * cosf(y * 0.03f));
+                    if (components == 4)
+                    {
+                        p[3] = (U8)((x + y) * 255 / llmax(width + height - 2, 1));
+                    }
+                }
+            }
+            return image;
+        }
+
+        F64 psnr(const std::vector<U8>& source, S32 components, const std::vector<U8>& rgba, S32 channel_begin, S32 channel_end)
+        {
+            const S32 pixels = (S32)(rgba.size() / 4);
+            F64 squared = 0.0;
+            for (S32 i = 0; i < pixels; ++i)
+            {
+                for (S32 c = channel_begin; c < channel_end; ++c)
+                {
+                    F64 d = (F64)source[i * components + c] - (F64)rgba[i * 4 + c];
+                    squared += d * d;
+                }
+            }
+            F64 mse = squared / (pixels * (channel_end - channel_begin));
+            return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+        }
+
+        std::vector<U8> roundTrip(LLImageBC::EFormat format, const std::vector<U8>& image, S32 width, S32 height, S32 components)
+        {
+            std::vector<U8> blocks(LLImageBC::getCompressedSize(format, width, height));
+            ensure("compress", LLImageBC::compress(format, image.data(), width, height, components, blocks.data()));
+            std::vector<U8> rgba(width * height * 4);
+            LLImageBC::decompress(format, blocks.data(), width, height, rgba.data());
+            return rgba;
+        }
+    };
+    typedef test_group<imagebc_data> imagebc_test;
+    typedef imagebc_test::object imagebc_object;
+    tut::imagebc_test imagebc_testcase("LLImageBC");
+
+    template<> template<>
+    void imagebc_object::test<1>()
+    {
+        set_test_name("compressed sizes");
+
+        ensure_equals("BC1 256x256", LLImageBC::getCompressedSize(LLImageBC::BC1, 256, 256), 256 * 256 / 2);
+        ensure_equals("BC3 256x256", LLImageBC::getCompressedSize(LLImageBC::BC3, 256, 256), 256 * 256);
+        ensure_equals("BC1 partial blocks", LLImageBC::getCompressedSize(LLImageBC::BC1, 6, 2), 2 * 8);
+        ensure_equals("BC3 single pixel", LLImageBC::getCompressedSize(LLImageBC::BC3, 1, 1), 16);
+
+        std::vector<U8> image(8 * 8 * 4, 255);
+        ensure("opaque", !LLImageBC::hasAlpha(image.data(), 8, 8, 4));
+        image[5 * 4 + 3] = 254;
+        ensure("alpha", LLImageBC::hasAlpha(image.data(), 8, 8, 4));
+        ensure("rgb never has alpha", !LLImageBC::hasAlpha(image.data(), 8, 8, 3));
+        ensure("rejects two components", !LLImageBC::compress(LLImageBC::BC1, image.data(), 8, 8, 2, image.data()));
+    }
+
+    template<> template<>
+    void imagebc_object::test<2>()
+    {
+        set_test_name("BC1 quality");
+
+        const S32 size = 256;
+        std::vector<U8> image = makeImage(size, size, 3);
+        std::vector<U8> rgba = roundTrip(LLImageBC::BC1, image, size, size, 3);
+        F64 quality = psnr(image, 3, rgba, 0, 3);
+        ensure("BC1 colour PSNR above 35dB, got " + std::to_string(quality), quality > 35.0);
+
+        // A flat block must come back exact up to 565 precision
+        std::vector<U8> flat(16 * 3);
+        for (S32 i = 0; i < 16; ++i)
+        {
+            flat[i * 3 + 0] = 200;
+            flat[i * 3 + 1] = 100;
+            flat[i * 3 + 2] = 48;
+        }
+        rgba = roundTrip(LLImageBC::BC1, flat, 4, 4, 3);
+        ensure("flat red", abs(rgba[0] - 200) <= 4);
+        ensure("flat green", abs(rgba[1] - 100) <= 2);
+        ensure("flat blue", abs(rgba[2] - 48) <= 4);
+        ensure_equals("flat opaque", (S32)rgba[3], 255);
+
+        // Partial edge blocks behave as if the last row and column repeat
+        std::vector<U8> odd = makeImage(10, 6, 3);
+        std::vector<U8> padded(12 * 8 * 3);
+        for (S32 y = 0; y < 8; ++y)
+        {
+            for (S32 x = 0; x < 12; ++x)
+            {
+                memcpy(&padded[(y * 12 + x) * 3], &odd[(llmin(y, 5) * 10 + llmin(x, 9)) * 3], 3);
+            }
+        }
+        rgba = roundTrip(LLImageBC::BC1, odd, 10, 6, 3);
+        std::vector<U8> padded_rgba = roundTrip(LLImageBC::BC1, padded, 12, 8, 3);
+        for (S32 y = 0; y < 6; ++y)
+        {
+            ensure("edge blocks", memcmp(&rgba[y * 10 * 4], &padded_rgba[y * 12 * 4], 10 * 4) == 0);
+        }
+    }
+
+    template<> template<>
+    void imagebc_object::test<3>()
+    {
+        set_test_name("BC3 quality and cutouts");
+
+        const S32 size = 256;
+        std::vector<U8> image = makeImage(size, size, 4);
+        std::vector<U8> rgba = roundTrip(LLImageBC::BC3, image, size, size, 4);
+        F64 color = psnr(image, 4, rgba, 0, 3);
+        F64 alpha = psnr(image, 4, rgba, 3, 4);
+        ensure("BC3 colour PSNR above 35dB, got " + std::to_string(color), color > 35.0);
+        ensure("BC3 alpha PSNR above 40dB, got " + std::to_string(alpha), alpha > 40.0);
+
+        // Alpha masks must keep their fully clear and fully opaque texels
+        for (S32 y = 0; y < size; ++y)
+        {
+            for (S32 x = 0; x < size; ++x)
+            {
+                image[(y * size + x) * 4 + 3] = ((x / 5 + y / 7) & 1) ? 255 : 0;
+            }
+        }
+        rgba = roundTrip(LLImageBC::BC3, image, size, size, 4);
+        S32 mismatches = 0;
+        for (S32 i = 0; i < size * size; ++i)
+        {
+            mismatches += image[i * 4 + 3] != rgba[i * 4 + 3];
+        }
+        ensure_equals("cutout alpha exact", mismatches, 0);
+    }
+
+    template<> template<>
+    void imagebc_object::test<4>()
+    {
+        set_test_name("throughput report");
+
+        const S32 size = 1024;
+        const S32 passes = 4;
+        std::vector<U8> image = makeImage(size, size, 4);
+        std::vector<U8> blocks(LLImageBC::getCompressedSize(LLImageBC::BC3, size, size));
+
+        for (LLImageBC::EFormat format : { LLImageBC::BC1, LLImageBC::BC3 })
+        {
+            LLTimer timer;
+            for (S32 i = 0; i < passes; ++i)
+            {
+                LLImageBC::compress(format, image.data(), size, size, 4, blocks.data());
+            }
+            F64 seconds = llmax(timer.getElapsedTimeF64(), 0.000001);
+            F64 mpixels = (F64)size * size * passes / seconds / 1000000.0;
+            LL_INFOS("ImageBC") << (format == LLImageBC::BC1 ? "BC1" : "BC3") << " compression: "
+                                << mpixels << " megapixels per second" << LL_ENDL;
+        }
+    }
+}
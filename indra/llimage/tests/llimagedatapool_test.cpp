@@ -0,0 +1,139 @@
+/**
+ * @file llimagedatapool_test.cpp
+ * @brief Tests for the image data buffer pool
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimagedatapool.h"
+
+#include "llmemory.h"
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace tut
+{
+    struct imagedatapool_data
+    {
+        imagedatapool_data()
+        {
+            LLImageDataPool::trim();
+        }
+        ~imagedatapool_data()
+        {
+            LLImageDataPool::setMaxBytes(128 * 1024 * 1024);
+            LLImageDataPool::trim();
+        }
+    };
+    typedef test_group<imagedatapool_data> imagedatapool_test;
+    typedef imagedatapool_test::object imagedatapool_object;
+    tut::imagedatapool_test imagedatapool_testcase("LLImageDataPool");
+
+    template<> template<>
+    void imagedatapool_object::test<1>()
+    {
+        set_test_name("size classes");
+
+        ensure_equals("power of two", LLImageDataPool::getCapacity(512 * 512 * 4), 512 * 512 * 4);
+        ensure_equals("RGB", LLImageDataPool::getCapacity(512 * 512 * 3), 512 * 512 * 3);
+        ensure_equals("just over", LLImageDataPool::getCapacity(65537), 65536 + 16384);
+        ensure_equals("small sizes are exact", LLImageDataPool::getCapacity(100), 100);
+        ensure_equals("huge sizes are exact", LLImageDataPool::getCapacity(LLImageDataPool::MAX_POOLED_SIZE + 1),
+                      LLImageDataPool::MAX_POOLED_SIZE + 1);
+
+        for (S32 size = LLImageDataPool::MIN_POOLED_SIZE; size <= LLImageDataPool::MAX_POOLED_SIZE; size += size / 7 + 1)
+        {
+            const S32 capacity = LLImageDataPool::getCapacity(size);
+            ensure("capacity covers the size", capacity >= size);
+            ensure("at most 25% slack", capacity - size <= size / 4 + 1);
+            ensure("capacity is its own class", LLImageDataPool::isSameClass(size, capacity));
+            ensure_equals("capacity is stable", LLImageDataPool::getCapacity(capacity), capacity);
+        }
+        ensure("different classes", !LLImageDataPool::isSameClass(512 * 512 * 3, 512 * 512 * 4));
+    }
+
+    template<> template<>
+    void imagedatapool_object::test<2>()
+    {
+        set_test_name("buffers are reused");
+
+        const S32 size = 256 * 256 * 4;
+        U8* first = LLImageDataPool::allocate(size);
+        ensure("allocated", first != NULL);
+        ensure("aligned", ((uintptr_t)first & 15) == 0);
+        memset(first, 0xab, LLImageDataPool::getCapacity(size));
+        LLImageDataPool::release(first, size);
+
+        const U64 hits = LLImageDataPool::getHitCount();
+        U8* second = LLImageDataPool::allocate(size - 100);
+        ensure("same class gets the same buffer", second == first);
+        ensure_equals("hit counted", LLImageDataPool::getHitCount(), hits + 1);
+        LLImageDataPool::release(second, size - 100);
+
+        // Buffers may leave the pool and be freed directly
+        U8* third = LLImageDataPool::allocate(size);
+        ll_aligned_free_16(third);
+    }
+
+    template<> template<>
+    void imagedatapool_object::test<3>()
+    {
+        set_test_name("buffers freed on another thread go through the shared cache");
+
+        const S32 size = 2048 * 2048 * 4;   // bigger than a thread keeps
+        std::vector<U8*> buffers;
+        std::thread producer([&buffers, size]()
+            {
+                for (S32 i = 0; i < 4; ++i)
+                {
+                    buffers.push_back(LLImageDataPool::allocate(size));
+                }
+            });
+        producer.join();
+        for (U8* data : buffers)
+        {
+            LLImageDataPool::release(data, size);
+        }
+        ensure_equals("cached", LLImageDataPool::getCachedBytes(), (U64)size * 4);
+
+        std::vector<U8*> reused;
+        std::thread consumer([&reused, size]()
+            {
+                for (S32 i = 0; i < 4; ++i)
+                {
+                    reused.push_back(LLImageDataPool::allocate(size));
+                }
+            });
+        consumer.join();
+        ensure_equals("all taken", LLImageDataPool::getCachedBytes(), (U64)0);
+        for (U8* data : reused)
+        {
+            ensure("came from the cache", std::find(buffers.begin(), buffers.end(), data) != buffers.end());
+            LLImageDataPool::release(data, size);
+        }
+
+        LLImageDataPool::setMaxBytes(size);
+        ensure("bounded", LLImageDataPool::getCachedBytes() <= (U64)size);
+    }
+}
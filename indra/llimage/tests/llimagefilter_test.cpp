@@ -0,0 +1,795 @@
+/**
+ * @file llimagefilter_test.cpp
+ * @brief Tests the tiled image filters against a per pixel reference
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimagefilter.h"
+
+#include "llformat.h"
+#include "llmath.h"
+#include "llsdserialize.h"
+#include "llsdutil.h"
+#include "m3math.h"
+#include "threadpool.h"
+#include "v3color.h"
+#include "v3math.h"
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    // The filters as they ran before tiling: each command is a separate
+    // pass over the whole image, one pixel at a time, in row order.  The
+    // only intended difference is the last line of a convolution, which
+    // now uses its own row's stencil alpha.
+    class ReferenceFilter
+    {
+    public:
+        ReferenceFilter(U8* data, S32 width, S32 height, S32 components)
+            : mData(data),
+              mWidth(width),
+              mHeight(height),
+              mComponents(components),
+              mHistoComputed(false),
+              mStencilBlendMode(STENCIL_BLEND_MODE_BLEND),
+              mStencilShape(STENCIL_SHAPE_UNIFORM),
+              mStencilMin(0.0),
+              mStencilMax(1.0)
+        {
+        }
+
+        void execute(const LLSD& commands)
+        {
+            for (S32 i = 0; i < commands.size(); ++i)
+            {
+                const LLSD& cmd = commands[i];
+                const std::string name = cmd[0].asString();
+                if (name == "stencil")
+                {
+                    const std::string shape_name = cmd[1].asString();
+                    EStencilShape shape = STENCIL_SHAPE_UNIFORM;
+                    if (shape_name == "gradient")
+                    {
+                        shape = STENCIL_SHAPE_GRADIENT;
+                    }
+                    else if (shape_name == "vignette")
+                    {
+                        shape = STENCIL_SHAPE_VIGNETTE;
+                    }
+                    else if (shape_name == "scanlines")
+                    {
+                        shape = STENCIL_SHAPE_SCAN_LINES;
+                    }
+                    const std::string mode_name = cmd[2].asString();
+                    EStencilBlendMode mode = STENCIL_BLEND_MODE_BLEND;
+                    if (mode_name == "add")
+                    {
+                        mode = STENCIL_BLEND_MODE_ADD;
+                    }
+                    else if (mode_name == "add_back")
+                    {
+                        mode = STENCIL_BLEND_MODE_ABACK;
+                    }
+                    else if (mode_name == "fade")
+                    {
+                        mode = STENCIL_BLEND_MODE_FADE;
+                    }
+                    F32 params[4] = { 0.0, 0.0, 0.0, 0.0 };
+                    for (S32 j = 5; (j < cmd.size()) && (j < 9); j++)
+                    {
+                        params[j - 5] = (F32)(cmd[j].asReal());
+                    }
+                    setStencil(shape, mode, (F32)(cmd[3].asReal()), (F32)(cmd[4].asReal()), params);
+                }
+                else if (name == "sepia")
+                {
+                    LLMatrix3 sepia;
+                    sepia.setRows(LLVector3(0.3588f, 0.7044f, 0.1368f),
+                                  LLVector3(0.2990f, 0.5870f, 0.1140f),
+                                  LLVector3(0.2392f, 0.4696f, 0.0912f));
+                    sepia.transpose();
+                    colorTransform(sepia);
+                }
+                else if (name == "grayscale")
+                {
+                    LLMatrix3 gray_scale;
+                    LLVector3 luminosity(0.2125f, 0.7154f, 0.0721f);
+                    gray_scale.setRows(luminosity, luminosity, luminosity);
+                    gray_scale.transpose();
+                    colorTransform(gray_scale);
+                }
+                else if (name == "saturate" || name == "rotate")
+                {
+                    LLMatrix3 r_a;
+                    LLMatrix3 r_b;
+                    r_a.setRows(LLVector3( OO_SQRT2,  OO_SQRT2, 0.0),
+                                LLVector3(-OO_SQRT2,  OO_SQRT2, 0.0),
+                                LLVector3( 0.0,       0.0,      1.0));
+                    float oo_sqrt3 = 1.0f / F_SQRT3;
+                    float sin_54 = F_SQRT2 * oo_sqrt3;
+                    r_b.setRows(LLVector3(oo_sqrt3, 0.0, -sin_54),
+                                LLVector3(0.0,      1.0,  0.0),
+                                LLVector3(sin_54,   0.0,  oo_sqrt3));
+                    LLMatrix3 Lij = r_b * r_a;
+                    LLMatrix3 Lij_inv = Lij;
+                    Lij_inv.transpose();
+
+                    LLMatrix3 local;
+                    if (name == "saturate")
+                    {
+                        F32 saturation = (float)(cmd[1].asReal());
+                        local.setRows(LLVector3(saturation, 0.0,  0.0),
+                                      LLVector3(0.0,  saturation, 0.0),
+                                      LLVector3(0.0,        0.0,  1.0));
+                    }
+                    else
+                    {
+                        F32 angle = (float)(cmd[1].asReal());
+                        angle *= DEG_TO_RAD;
+                        local.setRows(LLVector3( cosf(angle), sinf(angle), 0.0),
+                                      LLVector3(-sinf(angle), cosf(angle), 0.0),
+                                      LLVector3( 0.0,         0.0,         1.0));
+                    }
+                    LLMatrix3 transfo = Lij_inv * local * Lij;
+                    colorTransform(transfo);
+                }
+                else if (name == "gamma")
+                {
+                    LLColor3 alpha((float)(cmd[2].asReal()), (float)(cmd[3].asReal()), (float)(cmd[4].asReal()));
+                    F32 gamma = (float)(cmd[1].asReal());
+                    U8 lut[3][256];
+                    for (S32 v = 0; v < 256; v++)
+                    {
+                        F32 gamma_v = llclampf((float)(powf((float)(v)/255.0, 1.0/gamma)));
+                        for (S32 c = 0; c < 3; c++)
+                        {
+                            lut[c][v] = (U8)((1.0 - alpha.mV[c]) * (float)(v) + alpha.mV[c] * 255.0 * gamma_v);
+                        }
+                    }
+                    colorCorrect(lut);
+                }
+                else if (name == "colorize")
+                {
+                    LLColor3 color((float)(cmd[1].asReal()), (float)(cmd[2].asReal()), (float)(cmd[3].asReal()));
+                    LLColor3 alpha((F32)(cmd[4].asReal()), (float)(cmd[5].asReal()), (float)(cmd[6].asReal()));
+                    U8 lut[3][256];
+                    for (S32 c = 0; c < 3; c++)
+                    {
+                        F32 composite = 255.0 * alpha.mV[c] * color.mV[c];
+                        for (S32 v = 0; v < 256; v++)
+                        {
+                            lut[c][v] = (U8)(llclampb((S32)((1.0 - alpha.mV[c]) * (F32)(v) + composite)));
+                        }
+                    }
+                    colorCorrect(lut);
+                }
+                else if (name == "contrast")
+                {
+                    LLColor3 alpha((float)(cmd[2].asReal()), (float)(cmd[3].asReal()), (float)(cmd[4].asReal()));
+                    F32 slope = (float)(cmd[1].asReal());
+                    F32 translate = 128.0 * (1.0 - slope);
+                    U8 lut[3][256];
+                    for (S32 v = 0; v < 256; v++)
+                    {
+                        U8 value_v = (U8)(llclampb((S32)(slope*v + translate)));
+                        blendValue(lut, v, value_v, alpha);
+                    }
+                    colorCorrect(lut);
+                }
+                else if (name == "brighten" || name == "darken")
+                {
+                    LLColor3 alpha((float)(cmd[2].asReal()), (float)(cmd[3].asReal()), (float)(cmd[4].asReal()));
+                    F32 add = (name == "brighten" ? (float)(cmd[1].asReal()) : (float)(-cmd[1].asReal()));
+                    S32 add_value = (S32)(add * 255.0);
+                    U8 lut[3][256];
+                    for (S32 v = 0; v < 256; v++)
+                    {
+                        blendValue(lut, v, (U8)(llclampb(v + add_value)), alpha);
+                    }
+                    colorCorrect(lut);
+                }
+                else if (name == "linearize")
+                {
+                    LLColor3 alpha((float)(cmd[2].asReal()), (float)(cmd[3].asReal()), (float)(cmd[4].asReal()));
+                    filterLinearize((float)(cmd[1].asReal()), alpha);
+                }
+                else if (name == "posterize")
+                {
+                    LLColor3 alpha((float)(cmd[2].asReal()), (float)(cmd[3].asReal()), (float)(cmd[4].asReal()));
+                    filterEqualize((S32)(cmd[1].asReal()), alpha);
+                }
+                else if (name == "screen")
+                {
+                    EScreenMode mode = (cmd[1].asString() == "line" ? SCREEN_MODE_LINE : SCREEN_MODE_2DSINE);
+                    filterScreen(mode, (F32)(cmd[2].asReal()), (F32)(cmd[3].asReal()));
+                }
+                else if (name == "blur" || name == "sharpen" || name == "gradient")
+                {
+                    LLMatrix3 kernel;
+                    const F32 weight = (name == "blur" ? 1.0 : -1.0);
+                    for (S32 k = 0; k < NUM_VALUES_IN_MAT3; k++)
+                        for (S32 j = 0; j < NUM_VALUES_IN_MAT3; j++)
+                            kernel.mMatrix[k][j] = weight;
+                    if (name == "sharpen")
+                    {
+                        kernel.mMatrix[1][1] = 9.0;
+                    }
+                    else if (name == "gradient")
+                    {
+                        kernel.mMatrix[1][1] = 8.0;
+                    }
+                    convolve(kernel, name == "blur", name == "gradient");
+                }
+                else if (name == "convolve")
+                {
+                    LLMatrix3 kernel;
+                    S32 index = 1;
+                    bool normalize = (cmd[index++].asReal() > 0.0);
+                    bool abs_value = (cmd[index++].asReal() > 0.0);
+                    for (S32 k = 0; k < NUM_VALUES_IN_MAT3; k++)
+                        for (S32 j = 0; j < NUM_VALUES_IN_MAT3; j++)
+                            kernel.mMatrix[k][j] = cmd[index++].asReal();
+                    convolve(kernel, normalize, abs_value);
+                }
+                else if (name == "colortransform")
+                {
+                    LLMatrix3 transform;
+                    S32 index = 1;
+                    for (S32 k = 0; k < NUM_VALUES_IN_MAT3; k++)
+                        for (S32 j = 0; j < NUM_VALUES_IN_MAT3; j++)
+                            transform.mMatrix[k][j] = cmd[index++].asReal();
+                    transform.transpose();
+                    colorTransform(transform);
+                }
+            }
+        }
+
+    private:
+        static void blendValue(U8 (&lut)[3][256], S32 v, U8 value_v, const LLColor3& alpha)
+        {
+            for (S32 c = 0; c < 3; c++)
+            {
+                lut[c][v] = (U8)((1.0 - alpha.mV[c]) * (float)(v) + alpha.mV[c] * value_v);
+            }
+        }
+
+        void blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue)
+        {
+            F32 inv_alpha = 1.0 - alpha;
+            switch (mStencilBlendMode)
+            {
+                case STENCIL_BLEND_MODE_BLEND:
+                    pixel[VRED]   = inv_alpha * pixel[VRED]   + alpha * red;
+                    pixel[VGREEN] = inv_alpha * pixel[VGREEN] + alpha * green;
+                    pixel[VBLUE]  = inv_alpha * pixel[VBLUE]  + alpha * blue;
+                    break;
+                case STENCIL_BLEND_MODE_ADD:
+                    pixel[VRED]   = llclampb(pixel[VRED]   + alpha * red);
+                    pixel[VGREEN] = llclampb(pixel[VGREEN] + alpha * green);
+                    pixel[VBLUE]  = llclampb(pixel[VBLUE]  + alpha * blue);
+                    break;
+                case STENCIL_BLEND_MODE_ABACK:
+                    pixel[VRED]   = llclampb(inv_alpha * pixel[VRED]   + red);
+                    pixel[VGREEN] = llclampb(inv_alpha * pixel[VGREEN] + green);
+                    pixel[VBLUE]  = llclampb(inv_alpha * pixel[VBLUE]  + blue);
+                    break;
+                case STENCIL_BLEND_MODE_FADE:
+                    pixel[VRED]   = alpha * red;
+                    pixel[VGREEN] = alpha * green;
+                    pixel[VBLUE]  = alpha * blue;
+                    break;
+            }
+        }
+
+        void colorCorrect(const U8 (&lut)[3][256])
+        {
+            U8* pixel = mData;
+            for (S32 j = 0; j < mHeight; j++)
+            {
+                for (S32 i = 0; i < mWidth; i++)
+                {
+                    blendStencil(getStencilAlpha(i, j), pixel, lut[VRED][pixel[VRED]], lut[VGREEN][pixel[VGREEN]], lut[VBLUE][pixel[VBLUE]]);
+                    pixel += mComponents;
+                }
+            }
+        }
+
+        void colorTransform(const LLMatrix3& transform)
+        {
+            U8* pixel = mData;
+            for (S32 j = 0; j < mHeight; j++)
+            {
+                for (S32 i = 0; i < mWidth; i++)
+                {
+                    LLVector3 src((F32)(pixel[VRED]), (F32)(pixel[VGREEN]), (F32)(pixel[VBLUE]));
+                    LLVector3 dst = src * transform;
+                    dst.clamp(0.0f, 255.0f);
+                    blendStencil(getStencilAlpha(i, j), pixel, dst.mV[VRED], dst.mV[VGREEN], dst.mV[VBLUE]);
+                    pixel += mComponents;
+                }
+            }
+        }
+
+        void convolve(const LLMatrix3& kernel, bool normalize, bool abs_value)
+        {
+            F32 kernel_min = 0.0;
+            F32 kernel_max = 0.0;
+            for (S32 i = 0; i < NUM_VALUES_IN_MAT3; i++)
+            {
+                for (S32 j = 0; j < NUM_VALUES_IN_MAT3; j++)
+                {
+                    if (kernel.mMatrix[i][j] >= 0.0)
+                        kernel_max += kernel.mMatrix[i][j];
+                    else
+                        kernel_min += kernel.mMatrix[i][j];
+                }
+            }
+            if (abs_value)
+            {
+                kernel_max = llabs(kernel_max);
+                kernel_min = llabs(kernel_min);
+                kernel_max = llmax(kernel_max, kernel_min);
+                kernel_min = 0.0;
+            }
+            F32 kernel_range = kernel_max - kernel_min;
+
+            // Every pixel reads the unfiltered image
+            const S32 row_bytes = mWidth * mComponents;
+            const std::vector<U8> source(mData, mData + row_bytes * mHeight);
+            for (S32 j = 0; j < mHeight; j++)
+            {
+                for (S32 i = 0; i < mWidth; i++)
+                {
+                    U8* pixel = mData + j * row_bytes + i * mComponents;
+                    if (i == 0 || j == 0 || i == mWidth - 1 || j == mHeight - 1)
+                    {
+                        blendStencil(getStencilAlpha(i, j), pixel, 0, 0, 0);
+                        continue;
+                    }
+
+                    LLVector3 dst;
+                    for (S32 c = 0; c < 3; c++)
+                    {
+                        const U8* C = &source[j * row_bytes + i * mComponents + c];
+                        const U8* N = C - row_bytes;
+                        const U8* S = C + row_bytes;
+                        const S32 d = mComponents;
+                        dst.mV[c] = (kernel.mMatrix[0][0]*N[-d] + kernel.mMatrix[0][1]*N[0] + kernel.mMatrix[0][2]*N[d] +
+                                     kernel.mMatrix[1][0]*C[-d] + kernel.mMatrix[1][1]*C[0] + kernel.mMatrix[1][2]*C[d] +
+                                     kernel.mMatrix[2][0]*S[-d] + kernel.mMatrix[2][1]*S[0] + kernel.mMatrix[2][2]*S[d]);
+                        if (abs_value)
+                        {
+                            dst.mV[c] = llabs(dst.mV[c]);
+                        }
+                        if (normalize)
+                        {
+                            dst.mV[c] = (dst.mV[c] - kernel_min)/kernel_range;
+                        }
+                    }
+                    dst.clamp(0.0f, 255.0f);
+                    blendStencil(getStencilAlpha(i, j), pixel, dst.mV[VRED], dst.mV[VGREEN], dst.mV[VBLUE]);
+                }
+            }
+        }
+
+        void filterScreen(EScreenMode mode, const F32 wave_length, const F32 angle)
+        {
+            F32 wave_length_pixels = wave_length * (F32)(mHeight) / 2.0;
+            F32 sin = sinf(angle*DEG_TO_RAD);
+            F32 cos = cosf(angle*DEG_TO_RAD);
+
+            U8 gamma[256];
+            for (S32 i = 0; i < 256; i++)
+            {
+                F32 gamma_i = llclampf((float)(powf((float)(i)/255.0, 1.0/4.0)));
+                gamma[i] = (U8)(255.0 * gamma_i);
+            }
+
+            U8* pixel = mData;
+            for (S32 j = 0; j < mHeight; j++)
+            {
+                for (S32 i = 0; i < mWidth; i++)
+                {
+                    F32 value = 0.0;
+                    F32 di = 0.0;
+                    F32 dj = 0.0;
+                    switch (mode)
+                    {
+                        case SCREEN_MODE_2DSINE:
+                            di =  cos*i + sin*j;
+                            dj = -sin*i + cos*j;
+                            value = (sinf(2*F_PI*di/wave_length_pixels)*sinf(2*F_PI*dj/wave_length_pixels)+1.0)*255.0/2.0;
+                            break;
+                        case SCREEN_MODE_LINE:
+                            dj = sin*i - cos*j;
+                            value = (sinf(2*F_PI*dj/wave_length_pixels)+1.0)*255.0/2.0;
+                            break;
+                    }
+                    U8 dst_value = (pixel[VRED] >= (U8)(value) ? gamma[pixel[VRED] - (U8)(value)] : 0);
+                    blendStencil(getStencilAlpha(i, j), pixel, dst_value, dst_value, dst_value);
+                    pixel += mComponents;
+                }
+            }
+        }
+
+        // Like LLImageFilter, the histogram is taken once, the first time
+        // a command needs it
+        const U32* getBrightnessHistogram()
+        {
+            if (!mHistoComputed)
+            {
+                memset(mHistoBrightness, 0, sizeof(mHistoBrightness));
+                const U8* pixel = mData;
+                for (S32 i = 0; i < mWidth * mHeight; i++)
+                {
+                    S32 brightness = ((S32)(pixel[VRED]) + (S32)(pixel[VGREEN]) + (S32)(pixel[VBLUE])) / 3;
+                    mHistoBrightness[brightness]++;
+                    pixel += mComponents;
+                }
+                mHistoComputed = true;
+            }
+            return mHistoBrightness;
+        }
+
+        void filterLinearize(F32 tail, const LLColor3& alpha)
+        {
+            const U32* histo = getBrightnessHistogram();
+            U32 cumulated_histo[256];
+            cumulated_histo[0] = histo[0];
+            for (S32 i = 1; i < 256; i++)
+            {
+                cumulated_histo[i] = cumulated_histo[i-1] + histo[i];
+            }
+
+            tail = llclampf(tail);
+            S32 total = cumulated_histo[255];
+            S32 min_c = (S32)((F32)(total) * tail);
+            S32 max_c = (S32)((F32)(total) * (1.0 - tail));
+
+            S32 min_v = 0;
+            while (cumulated_histo[min_v] < min_c)
+            {
+                min_v++;
+            }
+            S32 max_v = 255;
+            while (cumulated_histo[max_v] > max_c)
+            {
+                max_v--;
+            }
+
+            U8 lut[3][256];
+            if (max_v == min_v)
+            {
+                for (S32 i = 0; i < 256; i++)
+                {
+                    blendValue(lut, i, (i < min_v ? 0 : 255), alpha);
+                }
+            }
+            else
+            {
+                F32 slope = 255.0 / (F32)(max_v - min_v);
+                F32 translate = -min_v * slope;
+                for (S32 i = 0; i < 256; i++)
+                {
+                    blendValue(lut, i, (U8)(llclampb((S32)(slope*i + translate))), alpha);
+                }
+            }
+            colorCorrect(lut);
+        }
+
+        void filterEqualize(S32 nb_classes, const LLColor3& alpha)
+        {
+            nb_classes = llmax(nb_classes, 2);
+            nb_classes = llclampb(nb_classes);
+
+            const U32* histo = getBrightnessHistogram();
+            U32 cumulated_histo[256];
+            cumulated_histo[0] = histo[0];
+            for (S32 i = 1; i < 256; i++)
+            {
+                cumulated_histo[i] = cumulated_histo[i-1] + histo[i];
+            }
+
+            S32 total = cumulated_histo[255];
+            S32 delta_count = total / nb_classes;
+            S32 current_count = delta_count;
+            S32 delta_value = 256 / (nb_classes - 1);
+            S32 current_value = 0;
+
+            U8 lut[3][256];
+            for (S32 i = 0; i < 256; i++)
+            {
+                for (S32 c = 0; c < 3; c++)
+                {
+                    lut[c][i] = (U8)((1.0 - alpha.mV[c]) * (float)(i) + alpha.mV[c] * current_value);
+                }
+                if (cumulated_histo[i] >= current_count)
+                {
+                    current_count += delta_count;
+                    current_value += delta_value;
+                    current_value = llclampb(current_value);
+                }
+            }
+            colorCorrect(lut);
+        }
+
+        void setStencil(EStencilShape shape, EStencilBlendMode mode, F32 min, F32 max, F32* params)
+        {
+            mStencilShape = shape;
+            mStencilBlendMode = mode;
+            mStencilMin = llmin(llmax(min, -1.0f), 1.0f);
+            mStencilMax = llmin(llmax(max, -1.0f), 1.0f);
+
+            mStencilCenterX = (S32)(mWidth  + params[0] * (F32)(mHeight))/2;
+            mStencilCenterY = (S32)(mHeight + params[1] * (F32)(mHeight))/2;
+            mStencilWidth = (S32)(params[2] * (F32)(mHeight))/2;
+            mStencilGamma = (params[3] <= 0.0 ? 1.0 : params[3]);
+
+            mStencilWavelength = (params[0] <= 0.0 ? 10.0 : params[0] * (F32)(mHeight) / 2.0);
+            mStencilSine   = sinf(params[1]*DEG_TO_RAD);
+            mStencilCosine = cosf(params[1]*DEG_TO_RAD);
+
+            mStencilStartX = ((F32)(mWidth)  + params[0] * (F32)(mHeight))/2.0;
+            mStencilStartY = ((F32)(mHeight) + params[1] * (F32)(mHeight))/2.0;
+            F32 end_x      = ((F32)(mWidth)  + params[2] * (F32)(mHeight))/2.0;
+            F32 end_y      = ((F32)(mHeight) + params[3] * (F32)(mHeight))/2.0;
+            mStencilGradX  = end_x - mStencilStartX;
+            mStencilGradY  = end_y - mStencilStartY;
+            mStencilGradN  = mStencilGradX*mStencilGradX + mStencilGradY*mStencilGradY;
+        }
+
+        F32 getStencilAlpha(S32 i, S32 j) const
+        {
+            F32 alpha = 1.0;
+            if (mStencilShape == STENCIL_SHAPE_VIGNETTE)
+            {
+                F32 d_center_square = (i - mStencilCenterX)*(i - mStencilCenterX) + (j - mStencilCenterY)*(j - mStencilCenterY);
+                alpha = powf(F_E, -(powf((d_center_square/(mStencilWidth*mStencilWidth)),mStencilGamma)/2.0f));
+            }
+            else if (mStencilShape == STENCIL_SHAPE_SCAN_LINES)
+            {
+                F32 d = mStencilSine*i - mStencilCosine*j;
+                alpha = (sinf(2*F_PI*d/mStencilWavelength) > 0.0 ? 1.0 : 0.0);
+            }
+            else if (mStencilShape == STENCIL_SHAPE_GRADIENT)
+            {
+                alpha = (((F32)(i) - mStencilStartX)*mStencilGradX + ((F32)(j) - mStencilStartY)*mStencilGradY) / mStencilGradN;
+                alpha = llclampf(alpha);
+            }
+            return (mStencilMin + alpha * (mStencilMax - mStencilMin));
+        }
+
+        U8* mData;
+        S32 mWidth;
+        S32 mHeight;
+        S32 mComponents;
+
+        bool mHistoComputed;
+        U32 mHistoBrightness[256];
+
+        EStencilBlendMode mStencilBlendMode;
+        EStencilShape mStencilShape;
+        F32 mStencilMin;
+        F32 mStencilMax;
+
+        S32 mStencilCenterX;
+        S32 mStencilCenterY;
+        S32 mStencilWidth;
+        F32 mStencilGamma;
+
+        F32 mStencilWavelength;
+        F32 mStencilSine;
+        F32 mStencilCosine;
+
+        F32 mStencilStartX;
+        F32 mStencilStartY;
+        F32 mStencilGradX;
+        F32 mStencilGradY;
+        F32 mStencilGradN;
+    };
+}
+
+namespace tut
+{
+    struct imagefilter_data
+    {
+        // Starting the "General" pool lets large images spread their tiles
+        // over its threads, as they do in the viewer
+        imagefilter_data()
+            : mPool("General", 3, 1024 * 1024, false)
+        {
+            mPool.start();
+        }
+
+        ~imagefilter_data()
+        {
+            mPool.close();
+        }
+
+        std::vector<U8> makeImage(S32 width, S32 height, S32 components)
+        {
+            std::vector<U8> image(width * height * components);
+            U32 seed = 8765;
+            for (S32 y = 0; y < height; ++y)
+            {
+                for (S32 x = 0; x < width; ++x)
+                {
+                    U8* p = &image[(y * width + x) * components];
+                    seed = seed * 1103515245 + 12345;
+                    for (S32 c = 0; c < components; ++c)
+                    {
+                        // Gradients covering the whole range, noise, and a
+                        // hard edge for the convolutions to find
+                        S32 v = (x * 5 + y * 3 + c * 70) % 256;
+                        v += (S32)((seed >> (16 + c * 2)) & 31) - 16;
+                        v = (y > height / 3) ? 255 - v : v;
+                        p[c] = (U8)llclamp(v, 0, 255);
+                    }
+                }
+            }
+            return image;
+        }
+
+        // Runs commands through LLImageFilter and through the reference on
+        // the same pixels, and compares every byte, alpha included.
+        void ensureSameAsReference(const std::string& msg, const LLSD& commands, S32 width, S32 height, S32 components)
+        {
+            std::ostringstream xml;
+            LLSDSerialize::toXML(commands, xml);
+            NamedTempFile file("imagefilter", xml.str());
+
+            // The reference reads the file back too, so both see the
+            // parameters as rounded by the XML
+            LLSD parsed;
+            std::istringstream in(xml.str());
+            LLSDSerialize::fromXML(parsed, in);
+
+            const std::vector<U8> source = makeImage(width, height, components);
+            LLPointer<LLImageRaw> image = new LLImageRaw(source.data(), width, height, components);
+            ensure(msg + " allocated", !image->isBufferInvalid());
+            LLImageFilter filter(file.getName());
+            filter.executeFilter(image);
+
+            std::vector<U8> expected = source;
+            ReferenceFilter reference(expected.data(), width, height, components);
+            reference.execute(parsed);
+
+            const U8* actual = image->getData();
+            for (size_t b = 0; b < expected.size(); ++b)
+            {
+                if (actual[b] != expected[b])
+                {
+                    const S32 pixel = (S32)(b / components);
+                    ensure_equals(llformat("%s, %dx%dx%d at (%d, %d) component %d", msg.c_str(), width, height, components,
+                                           pixel % width, pixel / width, (S32)(b % components)),
+                                  (S32)actual[b], (S32)expected[b]);
+                }
+            }
+        }
+
+        // Odd sizes, none a multiple of the SIMD width or of the tile
+        // height.  The small ones run as a single tile on this thread; the
+        // large ones are above the parallel threshold and split into
+        // several tiles, the last one partial.
+        void ensureAllSizes(const std::string& msg, const LLSD& commands)
+        {
+            ensureSameAsReference(msg, commands, 37, 23, 3);
+            ensureSameAsReference(msg, commands, 29, 17, 4);
+            ensureSameAsReference(msg, commands, 301, 263, 3);
+            ensureSameAsReference(msg, commands, 257, 259, 4);
+        }
+
+        static LLSD command(const std::string& name)
+        {
+            return llsd::array(name);
+        }
+
+        LL::ThreadPool mPool;
+    };
+    typedef test_group<imagefilter_data> imagefilter_test;
+    typedef imagefilter_test::object imagefilter_object;
+    tut::imagefilter_test imagefilter_testcase("LLImageFilter");
+
+    template<> template<>
+    void imagefilter_object::test<1>()
+    {
+        set_test_name("Each command matches the per pixel reference");
+
+        const LLSD commands = llsd::array(
+            command("sepia"),
+            command("grayscale"),
+            llsd::array("saturate", 1.6),
+            llsd::array("saturate", 0.4),
+            llsd::array("rotate", 35.0),
+            llsd::array("gamma", 1.8, 1.0, 0.6, 1.0),
+            llsd::array("colorize", 0.9, 0.3, 0.1, 0.5, 0.4, 0.3),
+            llsd::array("contrast", 1.4, 1.0, 1.0, 0.5),
+            llsd::array("brighten", 0.2, 1.0, 1.0, 1.0),
+            llsd::array("darken", 0.15, 1.0, 0.7, 1.0),
+            llsd::array("linearize", 0.05, 1.0, 1.0, 1.0),
+            llsd::array("posterize", 6, 1.0, 1.0, 0.8),
+            llsd::array("screen", "2Dsine", 0.02, 30.0),
+            llsd::array("screen", "line", 0.03, 45.0),
+            command("blur"),
+            command("sharpen"),
+            command("gradient"),
+            llsd::array("convolve", 1.0, 1.0, 1.0, 2.0, 1.0, 0.0, 0.0, 0.0, -1.0, -2.0, -1.0),
+            llsd::array("colortransform", 0.9, 0.1, 0.0, 0.2, 0.7, 0.1, 0.0, 0.3, 1.2));
+
+        for (S32 i = 0; i < commands.size(); ++i)
+        {
+            ensureAllSizes(commands[i][0].asString(), llsd::array(commands[i]));
+        }
+    }
+
+    template<> template<>
+    void imagefilter_object::test<2>()
+    {
+        set_test_name("Chains under every stencil shape and blend mode match the per pixel reference");
+
+        // Consecutive tables, a matrix and a screen queued together, then a
+        // convolution that has to flush them and a histogram that reads
+        // the result
+        const LLSD chain = llsd::array(
+            llsd::array("gamma", 1.3, 1.0, 1.0, 1.0),
+            llsd::array("contrast", 1.2, 1.0, 1.0, 1.0),
+            llsd::array("brighten", 0.1, 1.0, 0.5, 1.0),
+            command("sepia"),
+            llsd::array("screen", "line", 0.05, 20.0),
+            command("sharpen"),
+            llsd::array("linearize", 0.02, 1.0, 1.0, 1.0),
+            llsd::array("rotate", 60.0));
+
+        const LLSD stencils = llsd::array(
+            llsd::array("stencil", "uniform", "blend", 0.0, 0.6),
+            llsd::array("stencil", "uniform", "add", 0.0, 0.4),
+            llsd::array("stencil", "uniform", "add_back", 0.0, 0.7),
+            llsd::array("stencil", "uniform", "fade", 0.0, 0.8),
+            llsd::array("stencil", "gradient", "blend", 0.0, 1.0, -0.5, -0.5, 0.5, 0.5),
+            llsd::array("stencil", "vignette", "fade", 0.2, 1.0, 0.1, -0.1, 0.8, 2.0),
+            llsd::array("stencil", "scanlines", "add", 0.0, 0.5, 0.05, 30.0));
+
+        for (S32 i = 0; i < stencils.size(); ++i)
+        {
+            LLSD commands = llsd::array(stencils[i]);
+            for (S32 k = 0; k < chain.size(); ++k)
+            {
+                commands.append(chain[k]);
+            }
+            ensureAllSizes(stencils[i][1].asString() + " " + stencils[i][2].asString(), commands);
+        }
+
+        // A stencil change in the middle of a chain applies from there on
+        const LLSD switched = llsd::array(
+            llsd::array("stencil", "uniform", "blend", 0.0, 0.5),
+            llsd::array("gamma", 2.2, 1.0, 1.0, 1.0),
+            command("grayscale"),
+            llsd::array("stencil", "vignette", "blend", 0.0, 1.0, 0.0, 0.0, 1.0, 1.0),
+            llsd::array("colorize", 1.0, 0.5, 0.0, 0.6, 0.6, 0.6),
+            command("blur"));
+        ensureAllSizes("stencil switch", switched);
+    }
+}
@@ -0,0 +1,342 @@
+/**
+ * @file llimageresample_test.cpp
+ * @brief Conformance and throughput tests for the SIMD resamplers
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimageresample.h"
+
+#include "lltimer.h"
+#include "../test/lltut.h"
+
+#include <cmath>
+#include <vector>
+
+namespace tut
+{
+    struct imageresample_data
+    {
+        std::vector<U8> makeImage(S32 width, S32 height, S32 components)
+        {
+            std::vector<U8> image(width * height * components);
+            U32 seed = 4321;
+            for (S32 y = 0; y < height; ++y)
+            {
+                for (S32 x = 0; x < width; ++x)
+                {
+                    U8* p = &image[(y * width + x) * components];
+                    seed = seed * 1103515245 + 12345;
+                    for (S32 c = 0; c < components; ++c)
+                    {
+                        // Gradients plus a little noise and a hard edge, to
+                        // give the Lanczos lobes something to ring on
+                        S32 v = (x * 7 + y * 3 + c * 50) % 256;
+                        v += (S32)((seed >> (16 + c * 2)) & 15) - 8;
+                        v = (x > width / 2) ? 255 - v : v;
+                        p[c] = (U8)llclamp(v, 0, 255);
+                    }
+                }
+            }
+            return image;
+        }
+
+        // Double precision version of the same filters
+        static F64 filterValue(LLImageResample::EFilter filter, F64 x)
+        {
+            switch (filter)
+            {
+            case LLImageResample::BOX:
+                return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+            case LLImageResample::BILINEAR:
+                return fabs(x) < 1.0 ? 1.0 - fabs(x) : 0.0;
+            default:
+            {
+                if (x <= -3.0 || x >= 3.0)
+                {
+                    return 0.0;
+                }
+                if (x == 0.0)
+                {
+                    return 1.0;
+                }
+                const F64 pi = 3.14159265358979323846;
+                return 3.0 * sin(pi * x) * sin(pi * x / 3.0) / (pi * pi * x * x);
+            }
+            }
+        }
+
+        static F64 filterSupport(LLImageResample::EFilter filter)
+        {
+            return filter == LLImageResample::BOX ? 0.5 : (filter == LLImageResample::BILINEAR ? 1.0 : 3.0);
+        }
+
+        // One axis of the reference resampler, rounding to bytes between
+        // passes like the real one
+        std::vector<U8> referencePass(LLImageResample::EFilter filter, const std::vector<U8>& src,
+                                      S32 in_size, S32 out_size, S32 lines, S32 in_step, S32 out_step,
+                                      S32 in_line, S32 out_line, S32 components)
+        {
+            std::vector<U8> dst((size_t)(lines - 1) * out_line + (size_t)(out_size - 1) * out_step + components);
+            const F64 scale = (F64)in_size / out_size;
+            const F64 filter_scale = llmax(scale, 1.0);
+            const F64 support = filterSupport(filter) * filter_scale;
+            for (S32 i = 0; i < out_size; ++i)
+            {
+                const F64 center = (i + 0.5) * scale;
+                const S32 first = llmax((S32)(center - support + 0.5), 0);
+                const S32 last = llmin((S32)(center + support + 0.5), in_size);
+                std::vector<F64> weights;
+                F64 total = 0.0;
+                for (S32 k = first; k < last; ++k)
+                {
+                    weights.push_back(filterValue(filter, (k - center + 0.5) / filter_scale));
+                    total += weights.back();
+                }
+                for (S32 line = 0; line < lines; ++line)
+                {
+                    for (S32 c = 0; c < components; ++c)
+                    {
+                        F64 sum = 0.0;
+                        for (S32 k = first; k < last; ++k)
+                        {
+                            sum += weights[k - first] * src[(size_t)line * in_line + k * in_step + c];
+                        }
+                        dst[(size_t)line * out_line + i * out_step + c] = (U8)llclamp((S32)floor(sum / total + 0.5), 0, 255);
+                    }
+                }
+            }
+            return dst;
+        }
+
+        std::vector<U8> reference(LLImageResample::EFilter filter, const std::vector<U8>& src,
+                                  S32 src_width, S32 src_height, S32 dst_width, S32 dst_height, S32 components)
+        {
+            std::vector<U8> rows = src;
+            if (src_width != dst_width)
+            {
+                rows = referencePass(filter, src, src_width, dst_width, src_height, components, components,
+                                     src_width * components, dst_width * components, components);
+            }
+            if (src_height == dst_height)
+            {
+                return rows;
+            }
+            // Columns are lines of one pixel stepping a whole row at a time
+            const S32 row_bytes = dst_width * components;
+            return referencePass(filter, rows, src_height, dst_height, dst_width, row_bytes, row_bytes,
+                                 components, components, components);
+        }
+
+        S32 maxDifference(const std::vector<U8>& a, const std::vector<U8>& b)
+        {
+            S32 worst = 0;
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                worst = llmax(worst, abs((S32)a[i] - (S32)b[i]));
+            }
+            return worst;
+        }
+
+        std::vector<U8> referenceMip(const std::vector<U8>& src, S32 src_width, S32 src_height, S32 components)
+        {
+            const S32 width = llmax(src_width >> 1, 1);
+            const S32 height = llmax(src_height >> 1, 1);
+            std::vector<U8> dst(width * height * components);
+            for (S32 y = 0; y < height; ++y)
+            {
+                const S32 y0 = y * 2;
+                const S32 y1 = llmin(y * 2 + 1, src_height - 1);
+                for (S32 x = 0; x < width; ++x)
+                {
+                    const S32 x0 = x * 2;
+                    const S32 x1 = llmin(x * 2 + 1, src_width - 1);
+                    for (S32 c = 0; c < components; ++c)
+                    {
+                        U32 sum = src[(y0 * src_width + x0) * components + c] + src[(y0 * src_width + x1) * components + c]
+                                + src[(y1 * src_width + x0) * components + c] + src[(y1 * src_width + x1) * components + c];
+                        dst[(y * width + x) * components + c] = (U8)(sum >> 2);
+                    }
+                }
+            }
+            return dst;
+        }
+    };
+    typedef test_group<imageresample_data> imageresample_test;
+    typedef imageresample_test::object imageresample_object;
+    tut::imageresample_test imageresample_testcase("LLImageResample");
+
+    template<> template<>
+    void imageresample_object::test<1>()
+    {
+        set_test_name("filters match the reference");
+
+        const S32 sizes[][4] = {
+            { 64, 64, 32, 32 },     // halve
+            { 100, 60, 37, 23 },    // uneven shrink
+            { 17, 9, 64, 40 },      // grow
+            { 256, 8, 64, 8 },      // horizontal only
+            { 8, 200, 8, 33 },      // vertical only
+            { 50, 50, 123, 7 },     // grow one way, shrink the other
+            { 1, 1, 5, 3 },         // single pixel
+        };
+        for (LLImageResample::EFilter filter : { LLImageResample::BOX, LLImageResample::BILINEAR, LLImageResample::LANCZOS3 })
+        {
+            for (S32 components = 1; components <= 4; ++components)
+            {
+                for (const auto& size : sizes)
+                {
+                    std::vector<U8> src = makeImage(size[0], size[1], components);
+                    std::vector<U8> dst(size[2] * size[3] * components);
+                    ensure("resample", LLImageResample::resample(filter, src.data(), size[0], size[1], size[0] * components,
+                                                                 dst.data(), size[2], size[3], size[2] * components, components));
+                    std::vector<U8> expected = reference(filter, src, size[0], size[1], size[2], size[3], components);
+                    S32 worst = maxDifference(dst, expected);
+                    ensure("filter " + std::to_string(filter) + " components " + std::to_string(components)
+                           + " " + std::to_string(size[0]) + "x" + std::to_string(size[1])
+                           + " to " + std::to_string(size[2]) + "x" + std::to_string(size[3])
+                           + " off by " + std::to_string(worst), worst <= 1);
+                }
+            }
+        }
+    }
+
+    template<> template<>
+    void imageresample_object::test<2>()
+    {
+        set_test_name("flat images, strides and bad input");
+
+        // Weights are normalized in fixed point, so flat stays flat
+        for (LLImageResample::EFilter filter : { LLImageResample::BOX, LLImageResample::BILINEAR, LLImageResample::LANCZOS3 })
+        {
+            std::vector<U8> src(300 * 200 * 3, 173);
+            std::vector<U8> dst(77 * 411 * 3);
+            LLImageResample::resample(filter, src.data(), 300, 200, 300 * 3, dst.data(), 77, 411, 77 * 3, 3);
+            ensure_equals("flat", maxDifference(dst, std::vector<U8>(dst.size(), 173)), 0);
+        }
+
+        // Padded rows must not leak into the result
+        std::vector<U8> padded(40 * 30 * 4, 0);
+        std::vector<U8> packed = makeImage(32, 30, 4);
+        for (S32 y = 0; y < 30; ++y)
+        {
+            memcpy(&padded[y * 40 * 4], &packed[y * 32 * 4], 32 * 4);
+        }
+        std::vector<U8> from_padded(20 * 20 * 4), from_packed(20 * 20 * 4);
+        LLImageResample::resample(LLImageResample::BILINEAR, padded.data(), 32, 30, 40 * 4, from_padded.data(), 20, 20, 20 * 4, 4);
+        LLImageResample::resample(LLImageResample::BILINEAR, packed.data(), 32, 30, 32 * 4, from_packed.data(), 20, 20, 20 * 4, 4);
+        ensure("stride", from_padded == from_packed);
+
+        // Same size is a copy
+        std::vector<U8> copy(32 * 30 * 4);
+        LLImageResample::resample(LLImageResample::LANCZOS3, packed.data(), 32, 30, 32 * 4, copy.data(), 32, 30, 32 * 4, 4);
+        ensure("copy", copy == packed);
+
+        ensure("five components", !LLImageResample::resample(LLImageResample::BOX, packed.data(), 4, 4, 20, copy.data(), 2, 2, 10, 5));
+        ensure("empty", !LLImageResample::resample(LLImageResample::BOX, packed.data(), 0, 4, 0, copy.data(), 2, 2, 8, 4));
+    }
+
+    template<> template<>
+    void imageresample_object::test<3>()
+    {
+        set_test_name("mips and mip chains");
+
+        // Odd output widths exercise the scalar tails after the SIMD runs
+        for (S32 components = 1; components <= 4; ++components)
+        {
+            for (S32 width : { 1, 2, 3, 5, 8, 17, 33, 64 })
+            {
+                std::vector<U8> src = makeImage(width * 2, 6, components);
+                std::vector<U8> mip(width * 3 * components);
+                LLImageResample::generateMip(src.data(), mip.data(), width, 3, components);
+                ensure("mip components " + std::to_string(components) + " width " + std::to_string(width),
+                       mip == referenceMip(src, width * 2, 6, components));
+            }
+        }
+
+        ensure_equals("levels 256x256", LLImageResample::getMipLevelCount(256, 256), 9);
+        ensure_equals("levels 64x4", LLImageResample::getMipLevelCount(64, 4), 7);
+        ensure_equals("chain size", LLImageResample::getMipChainSize(4, 4, 4, 3), (2 * 2 + 1) * 4);
+
+        // Square and non square chains, including levels past the short side
+        const S32 sizes[][2] = { { 128, 128 }, { 64, 4 }, { 2, 32 }, { 1, 1 } };
+        for (const auto& size : sizes)
+        {
+            for (S32 components : { 1, 3, 4 })
+            {
+                const S32 levels = LLImageResample::getMipLevelCount(size[0], size[1]);
+                std::vector<U8> src = makeImage(size[0], size[1], components);
+                std::vector<U8> chain(LLImageResample::getMipChainSize(size[0], size[1], components, levels));
+                LLImageResample::generateMipChain(src.data(), size[0], size[1], components, chain.data(), levels);
+
+                std::vector<U8> expected = src;
+                S32 width = size[0], height = size[1];
+                size_t offset = 0;
+                for (S32 l = 1; l < levels; ++l)
+                {
+                    expected = referenceMip(expected, width, height, components);
+                    width = llmax(width >> 1, 1);
+                    height = llmax(height >> 1, 1);
+                    ensure("chain level " + std::to_string(l) + " of " + std::to_string(size[0]) + "x" + std::to_string(size[1]),
+                           memcmp(&chain[offset], expected.data(), expected.size()) == 0);
+                    offset += expected.size();
+                }
+                ensure_equals("chain filled", offset, chain.size());
+            }
+        }
+    }
+
+    template<> template<>
+    void imageresample_object::test<4>()
+    {
+        set_test_name("throughput");
+
+        const S32 size = 1024;
+        const S32 passes = 4;
+        std::vector<U8> src = makeImage(size, size, 4);
+        std::vector<U8> dst(size * size * 4);
+
+        for (LLImageResample::EFilter filter : { LLImageResample::BOX, LLImageResample::BILINEAR, LLImageResample::LANCZOS3 })
+        {
+            LLTimer timer;
+            for (S32 i = 0; i < passes; ++i)
+            {
+                LLImageResample::resample(filter, src.data(), size, size, size * 4, dst.data(), 700, 700, 700 * 4, 4);
+            }
+            F64 seconds = llmax(timer.getElapsedTimeF64(), 0.000001);
+            F64 mpixels = (F64)size * size * passes / seconds / 1000000.0;
+            LL_INFOS("ImageResample") << "filter " << filter << " 1024 to 700: " << mpixels << " source megapixels per second" << LL_ENDL;
+            ensure("resample throughput", mpixels > 2.0);
+        }
+
+        const S32 levels = LLImageResample::getMipLevelCount(size, size);
+        std::vector<U8> chain(LLImageResample::getMipChainSize(size, size, 4, levels));
+        LLTimer timer;
+        for (S32 i = 0; i < passes; ++i)
+        {
+            LLImageResample::generateMipChain(src.data(), size, size, 4, chain.data(), levels);
+        }
+        F64 seconds = llmax(timer.getElapsedTimeF64(), 0.000001);
+        F64 mpixels = (F64)size * size * passes / seconds / 1000000.0;
+        LL_INFOS("ImageResample") << "mip chain: " << mpixels << " source megapixels per second" << LL_ENDL;
+        ensure("mip chain throughput", mpixels > 2.0);
+    }
+}
@@ -217,13 +217,30 @@ int ceildivpow2(int a, int b)
 
 LLImageJ2COJ::LLImageJ2COJ()
     : LLImageJ2CImpl()
+    , mHasRegion(false)
+    , mRegion{ 0, 0, 0, 0 }
 {
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
 {
-    // No specific implementation for this method in the OpenJpeg case
-    return false;
+    // The discard level has already been applied to base by
+    // LLImageJ2C::initDecode() and is picked up through cp_reduce.
+    mHasRegion = false;
+    if (region)
+    {
+        if (region[2] <= region[0] || region[3] <= region[1] || region[0] < 0 || region[1] < 0)
+        {
+            LL_WARNS() << "LLImageJ2COJ: ignoring empty decode region" << LL_ENDL;
+            return false;
+        }
+        for (S32 i = 0; i < 4; ++i)
+        {
+            mRegion[i] = region[i];
+        }
+        mHasRegion = true;
+    }
+    return true;
 }
 
 bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size, int precincts_size, int levels)
@@ -319,6 +336,22 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
     //opj_decoder_set_strict_mode(opj_decoder_p, OPJ_FALSE);
 
+    // Let OpenJPEG spread code-block decoding of big images over its own
+    // worker threads.  Small images are cheaper to decode serially, and
+    // the decode pool already runs many of those side by side.
+    S32 decode_threads = LLImageJ2C::getDecodeThreads();
+    if (decode_threads > 1 && opj_has_thread_support())
+    {
+        S32 reduce = parameters.cp_reduce;
+        S32 area = mHasRegion
+            ? ((mRegion[2] - mRegion[0]) >> reduce) * ((mRegion[3] - mRegion[1]) >> reduce)
+            : (base.getWidth() >> reduce) * (base.getHeight() >> reduce);
+        if (area >= LLImageJ2C::getDecodeThreadsMinArea())
+        {
+            opj_codec_set_threads(opj_decoder_p, decode_threads);
+        }
+    }
+
     /* open a byte stream */
     LLJp2StreamReader streamReader(&base);
     opj_stream_t* opj_stream_p = opj_stream_default_create(OPJ_STREAM_READ);
@@ -329,9 +362,22 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     opj_stream_set_user_data_length(opj_stream_p, base.getDataSize());
 
     /* decode the stream and fill the image structure */
-    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image) &&
-                    opj_decode(opj_decoder_p, opj_stream_p, image) &&
-                    opj_end_decompress(opj_decoder_p, opj_stream_p);
+    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image);
+
+    if (success && mHasRegion)
+    {
+        // Clamp to the canvas, OpenJPEG rejects areas that stick out of it
+        S32 x0 = llclamp(mRegion[0], (S32)image->x0, (S32)image->x1);
+        S32 y0 = llclamp(mRegion[1], (S32)image->y0, (S32)image->y1);
+        S32 x1 = llclamp(mRegion[2], x0, (S32)image->x1);
+        S32 y1 = llclamp(mRegion[3], y0, (S32)image->y1);
+        success = x1 > x0 && y1 > y0 &&
+                    opj_set_decode_area(opj_decoder_p, image, x0, y0, x1, y1);
+    }
+
+    success = success &&
+                opj_decode(opj_decoder_p, opj_stream_p, image) &&
+                opj_end_decompress(opj_decoder_p, opj_stream_p);
 
     /* close the byte stream */
     opj_stream_destroy(opj_stream_p);
@@ -386,6 +432,13 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     S32 f=image->comps[0].factor;
     S32 width = ceildivpow2(image->x1 - image->x0, f);
     S32 height = ceildivpow2(image->y1 - image->y0, f);
+    if (mHasRegion)
+    {
+        // A region that doesn't start on the reduced grid rounds
+        // differently at each edge, trust the component size instead.
+        width = llmin(width, comp_width);
+        height = llmin(height, (S32)image->comps[0].h);
+    }
     raw_image.resize(width, height, channels);
     U8 *rawp = raw_image.getData();
     if (!rawp)
@@ -1964,7 +1964,7 @@ void LLPathParams::copyParams(const LLPathParams &params)
     setSkew(params.getSkew());
 }
 
-S32 LLVolume::sNumMeshPoints = 0;
+std::atomic<S32> LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
     : mParams(params)
@@ -2319,7 +2319,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
     return unpackVolumeFacesInternal(mdl);
 }
 
-bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
+bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size, bool cache_optimize)
 {
     //input data is now pointing at a zlib compressed block of LLSD
     //decompress block
@@ -2330,10 +2330,10 @@ bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
         LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
         return false;
     }
-    return unpackVolumeFacesInternal(mdl);
+    return unpackVolumeFacesInternal(mdl, cache_optimize);
 }
 
-bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
+bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl, bool cache_optimize)
 {
     {
         U32 face_count = mdl.size();
@@ -2717,7 +2717,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         }
     }
 
-    if (!cacheOptimize(true))
+    if (cache_optimize && !cacheOptimize(true))
     {
         // Out of memory?
         LL_WARNS() << "Failed to optimize!" << LL_ENDL;
@@ -2731,6 +2731,220 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 }
 
 
+namespace
+{
+    const U32 BINARY_FACES_MAGIC = 0x4656564c; // "LVVF"
+
+    enum
+    {
+        BINARY_FACE_TANGENTS = 0x1,
+        BINARY_FACE_WEIGHTS = 0x2
+    };
+
+    struct BinaryFacesHeader
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U32 mFaceCount;
+    };
+
+    struct BinaryFaceHeader
+    {
+        U32 mFlags;
+        S32 mNumVertices;
+        S32 mNumIndices;
+        F32 mExtents[8];
+        F32 mTexCoordExtents[4];
+        F32 mNormalizedScale[3];
+    };
+
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const U8* data, S32 size) : mData(data), mLeft(size > 0 ? size : 0) {}
+
+        bool read(void* dst, size_t bytes)
+        {
+            if (bytes > mLeft)
+            {
+                return false;
+            }
+            if (bytes)
+            {
+                memcpy(dst, mData, bytes);
+                mData += bytes;
+                mLeft -= bytes;
+            }
+            return true;
+        }
+
+        bool done() const { return mLeft == 0; }
+
+    private:
+        const U8* mData;
+        size_t mLeft;
+    };
+
+    inline void append(std::vector<U8>& out, const void* src, size_t bytes)
+    {
+        if (bytes)
+        {
+            const U8* p = (const U8*) src;
+            out.insert(out.end(), p, p + bytes);
+        }
+    }
+}
+
+bool LLVolume::packBinaryFaces(std::vector<U8>& out) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+    if (mVolumeFaces.empty())
+    {
+        return false;
+    }
+
+    size_t total = sizeof(BinaryFacesHeader);
+    for (const LLVolumeFace& face : mVolumeFaces)
+    {
+        const size_t streams = 2 + (face.mTangents ? 1 : 0) + (face.mWeights ? 1 : 0);
+        total += sizeof(BinaryFaceHeader)
+                 + face.mNumVertices * (streams * sizeof(LLVector4a) + sizeof(LLVector2))
+                 + face.mNumIndices * sizeof(U16);
+    }
+    out.clear();
+    out.reserve(total);
+
+    BinaryFacesHeader header = { BINARY_FACES_MAGIC, BINARY_FACES_VERSION, (U32) mVolumeFaces.size() };
+    append(out, &header, sizeof(header));
+
+    for (const LLVolumeFace& face : mVolumeFaces)
+    {
+        BinaryFaceHeader face_header;
+        face_header.mFlags = (face.mTangents ? BINARY_FACE_TANGENTS : 0) | (face.mWeights ? BINARY_FACE_WEIGHTS : 0);
+        face_header.mNumVertices = face.mNumVertices;
+        face_header.mNumIndices = face.mNumIndices;
+        memcpy(face_header.mExtents, face.mExtents[0].getF32ptr(), sizeof(F32) * 4);
+        memcpy(face_header.mExtents + 4, face.mExtents[1].getF32ptr(), sizeof(F32) * 4);
+        memcpy(face_header.mTexCoordExtents, face.mTexCoordExtents[0].mV, sizeof(F32) * 2);
+        memcpy(face_header.mTexCoordExtents + 2, face.mTexCoordExtents[1].mV, sizeof(F32) * 2);
+        memcpy(face_header.mNormalizedScale, face.mNormalizedScale.mV, sizeof(F32) * 3);
+        append(out, &face_header, sizeof(face_header));
+
+        const S32 num_verts = face.mNumVertices;
+        append(out, face.mPositions, sizeof(LLVector4a) * num_verts);
+        append(out, face.mNormals, sizeof(LLVector4a) * num_verts);
+        append(out, face.mTexCoords, sizeof(LLVector2) * num_verts);
+        if (face.mTangents)
+        {
+            append(out, face.mTangents, sizeof(LLVector4a) * num_verts);
+        }
+        if (face.mWeights)
+        {
+            append(out, face.mWeights, sizeof(LLVector4a) * num_verts);
+        }
+        append(out, face.mIndices, sizeof(U16) * face.mNumIndices);
+    }
+
+    return true;
+}
+
+bool LLVolume::unpackBinaryFaces(const U8* data, S32 size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+    BinaryReader reader(data, size);
+
+    BinaryFacesHeader header;
+    if (!reader.read(&header, sizeof(header))
+        || header.mMagic != BINARY_FACES_MAGIC
+        || header.mVersion != BINARY_FACES_VERSION
+        || header.mFaceCount == 0
+        || header.mFaceCount > (U32) LL_SCULPT_MESH_MAX_FACES)
+    {
+        return false;
+    }
+
+    mVolumeFaces.clear();
+    mVolumeFaces.resize(header.mFaceCount);
+
+    bool success = true;
+    for (LLVolumeFace& face : mVolumeFaces)
+    {
+        BinaryFaceHeader face_header;
+        if (!reader.read(&face_header, sizeof(face_header))
+            || face_header.mNumVertices < 0 || face_header.mNumVertices > 65536
+            || face_header.mNumIndices < 0 || face_header.mNumIndices % 3 != 0)
+        {
+            success = false;
+            break;
+        }
+
+        const S32 num_verts = face_header.mNumVertices;
+        face.resizeVertices(num_verts);
+        face.resizeIndices(face_header.mNumIndices);
+        if (face.mNumVertices != num_verts || face.mNumIndices != face_header.mNumIndices)
+        {
+            LL_WARNS() << "Failed to allocate " << num_verts << " vertices and " << face_header.mNumIndices
+                       << " indices for binary mesh face" << LL_ENDL;
+            success = false;
+            break;
+        }
+
+        face.mExtents[0].loadua(face_header.mExtents);
+        face.mExtents[1].loadua(face_header.mExtents + 4);
+        face.mTexCoordExtents[0].set(face_header.mTexCoordExtents[0], face_header.mTexCoordExtents[1]);
+        face.mTexCoordExtents[1].set(face_header.mTexCoordExtents[2], face_header.mTexCoordExtents[3]);
+        face.mNormalizedScale.set(face_header.mNormalizedScale);
+
+        success = reader.read(face.mPositions, sizeof(LLVector4a) * num_verts)
+                  && reader.read(face.mNormals, sizeof(LLVector4a) * num_verts)
+                  && reader.read(face.mTexCoords, sizeof(LLVector2) * num_verts);
+
+        if (success && (face_header.mFlags & BINARY_FACE_TANGENTS) && num_verts)
+        {
+            face.allocateTangents(num_verts);
+            success = face.mTangents && reader.read(face.mTangents, sizeof(LLVector4a) * num_verts);
+        }
+        if (success && (face_header.mFlags & BINARY_FACE_WEIGHTS) && num_verts)
+        {
+            face.allocateWeights(num_verts);
+            success = face.mWeights && reader.read(face.mWeights, sizeof(LLVector4a) * num_verts);
+        }
+        success = success && reader.read(face.mIndices, sizeof(U16) * face.mNumIndices);
+        if (!success)
+        {
+            break;
+        }
+
+        for (S32 i = 0; i < face.mNumIndices; ++i)
+        {
+            if (face.mIndices[i] >= num_verts)
+            {
+                success = false;
+                break;
+            }
+        }
+        if (!success)
+        {
+            break;
+        }
+
+        // already cache optimized when packed
+        face.mOptimized = TRUE;
+    }
+
+    if (!success || !reader.done())
+    {
+        mVolumeFaces.clear();
+        return false;
+    }
+
+    mSculptLevel = 0;  // success!
+
+    return true;
+}
+
 bool LLVolume::isMeshAssetLoaded()
 {
     return mIsMeshAssetLoaded;
@@ -2776,6 +2990,22 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
     mSculptLevel = 0;
 }
 
+void LLVolume::swapGeneratedData(LLVolume& other)
+{
+    llassert(mParams == other.mParams && mDetail == other.mDetail);
+
+    std::swap(mPathp, other.mPathp);
+    std::swap(mProfilep, other.mProfilep);
+    std::swap(mMesh.mArray, other.mMesh.mArray);
+    std::swap(mMesh.mElementCount, other.mMesh.mElementCount);
+    std::swap(mMesh.mCapacity, other.mMesh.mCapacity);
+    mVolumeFaces.swap(other.mVolumeFaces);
+    std::swap(mFaceMask, other.mFaceMask);
+    std::swap(mLODScaleBias, other.mLODScaleBias);
+    std::swap(mSculptLevel, other.mSculptLevel);
+    std::swap(mSurfaceArea, other.mSurfaceArea);
+}
+
 bool LLVolume::cacheOptimize(bool gen_tangents)
 {
     for (S32 i = 0; i < mVolumeFaces.size(); ++i)
@@ -5581,6 +5811,30 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
 
     ll_aligned_free_16(src_indices);
 
+    // then for overdraw, giving back at most 5% of the cache efficiency
+    LLMeshOptimizer::optimizeOverdrawU16(mIndices, mIndices, mNumIndices, mPositions, mNumVertices, 1.05f);
+
+    // and store vertices in the order the triangles first use them
+    std::vector<U32> remap(mNumVertices);
+    S32 vert_count = (S32) LLMeshOptimizer::optimizeVertexFetchRemapU16(&remap[0], mIndices, mNumIndices, mNumVertices);
+    if (vert_count > 0)
+    {
+        LLMeshOptimizer::remapIndexBufferU16(mIndices, mIndices, mNumIndices, &remap[0]);
+        LLMeshOptimizer::remapPositionsBuffer(mPositions, mPositions, mNumVertices, &remap[0]);
+        LLMeshOptimizer::remapNormalsBuffer(mNormals, mNormals, mNumVertices, &remap[0]);
+        LLMeshOptimizer::remapUVBuffer(mTexCoords, mTexCoords, mNumVertices, &remap[0]);
+        if (mTangents)
+        {
+            LLMeshOptimizer::remapTangentsBuffer(mTangents, mTangents, mNumVertices, &remap[0]);
+        }
+        if (mWeights)
+        {
+            LLMeshOptimizer::remapWeightsBuffer(mWeights, mWeights, mNumVertices, &remap[0]);
+        }
+        // unused vertices are dropped off the end
+        mNumVertices = vert_count;
+    }
+
     return true;
 }
 
@@ -7134,25 +7388,15 @@ void LLCalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LL
         U32 i2 = *index_array++;
         U32 i3 = *index_array++;
 
-        const LLVector4a& v1 = vertex[i1];
-        const LLVector4a& v2 = vertex[i2];
-        const LLVector4a& v3 = vertex[i3];
+        LLVector4a e1;
+        LLVector4a e2;
+        e1.setSub(vertex[i2], vertex[i1]);
+        e2.setSub(vertex[i3], vertex[i1]);
 
         const LLVector2& w1 = texcoord[i1];
         const LLVector2& w2 = texcoord[i2];
         const LLVector2& w3 = texcoord[i3];
 
-        const F32* v1ptr = v1.getF32ptr();
-        const F32* v2ptr = v2.getF32ptr();
-        const F32* v3ptr = v3.getF32ptr();
-
-        float x1 = v2ptr[0] - v1ptr[0];
-        float x2 = v3ptr[0] - v1ptr[0];
-        float y1 = v2ptr[1] - v1ptr[1];
-        float y2 = v3ptr[1] - v1ptr[1];
-        float z1 = v2ptr[2] - v1ptr[2];
-        float z2 = v3ptr[2] - v1ptr[2];
-
         float s1 = w2.mV[0] - w1.mV[0];
         float s2 = w3.mV[0] - w1.mV[0];
         float t1 = w2.mV[1] - w1.mV[1];
@@ -7166,10 +7410,20 @@ void LLCalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LL
         llassert(llfinite(r));
         llassert(!llisnan(r));
 
-        LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-                (t2 * z1 - t1 * z2) * r);
-        LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-                (s1 * z2 - s2 * z1) * r);
+        // sdir = (t2 * e1 - t1 * e2) * r, tdir = (s1 * e2 - s2 * e1) * r,
+        // the same operations per component as one lane each
+        LLVector4a sdir;
+        LLVector4a tdir;
+        LLVector4a tmp;
+        sdir.setMul(e1, LLVector4a(t2));
+        tmp.setMul(e2, LLVector4a(t1));
+        sdir.sub(tmp);
+        sdir.mul(r);
+
+        tdir.setMul(e2, LLVector4a(s1));
+        tmp.setMul(e1, LLVector4a(s2));
+        tdir.sub(tmp);
+        tdir.mul(r);
 
         tan1[i1].add(sdir);
         tan1[i2].add(sdir);
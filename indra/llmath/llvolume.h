@@ -27,6 +27,7 @@
 #ifndef LL_LLVOLUME_H
 #define LL_LLVOLUME_H
 
+#include <atomic>
 #include <iostream>
 
 class LLProfileParams;
@@ -1069,7 +1070,7 @@ class LLVolume : public LLRefCount
     LLFaceID generateFaceMask();
 
     BOOL isFaceMaskValid(LLFaceID face_mask);
-    static S32 sNumMeshPoints;
+    static std::atomic<S32> sNumMeshPoints;
 
     friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
     friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);      // HACK to bypass Windoze confusion over
@@ -1085,10 +1086,14 @@ class LLVolume : public LLRefCount
 
     void sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, S32 sculpt_level, bool visible_placeholder);
     void copyVolumeFaces(const LLVolume* volume);
+    // Trade everything generate() and sculpt() produce with a volume of the
+    // same params and detail that was generated elsewhere
+    void swapGeneratedData(LLVolume& other);
     void copyFacesTo(std::vector<LLVolumeFace> &faces) const;
     void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
 
-    // use meshoptimizer to optimize index buffer for vertex shader cache
+    // use meshoptimizer to optimize index buffer for vertex shader cache and overdraw,
+    // and vertex order for vertex fetch
     //  gen_tangents - if true, generate MikkTSpace tangents if needed before optimizing index buffer
     bool cacheOptimize(bool gen_tangents = false);
 
@@ -1105,9 +1110,19 @@ class LLVolume : public LLRefCount
     void createVolumeFaces();
 public:
     bool unpackVolumeFaces(std::istream& is, S32 size);
-    bool unpackVolumeFaces(U8* in_data, S32 size);
+    // cache_optimize false leaves faces in asset order without tangents,
+    // for measuring what cacheOptimize() does
+    bool unpackVolumeFaces(U8* in_data, S32 size, bool cache_optimize = true);
+
+    // Viewer-local binary copy of unpacked, cache optimized mesh faces,
+    // stored the way LLVolumeFace holds them so that loading is one copy
+    // per vertex stream.  Not an asset format:  bump BINARY_FACES_VERSION
+    // whenever the layout, or the unpacking that produced it, changes.
+    static const U32 BINARY_FACES_VERSION = 2;
+    bool packBinaryFaces(std::vector<U8>& out) const;
+    bool unpackBinaryFaces(const U8* data, S32 size);
 private:
-    bool unpackVolumeFacesInternal(const LLSD& mdl);
+    bool unpackVolumeFacesInternal(const LLSD& mdl, bool cache_optimize = true);
 
 public:
     virtual void setMeshAssetLoaded(bool loaded);
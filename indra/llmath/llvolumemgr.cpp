@@ -27,6 +27,7 @@
 
 #include "llvolumemgr.h"
 #include "llvolume.h"
+#include "threadpool.h"
 
 
 const F32 BASE_THRESHOLD = 0.03f;
@@ -53,6 +54,13 @@ LLVolumeMgr::LLVolumeMgr()
 
 LLVolumeMgr::~LLVolumeMgr()
 {
+    // Jobs still queued hand their volumes to this manager
+    if (mGeneratePool)
+    {
+        mGeneratePool->close();
+        mGeneratePool.reset();
+    }
+
     cleanup();
 
     delete mDataMutex;
@@ -218,6 +226,122 @@ void LLVolumeMgr::useMutex()
     }
 }
 
+void LLVolumeMgr::startGenerateThreads()
+{
+    if (!mGeneratePool)
+    {
+        mGeneratePool.reset(new LL::ThreadPool("VolumeGen", 2));
+        mGeneratePool->start();
+    }
+}
+
+S32 LLVolumeMgr::SculptMap::getVolumeLevel() const
+{
+    // LLVolume::sculpt() treats a map it can't use as empty
+    if (mWidth == 0 || mHeight == 0 || mComponents < 3 || mData.empty())
+    {
+        return -1;
+    }
+    return mLevel;
+}
+
+bool LLVolumeMgr::requestVolume(const LLVolumeParams& volume_params, S32 lod, const SculptMap* sculpt, bool tangents)
+{
+    if (!mGeneratePool)
+    {
+        return true;
+    }
+
+    LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+    LLVolume* volumep = volgroupp ? volgroupp->peekLOD(lod) : NULL;
+    if (volumep && (!sculpt || volumep->getSculptLevel() == sculpt->getVolumeLevel()))
+    {
+        return true;
+    }
+
+    const generate_key_t key(volume_params, lod);
+    if (mGenerating.count(key))
+    {
+        return false;
+    }
+
+    const F32 detail = LLVolumeLODGroup::getVolumeScaleFromDetail(lod);
+    std::shared_ptr<const SculptMap> map;
+    if (sculpt)
+    {
+        map = std::make_shared<SculptMap>(*sculpt);
+    }
+
+    bool posted = mGeneratePool->getQueue().post(
+        [this, key, detail, map, tangents]()
+        {
+            LLVolume* volumep = new LLVolume(key.first, detail);
+            if (map)
+            {
+                volumep->sculpt(map->mWidth, map->mHeight, map->mComponents,
+                                map->mData.empty() ? NULL : map->mData.data(),
+                                map->mLevel, map->mVisiblePlaceholder);
+            }
+            if (tangents)
+            {
+                for (S32 i = 0; i < volumep->getNumVolumeFaces(); ++i)
+                {
+                    volumep->genTangents(i);
+                }
+            }
+
+            // Only the main thread touches the reference count from here on
+            LLMutexLock lock(&mGeneratedMutex);
+            mGenerated.emplace_back(key, volumep);
+        });
+    if (!posted)
+    {
+        // Shutting down, let refVolume() build it
+        return true;
+    }
+
+    mGenerating.insert(key);
+    return false;
+}
+
+bool LLVolumeMgr::isGenerating(const LLVolumeParams& volume_params, S32 lod) const
+{
+    return mGenerating.count(generate_key_t(volume_params, lod)) > 0;
+}
+
+void LLVolumeMgr::updateGenerated()
+{
+    std::vector<std::pair<generate_key_t, LLPointer<LLVolume> > > generated;
+    {
+        LLMutexLock lock(&mGeneratedMutex);
+        generated.swap(mGenerated);
+    }
+
+    for (auto& entry : generated)
+    {
+        const generate_key_t& key = entry.first;
+        mGenerating.erase(key);
+
+        LLVolumeLODGroup* volgroupp = getGroup(key.first);
+        if (!volgroupp)
+        {
+            continue;
+        }
+
+        LLVolume* volumep = volgroupp->peekLOD(key.second);
+        if (!volumep)
+        {
+            volgroupp->adoptLOD(key.second, entry.second);
+        }
+        else if (key.first.isSculpt() && volumep->getSculptLevel() != entry.second->getSculptLevel())
+        {
+            // Everyone holding this volume sees the new sculpt at once
+            volumep->swapGeneratedData(*entry.second);
+        }
+        // else it was generated in place while the job ran
+    }
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
     s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -301,6 +425,24 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 lod)
     return mVolumeLODs[lod];
 }
 
+void LLVolumeLODGroup::adoptLOD(const S32 lod, LLVolume* volumep)
+{
+    llassert(lod >= 0 && lod < NUM_LODS);
+    llassert(mVolumeLODs[lod].isNull());
+    mVolumeLODs[lod] = volumep;
+}
+
+bool LLVolumeLODGroup::evictLOD(const S32 lod)
+{
+    llassert(lod >= 0 && lod < NUM_LODS);
+    if (mLODRefs[lod] > 0 || (mVolumeLODs[lod].notNull() && mVolumeLODs[lod]->getNumRefs() > 1))
+    {
+        return false;
+    }
+    mVolumeLODs[lod] = NULL;
+    return true;
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
     llassert_always(mRefs > 0);
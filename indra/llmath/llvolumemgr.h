@@ -28,10 +28,15 @@
 #define LL_LLVOLUMEMGR_H
 
 #include <map>
+#include <memory>
+#include <set>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
 #include "llthread.h"
+#include "llmutex.h"
+#include "threadpool_fwd.h"
 
 class LLVolumeParams;
 class LLVolumeLODGroup;
@@ -57,6 +62,14 @@ class LLVolumeLODGroup
 
     LLVolume* refLOD(const S32 detail);
     BOOL derefLOD(LLVolume *volumep);
+
+    // The volume refLOD() would return, without generating it
+    LLVolume* peekLOD(const S32 detail) const { return mVolumeLODs[detail]; }
+    // Takes a volume generated elsewhere for an LOD that has none
+    void adoptLOD(const S32 detail, LLVolume* volumep);
+    // Drops the volume of an LOD nothing references, so the next refLOD()
+    // starts over with an empty one.  False if the LOD is in use.
+    bool evictLOD(const S32 detail);
     S32 getNumRefs() const { return mRefs; }
 
     const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
@@ -78,6 +91,20 @@ class LLVolumeLODGroup
 class LLVolumeMgr
 {
 public:
+    // Copy of a sculpt map, for sculpting a volume on a generate thread
+    struct SculptMap
+    {
+        U16 mWidth = 0;
+        U16 mHeight = 0;
+        S8 mComponents = 0;
+        S32 mLevel = -1;
+        bool mVisiblePlaceholder = false;
+        std::vector<U8> mData;
+
+        // The sculpt level LLVolume::sculpt() ends up with for this map
+        S32 getVolumeLevel() const;
+    };
+
     LLVolumeMgr();
     virtual ~LLVolumeMgr();
     BOOL cleanup();         // Cleanup all volumes being managed, returns TRUE if no dangling references
@@ -95,6 +122,27 @@ class LLVolumeMgr
     // manually call this for mutex magic
     void useMutex();
 
+    // Generate volumes on a "VolumeGen" thread pool instead of in
+    // refVolume().  Everything below is for the main thread only.
+    void startGenerateThreads();
+    bool hasGenerateThreads() const { return (bool)mGeneratePool; }
+
+    // True if refVolume(volume_params, lod) has its volume ready, or would
+    // generate it in place because there are no generate threads.  If not,
+    // queues one job for the params and LOD (sculpts with the map to use)
+    // and returns false until updateGenerated() has picked up the result.
+    // An existing sculpt LOD made from another level of its map is
+    // regenerated and swapped into the same LLVolume.  With tangents, the
+    // job also generates tangents for every face, which the volume keeps
+    // for everything that uses it.
+    bool requestVolume(const LLVolumeParams& volume_params, S32 lod, const SculptMap* sculpt = NULL, bool tangents = false);
+    bool isGenerating(const LLVolumeParams& volume_params, S32 lod) const;
+
+    // Once a frame: hand finished volumes to their LOD groups.  Volumes
+    // nobody references any more are dropped.
+    void updateGenerated();
+    S32 getGeneratesPending() const { return (S32)mGenerating.size(); }
+
     friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -107,6 +155,12 @@ class LLVolumeMgr
     volume_lod_group_map_t mVolumeLODGroups;
 
     LLMutex* mDataMutex;
+
+    typedef std::pair<LLVolumeParams, S32> generate_key_t;
+    std::set<generate_key_t> mGenerating;
+    std::vector<std::pair<generate_key_t, LLPointer<LLVolume> > > mGenerated;   // guarded by mGeneratedMutex
+    LLMutex mGeneratedMutex;
+    std::unique_ptr<LL::ThreadPool> mGeneratePool;
 };
 
 #endif // LL_LLVOLUMEMGR_H
@@ -0,0 +1,410 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief Tests for the binary form of volume faces
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llvolume.h"
+#include "../llvolumemgr.h"
+
+#include "llmeshoptimizer.h"
+#include "llpointer.h"
+#include "lltimer.h"
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <array>
+
+namespace tut
+{
+    struct volume_data
+    {
+        LLVolumeParams mParams;
+
+        volume_data()
+        {
+            mParams.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+        }
+
+        bool sameStream(const void* a, const void* b, size_t bytes)
+        {
+            return bytes == 0 || (a && b && memcmp(a, b, bytes) == 0);
+        }
+
+        // Triangles as sorted corner positions, in sorted order
+        typedef std::array<F32, 9> triangle_t;
+        std::vector<triangle_t> getTriangles(const LLVolumeFace& face)
+        {
+            std::vector<triangle_t> triangles;
+            for (S32 i = 0; i + 2 < face.mNumIndices; i += 3)
+            {
+                std::array<std::array<F32, 3>, 3> corners;
+                for (S32 j = 0; j < 3; ++j)
+                {
+                    const F32* pos = face.mPositions[face.mIndices[i + j]].getF32ptr();
+                    corners[j] = { pos[0], pos[1], pos[2] };
+                }
+                std::sort(corners.begin(), corners.end());
+                triangle_t triangle;
+                for (S32 j = 0; j < 9; ++j)
+                {
+                    triangle[j] = corners[j / 3][j % 3];
+                }
+                triangles.push_back(triangle);
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        }
+
+        // Scalar tangents as LLCalculateTangentArray() computed them before
+        // it worked on whole vectors
+        std::vector<LLVector4a> scalarTangents(const LLVolumeFace& face)
+        {
+            std::vector<LLVector4a> tan1(face.mNumVertices * 2, LLVector4a(0.f, 0.f, 0.f, 0.f));
+            LLVector4a* tan2 = &tan1[face.mNumVertices];
+            for (S32 i = 0; i + 2 < face.mNumIndices; i += 3)
+            {
+                U32 i1 = face.mIndices[i], i2 = face.mIndices[i + 1], i3 = face.mIndices[i + 2];
+                const F32* v1 = face.mPositions[i1].getF32ptr();
+                const F32* v2 = face.mPositions[i2].getF32ptr();
+                const F32* v3 = face.mPositions[i3].getF32ptr();
+                const LLVector2& w1 = face.mTexCoords[i1];
+                const LLVector2& w2 = face.mTexCoords[i2];
+                const LLVector2& w3 = face.mTexCoords[i3];
+
+                float x1 = v2[0] - v1[0], x2 = v3[0] - v1[0];
+                float y1 = v2[1] - v1[1], y2 = v3[1] - v1[1];
+                float z1 = v2[2] - v1[2], z2 = v3[2] - v1[2];
+                float s1 = w2.mV[0] - w1.mV[0], s2 = w3.mV[0] - w1.mV[0];
+                float t1 = w2.mV[1] - w1.mV[1], t2 = w3.mV[1] - w1.mV[1];
+                F32 rd = s1 * t2 - s2 * t1;
+                float r = ((rd * rd) > FLT_EPSILON) ? (1.0f / rd) : ((rd > 0.0f) ? 1024.f : -1024.f);
+
+                LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+                LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+                tan1[i1].add(sdir);
+                tan1[i2].add(sdir);
+                tan1[i3].add(sdir);
+                tan2[i1].add(tdir);
+                tan2[i2].add(tdir);
+                tan2[i3].add(tdir);
+            }
+
+            std::vector<LLVector4a> tangents(face.mNumVertices);
+            for (S32 a = 0; a < face.mNumVertices; ++a)
+            {
+                LLVector4a n = face.mNormals[a];
+                const LLVector4a& t = tan1[a];
+                LLVector4a ncrosst;
+                ncrosst.setCross3(n, t);
+                n.mul(n.dot3(t).getF32());
+                LLVector4a tsubn;
+                tsubn.setSub(t, n);
+                if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
+                {
+                    tsubn.normalize3fast();
+                    tsubn.getF32ptr()[3] = ncrosst.dot3(tan2[a]).getF32() < 0.f ? -1.f : 1.f;
+                    tangents[a] = tsubn;
+                }
+                else
+                {
+                    tangents[a].set(0, 0, 1, 1);
+                }
+            }
+            return tangents;
+        }
+
+        // One manager with generate threads for every test, since a thread
+        // pool's name can only be taken once
+        static LLVolumeMgr& getGeneratingMgr()
+        {
+            static LLVolumeMgr volume_mgr;
+            volume_mgr.startGenerateThreads();
+            return volume_mgr;
+        }
+
+        // Picks up finished volumes like the viewer does once a frame
+        bool waitForGenerated(LLVolumeMgr& volume_mgr)
+        {
+            for (S32 i = 0; i < 1000 && volume_mgr.getGeneratesPending() > 0; ++i)
+            {
+                ms_sleep(10);
+                volume_mgr.updateGenerated();
+            }
+            return volume_mgr.getGeneratesPending() == 0;
+        }
+
+        LLVolumeMgr::SculptMap makeSculptMap()
+        {
+            LLVolumeMgr::SculptMap map;
+            map.mWidth = 16;
+            map.mHeight = 16;
+            map.mComponents = 3;
+            map.mLevel = 0;
+            for (S32 i = 0; i < map.mWidth * map.mHeight; ++i)
+            {
+                map.mData.push_back((U8)((i % map.mWidth) * 16));
+                map.mData.push_back((U8)((i / map.mWidth) * 16));
+                map.mData.push_back(128);
+            }
+            return map;
+        }
+    };
+    typedef test_group<volume_data> volume_test;
+    typedef volume_test::object volume_object;
+    tut::volume_test volume_testcase("LLVolume");
+
+    template<> template<>
+    void volume_object::test<1>()
+    {
+        set_test_name("binary faces round trip");
+
+        LLPointer<LLVolume> src = new LLVolume(mParams, 1.f);
+        ensure("source has faces", src->getNumVolumeFaces() > 0);
+        src->getVolumeFace(0).allocateWeights(src->getVolumeFace(0).mNumVertices);
+        for (S32 i = 0; i < src->getVolumeFace(0).mNumVertices; ++i)
+        {
+            src->getVolumeFace(0).mWeights[i].set(1.5f, 2.25f, 0.f, 0.f);
+        }
+
+        std::vector<U8> data;
+        ensure("packed", src->packBinaryFaces(data));
+
+        LLPointer<LLVolume> dst = new LLVolume(mParams, 1.f);
+        ensure("unpacked", dst->unpackBinaryFaces(data.data(), (S32) data.size()));
+        ensure_equals("face count", dst->getNumVolumeFaces(), src->getNumVolumeFaces());
+
+        for (S32 f = 0; f < src->getNumVolumeFaces(); ++f)
+        {
+            const LLVolumeFace& a = src->getVolumeFace(f);
+            const LLVolumeFace& b = dst->getVolumeFace(f);
+            ensure_equals("vertices", b.mNumVertices, a.mNumVertices);
+            ensure_equals("indices", b.mNumIndices, a.mNumIndices);
+            ensure("positions", sameStream(a.mPositions, b.mPositions, sizeof(LLVector4a) * a.mNumVertices));
+            ensure("normals", sameStream(a.mNormals, b.mNormals, sizeof(LLVector4a) * a.mNumVertices));
+            ensure("tex coords", sameStream(a.mTexCoords, b.mTexCoords, sizeof(LLVector2) * a.mNumVertices));
+            ensure("index data", sameStream(a.mIndices, b.mIndices, sizeof(U16) * a.mNumIndices));
+            ensure_equals("tangents", b.mTangents != NULL, a.mTangents != NULL);
+            ensure_equals("weights", b.mWeights != NULL, a.mWeights != NULL);
+            if (a.mWeights)
+            {
+                ensure("weight data", sameStream(a.mWeights, b.mWeights, sizeof(LLVector4a) * a.mNumVertices));
+            }
+            ensure("extents", b.mExtents[0].equals3(a.mExtents[0]) && b.mExtents[1].equals3(a.mExtents[1]));
+            ensure("marked optimized", b.mOptimized);
+        }
+    }
+
+    template<> template<>
+    void volume_object::test<2>()
+    {
+        set_test_name("damaged binary faces are rejected");
+
+        LLPointer<LLVolume> src = new LLVolume(mParams, 1.f);
+        std::vector<U8> data;
+        ensure("packed", src->packBinaryFaces(data));
+
+        LLPointer<LLVolume> dst = new LLVolume(mParams, 1.f);
+        ensure("truncated", !dst->unpackBinaryFaces(data.data(), (S32) data.size() - 1));
+        ensure_equals("no faces left behind", dst->getNumVolumeFaces(), 0);
+
+        std::vector<U8> longer(data);
+        longer.push_back(0);
+        ensure("trailing data", !dst->unpackBinaryFaces(longer.data(), (S32) longer.size()));
+
+        std::vector<U8> old_version(data);
+        old_version[4] ^= 0xff;
+        ensure("other version", !dst->unpackBinaryFaces(old_version.data(), (S32) old_version.size()));
+
+        ensure("empty", !dst->unpackBinaryFaces(NULL, 0));
+        ensure("still good", dst->unpackBinaryFaces(data.data(), (S32) data.size()));
+    }
+
+    template<> template<>
+    void volume_object::test<3>()
+    {
+        set_test_name("cache optimize keeps every triangle");
+
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+        LLPointer<LLVolume> volume = new LLVolume(params, 4.f);
+        ensure("has faces", volume->getNumVolumeFaces() > 0);
+        LLVolumeFace& face = volume->getVolumeFace(0);
+
+        // scatter the triangles so there's something to gain
+        std::vector<U16> indices(face.mIndices, face.mIndices + face.mNumIndices);
+        const S32 num_triangles = face.mNumIndices / 3;
+        for (S32 i = 0; i < num_triangles; ++i)
+        {
+            const S32 src = (i * 7919) % num_triangles;
+            for (S32 j = 0; j < 3; ++j)
+            {
+                face.mIndices[i * 3 + j] = indices[src * 3 + j];
+            }
+        }
+
+        const std::vector<triangle_t> before = getTriangles(face);
+        const F32 acmr_before = LLMeshOptimizer::getVertexCacheACMRU16(face.mIndices, face.mNumIndices, face.mNumVertices);
+
+        ensure("optimized", face.cacheOptimize());
+        for (S32 i = 0; i < face.mNumIndices; ++i)
+        {
+            ensure("index in range", face.mIndices[i] < face.mNumVertices);
+        }
+        S32 next_vertex = 0;
+        for (S32 i = 0; i < face.mNumIndices; ++i)
+        {   // fetch order follows first use
+            ensure("vertex order", face.mIndices[i] <= next_vertex);
+            next_vertex = llmax(next_vertex, face.mIndices[i] + 1);
+        }
+        ensure("same triangles", getTriangles(face) == before);
+
+        const F32 acmr_after = LLMeshOptimizer::getVertexCacheACMRU16(face.mIndices, face.mNumIndices, face.mNumVertices);
+        ensure("cache use improved", acmr_after < acmr_before);
+    }
+
+    template<> template<>
+    void volume_object::test<4>()
+    {
+        set_test_name("tangents match the scalar computation");
+
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+        params.setTwistEnd(0.5f);
+        LLPointer<LLVolume> volume = new LLVolume(params, 4.f);
+        ensure("has faces", volume->getNumVolumeFaces() > 0);
+
+        for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+        {
+            LLVolumeFace& face = volume->getVolumeFace(f);
+            const std::vector<LLVector4a> expected = scalarTangents(face);
+            volume->genTangents(f);
+            ensure("tangents", face.mTangents != NULL);
+            ensure("same tangents", sameStream(face.mTangents, expected.data(), sizeof(LLVector4a) * face.mNumVertices));
+        }
+    }
+
+    template<> template<>
+    void volume_object::test<5>()
+    {
+        set_test_name("identical in-flight requests share one job");
+
+        LLVolumeMgr& volume_mgr = getGeneratingMgr();
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE);
+        LLPointer<LLVolume> lowest = volume_mgr.refVolume(params, 0);
+
+        ensure("queued", !volume_mgr.requestVolume(params, 3));
+        ensure("still pending", !volume_mgr.requestVolume(params, 3));
+        LLVolumeParams same_params;
+        same_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE);
+        ensure("pending for equal params", !volume_mgr.requestVolume(same_params, 3));
+        ensure_equals("one job", volume_mgr.getGeneratesPending(), 1);
+        ensure("generating", volume_mgr.isGenerating(params, 3));
+
+        ensure("finished", waitForGenerated(volume_mgr));
+        ensure("not generating", !volume_mgr.isGenerating(params, 3));
+        ensure("ready", volume_mgr.requestVolume(params, 3));
+
+        volume_mgr.unrefVolume(lowest);
+        lowest = NULL;
+    }
+
+    template<> template<>
+    void volume_object::test<6>()
+    {
+        set_test_name("generated volumes are adopted into empty LODs");
+
+        LLVolumeMgr& volume_mgr = getGeneratingMgr();
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_LINE);
+        LLPointer<LLVolume> lowest = volume_mgr.refVolume(params, 0);
+        LLVolumeLODGroup* group = volume_mgr.getGroup(params);
+        ensure("group", group != NULL);
+        ensure("LOD empty", group->peekLOD(2) == NULL);
+
+        ensure("queued", !volume_mgr.requestVolume(params, 2));
+        ensure("finished", waitForGenerated(volume_mgr));
+        LLVolume* adopted = group->peekLOD(2);
+        ensure("adopted", adopted != NULL);
+        ensure_equals("detail", adopted->getDetail(), LLVolumeLODGroup::getVolumeScaleFromDetail(2));
+        ensure("has faces", adopted->getNumVolumeFaces() > 0);
+        ensure("lowest LOD untouched", group->peekLOD(0) == lowest.get());
+
+        // refVolume() hands out the adopted volume instead of building one
+        LLPointer<LLVolume> high = volume_mgr.refVolume(params, 2);
+        ensure("same volume", high.get() == adopted);
+
+        // Nobody holds these params any more by the time the job finishes
+        LLVolumeParams orphan_params;
+        orphan_params.setType(LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_CIRCLE);
+        ensure("orphan queued", !volume_mgr.requestVolume(orphan_params, 2));
+        ensure("orphan finished", waitForGenerated(volume_mgr));
+        ensure("orphan dropped", volume_mgr.getGroup(orphan_params) == NULL);
+
+        volume_mgr.unrefVolume(high);
+        high = NULL;
+        volume_mgr.unrefVolume(lowest);
+        lowest = NULL;
+    }
+
+    template<> template<>
+    void volume_object::test<7>()
+    {
+        set_test_name("a new sculpt level is swapped into the shared volume");
+
+        LLVolumeMgr& volume_mgr = getGeneratingMgr();
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+        LLUUID sculpt_id;
+        sculpt_id.generate();
+        params.setSculptID(sculpt_id, LL_SCULPT_TYPE_SPHERE);
+        const LLVolumeMgr::SculptMap map = makeSculptMap();
+
+        // swapGeneratedData() on its own trades the generated geometry
+        const F32 detail = LLVolumeLODGroup::getVolumeScaleFromDetail(1);
+        LLPointer<LLVolume> unsculpted = new LLVolume(params, detail);
+        LLPointer<LLVolume> sculpted = new LLVolume(params, detail);
+        sculpted->sculpt(map.mWidth, map.mHeight, map.mComponents, map.mData.data(), map.mLevel, false);
+        const S32 sculpted_faces = sculpted->getNumVolumeFaces();
+        const S32 sculpted_vertices = sculpted->getVolumeFace(0).mNumVertices;
+        const S32 unsculpted_level = unsculpted->getSculptLevel();
+        unsculpted->swapGeneratedData(*sculpted);
+        ensure_equals("level", unsculpted->getSculptLevel(), map.mLevel);
+        ensure_equals("faces", unsculpted->getNumVolumeFaces(), sculpted_faces);
+        ensure_equals("vertices", unsculpted->getVolumeFace(0).mNumVertices, sculpted_vertices);
+        ensure_equals("other level", sculpted->getSculptLevel(), unsculpted_level);
+
+        // Through the manager, whoever holds the LOD sees the new sculpt
+        LLPointer<LLVolume> shared = volume_mgr.refVolume(params, 1);
+        ensure("not sculpted yet", shared->getSculptLevel() != map.getVolumeLevel());
+        ensure("queued", !volume_mgr.requestVolume(params, 1, &map));
+        ensure("finished", waitForGenerated(volume_mgr));
+        ensure("same volume", volume_mgr.getGroup(params)->peekLOD(1) == shared.get());
+        ensure_equals("swapped level", shared->getSculptLevel(), map.getVolumeLevel());
+        ensure_equals("swapped vertices", shared->getVolumeFace(0).mNumVertices, sculpted_vertices);
+        ensure("ready", volume_mgr.requestVolume(params, 1, &map));
+
+        volume_mgr.unrefVolume(shared);
+        shared = NULL;
+    }
+}
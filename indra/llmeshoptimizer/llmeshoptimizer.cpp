@@ -152,6 +152,47 @@ void LLMeshOptimizer::optimizeVertexCacheU16(U16 * destination, const U16 * indi
     meshopt_optimizeVertexCache<unsigned short>(destination, indices, index_count, vertex_count);
 }
 
+void LLMeshOptimizer::optimizeOverdrawU32(U32 * destination, const U32 * indices, U64 index_count, const LLVector4a * vertex_positions, U64 vertex_count, F32 threshold)
+{
+    meshopt_optimizeOverdraw<unsigned int>(destination, indices, index_count, (const float*)vertex_positions, vertex_count, sizeof(LLVector4a), threshold);
+}
+
+void LLMeshOptimizer::optimizeOverdrawU16(U16 * destination, const U16 * indices, U64 index_count, const LLVector4a * vertex_positions, U64 vertex_count, F32 threshold)
+{
+    meshopt_optimizeOverdraw<unsigned short>(destination, indices, index_count, (const float*)vertex_positions, vertex_count, sizeof(LLVector4a), threshold);
+}
+
+size_t LLMeshOptimizer::optimizeVertexFetchRemapU32(unsigned int* remap, const U32 * indices, U64 index_count, U64 vertex_count)
+{
+    return meshopt_optimizeVertexFetchRemap(remap, indices, index_count, vertex_count);
+}
+
+size_t LLMeshOptimizer::optimizeVertexFetchRemapU16(unsigned int* remap, const U16 * indices, U64 index_count, U64 vertex_count)
+{
+    return meshopt_optimizeVertexFetchRemap<unsigned short>(remap, indices, index_count, vertex_count);
+}
+
+//static
+F32 LLMeshOptimizer::getVertexCacheACMRU32(const U32 * indices, U64 index_count, U64 vertex_count, U32 cache_size)
+{
+    if (index_count < 3)
+    {
+        return 0.f;
+    }
+    // no warps or primitive groups, a plain FIFO like the fixed function era
+    return meshopt_analyzeVertexCache(indices, index_count, vertex_count, cache_size, 0, 0).acmr;
+}
+
+//static
+F32 LLMeshOptimizer::getVertexCacheACMRU16(const U16 * indices, U64 index_count, U64 vertex_count, U32 cache_size)
+{
+    if (index_count < 3)
+    {
+        return 0.f;
+    }
+    return meshopt_analyzeVertexCache<unsigned short>(indices, index_count, vertex_count, cache_size, 0, 0).acmr;
+}
+
 size_t LLMeshOptimizer::generateRemapMultiU32(
     unsigned int* remap,
     const U32 * indices,
@@ -255,6 +296,22 @@ void LLMeshOptimizer::remapUVBuffer(LLVector2 * destination_uvs,
     meshopt_remapVertexBuffer((float*)destination_uvs, (const float*)uv_positions, uv_count, sizeof(LLVector2), remap);
 }
 
+void LLMeshOptimizer::remapTangentsBuffer(LLVector4a * destination_tangents,
+    const LLVector4a * tangents,
+    U64 tangents_count,
+    const unsigned int* remap)
+{
+    meshopt_remapVertexBuffer((float*)destination_tangents, (const float*)tangents, tangents_count, sizeof(LLVector4a), remap);
+}
+
+void LLMeshOptimizer::remapWeightsBuffer(LLVector4a * destination_weights,
+    const LLVector4a * weights,
+    U64 weights_count,
+    const unsigned int* remap)
+{
+    meshopt_remapVertexBuffer((float*)destination_weights, (const float*)weights, weights_count, sizeof(LLVector4a), remap);
+}
+
 //static
 U64 LLMeshOptimizer::simplifyU32(U32 *destination,
     const U32 *indices,
@@ -67,6 +67,55 @@ class LLMeshOptimizer
         U64 index_count,
         U64 vertex_count);
 
+    // Reorders triangles of a vertex cache optimized index buffer to cut
+    // overdraw, letting cache efficiency get at most threshold times worse
+    // (1.05 = 5%).  destination may be indices.
+    static void optimizeOverdrawU32(
+        U32 *destination,
+        const U32 *indices,
+        U64 index_count,
+        const LLVector4a * vertex_positions,
+        U64 vertex_count,
+        F32 threshold);
+
+    static void optimizeOverdrawU16(
+        U16 *destination,
+        const U16 *indices,
+        U64 index_count,
+        const LLVector4a * vertex_positions,
+        U64 vertex_count,
+        F32 threshold);
+
+    // Generates a remap that stores vertices in the order indices first
+    // use them and drops unused ones, returns the number of vertices left.
+    // Apply with remapIndexBuffer and the remap*Buffer functions.
+    static size_t optimizeVertexFetchRemapU32(
+        unsigned int* remap,
+        const U32 *indices,
+        U64 index_count,
+        U64 vertex_count);
+
+    static size_t optimizeVertexFetchRemapU16(
+        unsigned int* remap,
+        const U16 *indices,
+        U64 index_count,
+        U64 vertex_count);
+
+    // Average number of vertices transformed per triangle with a FIFO
+    // post-transform cache of cache_size vertices (ACMR).  0.5 is the best
+    // a closed mesh can do, 3 means no reuse at all.
+    static F32 getVertexCacheACMRU32(
+        const U32 *indices,
+        U64 index_count,
+        U64 vertex_count,
+        U32 cache_size = 16);
+
+    static F32 getVertexCacheACMRU16(
+        const U16 *indices,
+        U64 index_count,
+        U64 vertex_count,
+        U32 cache_size = 16);
+
     // Remap functions
     // Welds indentical vertexes together.
     // Removes unused vertices if indices were provided.
@@ -115,6 +164,16 @@ class LLMeshOptimizer
         U64 uv_count,
         const unsigned int* remap);
 
+    static void remapTangentsBuffer(LLVector4a * destination_tangents,
+        const LLVector4a * tangents,
+        U64 tangents_count,
+        const unsigned int* remap);
+
+    static void remapWeightsBuffer(LLVector4a * destination_weights,
+        const LLVector4a * weights,
+        U64 weights_count,
+        const unsigned int* remap);
+
     // Simplification
 
     // returns amount of indices in destiantion
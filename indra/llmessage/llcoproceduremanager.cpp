@@ -57,6 +57,8 @@ class LLCoprocedurePool: private boost::noncopyable
 {
 public:
     typedef LLCoprocedureManager::CoProcedure_t CoProcedure_t;
+    typedef LLCoprocedureManager::KeyedCoProcedure_t KeyedCoProcedure_t;
+    typedef LLCoprocedureManager::KeyedCallback_t KeyedCallback_t;
 
     LLCoprocedurePool(const std::string &name, size_t size);
     ~LLCoprocedurePool() = default;
@@ -69,6 +71,13 @@ class LLCoprocedurePool: private boost::noncopyable
     /// @return This method returns a UUID that can be used later to cancel execution.
     LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc);
 
+    /// Places a keyed coprocedure on the queue or merges it with an
+    /// identical one already queued or running.
+    ///
+    /// @return This method returns the UUID of the coprocedure that will run.
+    LLUUID enqueueKeyedCoprocedure(const std::string &name, const std::string &key,
+                                   KeyedCoProcedure_t proc, KeyedCallback_t callback);
+
     /// Returns the number of coprocedures in the queue awaiting processing.
     ///
     inline size_t countPending() const
@@ -90,6 +99,13 @@ class LLCoprocedurePool: private boost::noncopyable
         return countPending() + countActive();
     }
 
+    /// Returns the number of keyed requests merged into another.
+    ///
+    inline size_t countCoalesced() const
+    {
+        return mCoalescedCount;
+    }
+
     void close();
 
 private:
@@ -117,8 +133,18 @@ class LLCoprocedurePool: private boost::noncopyable
     // instance.
     typedef std::shared_ptr<CoprocQueue_t> CoprocQueuePtr;
 
+    // Queued or running keyed coprocedure and everyone waiting on it
+    struct KeyedCoproc
+    {
+        typedef std::shared_ptr<KeyedCoproc> ptr_t;
+
+        LLUUID mId;
+        std::vector<KeyedCallback_t> mWaiters;
+    };
+    typedef std::map<std::string, KeyedCoproc::ptr_t> KeyedCoprocMap_t;
+
     std::string     mPoolName;
-    size_t          mPoolSize, mActiveCoprocsCount, mPending;
+    size_t          mPoolSize, mActiveCoprocsCount, mPending, mCoalescedCount;
     CoprocQueuePtr  mPendingCoprocs;
     LLTempBoundListener mStatusListener;
 
@@ -126,6 +152,11 @@ class LLCoprocedurePool: private boost::noncopyable
     LLCore::HttpRequest::policy_t mHTTPPolicy;
 
     CoroAdapterMap_t mCoroMapping;
+    KeyedCoprocMap_t mKeyedCoprocs;
+
+    void runKeyedCoprocedure(const std::string &key, KeyedCoproc::ptr_t keyed, KeyedCoProcedure_t proc,
+                             LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, const LLUUID &id);
+    void fanOutKeyedResult(const std::string &key, KeyedCoproc::ptr_t keyed, const LLSD &result);
 
     void coprocedureInvokerCoro(CoprocQueuePtr pendingCoprocs,
                                 LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter);
@@ -199,6 +230,22 @@ LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const s
     return targetPool->enqueueCoprocedure(name, proc);
 }
 
+LLUUID LLCoprocedureManager::enqueueKeyedCoprocedure(const std::string &pool, const std::string &name, const std::string &key,
+                                                     KeyedCoProcedure_t proc, KeyedCallback_t callback)
+{
+    poolMap_t::iterator it = mPoolMap.find(pool);
+
+    if (it == mPoolMap.end())
+    {
+        // initializing pools in enqueueCoprocedure is not thread safe,
+        // at the moment pools need to be initialized manually
+        LL_ERRS() << "Uninitialized pool " << pool << LL_ENDL;
+    }
+
+    poolPtr_t targetPool = it->second;
+    return targetPool->enqueueKeyedCoprocedure(name, key, proc, callback);
+}
+
 void LLCoprocedureManager::setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn)
 {
     // functions to discover and store the pool sizes
@@ -208,6 +255,8 @@ void LLCoprocedureManager::setPropertyMethods(SettingQuery_t queryfn, SettingUpd
 
     initializePool("Upload");
     initializePool("AIS"); // it might be better to have some kind of on-demand initialization for AIS
+    initializePool("ObjectCost");
+    initializePool("Materials");
     // "ExpCache" pool gets initialized in LLExperienceCache
     // asset storage pool gets initialized in LLViewerAssetStorage
 }
@@ -272,6 +321,25 @@ size_t LLCoprocedureManager::count(const std::string &pool) const
     return it->second->count();
 }
 
+size_t LLCoprocedureManager::countCoalesced() const
+{
+    size_t count = 0;
+    for (const auto& pair : mPoolMap)
+    {
+        count += pair.second->countCoalesced();
+    }
+    return count;
+}
+
+size_t LLCoprocedureManager::countCoalesced(const std::string &pool) const
+{
+    poolMap_t::const_iterator it = mPoolMap.find(pool);
+
+    if (it == mPoolMap.end())
+        return 0;
+    return it->second->countCoalesced();
+}
+
 void LLCoprocedureManager::close()
 {
     for(auto & poolEntry : mPoolMap)
@@ -295,6 +363,7 @@ LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
     mPoolSize(size),
     mActiveCoprocsCount(0),
     mPending(0),
+    mCoalescedCount(0),
     mPendingCoprocs(std::make_shared<CoprocQueue_t>(LLCoprocedureManager::DEFAULT_QUEUE_SIZE)),
     mHTTPPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
     mCoroMapping()
@@ -393,6 +462,86 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
     return {};                      // never executed, pacify the compiler
 }
 
+//-------------------------------------------------------------------------
+LLUUID LLCoprocedurePool::enqueueKeyedCoprocedure(const std::string &name, const std::string &key,
+                                                  LLCoprocedurePool::KeyedCoProcedure_t proc,
+                                                  LLCoprocedurePool::KeyedCallback_t callback)
+{
+    KeyedCoprocMap_t::iterator it = mKeyedCoprocs.find(key);
+    if (it != mKeyedCoprocs.end())
+    {
+        // Identical request already queued or running, wait on its result
+        it->second->mWaiters.push_back(callback);
+        ++mCoalescedCount;
+        LL_DEBUGS("CoProcMgr") << "Coprocedure(" << name << ") coalesced into id=" << it->second->mId.asString()
+                               << " in pool \"" << mPoolName << "\" (" << it->second->mWaiters.size() << " waiters)" << LL_ENDL;
+        return it->second->mId;
+    }
+
+    KeyedCoproc::ptr_t keyed(std::make_shared<KeyedCoproc>());
+    keyed->mWaiters.push_back(callback);
+
+    // Coprocedures only run once this coroutine yields, so the entry
+    // can safely be registered after the enqueue succeeds.
+    keyed->mId = enqueueCoprocedure(name,
+        [this, key, keyed, proc](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, const LLUUID &id)
+        {
+            runKeyedCoprocedure(key, keyed, proc, httpAdapter, id);
+        });
+    if (keyed->mId.notNull())
+    {
+        mKeyedCoprocs[key] = keyed;
+    }
+    return keyed->mId;
+}
+
+//-------------------------------------------------------------------------
+void LLCoprocedurePool::runKeyedCoprocedure(const std::string &key, KeyedCoproc::ptr_t keyed, KeyedCoProcedure_t proc,
+                                            LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, const LLUUID &id)
+{
+    LLSD result;
+    try
+    {
+        result = proc(httpAdapter, id);
+    }
+    catch (...)
+    {
+        // Don't leave later requests merging into one that will never
+        // answer, and don't leave the ones already merged waiting forever
+        LLSD status;
+        LLCoreHttpUtil::HttpCoroHandler::writeStatusCodes(LLCore::HttpStatus(LLCore::HttpStatus::LLCORE, LLCore::HE_OP_CANCELED),
+                                                          key, status);
+        LLSD error;
+        error[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS] = status;
+        fanOutKeyedResult(key, keyed, error);
+        throw;
+    }
+
+    fanOutKeyedResult(key, keyed, result);
+}
+
+//-------------------------------------------------------------------------
+void LLCoprocedurePool::fanOutKeyedResult(const std::string &key, KeyedCoproc::ptr_t keyed, const LLSD &result)
+{
+    // Retire the key before fanning out so that waiters issuing the same
+    // request again from their callbacks get a fresh execution.
+    KeyedCoprocMap_t::iterator it = mKeyedCoprocs.find(key);
+    if (it != mKeyedCoprocs.end() && it->second == keyed)
+    {
+        mKeyedCoprocs.erase(it);
+    }
+
+    std::vector<KeyedCallback_t> waiters;
+    waiters.swap(keyed->mWaiters);
+    for (const KeyedCallback_t &waiter : waiters)
+    {
+        if (waiter)
+        {
+            waiter(result);
+        }
+    }
+}
+
 //-------------------------------------------------------------------------
 void LLCoprocedurePool::coprocedureInvokerCoro(
     CoprocQueuePtr pendingCoprocs,
@@ -471,5 +620,10 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
 
 void LLCoprocedurePool::close()
 {
+    if (mCoalescedCount)
+    {
+        LL_INFOS("CoProcMgr") << "Pool \"" << mPoolName << "\" coalesced " << mCoalescedCount
+                              << " duplicate requests" << LL_ENDL;
+    }
     mPendingCoprocs->close();
 }
@@ -45,6 +45,8 @@ class LLCoprocedureManager final : public LLSingleton < LLCoprocedureManager >
     typedef boost::function<void(const std::string &, U32, const std::string &)> SettingUpdate_t;
 
     typedef boost::function<void(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &id)> CoProcedure_t;
+    typedef boost::function<LLSD(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &id)> KeyedCoProcedure_t;
+    typedef boost::function<void(const LLSD &result)> KeyedCallback_t;
 
     /// Places the coprocedure on the queue for processing.
     ///
@@ -54,6 +56,22 @@ class LLCoprocedureManager final : public LLSingleton < LLCoprocedureManager >
     /// @return This method returns a UUID that can be used later to cancel execution.
     LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc);
 
+    /// Places a coprocedure identified by key on the queue for processing.
+    /// If a coprocedure with the same key is already queued or running in
+    /// the pool, no new work is queued; the callback is added to that
+    /// coprocedure's waiters instead.  Each waiter receives the LLSD
+    /// returned by the single execution.
+    ///
+    /// @param key Identifies equivalent requests, e.g. a capability URL
+    ///            plus request body.  Callers are responsible for making it
+    ///            specific enough that merged requests really are identical.
+    /// @param proc Is a bound function to be executed returning the result
+    /// @param callback Is invoked with the result once proc completes
+    ///
+    /// @return The UUID of the coprocedure that will satisfy this request.
+    LLUUID enqueueKeyedCoprocedure(const std::string &pool, const std::string &name, const std::string &key,
+                                   KeyedCoProcedure_t proc, KeyedCallback_t callback);
+
     /// Cancel a coprocedure. If the coprocedure is already being actively executed
     /// this method calls cancelYieldingOperation() on the associated HttpAdapter
     /// If it has not yet been dequeued it is simply removed from the queue.
@@ -76,6 +94,12 @@ class LLCoprocedureManager final : public LLSingleton < LLCoprocedureManager >
     size_t count() const;
     size_t count(const std::string &pool) const;
 
+    /// Returns the number of keyed requests that were merged into an
+    /// already queued or running coprocedure rather than executed.
+    ///
+    size_t countCoalesced() const;
+    size_t countCoalesced(const std::string &pool) const;
+
     void close();
     void close(const std::string &pool);
 
@@ -0,0 +1,185 @@
+/**
+ * @file llmessagecapture.cpp
+ * @brief Timestamped on-disk capture of lludp and capability traffic
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llmessagecapture.h"
+
+#include "lltimer.h"
+
+static const char CAPTURE_MAGIC[8] = { 'L', 'L', 'M', 'S', 'G', 'C', 'A', 'P' };
+
+// Upper bound on a single string or payload; anything larger means the
+// file is corrupt rather than that someone captured a 256MB body.
+static const U32 CAPTURE_FIELD_MAX = 256 * 1024 * 1024;
+
+namespace
+{
+    template <typename T>
+    void write_pod(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read_pod(std::istream& in, T& value)
+    {
+        return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    void write_bytes(std::ostream& out, const void* data, U32 size)
+    {
+        write_pod(out, size);
+        if (size)
+        {
+            out.write(static_cast<const char*>(data), size);
+        }
+    }
+
+    template <typename C>
+    bool read_bytes(std::istream& in, C& dest)
+    {
+        U32 size = 0;
+        if (!read_pod(in, size) || size > CAPTURE_FIELD_MAX)
+        {
+            return false;
+        }
+        dest.resize(size);
+        return !size || (bool) in.read(reinterpret_cast<char*>(&dest[0]), size);
+    }
+}
+
+LLMessageCapture::LLMessageCapture()
+:   mStartTime(0)
+,   mRecordCount(0)
+{
+}
+
+LLMessageCapture::~LLMessageCapture()
+{
+    close();
+}
+
+bool LLMessageCapture::open(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStream.is_open())
+    {
+        mStream.close();
+    }
+
+    mStream.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!mStream.is_open())
+    {
+        LL_WARNS("Messaging") << "Unable to open message capture " << filename << LL_ENDL;
+        return false;
+    }
+
+    mStream.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    write_pod(mStream, CAPTURE_VERSION);
+    mStartTime = LLTimer::getTotalTime();
+    mRecordCount = 0;
+    LL_INFOS("Messaging") << "Capturing message traffic to " << filename << LL_ENDL;
+    return true;
+}
+
+void LLMessageCapture::close()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStream.is_open())
+    {
+        mStream.close();
+        LL_INFOS("Messaging") << "Message capture closed after " << mRecordCount << " records" << LL_ENDL;
+    }
+}
+
+void LLMessageCapture::write(const LLMessageCaptureRecord& record)
+{
+    const U64 timestamp = LLTimer::getTotalTime();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mStream.is_open())
+    {
+        return;
+    }
+
+    U8 inbound = record.mInbound ? 1 : 0;
+    write_pod(mStream, timestamp > mStartTime ? timestamp - mStartTime : U64(0));
+    write_pod(mStream, record.mType);
+    write_pod(mStream, inbound);
+    write_pod(mStream, record.mFromHost.getAddress());
+    write_pod(mStream, record.mFromHost.getPort());
+    write_pod(mStream, record.mToHost.getAddress());
+    write_pod(mStream, record.mToHost.getPort());
+    write_pod(mStream, record.mStatus);
+    write_bytes(mStream, record.mURL.data(), (U32) record.mURL.size());
+    write_bytes(mStream, record.mContentType.data(), (U32) record.mContentType.size());
+    write_bytes(mStream, record.mData.data(), (U32) record.mData.size());
+    ++mRecordCount;
+}
+
+// static
+bool LLMessageCapture::read(const std::string& filename, std::vector<LLMessageCaptureRecord>& records)
+{
+    llifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        LL_WARNS("Messaging") << "Unable to open message capture " << filename << LL_ENDL;
+        return false;
+    }
+
+    char magic[sizeof(CAPTURE_MAGIC)];
+    U32 version = 0;
+    if (!in.read(magic, sizeof(magic))
+        || memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0
+        || !read_pod(in, version)
+        || version != CAPTURE_VERSION)
+    {
+        LL_WARNS("Messaging") << filename << " is not a version " << CAPTURE_VERSION
+                              << " message capture" << LL_ENDL;
+        return false;
+    }
+
+    records.clear();
+    while (in.peek() != EOF)
+    {
+        LLMessageCaptureRecord record;
+        U8 inbound = 0;
+        U32 from_addr = 0, from_port = 0, to_addr = 0, to_port = 0;
+        if (!read_pod(in, record.mTimestamp)
+            || !read_pod(in, record.mType)
+            || !read_pod(in, inbound)
+            || !read_pod(in, from_addr)
+            || !read_pod(in, from_port)
+            || !read_pod(in, to_addr)
+            || !read_pod(in, to_port)
+            || !read_pod(in, record.mStatus)
+            || !read_bytes(in, record.mURL)
+            || !read_bytes(in, record.mContentType)
+            || !read_bytes(in, record.mData))
+        {
+            LL_WARNS("Messaging") << "Truncated record in " << filename << " after "
+                                  << records.size() << " records, ignoring the rest" << LL_ENDL;
+            break;
+        }
+        record.mInbound = inbound != 0;
+        record.mFromHost = LLHost(from_addr, from_port);
+        record.mToHost = LLHost(to_addr, to_port);
+        records.push_back(std::move(record));
+    }
+    return true;
+}
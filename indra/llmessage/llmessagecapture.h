@@ -0,0 +1,100 @@
+/**
+ * @file llmessagecapture.h
+ * @brief Timestamped on-disk capture of lludp and capability traffic
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGECAPTURE_H
+#define LL_LLMESSAGECAPTURE_H
+
+#include "llhost.h"
+#include "llfile.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One captured packet or HTTP exchange
+ *
+ * mType mirrors LLMessageLogEntry::EEntryType so the two stay
+ * interchangeable; the capture format itself does not depend on
+ * llcorehttp types.
+ */
+struct LLMessageCaptureRecord
+{
+    typedef enum e_record_type {
+        TEMPLATE = 0,
+        HTTP_RESPONSE = 1,
+        HTTP_REQUEST = 2
+    } ERecordType;
+
+    LLMessageCaptureRecord()
+    :   mTimestamp(0)
+    ,   mType(TEMPLATE)
+    ,   mInbound(false)
+    ,   mStatus(0)
+    {}
+
+    U64 mTimestamp;                 // microseconds since capture start
+    U8 mType;
+    bool mInbound;                  // lludp packet was received, not sent
+    LLHost mFromHost;
+    LLHost mToHost;
+    S32 mStatus;                    // HTTP status type, 0 for lludp
+    std::string mURL;
+    std::string mContentType;
+    std::vector<U8> mData;
+};
+
+/**
+ * @brief Writer and reader for message capture files
+ *
+ * A capture is a fixed header followed by a flat sequence of records,
+ * written in host byte order.  Records are timestamped at write time
+ * relative to open() so a replay can reproduce the original pacing.
+ * Writes may come from the main thread and the HTTP thread and are
+ * serialized internally.
+ */
+class LLMessageCapture
+{
+public:
+    static const U32 CAPTURE_VERSION = 1;
+
+    LLMessageCapture();
+    ~LLMessageCapture();
+
+    /// Create (truncate) a capture file and write the header.
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return mStream.is_open(); }
+
+    /// Append a record, stamping it with the time since open().
+    void write(const LLMessageCaptureRecord& record);
+
+    U32 getRecordCount() const { return mRecordCount; }
+
+    /// Read an entire capture file.  Returns false on a missing file or
+    /// bad header; a truncated tail is dropped with a warning.
+    static bool read(const std::string& filename, std::vector<LLMessageCaptureRecord>& records);
+
+private:
+    std::mutex mMutex;
+    llofstream mStream;
+    U64 mStartTime;
+    U32 mRecordCount;
+};
+
+#endif // LL_LLMESSAGECAPTURE_H
@@ -22,6 +22,8 @@
 #include "httprequest.h"
 #include "httpresponse.h"
 #include "llmemory.h"
+#include "llmessagecapture.h"
+#include "net.h"
 #include <boost/circular_buffer.hpp>
 #include <utility>
 #include "_httpoprequest.h"
@@ -93,6 +95,8 @@ LLMessageLogEntry::~LLMessageLogEntry()
 
 /* static */
 LogCallback LLMessageLog::sCallback = nullptr;
+/* static */
+std::shared_ptr<LLMessageCapture> LLMessageLog::sCapture;
 
 /* static */
 void LLMessageLog::setCallback(LogCallback callback)
@@ -103,6 +107,17 @@ void LLMessageLog::setCallback(LogCallback callback)
         {
             callback(m);
         }
+    }
+
+    sCallback = callback;
+    updateHTTPHooks();
+}
+
+/* static */
+void LLMessageLog::updateHTTPHooks()
+{
+    if (haveLogger())
+    {
         LLCore::HttpRequestQueue::setMessageLogFunc([](const LLCore::HttpRequestQueue::opPtr_t& op) { LLMessageLog::log(op); });
         LLCore::HttpOpRequest::setMessageLogFunc([](LLCore::HttpResponse* response) { LLMessageLog::log(response); });
     }
@@ -111,8 +126,55 @@ void LLMessageLog::setCallback(LogCallback callback)
         LLCore::HttpOpRequest::setMessageLogFunc(nullptr);
         LLCore::HttpRequestQueue::setMessageLogFunc(nullptr);
     }
+}
 
-    sCallback = callback;
+/* static */
+bool LLMessageLog::startCapture(const std::string& filename)
+{
+    stopCapture();
+
+    auto capture = std::make_shared<LLMessageCapture>();
+    if (!capture->open(filename))
+    {
+        return false;
+    }
+    std::atomic_store(&sCapture, capture);
+    updateHTTPHooks();
+    return true;
+}
+
+/* static */
+void LLMessageLog::stopCapture()
+{
+    auto capture = std::atomic_exchange(&sCapture, std::shared_ptr<LLMessageCapture>());
+    if (capture)
+    {
+        updateHTTPHooks();
+        capture->close();
+    }
+}
+
+/* static */
+void LLMessageLog::capture(const LogPayload& payload)
+{
+    auto capture = std::atomic_load(&sCapture);
+    if (!capture) return;
+
+    // LLMessageSystem logs received packets as addressed to loopback
+    static const U32 loopback_addr = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+    LLMessageCaptureRecord record;
+    record.mType = (U8) payload->mType;
+    record.mInbound = payload->mToHost.getAddress() == loopback_addr;
+    record.mFromHost = payload->mFromHost;
+    record.mToHost = payload->mToHost;
+    record.mStatus = (S32) payload->mStatusCode;
+    record.mURL = payload->mURL;
+    record.mContentType = payload->mContentType;
+    if (payload->mData && payload->mDataSize > 0)
+    {
+        record.mData.assign(payload->mData, payload->mData + payload->mDataSize);
+    }
+    capture->write(record);
 }
 
 /* static */
@@ -125,6 +187,7 @@ void LLMessageLog::log(LLHost from_host, LLHost to_host, U8* data, S32 data_size
     LogPayload payload = std::make_shared<LLMessageLogEntry>(from_host, to_host, data, data_size);
 
     if(sCallback) sCallback(payload);
+    capture(payload);
 
     sRingBuffer.push_back(std::move(payload));
 }
@@ -165,6 +228,7 @@ void LLMessageLog::log(const LLCore::HttpRequestQueue::opPtr_t& op)
         req->mReqURL, req->mReplyConType, req->mReqHeaders, convertEMethodToEHTTPMethod(req->mReqMethod),
         req->mStatus.getType(), req->mRequestId);
     if (sCallback) sCallback(payload);
+    capture(payload);
     sRingBuffer.push_back(std::move(payload));
 }
 
@@ -187,5 +251,6 @@ void LLMessageLog::log(LLCore::HttpResponse* response)
         response->getRequestURL(), response->getContentType(), response->getHeaders(), HTTP_INVALID,
         response->getStatus().getType(), response->getRequestId());
     if (sCallback) sCallback(payload);
+    capture(payload);
     sRingBuffer.push_back(std::move(payload));
 }
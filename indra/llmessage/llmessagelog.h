@@ -24,7 +24,10 @@
 #include "_httpoperation.h"
 #include "_httprequestqueue.h"
 
+#include <memory>
 
+
+class LLMessageCapture;
 class LLMessageSystem;
 
 namespace LLCore {
@@ -88,11 +91,22 @@ class LLMessageLog
     static void log(const LLCore::HttpRequestQueue::opPtr_t& op);
     /// Log HTTP Response
     static void log(LLCore::HttpResponse* response);
-    /// Returns false if sCallback is null
-    static bool haveLogger() { return sCallback != nullptr; }
+    /// Returns false if neither a callback nor a capture is installed
+    static bool haveLogger() { return sCallback != nullptr || isCapturing(); }
+
+    /// Start writing all logged traffic to a capture file for later replay
+    static bool startCapture(const std::string& filename);
+    /// Stop and close the current capture, if any
+    static void stopCapture();
+    static bool isCapturing() { return std::atomic_load(&sCapture) != nullptr; }
 
 private:
+    static void updateHTTPHooks();
+    static void capture(const LogPayload& payload);
+
     static LogCallback sCallback;
+    // Swapped atomically: HTTP responses are logged from the HTTP thread.
+    static std::shared_ptr<LLMessageCapture> sCapture;
 };
 
 #endif
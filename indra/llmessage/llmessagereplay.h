@@ -0,0 +1,103 @@
+/**
+ * @file llmessagereplay.h
+ * @brief Feeds a message capture back through LLMessageSystem
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEREPLAY_H
+#define LL_LLMESSAGEREPLAY_H
+
+#include "llmessagecapture.h"
+#include "llsd.h"
+#include "lltimer.h"
+
+#include <functional>
+
+class LLMessageSystem;
+
+/**
+ * @brief Headless replay of a capture written by LLMessageLog::startCapture()
+ *
+ * Inbound lludp packets are injected into the message system's packet
+ * ring (which is switched to replay mode, so nothing reaches the network)
+ * and decoded by checkMessages() exactly as live traffic would be,
+ * including acks, circuit bookkeeping and the registered handlers.
+ * Event queue responses are unpacked and dispatched the way
+ * LLEventPollImpl does; other capability responses go to an optional
+ * caller-supplied handler.  Outbound packets and HTTP requests are
+ * skipped.
+ *
+ * The message system must already be started and have its template
+ * loaded.  Replay either follows the captured timestamps (PACE_WALL_CLOCK)
+ * or feeds records as fast as they can be decoded (PACE_MAX_SPEED), the
+ * latter being the useful mode for profiling.
+ */
+class LLMessageReplay
+{
+public:
+    typedef enum e_pace {
+        PACE_WALL_CLOCK,
+        PACE_MAX_SPEED
+    } EPace;
+
+    typedef std::function<void(const LLMessageCaptureRecord&)> http_handler_t;
+
+    LLMessageReplay(LLMessageSystem* msg, EPace pace = PACE_MAX_SPEED);
+    ~LLMessageReplay();
+
+    /// Load a capture file; enables a trusted circuit for every
+    /// inbound sender found in it.
+    bool load(const std::string& filename);
+
+    /// Receives capability responses that are not event queue polls.
+    void setHTTPResponseHandler(http_handler_t handler) { mHTTPHandler = handler; }
+
+    /// Feed whatever is due and drain the message system once.
+    /// Returns false when the capture is exhausted.
+    bool pump();
+
+    /// pump() until done, sleeping between records at wall-clock pace.
+    void run();
+
+    bool isDone() const;
+
+    /// Counters and timings as LLSD, suitable for a benchmark report.
+    LLSD getStats() const;
+
+private:
+    void feed(const LLMessageCaptureRecord& record);
+    void dispatchEvents(const LLMessageCaptureRecord& record);
+
+    LLMessageSystem* mMessageSystem;
+    EPace mPace;
+    http_handler_t mHTTPHandler;
+    bool mPrevReplayMode;
+
+    std::vector<LLMessageCaptureRecord> mRecords;
+    size_t mNext;
+    bool mStarted;
+    LLTimer mTimer;
+    S64 mFrameCount;
+
+    U32 mPacketsInjected;
+    U64 mBytesInjected;
+    U32 mMessagesDecoded;
+    U32 mEventsDispatched;
+    U32 mHTTPResponses;
+    U32 mRecordsSkipped;
+    F64 mElapsed;
+};
+
+#endif // LL_LLMESSAGEREPLAY_H
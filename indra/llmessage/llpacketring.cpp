@@ -56,7 +56,8 @@ LLPacketRing::LLPacketRing () :
     mInBufferLength(0),
     mOutBufferLength(0),
     mDropPercentage(0.0f),
-    mPacketsToDrop(0x0)
+    mPacketsToDrop(0x0),
+    mReplayMode(false)
 {
 }
 
@@ -84,6 +85,13 @@ void LLPacketRing::cleanup ()
         delete packetp;
         mSendQueue.pop();
     }
+
+    while (!mInjectQueue.empty())
+    {
+        packetp = mInjectQueue.front();
+        delete packetp;
+        mInjectQueue.pop();
+    }
 }
 
 ///////////////////////////////////////////////////////////
@@ -117,6 +125,21 @@ void LLPacketRing::setOutBandwidth(const F32 bps)
 {
     mOutThrottle.setRate(bps);
 }
+
+void LLPacketRing::setReplayMode(bool replay)
+{
+    mReplayMode = replay;
+}
+
+void LLPacketRing::injectPacket(const LLHost& sender, const char* datap, S32 size)
+{
+    if (size <= 0 || size > NET_BUFFER_SIZE)
+    {
+        LL_WARNS("Messaging") << "Dropping injected packet of size " << size << LL_ENDL;
+        return;
+    }
+    mInjectQueue.push(new LLPacketBuffer(sender, datap, size));
+}
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 {
@@ -159,6 +182,23 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 {
     S32 packet_size = 0;
 
+    if (mReplayMode)
+    {
+        if (mInjectQueue.empty())
+        {
+            return 0;
+        }
+        LLPacketBuffer* packetp = mInjectQueue.front();
+        mInjectQueue.pop();
+        packet_size = packetp->getSize();
+        memcpy(datap, packetp->getData(), packet_size); /*Flawfinder: ignore*/
+        mLastSender = packetp->getHost();
+        mLastReceivingIF = packetp->getReceivingInterface();
+        mActualBitsIn += packet_size * 8;
+        delete packetp;
+        return packet_size;
+    }
+
     // If using the throttle, simulate a limited size input buffer.
     if (mUseInThrottle)
     {
@@ -277,6 +317,11 @@ BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, co
     LLMessageLog::log(LLHost(LOCALHOST_ADDR, gMessageSystem->getListenPort()), host, (U8*)send_buffer, buf_size);
 #undef LOCALHOST_ADDR
     BOOL status = TRUE;
+    if (mReplayMode)
+    {
+        mActualBitsOut += buf_size * 8;
+        return TRUE;
+    }
     if (!mUseOutThrottle)
     {
         return sendPacketImpl(h_socket, send_buffer, buf_size, host );
@@ -55,6 +55,15 @@ class LLPacketRing
 
     BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, const LLHost& host);
 
+    // Replay mode detaches the ring from the network: receivePacket()
+    // only returns packets handed to injectPacket() and sendPacket()
+    // discards everything, so a captured session can be fed back through
+    // the message system without talking to the original hosts.
+    void setReplayMode(bool replay);
+    bool getReplayMode() const                  { return mReplayMode; }
+    void injectPacket(const LLHost& sender, const char* datap, S32 size);
+    bool hasInjectedPackets() const             { return !mInjectQueue.empty(); }
+
     inline LLHost getLastSender();
     inline LLHost getLastReceivingInterface();
 
@@ -79,6 +88,9 @@ class LLPacketRing
 
     std::queue<LLPacketBuffer *> mReceiveQueue;
     std::queue<LLPacketBuffer *> mSendQueue;
+    std::queue<LLPacketBuffer *> mInjectQueue;
+
+    bool mReplayMode;
 
     LLHost mLastSender;
     LLHost mLastReceivingIF;
@@ -66,6 +66,14 @@ LLCoreHttpUtil::HttpCoroutineAdapter::~HttpCoroutineAdapter()
 {
 }
 
+const std::string LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS("http_result");
+const std::string LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_SUCCESS("success");
+
+void LLCoreHttpUtil::HttpCoroHandler::writeStatusCodes(LLCore::HttpStatus status, const std::string &url, LLSD &result)
+{
+    result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_SUCCESS] = static_cast<LLSD::Boolean>(status);
+}
+
 LLCore::HttpRequest::HttpRequest()
 {
 }
@@ -182,4 +190,75 @@ namespace tut
         LL_INFOS("CoMain") << "checking count" << LL_ENDL;
         ensure_equals("coprocedure failed to update counter", counter, 5);
     }
+
+    template<> template<>
+    void coproceduremanager_object_t::test<5>()
+    {
+        Sync sync;
+        int executions = 0;
+        LLSD results = LLSD::emptyArray();
+        LLCoprocedureManager::instance().initializePool("KeyedPool");
+
+        auto proc = [&executions, &sync] (LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t & ptr, const LLUUID & id) {
+            sync.bump();
+            ++executions;
+            return LLSD(42);
+        };
+        auto callback = [&results] (const LLSD & result) {
+            results.append(result);
+        };
+
+        LLUUID first = LLCoprocedureManager::instance().enqueueKeyedCoprocedure("KeyedPool", "ProcName", "key",
+                                                                              proc, callback);
+        LLUUID second = LLCoprocedureManager::instance().enqueueKeyedCoprocedure("KeyedPool", "ProcName", "key",
+                                                                               proc, callback);
+        LLUUID other = LLCoprocedureManager::instance().enqueueKeyedCoprocedure("KeyedPool", "ProcName", "other",
+                                                                              proc, callback);
+        ensure("duplicate request returned same id", first == second);
+        ensure("distinct request returned new id", first != other);
+        ensure_equals("coalesced count", LLCoprocedureManager::instance().countCoalesced("KeyedPool"), size_t(1));
+
+        // one bump from each of the two executions
+        sync.yield_until(2);
+        ensure_equals("duplicate request executed once", executions, 2);
+        ensure_equals("all waiters received results", results.size(), 3);
+        ensure_equals("waiter received proc result", results[0].asInteger(), 42);
+
+        LLCoprocedureManager::instance().close("KeyedPool");
+    }
+
+    template<> template<>
+    void coproceduremanager_object_t::test<6>()
+    {
+        Sync sync;
+        int executions = 0;
+        LLSD results = LLSD::emptyArray();
+        LLCoprocedureManager::instance().initializePool("FailingPool");
+
+        auto proc = [&executions, &sync] (LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t & ptr, const LLUUID & id) -> LLSD {
+            sync.bump();
+            ++executions;
+            throw std::runtime_error("keyed failure");
+        };
+        auto callback = [&results, &sync] (const LLSD & result) {
+            results.append(result);
+            sync.bump();
+        };
+
+        LLCoprocedureManager::instance().enqueueKeyedCoprocedure("FailingPool", "ProcName", "key", proc, callback);
+        LLCoprocedureManager::instance().enqueueKeyedCoprocedure("FailingPool", "ProcName", "key", proc, callback);
+
+        // one bump from the execution, one from each waiter
+        sync.yield_until(3);
+        ensure_equals("failing request executed once", executions, 1);
+        ensure_equals("all waiters told of failure", results.size(), 2);
+        for (LLSD::array_const_iterator it = results.beginArray(); it != results.endArray(); ++it)
+        {
+            ensure("waiter received failed status",
+                   !(*it)[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS][LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_SUCCESS].asBoolean());
+        }
+        ensure_equals("second request merged", LLCoprocedureManager::instance().countCoalesced("FailingPool"), size_t(1));
+
+        LLCoprocedureManager::instance().close("FailingPool");
+    }
 }  // namespace tut
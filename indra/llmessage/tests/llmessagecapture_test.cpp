@@ -0,0 +1,114 @@
+/**
+ * @file llmessagecapture_test.cpp
+ * @brief Tests for the message capture file format
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llmessagecapture.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+namespace tut
+{
+    struct messagecapture_data
+    {
+        LLMessageCaptureRecord makePacket(U8 fill, S32 size)
+        {
+            LLMessageCaptureRecord record;
+            record.mType = LLMessageCaptureRecord::TEMPLATE;
+            record.mInbound = true;
+            record.mFromHost = LLHost(0x0100007f, 13000);
+            record.mToHost = LLHost(0x0100007f, 13001);
+            record.mData.assign(size, fill);
+            return record;
+        }
+    };
+    typedef test_group<messagecapture_data> messagecapture_test;
+    typedef messagecapture_test::object messagecapture_object;
+    tut::messagecapture_test messagecapture_testcase("LLMessageCapture");
+
+    template<> template<>
+    void messagecapture_object::test<1>()
+    {
+        set_test_name("round trip");
+
+        NamedTempFile file("msgcap", "");
+        {
+            LLMessageCapture capture;
+            ensure("open", capture.open(file.getName()));
+            capture.write(makePacket(0xab, 40));
+
+            LLMessageCaptureRecord http;
+            http.mType = LLMessageCaptureRecord::HTTP_RESPONSE;
+            http.mStatus = 200;
+            http.mURL = "https://sim.example/cap/EventQueueGet";
+            http.mContentType = "application/llsd+xml";
+            const std::string body("<llsd><map /></llsd>");
+            http.mData.assign(body.begin(), body.end());
+            capture.write(http);
+
+            ensure_equals("record count", capture.getRecordCount(), 2U);
+        }
+
+        std::vector<LLMessageCaptureRecord> records;
+        ensure("read", LLMessageCapture::read(file.getName(), records));
+        ensure_equals("records read", records.size(), 2U);
+
+        const LLMessageCaptureRecord& packet(records[0]);
+        ensure_equals("packet type", packet.mType, U8(LLMessageCaptureRecord::TEMPLATE));
+        ensure("packet inbound", packet.mInbound);
+        ensure("packet sender", packet.mFromHost == LLHost(0x0100007f, 13000));
+        ensure("packet receiver", packet.mToHost == LLHost(0x0100007f, 13001));
+        ensure_equals("packet size", packet.mData.size(), 40U);
+        ensure_equals("packet data", packet.mData[39], U8(0xab));
+
+        const LLMessageCaptureRecord& http(records[1]);
+        ensure_equals("http type", http.mType, U8(LLMessageCaptureRecord::HTTP_RESPONSE));
+        ensure_equals("http status", http.mStatus, 200);
+        ensure_equals("http url", http.mURL, "https://sim.example/cap/EventQueueGet");
+        ensure_equals("http content type", http.mContentType, "application/llsd+xml");
+        ensure_equals("http body", std::string(http.mData.begin(), http.mData.end()),
+                      "<llsd><map /></llsd>");
+        ensure("timestamps ordered", packet.mTimestamp <= http.mTimestamp);
+    }
+
+    template<> template<>
+    void messagecapture_object::test<2>()
+    {
+        set_test_name("bad header and truncated tail");
+
+        NamedTempFile junk("msgcap", "not a capture");
+        std::vector<LLMessageCaptureRecord> records;
+        ensure("junk rejected", !LLMessageCapture::read(junk.getName(), records));
+
+        NamedTempFile file("msgcap", "");
+        {
+            LLMessageCapture capture;
+            ensure("open", capture.open(file.getName()));
+            capture.write(makePacket(1, 20));
+            capture.write(makePacket(2, 20));
+        }
+        // Chop the second record in half as if the viewer died mid-write.
+        boost::filesystem::resize_file(file.getName(),
+                                       boost::filesystem::file_size(file.getName()) - 10);
+
+        ensure("truncated read", LLMessageCapture::read(file.getName(), records));
+        ensure_equals("complete records kept", records.size(), 1U);
+        ensure_equals("first record intact", records[0].mData[0], U8(1));
+    }
+}
@@ -56,6 +56,7 @@
 #include "lldaeloader.h"
 #include "llsdserialize.h"
 #include "lljoint.h"
+#include "lltimer.h"
 
 #include "llmatrix4a.h"
 
@@ -934,6 +935,8 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 {
     setLoadState( READING_FILE );
 
+    LLTimer timer;
+
     //no suitable slm exists, load from the .dae file
 
     // Collada expects file and folder names to be escaped
@@ -1066,7 +1069,12 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 
     mTransform.condition();
 
+    addPhaseTime("parse", timer);
+
     U32 submodel_limit = count > 0 ? mGeneratedModelLimit/count : 0;
+    std::vector<domMesh*> meshes;
+    std::vector<std::string> model_names;
+    std::vector<LLModel*> loaded_models;
     for (daeInt idx = 0; idx < count; ++idx)
     { //build map of domEntities to LLModel
         domMesh* mesh = NULL;
@@ -1074,29 +1082,43 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 
         if (mesh)
         {
+            meshes.push_back(mesh);
+            model_names.push_back(getLodlessLabel(mesh));
+            loaded_models.push_back(loadModelFromDomMesh(mesh, model_names.back()));
+        }
+    }
 
-            std::vector<LLModel*> models;
+    addPhaseTime("faces", timer);
 
-            loadModelsFromDomMesh(mesh, models, submodel_limit);
+    // Normalizing and remapping only needs the model itself, so
+    // spread the meshes across the import threads
+    std::vector<std::vector<LLModel*> > mesh_models(meshes.size());
+    forEachParallel(meshes.size(), [&](size_t i)
+        {
+            splitModel(loaded_models[i], model_names[i], mesh_models[i], submodel_limit);
+        });
+
+    addPhaseTime("normalize", timer);
 
-            std::vector<LLModel*>::iterator i;
-            i = models.begin();
-            while (i != models.end())
+    // Collect in document order so the result doesn't depend on threading
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        std::vector<LLModel*>::iterator mdl_iter = mesh_models[i].begin();
+        while (mdl_iter != mesh_models[i].end())
+        {
+            LLModel* mdl = *mdl_iter;
+            if(mdl->getStatus() != LLModel::NO_ERRORS)
             {
-                LLModel* mdl = *i;
-                if(mdl->getStatus() != LLModel::NO_ERRORS)
-                {
-                    setLoadState(ERROR_MODEL + mdl->getStatus()) ;
-                    return false; //abort
-                }
+                setLoadState(ERROR_MODEL + mdl->getStatus()) ;
+                return false; //abort
+            }
 
-                if (mdl && validate_model(mdl))
-                {
-                    mModelList.push_back(mdl);
-                    mModelsMap[mesh].push_back(mdl);
-                }
-                i++;
+            if (mdl && validate_model(mdl))
+            {
+                mModelList.push_back(mdl);
+                mModelsMap[meshes[i]].push_back(mdl);
             }
+            mdl_iter++;
         }
     }
 
@@ -1149,6 +1171,8 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 
     LL_INFOS()<< "Collada skins processed: " << count <<LL_ENDL;
 
+    addPhaseTime("skins", timer);
+
     daeElement* scene = root->getDescendant("visual_scene");
 
     if (!scene)
@@ -1167,6 +1191,8 @@ bool LLDAELoader::OpenFile(const std::string& filename)
 
     processElement( scene, badElement, &dae);
 
+    addPhaseTime("scene", timer);
+
     if ( badElement )
     {
         LL_INFOS()<<"Scene could not be parsed"<<LL_ENDL;
@@ -2520,20 +2546,17 @@ bool LLDAELoader::addVolumeFacesFromDomMesh(LLModel* pModel,domMesh* mesh, LLSD&
     return (status == LLModel::NO_ERRORS);
 }
 
-//static diff version supports creating multiple models when material counts spill
-// over the 8 face server-side limit
+// Reads the whole set of faces of mesh into a new model.  This walks the
+// DOM, which resolves and caches references as it goes, so it has to stay
+// on the loader thread.
 //
-bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& models_out, U32 submodel_limit)
+LLModel* LLDAELoader::loadModelFromDomMesh(domMesh* mesh, const std::string& model_name)
 {
-
     LLVolumeParams volume_params;
     volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
 
-    models_out.clear();
-
     LLModel* ret = new LLModel(volume_params, 0.f);
 
-    std::string model_name = getLodlessLabel(mesh);
     ret->mLabel = model_name + lod_suffix[mLod];
 
     llassert(!ret->mLabel.empty());
@@ -2546,6 +2569,20 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
     //
     addVolumeFacesFromDomMesh(ret, mesh, mWarningsArray);
 
+    return ret;
+}
+
+//diff version supports creating multiple models when material counts spill
+// over the 8 face server-side limit.  Only touches ret and the models split
+// off it, so models of different meshes can be split concurrently.
+//
+void LLDAELoader::splitModel(LLModel* ret, const std::string& model_name, std::vector<LLModel*>& models_out, U32 submodel_limit) const
+{
+    LLVolumeParams volume_params;
+    volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+
+    models_out.clear();
+
     U32 volume_faces = ret->getNumVolumeFaces();
 
     // Side-steps all manner of issues when splitting models
@@ -2609,8 +2646,6 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
         remainder.clear();
 
     } while (volume_faces);
-
-    return true;
 }
 
 void LLDAELoader::LLDAELogHandler::handleError(daeString msg)
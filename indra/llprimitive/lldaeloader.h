@@ -93,10 +93,15 @@ class LLDAELoader final : public LLModelLoader
 
     static bool addVolumeFacesFromDomMesh(LLModel* model, domMesh* mesh, LLSD& log_msg);
 
-    // Loads a mesh breaking it into one or more models as necessary
-    // to get around volume face limitations while retaining >8 materials
+    // Loads the faces of a mesh into a single model
     //
-    bool loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& models_out, U32 submodel_limit);
+    LLModel* loadModelFromDomMesh(domMesh* mesh, const std::string& model_name);
+
+    // Normalizes a loaded model, breaking it into one or more models as
+    // necessary to get around volume face limitations while retaining >8
+    // materials
+    //
+    void splitModel(LLModel* model, const std::string& model_name, std::vector<LLModel*>& models_out, U32 submodel_limit) const;
 
     static std::string getElementLabel(daeElement *element);
     static size_t getSuffixPosition(std::string label);
@@ -31,11 +31,15 @@
 #include "lljoint.h"
 #include "llcallbacklist.h"
 #include "lltimer.h"
+#include "threadpool.h"
 
 #include "llmatrix4a.h"
 #include <boost/bind.hpp>
+#include <condition_variable>
+#include <mutex>
 
 std::list<LLModelLoader*> LLModelLoader::sActiveLoaderList;
+std::unique_ptr<LL::ThreadPool> LLModelLoader::sImportPool;
 
 void stretch_extents(LLModel* model, LLMatrix4a& mat, LLVector4a& min, LLVector4a& max, BOOL& first_transform)
 {
@@ -150,6 +154,7 @@ LLModelLoader::~LLModelLoader()
 void LLModelLoader::run()
 {
     mWarningsArray.clear();
+    mPhaseTimes.clear();
     doLoadModel();
     doOnIdleOneTime(boost::bind(&LLModelLoader::loadModelCallback,this));
 }
@@ -172,6 +177,70 @@ bool LLModelLoader::getSLMFilename(const std::string& model_filename, std::strin
     }
 }
 
+// static
+void LLModelLoader::startImportThreads(size_t threads)
+{
+    if (!sImportPool)
+    {
+        sImportPool.reset(new LL::ThreadPool("ModelImport", threads ? threads : 4));
+        sImportPool->start();
+    }
+}
+
+// static
+void LLModelLoader::stopImportThreads()
+{
+    if (sImportPool)
+    {
+        sImportPool->close();
+        sImportPool.reset();
+    }
+}
+
+// static
+void LLModelLoader::forEachParallel(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count < 2 || !sImportPool || sImportPool->getWidth() < 2)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t remaining = count; // guarded by mutex
+
+    auto done = [&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0)
+        {
+            finished.notify_one();
+        }
+    };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!sImportPool->getQueue().post([&func, &done, i]() { func(i); done(); }))
+        {
+            // Shutting down, do it here
+            func(i);
+            done();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&remaining]() { return remaining == 0; });
+}
+
+void LLModelLoader::addPhaseTime(const std::string& name, LLTimer& timer)
+{
+    mPhaseTimes.emplace_back(name, timer.getElapsedTimeAndResetF64().value());
+}
+
 bool LLModelLoader::doLoadModel()
 {
     //first, look for a .slm file of the same name that was modified later
@@ -29,10 +29,13 @@
 
 #include "llmodel.h"
 #include "llthread.h"
+#include "threadpool_fwd.h"
 #include <boost/function.hpp>
+#include <functional>
 #include <list>
 
 class LLJoint;
+class LLTimer;
 
 typedef std::map<std::string, LLMatrix4>            JointTransformMap;
 typedef std::map<std::string, LLMatrix4>::iterator  JointTransformMapIt;
@@ -145,6 +148,18 @@ class LLModelLoader : public LLThread
 
     static bool getSLMFilename(const std::string& model_filename, std::string& slm_filename);
 
+    // Starts the "ModelImport" pool that loaders and LOD generation split
+    // their per model work across.  Until it's started, and after it's
+    // stopped, that work runs on the calling thread.
+    static void startImportThreads(size_t threads = 0);
+    static void stopImportThreads();
+
+    // Calls func(0) .. func(count - 1) on the import pool and returns once
+    // all of them have.  func should only write to slots of its own index
+    // so the result doesn't depend on which thread got there first.  Must
+    // not be called from func.
+    static void forEachParallel(size_t count, const std::function<void(size_t)>& func);
+
     // Will try SLM or derived class OpenFile as appropriate
     //
     virtual bool doLoadModel();
@@ -193,6 +208,10 @@ class LLModelLoader : public LLThread
     const LLSD logOut() const { return mWarningsArray; }
     void clearLog() { mWarningsArray.clear(); }
 
+    // Seconds spent in each stage of the last load, in the order they ran
+    typedef std::vector<std::pair<std::string, F64> > phase_times_t;
+    const phase_times_t& getPhaseTimes() const { return mPhaseTimes; }
+
 protected:
 
     LLModelLoader::load_callback_t      mLoadCallback;
@@ -211,8 +230,14 @@ class LLModelLoader : public LLThread
 
     LLSD mWarningsArray; // preview floater will pull logs from here
 
+    phase_times_t mPhaseTimes;
+    // Records the time since timer was last reset as stage name
+    void addPhaseTime(const std::string& name, LLTimer& timer);
+
     static std::list<LLModelLoader*> sActiveLoaderList;
     static bool isAlive(LLModelLoader* loader) ;
+
+    static std::unique_ptr<LL::ThreadPool> sImportPool;
 };
 class LLMatrix4a;
 void stretch_extents(LLModel* model, LLMatrix4a& mat, LLVector4a& min, LLVector4a& max, BOOL& first_transform);
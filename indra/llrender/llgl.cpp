@@ -1451,6 +1451,7 @@ void LLGLManager::initExtensions()
     mHasDebugOutput = mGLVersion >= 4.29f;
     mHasTextureSwizzle = mGLVersion >= 3.29f;
     mHasTextureFilterAnisotropic = mGLVersion >= 4.59f || ExtensionExists("GL_EXT_texture_filter_anisotropic", gGLHExts.mSysExts);
+    mHasTextureCompressionS3TC = ExtensionExists("GL_EXT_texture_compression_s3tc", gGLHExts.mSysExts);
 
     // Misc
     glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, (GLint*) &mGLMaxVertexRange);
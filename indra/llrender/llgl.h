@@ -103,6 +103,7 @@ class LLGLManager
     bool mHasNVXMemInfo = false;
     bool mHasATIMemInfo = false;
     bool mHasTextureFilterAnisotropic = false;
+    bool mHasTextureCompressionS3TC = false;
 
     BOOL mIsAMD;
     BOOL mIsNVIDIA;
@@ -34,6 +34,8 @@
 #include "llerror.h"
 #include "llfasttimer.h"
 #include "llimage.h"
+#include "llimagebc.h"
+#include "llimageresample.h"
 
 #include "llmath.h"
 #include "llgl.h"
@@ -42,6 +44,8 @@
 #include "llwindow.h"
 #include "llframetimer.h"
 
+#include <atomic>
+
 extern LL_COMMON_API bool on_main_thread();
 
 #if !LL_IMAGEGL_THREAD_CHECK
@@ -60,6 +64,7 @@ U32 wpo2(U32 i);
 static LLMutex sTexMemMutex;
 static boost::unordered_flat_map<U32, U64> sTextureAllocs;
 static U64 sTextureBytes = 0;
+static std::atomic<S64> sBlockCompressionSavedBytes(0);
 
 // track a texture alloc on the currently bound texture.
 // asserts that no currently tracked alloc exists
@@ -121,6 +126,12 @@ U64 LLImageGL::getTextureBytesAllocated()
     return sTextureBytes;
 }
 
+// static
+S64 LLImageGL::getBlockCompressionSavedBytes()
+{
+    return sBlockCompressionSavedBytes;
+}
+
 //statics
 
 U32 LLImageGL::sUniqueCount             = 0;
@@ -131,6 +142,9 @@ F32 LLImageGL::sLastFrameTime           = 0.f;
 BOOL LLImageGL::sAllowReadBackRaw       = FALSE ;
 LLImageGL* LLImageGL::sDefaultGLTexture = NULL ;
 bool LLImageGL::sCompressTextures = false;
+bool LLImageGL::sBlockCompressTextures = false;
+bool LLImageGL::sBlockCompressNormals = false;
+U32 LLImageGL::sUploadRingBytes = 0;
 std::set<LLImageGL*> LLImageGL::sImageList;
 
 
@@ -256,6 +270,11 @@ void LLImageGL::initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyz
         LLImageGLThread::sEnabledTextures = thread_texture_loads;
         LLImageGLThread::sEnabledMedia = thread_media_updates;
     }
+
+    if (sUploadRingBytes && LLTextureUploadRing::isSupported())
+    {
+        LLTextureUploadRing::createInstance(sUploadRingBytes);
+    }
 }
 
 //static
@@ -263,6 +282,7 @@ void LLImageGL::cleanupClass()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     LLImageGLThread::deleteSingleton();
+    LLTextureUploadRing::deleteSingleton();
 }
 
 
@@ -271,6 +291,7 @@ S32 LLImageGL::dataFormatBits(S32 dataformat)
 {
     switch (dataformat)
     {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:           return 4;
     case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:          return 4;
     case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:    return 4;
     case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:          return 8;
@@ -304,6 +325,7 @@ S64 LLImageGL::dataFormatBytes(S32 dataformat, S32 width, S32 height)
 {
     switch (dataformat)
     {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
     case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
     case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
     case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
@@ -326,6 +348,7 @@ S32 LLImageGL::dataFormatComponents(S32 dataformat)
 {
     switch (dataformat)
     {
+      case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:     return 3;
       case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:    return 3;
       case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: return 3;
       case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:    return 4;
@@ -356,6 +379,11 @@ void LLImageGL::updateStats(F32 current_time)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     sLastFrameTime = current_time;
+
+    if (LLTextureUploadRing::instanceExists())
+    {
+        LLTextureUploadRing::getInstance()->update();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -389,11 +417,21 @@ void LLImageGL::destroyGL(BOOL save_state)
         }
     }
     sAllowReadBackRaw = false ;
+
+    if (LLTextureUploadRing::instanceExists())
+    {
+        LLTextureUploadRing::getInstance()->destroyGL();
+    }
 }
 
 //static
 void LLImageGL::restoreGL()
 {
+    if (LLTextureUploadRing::instanceExists())
+    {
+        LLTextureUploadRing::getInstance()->restoreGL();
+    }
+
     for (std::set<LLImageGL*>::iterator iter = sImageList.begin();
          iter != sImageList.end(); iter++)
     {
@@ -553,6 +591,8 @@ void LLImageGL::init(BOOL usemipmaps)
     mTexelsInGLTexture = 0 ;
 
     mAllowCompression = true;
+    mCompressionPolicy = COMPRESS_NONE;
+    mBlockCompressionSaved = 0;
 
     mTarget = GL_TEXTURE_2D;
     mBindTarget = LLTexUnit::TT_TEXTURE;
@@ -590,6 +630,7 @@ void LLImageGL::cleanup()
         destroyGLTexture();
     }
     freePickMask();
+    discardStagedUpload();
 
     mSaveData = NULL; // deletes data
 }
@@ -798,7 +839,15 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
                 if (is_compressed)
                 {
                     S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
+                    if (gl_level == 0)
+                    {
+                        free_cur_tex_image();
+                    }
                     glCompressedTexImage2D(mTarget, gl_level, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
+                    if (gl_level == 0)
+                    {
+                        alloc_tex_image(w, h, mFormatPrimary, 1);
+                    }
                     stop_glerror();
                 }
                 else
@@ -844,10 +893,13 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 
                     mMipLevels = wpo2(llmax(w, h));
 
-                    LLImageGL::setManualImage(mTarget, 0, mFormatInternal,
-                                 w, h,
-                                 mFormatPrimary, mFormatType,
-                                 data_in, mAllowCompression);
+                    if (!uploadStaged(data_in, w, h))
+                    {
+                        LLImageGL::setManualImage(mTarget, 0, mFormatInternal,
+                                     w, h,
+                                     mFormatPrimary, mFormatType,
+                                     data_in, mAllowCompression);
+                    }
                     analyzeAlpha(data_in, w, h);
                     stop_glerror();
 
@@ -947,7 +999,10 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
                             stop_glerror();
                         }
 
-                        LLImageGL::setManualImage(mTarget, m, mFormatInternal, w, h, mFormatPrimary, mFormatType, cur_mip_data, mAllowCompression);
+                        if (m != 0 || !uploadStaged(cur_mip_data, w, h))
+                        {
+                            LLImageGL::setManualImage(mTarget, m, mFormatInternal, w, h, mFormatPrimary, mFormatType, cur_mip_data, mAllowCompression);
+                        }
                         if (m == 0)
                         {
                             analyzeAlpha(data_in, w, h);
@@ -992,7 +1047,9 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
         if (is_compressed)
         {
             S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
+            free_cur_tex_image();
             glCompressedTexImage2D(mTarget, 0, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
+            alloc_tex_image(w, h, mFormatPrimary, 1);
             stop_glerror();
         }
         else
@@ -1003,8 +1060,11 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
                 stop_glerror();
             }
 
-            LLImageGL::setManualImage(mTarget, 0, mFormatInternal, w, h,
-                         mFormatPrimary, mFormatType, (GLvoid *)data_in, mAllowCompression);
+            if (!uploadStaged(data_in, w, h))
+            {
+                LLImageGL::setManualImage(mTarget, 0, mFormatInternal, w, h,
+                             mFormatPrimary, mFormatType, (GLvoid *)data_in, mAllowCompression);
+            }
             analyzeAlpha(data_in, w, h);
 
             updatePickMask(w, h, data_in);
@@ -1678,8 +1738,213 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S
     }
 
     setCategory(category);
+    BOOL res;
+    if (!defer_copy && canBlockCompress(imageraw))
+    {
+        res = createBlockCompressedTexture(discard_level, imageraw, usename, tex_name);
+    }
+    else
+    {
+        setBlockCompressionSaved(0);
+        const U8* rawdata = imageraw->getData();
+        res = createGLTexture(discard_level, rawdata, FALSE, usename, defer_copy, tex_name);
+    }
+
+    // A staged copy is only good for this one upload
+    discardStagedUpload();
+    return res;
+}
+
+bool LLImageGL::canBlockCompress(const LLImageRaw* imageraw) const
+{
+    if (!sBlockCompressTextures || !gGLManager.mHasTextureCompressionS3TC
+        || !mAllowCompression || mHasExplicitFormat || mTarget != GL_TEXTURE_2D)
+    {
+        return false;
+    }
+
+    switch (mCompressionPolicy)
+    {
+    case COMPRESS_COLOR:
+        break;
+    case COMPRESS_NORMAL:
+        if (!sBlockCompressNormals)
+        {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    // Tiny mips gain nothing and partial blocks only happen off power of two
+    S32 width = imageraw->getWidth();
+    S32 height = imageraw->getHeight();
+    return imageraw->getComponents() >= 3 && width >= 4 && height >= 4 && checkSize(width, height);
+}
+
+// Builds the mip chain, BC1 or BC3 encodes every level and uploads the
+// result in the layout setImage expects for data_hasmips: smaller levels
+// first, data pointing at the top level at the end of the buffer.
+BOOL LLImageGL::createBlockCompressedTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename, LLGLuint* tex_name)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
     const U8* rawdata = imageraw->getData();
-    return createGLTexture(discard_level, rawdata, FALSE, usename, defer_copy, tex_name);
+    const S32 components = imageraw->getComponents();
+    const S32 width = imageraw->getWidth();
+    const S32 height = imageraw->getHeight();
+
+    // Alpha analysis and the pick mask want the uncompressed top level
+    analyzeAlpha(rawdata, width, height);
+    updatePickMask(width, height, rawdata);
+
+    const bool has_alpha = LLImageBC::hasAlpha(rawdata, width, height, components);
+    const LLImageBC::EFormat bc_format = has_alpha ? LLImageBC::BC3 : LLImageBC::BC1;
+    const LLGLenum gl_format = has_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    const S64 raw_bytes = getMipBytes(discard_level);
+
+    const S32 levels = mUseMipMaps ? mMaxDiscardLevel - discard_level + 1 : 1;
+    std::vector<S64> level_bytes(levels);
+    S64 total = 0;
+    for (S32 l = 0; l < levels; ++l)
+    {
+        level_bytes[l] = dataFormatBytes(gl_format, getWidth(discard_level + l), getHeight(discard_level + l));
+        total += level_bytes[l];
+    }
+
+    // Every smaller level comes out of one walk over the top level
+    const S32 mip_levels = llmin(levels, LLImageResample::getMipLevelCount(width, height));
+    std::vector<U8> blocks;
+    std::vector<U8> mips;
+    try
+    {
+        blocks.resize(total);
+        mips.resize(LLImageResample::getMipChainSize(width, height, components, mip_levels));
+    }
+    catch (const std::bad_alloc&)
+    {
+        LL_WARNS() << "Failed to allocate " << total << " bytes for block compression, uploading uncompressed" << LL_ENDL;
+        setBlockCompressionSaved(0);
+        return createGLTexture(discard_level, rawdata, FALSE, usename, false, tex_name);
+    }
+
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("cglt - block compress");
+        LLImageResample::generateMipChain(rawdata, width, height, components, mips.data(), mip_levels);
+
+        const U8* level_data = rawdata;
+        const U8* next_level = mips.data();
+        S64 offset = total;
+        for (S32 l = 0; l < levels; ++l)
+        {
+            S32 w = getWidth(discard_level + l);
+            S32 h = getHeight(discard_level + l);
+            if (l > 0 && l < mip_levels)
+            {
+                level_data = next_level;
+                next_level += w * h * components;
+            }
+            offset -= level_bytes[l];
+            LLImageBC::compress(bc_format, level_data, w, h, components, blocks.data() + offset);
+        }
+    }
+
+    mFormatInternal = gl_format;
+    mFormatPrimary = gl_format;
+
+    if (!createGLTexture(discard_level, blocks.data() + total - level_bytes[0], mUseMipMaps, usename, false, tex_name))
+    {
+        setBlockCompressionSaved(0);
+        return FALSE;
+    }
+
+    setBlockCompressionSaved(raw_bytes - getMipBytes(discard_level));
+    return TRUE;
+}
+
+void LLImageGL::setBlockCompressionSaved(S64 bytes)
+{
+    sBlockCompressionSavedBytes += bytes - mBlockCompressionSaved;
+    mBlockCompressionSaved = bytes;
+}
+
+bool LLImageGL::canStageUpload(const LLImageRaw* imageraw) const
+{
+    LLTextureUploadRing* ring = LLTextureUploadRing::getInstance();
+    if (!ring || !imageraw || imageraw->isBufferInvalid()
+        || mHasExplicitFormat || mTarget != GL_TEXTURE_2D
+        || (sCompressTextures && mAllowCompression)
+        || canBlockCompress(imageraw))
+    {
+        return false;
+    }
+
+    // Only formats setManualImage passes straight through to glTexImage2D
+    const S32 components = imageraw->getComponents();
+    return (components == 3 || components == 4)
+        && (U32)imageraw->getDataSize() <= ring->getMaxStageSize();
+}
+
+void LLImageGL::setStagedUpload(const LLTextureUploadRing::Region& region, LLImageRaw* source)
+{
+    discardStagedUpload();
+    mStagedUpload = region;
+    mStagedSource = source;
+}
+
+void LLImageGL::discardStagedUpload()
+{
+    if (mStagedUpload.isValid() && LLTextureUploadRing::instanceExists())
+    {
+        LLTextureUploadRing::getInstance()->discard(mStagedUpload);
+    }
+    mStagedUpload = LLTextureUploadRing::Region();
+    mStagedSource = NULL;
+}
+
+// Uploads the top level from the copy staged in the upload ring, if it is
+// a copy of data_in.  Returns false if the caller must upload data_in.
+bool LLImageGL::uploadStaged(const U8* data_in, S32 width, S32 height)
+{
+    if (!mStagedUpload.isValid())
+    {
+        return false;
+    }
+
+    LLTextureUploadRing* ring = LLTextureUploadRing::getInstance();
+    const bool usable = ring && on_main_thread()
+        && mStagedSource.notNull()
+        && data_in == mStagedSource->getData()
+        && mStagedUpload.mSize == (U32)mStagedSource->getDataSize()
+        && mStagedUpload.mSize == (U32)(width * height * mComponents)
+        && mFormatType == GL_UNSIGNED_BYTE
+        && (mFormatPrimary == GL_RGB || mFormatPrimary == GL_RGBA)
+        && dataFormatComponents(mFormatPrimary) == mComponents
+        && !(sCompressTextures && mAllowCompression)
+        && ring->isStaged(mStagedUpload);
+    if (!usable)
+    {
+        discardStagedUpload();
+        return false;
+    }
+
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("glTexImage2D from upload ring");
+        free_cur_tex_image();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->getBuffer());
+        // With an unpack buffer bound the pixel pointer is an offset into it
+        glTexImage2D(mTarget, 0, mFormatInternal, width, height, 0, mFormatPrimary, mFormatType,
+                     (const GLvoid*)(uintptr_t)mStagedUpload.mOffset);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        alloc_tex_image(width, height, mFormatPrimary, 1);
+        stop_glerror();
+    }
+
+    ring->retire(mStagedUpload);
+    mStagedUpload = LLTextureUploadRing::Region();
+    mStagedSource = NULL;
+    return true;
 }
 
 BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_hasmips, S32 usename, bool defer_copy, LLGLuint* tex_name)
@@ -1952,7 +2217,15 @@ BOOL LLImageGL::readBackRaw(S32 discard_level, LLImageRaw* imageraw, bool compre
             return FALSE ;
         }
 
-        glGetTexImage(GL_TEXTURE_2D, gl_discard, mFormatPrimary, mFormatType, (GLvoid*)(imageraw->getData()));
+        // Block compressed textures read back decoded in their plain layout
+        LLGLenum format = mFormatPrimary;
+        LLGLenum type = mFormatType;
+        if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+        {
+            format = ncomponents == 4 ? GL_RGBA : GL_RGB;
+            type = GL_UNSIGNED_BYTE;
+        }
+        glGetTexImage(GL_TEXTURE_2D, gl_discard, format, type, (GLvoid*)(imageraw->getData()));
         //stop_glerror();
     }
 
@@ -1990,6 +2263,7 @@ void LLImageGL::destroyGLTexture()
         mTexName = 0;
         mGLTextureCreated = FALSE ;
     }
+    setBlockCompressionSaved(0);
 }
 
 //force to invalidate the gl texture, most likely a sculpty texture
@@ -2406,6 +2680,7 @@ bool LLImageGL::isCompressed()
     bool is_compressed = false;
     switch (mFormatPrimary)
     {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
     case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
     case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
     case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
@@ -37,6 +37,7 @@
 #include "llunits.h"
 #include "llthreadsafequeue.h"
 #include "llrender.h"
+#include "lltextureuploadring.h"
 #include "threadpool.h"
 #include "workqueue.h"
 
@@ -89,6 +90,17 @@ class LLImageGL : public LLRefCount
     static BOOL create(LLPointer<LLImageGL>& dest, U32 width, U32 height, U8 components, BOOL usemipmaps = TRUE);
     static BOOL create(LLPointer<LLImageGL>& dest, const LLImageRaw* imageraw, BOOL usemipmaps = TRUE);
 
+    // Bytes of texture memory currently saved by CPU block compression
+    static S64 getBlockCompressionSavedBytes();
+
+    // How createGLTexture may block compress an image on the CPU
+    enum ECompressionPolicy
+    {
+        COMPRESS_NONE = 0,  // upload as is (UI, media, anything updated in place)
+        COMPRESS_COLOR,     // BC1, or BC3 when the image has alpha
+        COMPRESS_NORMAL,    // tangent space normals, only when sBlockCompressNormals is set
+    };
+
 public:
     LLImageGL(BOOL usemipmaps = TRUE);
     LLImageGL(U32 width, U32 height, U8 components, BOOL usemipmaps = TRUE);
@@ -109,6 +121,17 @@ class LLImageGL : public LLRefCount
     bool setSize(S32 width, S32 height, S32 ncomponents, S32 discard_level = -1);
     void setComponents(S32 ncomponents) { mComponents = (S8)ncomponents ;}
     void setAllowCompression(bool allow) { mAllowCompression = allow; }
+    void setCompressionPolicy(ECompressionPolicy policy) { mCompressionPolicy = policy; }
+
+    // True if the next createGLTexture from imageraw could upload it from a
+    // copy staged in the upload ring.  Main thread.
+    bool canStageUpload(const LLImageRaw* imageraw) const;
+    // Hands over a copy of source staged in the upload ring.  The next
+    // createGLTexture or setImage of that same data uploads from it, or gives
+    // it back to the ring if it can't.  Holds on to source until then, so its
+    // pixels can't be freed and another image allocated at the same address.
+    // Main thread.
+    void setStagedUpload(const LLTextureUploadRing::Region& region, LLImageRaw* source);
 
     static void setManualImage(U32 target, S32 miplevel, S32 intformat, S32 width, S32 height, U32 pixformat, U32 pixtype, const void *pixels, bool allow_compression = true);
 
@@ -218,6 +241,11 @@ class LLImageGL : public LLRefCount
     U32 createPickMask(S32 pWidth, S32 pHeight);
     void freePickMask();
     bool isCompressed();
+    bool canBlockCompress(const LLImageRaw* imageraw) const;
+    BOOL createBlockCompressedTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename, LLGLuint* tex_name);
+    void setBlockCompressionSaved(S64 bytes);
+    bool uploadStaged(const U8* data_in, S32 width, S32 height);
+    void discardStagedUpload();
 
     LLPointer<LLImageRaw> mSaveData; // used for destroyGL/restoreGL
     LL::WorkQueue::weak_t mMainQueue;
@@ -247,6 +275,10 @@ class LLImageGL : public LLRefCount
     U32      mTexelsInGLTexture;
 
     bool mAllowCompression;
+    ECompressionPolicy mCompressionPolicy;
+    S64 mBlockCompressionSaved; // bytes this texture saves by being block compressed
+    LLTextureUploadRing::Region mStagedUpload;
+    LLPointer<LLImageRaw> mStagedSource; // the image mStagedUpload is a copy of
 
 protected:
     LLGLenum mTarget;       // Normally GL_TEXTURE2D, sometimes something else (ex. cube maps)
@@ -283,6 +315,9 @@ class LLImageGL : public LLRefCount
     static LLImageGL* sDefaultGLTexture ;
     static BOOL sAutomatedTest;
     static bool sCompressTextures;          //use GL texture compression
+    static bool sBlockCompressTextures;     //block compress on the CPU before upload, see ECompressionPolicy
+    static bool sBlockCompressNormals;      //also block compress COMPRESS_NORMAL textures
+    static U32 sUploadRingBytes;            //size of the streaming upload ring, 0 to upload synchronously
 #if DEBUG_MISS
     BOOL mMissed; // Missed on last bind?
     BOOL getMissed() const { return mMissed; };
@@ -0,0 +1,276 @@
+/**
+ * @file lltextureuploadring.cpp
+ * @brief Persistently mapped pixel unpack buffer for streaming texture uploads
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltextureuploadring.h"
+
+#include "llgl.h"
+
+#include <iterator>
+
+// Keeps every region on a boundary the memcpy and the driver both like
+static const U32 REGION_ALIGNMENT = 256;
+
+//static
+bool LLTextureUploadRing::isSupported()
+{
+    return glBufferStorage != nullptr && glMapBufferRange != nullptr && glFenceSync != nullptr;
+}
+
+LLTextureUploadRing::LLTextureUploadRing(U32 size)
+    : mSize(size & ~(REGION_ALIGNMENT - 1))
+{
+    restoreGL();
+}
+
+LLTextureUploadRing::~LLTextureUploadRing()
+{
+    destroyGL();
+}
+
+void LLTextureUploadRing::restoreGL()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (mBuffer || !mSize || !isSupported())
+    {
+        return;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, mSize, nullptr, flags);
+    U8* data = (U8*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mSize, flags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stop_glerror();
+
+    if (!data)
+    {
+        LL_WARNS() << "Could not map a " << mSize << " byte texture upload buffer, uploads will not be streamed" << LL_ENDL;
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mData = data;
+    mHead = 0;
+}
+
+void LLTextureUploadRing::destroyGL()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        // Nothing may be writing to the mapping when it goes away
+        mCopyDone.wait(lock, [this]()
+            {
+                for (const auto& entry : mBlocks)
+                {
+                    if (entry.second.mCopying)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+
+        for (const auto& entry : mBlocks)
+        {
+            if (entry.second.mFence)
+            {
+                glDeleteSync(entry.second.mFence);
+            }
+        }
+        mBlocks.clear();
+        mData = nullptr;
+    }
+
+    if (mBuffer)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+        stop_glerror();
+    }
+}
+
+// Next fit: the first gap big enough at or after mHead, then from the
+// start of the buffer.  Blocks come back out of order, so the gaps can be
+// anywhere.
+bool LLTextureUploadRing::allocate(U32 size, U32& offset)
+{
+    if (mBlocks.empty())
+    {
+        mHead = 0;
+    }
+
+    for (U32 pass = 0; pass < 2; ++pass)
+    {
+        U32 start = pass ? 0 : mHead;
+        auto next = mBlocks.upper_bound(start);
+        if (next != mBlocks.begin())
+        {
+            // Skip past the block start falls in
+            auto prev = std::prev(next);
+            start = llmax(start, prev->first + prev->second.mSize);
+        }
+
+        while (true)
+        {
+            const U32 end = next == mBlocks.end() ? mSize : next->first;
+            if (start + size <= end)
+            {
+                offset = start;
+                return true;
+            }
+            if (next == mBlocks.end())
+            {
+                break;
+            }
+            start = next->first + next->second.mSize;
+            ++next;
+        }
+    }
+    return false;
+}
+
+LLTextureUploadRing::Region LLTextureUploadRing::stage(const void* data, U32 size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    Region region;
+    if (!size || size > getMaxStageSize())
+    {
+        return region;
+    }
+
+    const U32 aligned = (size + REGION_ALIGNMENT - 1) & ~(REGION_ALIGNMENT - 1);
+    U8* dest = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        U32 offset = 0;
+        if (!mData || !allocate(aligned, offset))
+        {
+            return region;
+        }
+
+        region.mId = mNextId++;
+        if (!mNextId)
+        {
+            mNextId = 1;
+        }
+        region.mOffset = offset;
+        region.mSize = size;
+        mBlocks.emplace(offset, Block{ region.mId, aligned, nullptr, true, false });
+        mHead = offset + aligned;
+        dest = mData + offset;
+    }
+
+    // The block is ours alone until mCopying is cleared
+    memcpy(dest, data, size);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Block* block = findBlock(region.mId);
+        if (block)
+        {
+            block->mCopying = false;
+        }
+    }
+    mCopyDone.notify_all();
+    return region;
+}
+
+LLTextureUploadRing::Block* LLTextureUploadRing::findBlock(U32 id)
+{
+    for (auto& entry : mBlocks)
+    {
+        if (entry.second.mId == id)
+        {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void LLTextureUploadRing::discard(const Region& region)
+{
+    if (!region.isValid())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    Block* block = findBlock(region.mId);
+    if (block)
+    {
+        block->mDiscarded = true;
+    }
+}
+
+bool LLTextureUploadRing::isStaged(const Region& region)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const Block* block = findBlock(region.mId);
+    return block && !block->mCopying && !block->mDiscarded && !block->mFence;
+}
+
+void LLTextureUploadRing::retire(const Region& region)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Block* block = findBlock(region.mId);
+    if (block && !block->mFence)
+    {
+        block->mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void LLTextureUploadRing::update()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto it = mBlocks.begin(); it != mBlocks.end(); )
+    {
+        Block& block = it->second;
+        if (block.mFence)
+        {
+            // Zero timeout, this only polls
+            if (glClientWaitSync(block.mFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                ++it;
+                continue;
+            }
+            glDeleteSync(block.mFence);
+        }
+        else if (!block.mDiscarded || block.mCopying)
+        {
+            // Still waiting to be uploaded
+            ++it;
+            continue;
+        }
+        it = mBlocks.erase(it);
+    }
+}
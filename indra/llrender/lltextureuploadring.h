@@ -0,0 +1,119 @@
+/**
+ * @file lltextureuploadring.h
+ * @brief Persistently mapped pixel unpack buffer for streaming texture uploads
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREUPLOADRING_H
+#define LL_LLTEXTUREUPLOADRING_H
+
+#include "llglheaders.h"
+#include "llsingleton.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+// One GL_PIXEL_UNPACK_BUFFER, mapped once for the life of the context,
+// used as a ring of staging space for texture uploads.  Worker threads copy
+// decoded pixels straight into it, the main thread then hands glTexImage2D
+// an offset into the buffer instead of a client pointer, so the driver can
+// pull the data whenever it likes rather than copying it during the call.
+// A fence placed after each upload tells us when its space can be reused.
+// Space is reclaimed as soon as its own upload is done, in any order, so a
+// large upload the GPU has yet to get to does not hold back the smaller
+// ones staged after it.
+//
+// Needs glBufferStorage (GL 4.4); see isSupported().
+class LLTextureUploadRing : public LLSimpleton<LLTextureUploadRing>
+{
+public:
+    struct Region
+    {
+        U32 mId = 0;        // 0 for no region
+        U32 mOffset = 0;    // byte offset in the buffer
+        U32 mSize = 0;      // bytes staged
+
+        bool isValid() const { return mId != 0; }
+    };
+
+    // Main thread with the GL context current
+    LLTextureUploadRing(U32 size);
+    ~LLTextureUploadRing();
+
+    static bool isSupported();
+
+    // Largest single upload worth staging; anything bigger would hold most
+    // of the ring hostage while it waits for the GPU.
+    U32 getMaxStageSize() const { return mSize / 4; }
+
+    // Any thread.  Copies size bytes into the ring, or returns an invalid
+    // region if there is not that much free space right now.
+    Region stage(const void* data, U32 size);
+
+    // Any thread.  Gives back a region that is not going to be uploaded.
+    void discard(const Region& region);
+
+    // Main thread.  True if region is still in the ring, i.e. the buffer
+    // has not been recreated since it was staged.
+    bool isStaged(const Region& region);
+
+    // Main thread.  The GL name to bind to GL_PIXEL_UNPACK_BUFFER for the
+    // upload.  Offsets passed as the pixel pointer index into it.
+    U32 getBuffer() const { return mBuffer; }
+
+    // Main thread, after the GL commands reading the region.  Its space is
+    // reused once the GPU has passed this point.
+    void retire(const Region& region);
+
+    // Main thread, once per frame.  Recycles the space of uploads the GPU
+    // has finished with.
+    void update();
+
+    // Main thread.  Drop and recreate the GL buffer around a context change.
+    // Regions staged before destroyGL are forgotten.
+    void destroyGL();
+    void restoreGL();
+
+private:
+    struct Block
+    {
+        U32 mId;
+        U32 mSize;          // aligned size held in the ring
+        GLsync mFence;      // set by retire()
+        bool mCopying;      // stage() is still writing it
+        bool mDiscarded;
+    };
+
+    Block* findBlock(U32 id);
+    bool allocate(U32 size, U32& offset);
+
+    const U32 mSize;
+    U32 mBuffer = 0;
+    U8* mData = nullptr;
+
+    std::mutex mMutex;
+    std::condition_variable mCopyDone;
+    std::map<U32, Block> mBlocks;   // live blocks by offset
+    U32 mHead = 0;                  // where the search for free space starts
+    U32 mNextId = 1;
+};
+
+#endif // LL_LLTEXTUREUPLOADRING_H
@@ -488,10 +488,10 @@ void AISAPI::FetchCategoryChildren(const LLUUID &catId, ITEM_TYPE type, bool rec
     // get doesn't use body, can pass additional data
     LLSD body;
     body["depth"] = depth;
-    LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
-        _1, getFn, url, catId, body, callback, FETCHCATEGORYCHILDREN));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro,
+        _1, getFn, url, catId, body, _2, FETCHCATEGORYCHILDREN));
 
-    EnqueueAISCommand("FetchCategoryChildren", proc);
+    EnqueueKeyedAISCommand("FetchCategoryChildren", url, command, callback);
 }
 
 // some folders can be requested by name, like
@@ -541,10 +541,10 @@ void AISAPI::FetchCategoryChildren(const std::string &identifier, bool recursive
     // get doesn't use body, can pass additional data
     LLSD body;
     body["depth"] = depth;
-    LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
-        _1, getFn, url, LLUUID::null, body, callback, FETCHCATEGORYCHILDREN));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro,
+        _1, getFn, url, LLUUID::null, body, _2, FETCHCATEGORYCHILDREN));
 
-    EnqueueAISCommand("FetchCategoryChildren", proc);
+    EnqueueKeyedAISCommand("FetchCategoryChildren", url, command, callback);
 }
 
 /*static*/
@@ -592,10 +592,10 @@ void AISAPI::FetchCategoryCategories(const LLUUID &catId, ITEM_TYPE type, bool r
     // get doesn't use body, can pass additional data
     LLSD body;
     body["depth"] = depth;
-    LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
-        _1, getFn, url, catId, body, callback, FETCHCATEGORYCATEGORIES));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro,
+        _1, getFn, url, catId, body, _2, FETCHCATEGORYCATEGORIES));
 
-    EnqueueAISCommand("FetchCategoryCategories", proc);
+    EnqueueKeyedAISCommand("FetchCategoryCategories", url, command, callback);
 }
 
 void AISAPI::FetchCategorySubset(const LLUUID& catId,
@@ -669,10 +669,10 @@ void AISAPI::FetchCategorySubset(const LLUUID& catId,
     // get doesn't use body, can pass additional data
     LLSD body;
     body["depth"] = depth;
-    LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
-                                                         _1, getFn, url, catId, body, callback, FETCHCATEGORYSUBSET));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro,
+                                       _1, getFn, url, catId, body, _2, FETCHCATEGORYSUBSET));
 
-    EnqueueAISCommand("FetchCategorySubset", proc);
+    EnqueueKeyedAISCommand("FetchCategorySubset", url, command, callback);
 }
 
 /*static*/
@@ -707,10 +707,10 @@ void AISAPI::FetchCOF(completion_t callback)
     // Only cof folder will be full, but cof can contain an outfit
     // link with embedded outfit folder for request to parse
     body["depth"] = 0;
-    LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
-                                                         _1, getFn, url, LLUUID::null, body, callback, FETCHCOF));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro,
+                                       _1, getFn, url, LLUUID::null, body, _2, FETCHCOF));
 
-    EnqueueAISCommand("FetchCOF", proc);
+    EnqueueKeyedAISCommand("FetchCOF", url, command, callback);
 }
 
 void AISAPI::FetchCategoryLinks(const LLUUID &catId, completion_t callback)
@@ -743,10 +743,9 @@ void AISAPI::FetchCategoryLinks(const LLUUID &catId, completion_t callback)
 
     LLSD body;
     body["depth"] = 0;
-    LLCoprocedureManager::CoProcedure_t proc(
-        boost::bind(&AISAPI::InvokeAISCommandCoro, _1, getFn, url, LLUUID::null, body, callback, FETCHCATEGORYLINKS));
+    keyedCommand_t command(boost::bind(&AISAPI::InvokeAISCommandCoro, _1, getFn, url, LLUUID::null, body, _2, FETCHCATEGORYLINKS));
 
-    EnqueueAISCommand("FetchCategoryLinks", proc);
+    EnqueueKeyedAISCommand("FetchCategoryLinks", url, command, callback);
 }
 
 /*static*/
@@ -784,13 +783,53 @@ void AISAPI::FetchOrphans(completion_t callback)
 
 /*static*/
 void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc)
+{
+    std::string procFullName = "AIS(" + procName + ")";
+    LaunchAISCommand([procFullName, proc]()
+        {
+            LLCoprocedureManager::instance().enqueueCoprocedure("AIS", procFullName, proc);
+        });
+}
+
+/*static*/
+void AISAPI::EnqueueKeyedAISCommand(const std::string &procName, const std::string &url,
+                                    keyedCommand_t command, completion_t callback)
+{
+    std::string procFullName = "AIS(" + procName + ")";
+
+    // The shared request reports the id it would have completed with,
+    // each caller gets it through its own completion.  A request that
+    // threw reports a failed result, which is a null id.
+    LLCoprocedureManager::KeyedCoProcedure_t proc(
+        [command](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, const LLUUID &)
+        {
+            LLUUID completed_id;
+            command(httpAdapter, [&completed_id](const LLUUID &id) { completed_id = id; });
+            return LLSD(completed_id);
+        });
+    LLCoprocedureManager::KeyedCallback_t waiter(
+        [callback](const LLSD &result)
+        {
+            if (callback)
+            {
+                callback(result.isUUID() ? result.asUUID() : LLUUID::null);
+            }
+        });
+
+    LaunchAISCommand([procFullName, url, proc, waiter]()
+        {
+            LLCoprocedureManager::instance().enqueueKeyedCoprocedure("AIS", procFullName, url, proc, waiter);
+        });
+}
+
+/*static*/
+void AISAPI::LaunchAISCommand(boost::function<void()> launch)
 {
     LLCoprocedureManager &inst = LLCoprocedureManager::instance();
     S32 pending_in_pool = inst.countPending("AIS");
-    std::string procFullName = "AIS(" + procName + ")";
     if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES)
     {
-        inst.enqueueCoprocedure("AIS", procFullName, proc);
+        launch();
     }
     else
     {
@@ -799,12 +838,12 @@ void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager
         // so this is a workaround to not overfill it.
         if (sPostponedQuery.empty())
         {
-            sPostponedQuery.push_back(ais_query_item_t(procFullName, proc));
+            sPostponedQuery.push_back(launch);
             gIdleCallbacks.addFunction(onIdle, NULL);
         }
         else
         {
-            sPostponedQuery.push_back(ais_query_item_t(procFullName, proc));
+            sPostponedQuery.push_back(launch);
         }
     }
 }
@@ -818,9 +857,9 @@ void AISAPI::onIdle(void *userdata)
         S32 pending_in_pool = inst.countPending("AIS");
         while (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES && !sPostponedQuery.empty())
         {
-            ais_query_item_t &item = sPostponedQuery.front();
-            inst.enqueueCoprocedure("AIS", item.first, item.second);
+            ais_query_item_t item = sPostponedQuery.front();
             sPostponedQuery.pop_front();
+            item();
             pending_in_pool++;
         }
     }
@@ -92,7 +92,14 @@ class AISAPI
     typedef boost::function < LLSD (LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t, LLCore::HttpRequest::ptr_t,
         const std::string, LLSD, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t) > invokationFn_t;
 
+    // InvokeAISCommandCoro with everything bound but the adapter and the completion
+    typedef boost::function<void(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t, completion_t)> keyedCommand_t;
+
     static void EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc);
+    // Fetches of the same url while one is in flight share its request
+    static void EnqueueKeyedAISCommand(const std::string &procName, const std::string &url,
+                                       keyedCommand_t command, completion_t callback);
+    static void LaunchAISCommand(boost::function<void()> launch);
     static void onIdle(void *userdata); // launches postponed AIS commands
     static void onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD& request_body);
 
@@ -103,7 +110,7 @@ class AISAPI
         invokationFn_t invoke, std::string url, LLUUID targetId, LLSD body,
         completion_t callback, COMMAND_TYPE type);
 
-    typedef std::pair<std::string, LLCoprocedureManager::CoProcedure_t> ais_query_item_t;
+    typedef boost::function<void()> ais_query_item_t;
     static std::list<ais_query_item_t> sPostponedQuery;
 };
 
@@ -466,6 +466,35 @@ void LLAppCoreHttp::refreshSettings(bool initial)
                     mHttpClasses[app_policy].mPipelined = to_pipeline;
                 }
             }
+
+            // HTTP/2 multiplexing, offered to the same CDN-facing
+            // classes that may pipeline.
+            static const std::string http2_streams("HttpMultiplexStreams");
+            if (init_data[i].mPipelined && gSavedSettings.controlExists(http2_streams))
+            {
+                const long streams(long(gSavedSettings.getU32(http2_streams)));
+                if (streams)
+                {
+                    LLCore::HttpHandle handle;
+                    handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                       mHttpClasses[app_policy].mPolicy,
+                                                       streams,
+                                                       LLCore::HttpHandler::ptr_t());
+                    if (LLCORE_HTTP_HANDLE_INVALID == handle)
+                    {
+                        status = mRequest->getStatus();
+                        LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+                                         << " HTTP/2 stream limit.  Reason:  " << status.toString()
+                                         << LL_ENDL;
+                    }
+                    else
+                    {
+                        LL_INFOS("Init") << "Enabled HTTP/2 multiplexing for " << init_data[i].mUsage
+                                         << ".  Streams per connection:  " << streams
+                                         << LL_ENDL;
+                    }
+                }
+            }
         }
 
         // Get target connection concurrency value
@@ -56,6 +56,8 @@
 #include "llmarketplacenotifications.h"
 #include "llmd5.h"
 #include "llmeshrepository.h"
+#include "llmessagelog.h"
+#include "llmodelloader.h"
 #include "llpumpio.h"
 #include "llmimetypes.h"
 #include "llslurl.h"
@@ -126,6 +128,7 @@
 #include "llavatarnamecache.h"
 #include "lldiriterator.h"
 #include "llexperiencecache.h"
+#include "llimagedatapool.h"
 #include "llimagej2c.h"
 #include "llmemory.h"
 #include "llprimitive.h"
@@ -554,6 +557,9 @@ static void settings_to_globals()
     LLRender::sNsightDebugSupport = gSavedSettings.getBOOL("RenderNsightDebugSupport");
     LLRender::sAnisotropicFilteringLevel = static_cast<F32>(gSavedSettings.getU32("RenderAnisotropicLevel"));
     LLImageGL::sCompressTextures        = gSavedSettings.getBOOL("RenderCompressTextures");
+    LLImageGL::sBlockCompressTextures   = gSavedSettings.getBOOL("RenderBlockCompressTextures");
+    LLImageGL::sBlockCompressNormals    = gSavedSettings.getBOOL("RenderBlockCompressNormalMaps");
+    LLImageGL::sUploadRingBytes         = llmin(gSavedSettings.getU32("RenderTextureUploadRingMB"), 1024U) << 20;
     LLVOVolume::sLODFactor              = llclamp(gSavedSettings.getF32("RenderVolumeLODFactor"), 0.01f, MAX_LOD_FACTOR);
     LLVOVolume::sDistanceFactor         = 1.f-LLVOVolume::sLODFactor * 0.1f;
     LLVolumeImplFlexible::sUpdateFactor = gSavedSettings.getF32("RenderFlexTimeFactor");
@@ -1723,6 +1729,8 @@ bool LLAppViewer::cleanup()
     // shut down mesh streamer
     gMeshRepo.shutdown();
 
+    LLModelLoader::stopImportThreads();
+
     // shut down Havok
     LLPhysicsExtensions::quitSystem();
 
@@ -2011,6 +2019,7 @@ bool LLAppViewer::cleanup()
     LLDiskCache::deleteSingleton();
 
     LL_INFOS() << "Shutting down message system" << LL_ENDL;
+    LLMessageLog::stopCapture();
     end_messaging_system();
 
     // Non-LLCurl libcurl library
@@ -2145,6 +2154,7 @@ bool LLAppViewer::initThreads()
     static const bool enable_threads = true;
 
     LLImage::initClass(gSavedSettings.getBOOL("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
+    LLImageDataPool::setMaxBytes((U64)gSavedSettings.getU32("ImageDataPoolMaxMB") * 1024 * 1024);
 
     LLLFSThread::initClass(enable_threads && true); // TODO: fix crashes associated with this shutdo
 
@@ -2167,10 +2177,20 @@ bool LLAppViewer::initThreads()
     threadCounts["ImageDecode"] = image_decode_count;
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
+    // Large textures can additionally split their own decode across codec
+    // threads; size that so the decode pool and the codec share the cores.
+    S32 codec_threads = gSavedSettings.getS32("ImageDecodeCodecThreads");
+    if (codec_threads < 0)
+    {
+        codec_threads = llclamp(cores / image_decode_count, 1, 4);
+    }
+    LLImageJ2C::setDecodeThreads(codec_threads);
+
     // Image decoding
     LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
     LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
     LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
+                                                    LLAppViewer::getImageDecodeThread(),
                                                     enable_threads && true,
                                                     app_metrics_qa_mode);
 
@@ -2882,8 +2902,11 @@ bool LLAppViewer::initConfiguration()
     //LLVolumeMgr::initClass();
     LLVolumeMgr* volume_manager = new LLVolumeMgr();
     volume_manager->useMutex(); // LLApp and LLMutex magic must be manually enabled
+    volume_manager->startGenerateThreads();
     LLPrimitive::setVolumeManager(volume_manager);
 
+    LLModelLoader::startImportThreads();
+
     // Note: this is where we used to initialize gFeatureManagerp.
 
     gStartTime = totalTime();
@@ -4186,6 +4209,7 @@ bool LLAppViewer::initCache()
         texture_cache_size = llclamp(texture_cache_size, MIN_CACHE_SIZE, MAX_CACHE_SIZE);
 
         LLAppViewer::getTextureCache()->initCache(LL_PATH_CACHE, texture_cache_size, texture_cache_mismatch);
+        LLAppViewer::getImageDecodeThread()->setDecodedCache(LLAppViewer::getTextureCache()->getDecodedCache());
     }
 
     const U32 CACHE_NUMBER_OF_REGIONS_FOR_OBJECTS = 128;
@@ -71,6 +71,7 @@ class alignas(16) LLFace
         TEXTURE_ANIM    = 0x0020,
         RIGGED          = 0x0040,
         PARTICLE        = 0x0080,
+        SHARED_GEOMETRY = 0x0100,   // vertex buffer is shared with identical faces, don't write to it
     };
 
 public:
@@ -169,6 +169,10 @@ bool LLFetchedGLTFMaterial::replaceLocalTexture(const LLUUID& tracking_id, const
     {
         mTextureId[LLGLTFMaterial::GLTF_TEXTURE_INFO_NORMAL] = new_id;
         mNormalTexture = fetch_texture(new_id);
+        if (mNormalTexture)
+        {
+            mNormalTexture->setIsNormalMap(true);
+        }
         res = true;
     }
     if (mTextureId[LLGLTFMaterial::GLTF_TEXTURE_INFO_METALLIC_ROUGHNESS] == old_id)
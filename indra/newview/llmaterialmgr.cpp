@@ -31,6 +31,7 @@
 
 #include "llagent.h"
 #include "llcallbacklist.h"
+#include "llcoproceduremanager.h"
 #include "llmaterialmgr.h"
 #include "llviewerobject.h"
 #include "llviewerobjectlist.h"
@@ -875,12 +876,22 @@ void LLMaterialMgr::processGetAllQueueCoro(LLUUID regionId)
 
     LL_DEBUGS("Materials") << "GET all for region " << regionId << "url " << capURL << LL_ENDL;
 
-    LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter =
-            std::make_shared<LLCoreHttpUtil::HttpCoroutineAdapter>("processGetAllQueue", LLCore::HttpRequest::DEFAULT_POLICY_ID);
+    // A get all for the same region still in flight answers this one too
+    LLCoprocedureManager::instance().enqueueKeyedCoprocedure("Materials", "LLMaterialMgr::getAllCoro", capURL,
+        boost::bind(&LLMaterialMgr::getAllCoro, _1, capURL),
+        boost::bind(&LLMaterialMgr::onGetAllFetched, this, regionId, _1));
+}
+
+/*static*/
+LLSD LLMaterialMgr::getAllCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, std::string capURL)
+{
     LLCore::HttpRequest::ptr_t httpRequest = std::make_shared<LLCore::HttpRequest>();
 
-    LLSD result = httpAdapter->getAndSuspend(httpRequest, capURL);
+    return httpAdapter->getAndSuspend(httpRequest, capURL);
+}
 
+void LLMaterialMgr::onGetAllFetched(LLUUID regionId, const LLSD &result)
+{
     LLSD httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
     LLCore::HttpStatus status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
 
@@ -894,7 +905,7 @@ void LLMaterialMgr::processGetAllQueueCoro(LLUUID regionId)
     }
 
     // reget the region from the region ID since it may have gone away while waiting.
-    regionp = worldInst.getRegionFromID(regionId);
+    LLViewerRegion* regionp = LLWorld::instance().getRegionFromID(regionId);
     if (!regionp)
     {
         LL_WARNS("Materials") << "Region with ID " << regionId << " is no longer valid." << LL_ENDL;
@@ -33,6 +33,7 @@
 #include "httprequest.h"
 #include "httpheaders.h"
 #include "httpoptions.h"
+#include "llcorehttputil.h"
 #include "boost/unordered/unordered_map.hpp"
 #include "boost/unordered/unordered_flat_map.hpp"
 #include "boost/unordered/unordered_flat_set.hpp"
@@ -80,6 +81,8 @@ class LLMaterialMgr final : public LLSingleton<LLMaterialMgr>
     void onGetResponse(bool success, const LLSD& content, const LLUUID& region_id);
     void processGetAllQueue();
     void processGetAllQueueCoro(LLUUID regionId);
+    static LLSD getAllCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, std::string capURL);
+    void onGetAllFetched(LLUUID regionId, const LLSD &result);
     void onGetAllResponse(bool success, const LLSD& content, const LLUUID& region_id);
     void processPutQueue();
     void onPutResponse(bool success, const LLSD& content);
@@ -0,0 +1,135 @@
+/**
+ * @file llmeshdecodedcache.cpp
+ * @brief Byte accounted LRU of decoded mesh data
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshdecodedcache.h"
+
+LLMeshDecodedCache::LLMeshDecodedCache()
+    : mBytes(0),
+      mBudget(U64_MAX)
+{
+}
+
+void LLMeshDecodedCache::touch(const LLUUID& id, S32 kind, U64 bytes)
+{
+    const Key key = { id, kind };
+    auto iter = mEntries.find(key);
+    if (iter == mEntries.end())
+    {
+        mLRU.push_front({ key, bytes });
+        mEntries.emplace(key, mLRU.begin());
+    }
+    else
+    {
+        mBytes -= iter->second->mBytes;
+        iter->second->mBytes = bytes;
+        mLRU.splice(mLRU.begin(), mLRU, iter->second);
+    }
+    mBytes += bytes;
+}
+
+void LLMeshDecodedCache::touch(const LLUUID& id, S32 kind)
+{
+    auto iter = mEntries.find({ id, kind });
+    if (iter != mEntries.end())
+    {
+        mLRU.splice(mLRU.begin(), mLRU, iter->second);
+    }
+}
+
+void LLMeshDecodedCache::remove(const LLUUID& id, S32 kind)
+{
+    auto iter = mEntries.find({ id, kind });
+    if (iter != mEntries.end())
+    {
+        mBytes -= iter->second->mBytes;
+        mLRU.erase(iter->second);
+        mEntries.erase(iter);
+    }
+}
+
+bool LLMeshDecodedCache::has(const LLUUID& id, S32 kind) const
+{
+    return mEntries.find({ id, kind }) != mEntries.end();
+}
+
+void LLMeshDecodedCache::clear()
+{
+    mEntries.clear();
+    mLRU.clear();
+    mBytes = 0;
+}
+
+U64 LLMeshDecodedCache::trim(const evict_callback_t& evict)
+{
+    U64 freed(0);
+    size_t offers = mLRU.size();
+    while (mBytes > mBudget && offers-- > 0)
+    {
+        lru_list_t::iterator oldest = std::prev(mLRU.end());
+        const U64 kept = evict(oldest->mKey, oldest->mBytes);
+        if (kept < oldest->mBytes)
+        {
+            freed += oldest->mBytes - kept;
+        }
+        mBytes = mBytes - oldest->mBytes + kept;
+        if (kept == 0)
+        {
+            mEntries.erase(oldest->mKey);
+            mLRU.erase(oldest);
+        }
+        else
+        {
+            oldest->mBytes = kept;
+            mLRU.splice(mLRU.begin(), mLRU, oldest);
+        }
+    }
+    return freed;
+}
+
+U64 LLMeshDecodedCache::refresh(const measure_callback_t& measure)
+{
+    U64 gone(0);
+    lru_list_t::iterator iter = mLRU.begin();
+    while (iter != mLRU.end())
+    {
+        const U64 bytes = measure(iter->mKey, iter->mBytes);
+        if (bytes < iter->mBytes)
+        {
+            gone += iter->mBytes - bytes;
+        }
+        mBytes = mBytes - iter->mBytes + bytes;
+        if (bytes == 0)
+        {
+            mEntries.erase(iter->mKey);
+            iter = mLRU.erase(iter);
+        }
+        else
+        {
+            iter->mBytes = bytes;
+            ++iter;
+        }
+    }
+    return gone;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file llmeshdecodedcache.h
+ * @brief Byte accounted LRU of decoded mesh data
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESHDECODEDCACHE_H
+#define LL_LLMESHDECODEDCACHE_H
+
+#include "lluuid.h"
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include <functional>
+#include <list>
+
+// Keeps the use order and size of the decoded mesh data LLMeshRepository
+// holds on to:  the LODs of each mesh, its skin info and its physics
+// decomposition.  The data itself stays where it is, this only decides
+// what goes first when the total is over budget.  Whoever owns the data
+// frees it from the callback given to trim(), or keeps what is in use.
+// Data its owner can free behind the cache's back is recounted with
+// refresh().
+//
+// Main thread only.
+class LLMeshDecodedCache
+{
+public:
+    enum EKind
+    {
+        KIND_LOD_LOWEST = 0,    // LODs 0 to 3 are their LLModel::LOD_* values
+        KIND_LOD_HIGH = 3,
+        KIND_SKIN,
+        KIND_DECOMPOSITION,
+        KIND_COUNT
+    };
+
+    struct Key
+    {
+        LLUUID mID;
+        S32 mKind;
+
+        bool operator==(const Key& rhs) const
+        {
+            return mKind == rhs.mKind && mID == rhs.mID;
+        }
+
+        friend std::size_t hash_value(const Key& key)
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, key.mID);
+            boost::hash_combine(seed, key.mKind);
+            return seed;
+        }
+    };
+
+    // Frees what it can of the data for key, accounted at bytes, and
+    // returns the bytes still held because they are in use.  0 means all
+    // of it is gone, already gone included.
+    typedef std::function<U64(const Key& key, U64 bytes)> evict_callback_t;
+    // Returns the bytes the data for key holds now, 0 if it is gone.
+    typedef std::function<U64(const Key& key, U64 bytes)> measure_callback_t;
+
+    LLMeshDecodedCache();
+
+    void setBudget(U64 bytes) { mBudget = bytes; }
+    U64 getBudget() const { return mBudget; }
+    U64 getBytes() const { return mBytes; }
+    S32 getCount() const { return (S32)mEntries.size(); }
+
+    // Record a use of the data with its current size, adding it as the
+    // most recently used if it's new.
+    void touch(const LLUUID& id, S32 kind, U64 bytes);
+    // Same, keeping the size it was added with.  Unknown data is ignored.
+    void touch(const LLUUID& id, S32 kind);
+    // Forget data that was freed some other way.
+    void remove(const LLUUID& id, S32 kind);
+    bool has(const LLUUID& id, S32 kind) const;
+    void clear();
+
+    // Evict the least recently used data until the total fits the budget.
+    // Data the callback keeps some of is in use, so it stays at its new
+    // size and moves to the most recently used end.  Every entry is
+    // offered at most once a call.  Returns the number of bytes freed.
+    U64 trim(const evict_callback_t& evict);
+    // Resize every entry to what the callback measures, dropping the ones
+    // that are gone, without changing the use order.  Returns the number
+    // of bytes that went away.
+    U64 refresh(const measure_callback_t& measure);
+
+private:
+    struct Entry
+    {
+        Key mKey;
+        U64 mBytes;
+    };
+    typedef std::list<Entry> lru_list_t;    // most recently used first
+
+    lru_list_t mLRU;
+    boost::unordered_flat_map<Key, lru_list_t::iterator> mEntries;
+    U64 mBytes;
+    U64 mBudget;
+};
+
+#endif // LL_LLMESHDECODEDCACHE_H
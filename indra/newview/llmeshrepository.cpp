@@ -53,10 +53,12 @@
 #include "llviewernetwork.h"
 #include "llviewerobjectlist.h"
 #include "llviewerregion.h"
+#include "llviewerstats.h"
 #include "llviewerstatsrecorder.h"
 #include "llviewertexturelist.h"
 #include "llvolume.h"
 #include "llvolumemgr.h"
+#include "llvolumeoctree.h"
 #include "llvovolume.h"
 #include "llworld.h"
 #include "material_codes.h"
@@ -109,6 +111,8 @@
 //
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
+//   decode   "MeshDecode" thread pool decoding LOD, skin, decomposition and
+//            physics data for the repo thread (headers stay on repo)
 //   decom    Worker thread for mesh decomposition requests
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
@@ -149,9 +153,13 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                               decodeFetched() posts decode job
+//                             ...
+//                                                 decode thread
+//                                                 lodReceived() invoked
+//                                                   unpack data into LLVolume
+//                                                   append LoadedMesh to mLoadedQ
+//                                                 data written to cache
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -222,12 +230,16 @@
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
-//     sCacheBytesWritten              "
-//     sCacheReads                     "
-//     sCacheWrites                    "
+//     sCacheBytesWritten              atomic          rw.repo, rw.decode, ro.main
+//     sCacheReads                     none            rw.repo.none, ro.main.none [1]
+//     sCacheWrites                    atomic          rw.repo, rw.decode, ro.main
+//     sBinaryCacheHits                atomic          rw.decode, ro.main
+//     sBinaryCacheWrites              atomic          rw.decode, ro.main
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
+//     mDecodedCache                   none            rw.main.none
+//     mDecodedLODParams               none            rw.main.none
 //     mPendingRequests                mMeshMutex [4]  rw.main.mMeshMutex
 //     mLoadingSkins                   mMeshMutex [4]  rw.main.mMeshMutex
 //     mPendingSkinRequests            mMeshMutex [4]  rw.main.mMeshMutex
@@ -246,21 +258,26 @@
 //     sActiveHeaderRequests    mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sActiveLODRequests       mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
+//     sBinaryLODCache          none          wo.main.none, ro.repo.none, ro.decode.none [1]
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
-//     mSkinReqQ                mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinUnavailableQ        mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
-//     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinReqQ                mMutex        rw.repo.mMutex, wo.decode.mMutex, ro.repo.none [5]
+//     mSkinUnavailableQ        mMutex        rw.repo.mMutex, wo.decode.mMutex, ro.repo.none [5]
+//     mSkinInfoQ               mMutex        rw.decode.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mDecompositionRequests   mMutex        rw.repo.mMutex, wo.decode.mMutex, ro.repo.none [5]
+//     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, wo.decode.mMutex, ro.repo.none [5]
+//     mDecompositionQ          mMutex        rw.decode.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mPhysicsQ                mMutex        rw.decode.mMutex, rw.main.mMutex [5]
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], wo.decode.mMutex, ro.main.none [5], rw.main.mMutex
+//     mLoadedQ                 mMutex        rw.decode.mMutex, ro.main.none [5], rw.main.mMutex
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMeshVersion          mMutex        rw.main.mMutex, ro.repo.mMutex
+//     mCacheFailures           mMutex        rw.repo.mMutex, rw.decode.mMutex
+//     mDecodePool              none          rw.repo.none (posting is thread safe)
+//     mDecodesPending          atomic        rw.repo, rw.decode, ro.main
 //     mHttp*                   none          rw.repo.none
 //
 //   LLMeshUploadThread:
@@ -356,6 +373,9 @@ const U32 LARGE_MESH_FETCH_THRESHOLD = 1U << 21;        // Size at which request
 const long SMALL_MESH_XFER_TIMEOUT = 120L;              // Seconds to complete xfer, small mesh downloads
 const long LARGE_MESH_XFER_TIMEOUT = 600L;              // Seconds to complete xfer, large downloads
 
+// HTTP/2 stream weights by LLMeshRepoThread::EFetchPriority
+const S32 MESH_STREAM_WEIGHTS[LLMeshRepoThread::FETCH_PRIORITY_COUNT] = { 256, 128, 64, 32, 8 };
+
 const U32 DOWNLOAD_RETRY_LIMIT = 8;
 const F32 DOWNLOAD_RETRY_DELAY = 0.5f; // seconds
 
@@ -387,12 +407,14 @@ U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
 U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+std::atomic<U32> LLMeshRepository::sCacheBytesWritten(0);
 U32 LLMeshRepository::sCacheBytesHeaders = 0;
 U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+std::atomic<U32> LLMeshRepository::sCacheWrites(0);
+std::atomic<U32> LLMeshRepository::sBinaryCacheHits(0);
+std::atomic<U32> LLMeshRepository::sBinaryCacheWrites(0);
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);  // true -> gather cpu metrics
@@ -556,6 +578,7 @@ U32 LLMeshRepoThread::sMaxConcurrentRequests = 1;
 S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
+bool LLMeshRepoThread::sBinaryLODCache = true;
 
 // Base handler class for all mesh users of llcorehttp.
 // This is roughly equivalent to a Responder class in
@@ -816,12 +839,11 @@ void log_upload_error(LLCore::HttpStatus status, const LLSD& content,
 LLMeshRepoThread::LLMeshRepoThread()
 : LLThread("mesh repo"),
   mHttpRequest(NULL),
-  mHttpOptions(),
-  mHttpLargeOptions(),
   mHttpHeaders(),
   mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLegacyPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
+  mDecodesPending(0),
   mLegacyGetMeshVersion(0)
 {
     LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
@@ -830,17 +852,26 @@ LLMeshRepoThread::LLMeshRepoThread()
     mHeaderMutex = new LLMutex();
     mSignal = new LLCondition();
     mHttpRequest = new LLCore::HttpRequest;
-    mHttpOptions = std::make_shared<LLCore::HttpOptions>();
-    mHttpOptions->setTransferTimeout(SMALL_MESH_XFER_TIMEOUT);
-    mHttpOptions->setUseRetryAfter(gSavedSettings.getBOOL("MeshUseHttpRetryAfter"));
-    mHttpLargeOptions = std::make_shared<LLCore::HttpOptions>();
-    mHttpLargeOptions->setTransferTimeout(LARGE_MESH_XFER_TIMEOUT);
-    mHttpLargeOptions->setUseRetryAfter(gSavedSettings.getBOOL("MeshUseHttpRetryAfter"));
+    const bool use_retry_after = gSavedSettings.getBOOL("MeshUseHttpRetryAfter");
+    for (S32 i = 0; i < FETCH_PRIORITY_COUNT; ++i)
+    {
+        mHttpOptions[i] = std::make_shared<LLCore::HttpOptions>();
+        mHttpOptions[i]->setTransferTimeout(SMALL_MESH_XFER_TIMEOUT);
+        mHttpOptions[i]->setUseRetryAfter(use_retry_after);
+        mHttpOptions[i]->setStreamWeight(MESH_STREAM_WEIGHTS[i]);
+        mHttpLargeOptions[i] = std::make_shared<LLCore::HttpOptions>();
+        mHttpLargeOptions[i]->setTransferTimeout(LARGE_MESH_XFER_TIMEOUT);
+        mHttpLargeOptions[i]->setUseRetryAfter(use_retry_after);
+        mHttpLargeOptions[i]->setStreamWeight(MESH_STREAM_WEIGHTS[i]);
+    }
     mHttpHeaders = std::make_shared<LLCore::HttpHeaders>();
     mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_VND_LL_MESH);
     mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
     mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1);
     mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+    mDecodePool.reset(new LL::ThreadPool("MeshDecode", 4));
+    mDecodePool->start();
 }
 
 
@@ -851,6 +882,10 @@ LLMeshRepoThread::~LLMeshRepoThread()
                        << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
                        << LL_ENDL;
 
+    // Jobs still queued reference this thread's queues and mutexes
+    mDecodePool->close();
+    mDecodePool.reset();
+
     mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
@@ -1273,7 +1308,7 @@ void LLMeshRepoThread::constructUrl(LLUUID mesh_id, std::string * url, int * leg
 //
 // Thread:  repo
 LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int legacy_cap_version,
-                                                  size_t offset, size_t len,
+                                                  size_t offset, size_t len, EFetchPriority priority,
                                                   const LLCore::HttpHandler::ptr_t &handler)
 {
     // Also used in lltexturefetch.cpp
@@ -1287,7 +1322,7 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
                                                     url,
                                                     (disable_range_req ? size_t(0) : offset),
                                                     (disable_range_req ? size_t(0) : len),
-                                                    mHttpOptions,
+                                                    mHttpOptions[priority],
                                                     mHttpHeaders,
                                                     handler);
         if (LLCORE_HTTP_HANDLE_INVALID != handle)
@@ -1301,7 +1336,7 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
                                                    url,
                                                    (disable_range_req ? size_t(0) : offset),
                                                    (disable_range_req ? size_t(0) : len),
-                                                   mHttpLargeOptions,
+                                                   mHttpLargeOptions[priority],
                                                    mHttpHeaders,
                                                    handler);
         if (LLCORE_HTTP_HANDLE_INVALID != handle)
@@ -1317,13 +1352,38 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
     return handle;
 }
 
-bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn)
+bool LLMeshRepoThread::postDecode(std::function<void()> decode)
 {
+    ++mDecodesPending;
+    bool posted = mDecodePool->getQueue().post(
+        [this, decode]()
+        {
+            decode();
+            --mDecodesPending;
+        });
+    if (!posted)
+    {
+        --mDecodesPending;
+        LL_DEBUGS(LOG_MESH) << "Tried to start mesh decode on shutdown" << LL_ENDL;
+    }
+    return posted;
+}
+
+bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, decode_fn_t decode, std::function<void()> retry)
+{
+    {
+        LLMutexLock lock(mMutex);
+        if (mCacheFailures.count(mesh_id))
+        {
+            return false;
+        }
+    }
+
     //check cache for mesh skin info
     LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
     if (file.getSize() >= info.mOffset + info.mSize)
     {
-        auto buffer = std::make_unique<U8[]>(info.mSize);
+        std::shared_ptr<U8[]> buffer(new(std::nothrow) U8[info.mSize]);
         if (!buffer)
         {
             LL_WARNS_ONCE(LOG_MESH) << "Failed to allocate memory for mesh data load, size: " << info.mSize << LL_ENDL;
@@ -1343,13 +1403,160 @@ bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderI
 
         if (!zero)
         { //attempt to parse
-            if (fn(mesh_id, buffer.get(), info.mSize) == MESH_OK)
+            const S32 size = info.mSize;
+            return postDecode(
+                [this, mesh_id, buffer, size, decode, retry]()
+                {
+                    if (decode(buffer.get(), size) != MESH_OK)
+                    {
+                        LL_INFOS(LOG_MESH) << "Cached data for mesh " << mesh_id
+                                           << " failed to decode, fetching from simulator" << LL_ENDL;
+                        {
+                            LLMutexLock lock(mMutex);
+                            mCacheFailures.insert(mesh_id);
+                        }
+                        retry();
+                    }
+                });
+        }
+    }
+    return false;
+}
+
+void LLMeshRepoThread::decodeFetched(const LLUUID& mesh_id, S32 offset, S32 size, const U8* data, S32 data_size,
+                                     decode_fn_t decode, std::function<void(EMeshProcessingResult)> on_failure)
+{
+    // data only lives as long as the HTTP response
+    std::shared_ptr<U8[]> buffer;
+    if (data_size > 0)
+    {
+        buffer.reset(new(std::nothrow) U8[data_size]);
+        if (!buffer)
+        {
+            LL_WARNS(LOG_MESH) << "Failed to allocate " << data_size << " memory for mesh decode" << LL_ENDL;
+            on_failure(MESH_OUT_OF_MEMORY);
+            return;
+        }
+        memcpy(buffer.get(), data, data_size);
+    }
+
+    postDecode(
+        [mesh_id, offset, size, buffer, data_size, decode, on_failure]()
+        {
+            EMeshProcessingResult result = decode(buffer.get(), data_size);
+            if (result != MESH_OK)
             {
-                return true;
+                on_failure(result);
+                return;
             }
+
+            // good fetch from sim, write to cache
+            // <FS:Ansariel> Fix asset caching
+            //LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+            LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+            if (data_size >= size && file.getSize() >= offset + size)
+            {
+                file.seek(offset);
+                file.write(buffer.get(), size);
+                LLMeshRepository::sCacheBytesWritten += size;
+                ++LLMeshRepository::sCacheWrites;
+            }
+        });
+}
+
+//static
+LLUUID LLMeshRepoThread::getBinaryLODCacheID(const LLVolumeParams& mesh_params, S32 lod)
+{
+    // Mirrored and inverted meshes are unpacked differently, keep them apart
+    const U8 flags = mesh_params.getSculptType() & (LL_SCULPT_FLAG_MIRROR | LL_SCULPT_FLAG_INVERT);
+
+    static const LLUUID binary_lod_salt("2b0a3c1e-6f4d-4e57-9d3a-8c1f0b7e5a90");
+    LLUUID salt = binary_lod_salt;
+    salt.mData[0] ^= (U8) LLVolume::BINARY_FACES_VERSION;
+    salt.mData[1] ^= (U8) lod;
+    salt.mData[2] ^= flags;
+
+    LLUUID id;
+    mesh_params.getSculptID().combine(salt, id);
+    return id;
+}
+
+bool LLMeshRepoThread::loadLODFromBinaryCache(const LLVolumeParams& mesh_params, S32 lod)
+{
+    const LLUUID cache_id = getBinaryLODCacheID(mesh_params, lod);
+    {
+        LLMutexLock lock(mMutex);
+        if (mCacheFailures.count(cache_id))
+        {
+            return false;
+        }
+    }
+
+    LLFileSystem file(cache_id, LLAssetType::AT_MESH);
+    const S32 size = file.getSize();
+    if (size <= 0)
+    {
+        return false;
+    }
+
+    std::shared_ptr<U8[]> buffer(new(std::nothrow) U8[size]);
+    if (!buffer || !file.read(buffer.get(), size) || file.getLastBytesRead() != size)
+    {
+        return false;
+    }
+    LLMeshRepository::sCacheBytesRead += size;
+    ++LLMeshRepository::sCacheReads;
+
+    return postDecode(
+        [this, mesh_params, lod, cache_id, buffer, size]()
+        {
+            LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+            if (volume->unpackBinaryFaces(buffer.get(), size) && volume->getNumVolumeFaces() > 0)
+            {
+                ++LLMeshRepository::sBinaryCacheHits;
+
+                LoadedMesh mesh(volume, mesh_params, lod);
+                LLMutexLock lock(mMutex);
+                mLoadedQ.push_back(mesh);
+                // see lodReceived(), release our references under the lock
+                volume = NULL;
+                mesh.mVolume = NULL;
+                return;
+            }
+
+            LL_INFOS(LOG_MESH) << "Binary cache entry for mesh " << mesh_params.getSculptID() << " LOD " << lod
+                               << " is unusable, decoding the asset instead" << LL_ENDL;
+            LLFileSystem::removeFile(cache_id, LLAssetType::AT_MESH);
+
+            LLMutexLock lock(mMutex);
+            mCacheFailures.insert(cache_id);
+            mLODReqQ.push(LODRequest(mesh_params, lod));
+            ++LLMeshRepository::sLODProcessing;
+        });
+}
+
+void LLMeshRepoThread::writeLODToBinaryCache(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume)
+{
+    const LLUUID cache_id = getBinaryLODCacheID(mesh_params, lod);
+    {
+        LLMutexLock lock(mMutex);
+        if (mCacheFailures.count(cache_id))
+        {
+            return;
+        }
+    }
+
+    std::vector<U8> data;
+    if (volume->packBinaryFaces(data))
+    {
+        LLFileSystem file(cache_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+        if (file.write(data.data(), (S32) data.size()))
+        {
+            LLMeshRepository::sCacheBytesWritten += data.size();
+            ++LLMeshRepository::sBinaryCacheWrites;
         }
     }
-    return false;
 }
 
 bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
@@ -1383,7 +1590,16 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
     if (info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
         //check cache for mesh skin info
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::skinInfoReceived, this, _1, _2, _3)))
+        if (loadInfoFromFilesystem(mesh_id, info,
+                                   [this, mesh_id](U8* data, S32 data_size)
+                                   {
+                                       return skinInfoReceived(mesh_id, data, data_size);
+                                   },
+                                   [this, mesh_id]()
+                                   {
+                                       LLMutexLock lock(mMutex);
+                                       mSkinReqQ.push(UUIDBasedRequest(mesh_id));
+                                   }))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1394,7 +1610,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
         if (!http_url.empty())
         {
             auto handler = std::make_shared<LLMeshSkinInfoHandler>(mesh_id, info.mOffset, info.mSize);
-            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, handler);
+            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, FETCH_SKIN, handler);
             if (LLCORE_HTTP_HANDLE_INVALID == handle)
             {
                 LL_WARNS(LOG_MESH) << "HTTP GET request failed for skin info on mesh " << getID()
@@ -1461,7 +1677,16 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
     if (info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
         //check cache for mesh physics info
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::decompositionReceived, this, _1, _2, _3)))
+        if (loadInfoFromFilesystem(mesh_id, info,
+                                   [this, mesh_id](U8* data, S32 data_size)
+                                   {
+                                       return decompositionReceived(mesh_id, data, data_size);
+                                   },
+                                   [this, mesh_id]()
+                                   {
+                                       LLMutexLock lock(mMutex);
+                                       mDecompositionRequests.insert(UUIDBasedRequest(mesh_id));
+                                   }))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1472,7 +1697,7 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
         if (!http_url.empty())
         {
             auto handler = std::make_shared<LLMeshDecompositionHandler>(mesh_id, info.mOffset, info.mSize);
-            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, handler);
+            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, FETCH_PHYSICS, handler);
             if (LLCORE_HTTP_HANDLE_INVALID == handle)
             {
                 LL_WARNS(LOG_MESH) << "HTTP GET request failed for decomposition mesh " << getID()
@@ -1523,7 +1748,16 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 
     if (info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::physicsShapeReceived, this, _1, _2, _3)))
+        if (loadInfoFromFilesystem(mesh_id, info,
+                                   [this, mesh_id](U8* data, S32 data_size)
+                                   {
+                                       return physicsShapeReceived(mesh_id, data, data_size);
+                                   },
+                                   [this, mesh_id]()
+                                   {
+                                       LLMutexLock lock(mMutex);
+                                       mPhysicsShapeRequests.insert(UUIDBasedRequest(mesh_id));
+                                   }))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1534,7 +1768,7 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
         if (!http_url.empty())
         {
             auto handler = std::make_shared<LLMeshPhysicsShapeHandler>(mesh_id, info.mOffset, info.mSize);
-            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, handler);
+            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, FETCH_PHYSICS, handler);
             if (LLCORE_HTTP_HANDLE_INVALID == handle)
             {
                 LL_WARNS(LOG_MESH) << "HTTP GET request failed for physics shape on mesh " << getID()
@@ -1636,7 +1870,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
         //NOTE -- this will break of headers ever exceed 4KB
 
         auto handler = std::make_shared<LLMeshHeaderHandler>(mesh_params, 0, MESH_HEADER_SIZE);
-        LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, 0, MESH_HEADER_SIZE, handler);
+        LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, 0, MESH_HEADER_SIZE, FETCH_HEADER, handler);
         if (LLCORE_HTTP_HANDLE_INVALID == handle)
         {
             LL_WARNS(LOG_MESH) << "HTTP GET request failed for mesh header " << getID()
@@ -1687,7 +1921,20 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
     if(info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::lodReceived, this, mesh_params, lod, _2, _3 )))
+        if (sBinaryLODCache && loadLODFromBinaryCache(mesh_params, lod))
+            return true;
+
+        if (loadInfoFromFilesystem(mesh_id, info,
+                                   [this, mesh_params, lod](U8* data, S32 data_size)
+                                   {
+                                       return lodReceived(mesh_params, lod, data, data_size);
+                                   },
+                                   [this, mesh_params, lod]()
+                                   {
+                                       LLMutexLock lock(mMutex);
+                                       mLODReqQ.push(LODRequest(mesh_params, lod));
+                                       ++LLMeshRepository::sLODProcessing;
+                                   }))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1700,7 +1947,8 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
             LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mesh_id << " - was retrieved from the simulator." << LL_ENDL;
 
             auto handler = std::make_shared<LLMeshLODHandler>(mesh_params, lod, info.mOffset, info.mSize);
-            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize, handler);
+            LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, info.mOffset, info.mSize,
+                                                     lod <= LLModel::LOD_LOW ? FETCH_LOD_LOW : FETCH_LOD_HIGH, handler);
             if (LLCORE_HTTP_HANDLE_INVALID == handle)
             {
                 LL_WARNS(LOG_MESH) << "HTTP GET request failed for LOD on mesh " << getID()
@@ -1825,6 +2073,11 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
     {
         if (volume->getNumFaces() > 0)
         {
+            if (sBinaryLODCache)
+            {
+                writeLODToBinaryCache(mesh_params, lod, volume);
+            }
+
             LoadedMesh mesh(volume, mesh_params, lod);
             {
                 LLMutexLock lock(mMutex);
@@ -2981,6 +3234,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
         LLCore::BufferArray * body(response->getBody());
         S32 body_offset(0);
         U8 * data(NULL);
+        U8 * data_copy(NULL);
         S32 data_size(body ? body->size() : 0);
 
         if (data_size > 0)
@@ -3033,14 +3287,19 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
                 goto common_exit;
             }
 
-            // *TODO: Try to get rid of data copying and add interfaces
-            // that support BufferArray directly.  Introduce a two-phase
-            // handler, optional first that takes a body, fallback second
-            // that requires a temporary allocation and data copy.
+            // Bodies with a Content-Length arrive in one contiguous
+            // block and are processed in place.  Otherwise fall back
+            // to a temporary allocation and data copy.
             body_offset = mOffset - offset;
-            data = new(std::nothrow) U8[data_size - body_offset];
-            if (data)
+            U8 * contiguous((U8 *) body->contiguousData());
+            if (contiguous)
             {
+                data = contiguous + body_offset;
+                LLMeshRepository::sBytesReceived += data_size;
+            }
+            else if ((data_copy = new(std::nothrow) U8[data_size - body_offset]))
+            {
+                data = data_copy;
                 body->read(body_offset, (char *) data, data_size - body_offset);
                 LLMeshRepository::sBytesReceived += data_size;
             }
@@ -3053,7 +3312,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
         processData(body, body_offset, data, data_size - body_offset);
 
-        delete [] data;
+        delete [] data_copy;
     }
 
     // Release handler
@@ -3235,36 +3494,25 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
     if ((!MESH_LOD_PROCESS_FAILED)
         && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
-        if (result == MESH_OK)
-        {
-            // good fetch from sim, write to cache
-            // <FS:Ansariel> Fix asset caching
-            //LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::WRITE);
-            LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-            S32 offset = mOffset;
-            S32 size = mRequestedBytes;
-
-            if (file.getSize() >= offset+size)
+        LLMeshRepoThread* thread = gMeshRepo.mThread;
+        const LLVolumeParams mesh_params = mMeshParams;
+        const S32 lod = mLOD;
+        thread->decodeFetched(mesh_params.getSculptID(), mOffset, mRequestedBytes, data, data_size,
+            [thread, mesh_params, lod](U8* data, S32 data_size)
             {
-                file.seek(offset);
-                file.write(data, size);
-                LLMeshRepository::sCacheBytesWritten += size;
-                ++LLMeshRepository::sCacheWrites;
-            }
-        }
-        else
-        {
-            LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mMeshParams.getSculptID()
-                               << ", Reason: " << result
-                               << " LOD: " << mLOD
-                               << " Data size: " << data_size
-                               << " Not retrying."
-                               << LL_ENDL;
-            LLMutexLock lock(gMeshRepo.mThread->mMutex);
-            gMeshRepo.mThread->mUnavailableQ.emplace_back(mMeshParams, mLOD);
-        }
+                return thread->lodReceived(mesh_params, lod, data, data_size);
+            },
+            [thread, mesh_params, lod, data_size](EMeshProcessingResult result)
+            {
+                LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_params.getSculptID()
+                                   << ", Reason: " << result
+                                   << " LOD: " << lod
+                                   << " Data size: " << data_size
+                                   << " Not retrying."
+                                   << LL_ENDL;
+                LLMutexLock lock(thread->mMutex);
+                thread->mUnavailableQ.emplace_back(mesh_params, lod);
+            });
     }
     else
     {
@@ -3299,33 +3547,30 @@ void LLMeshSkinInfoHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
                                         U8 * data, S32 data_size)
 {
+    LLMeshRepoThread* thread = gMeshRepo.mThread;
+    const LLUUID mesh_id = mMeshID;
+    auto on_failure = [thread, mesh_id](EMeshProcessingResult)
+        {
+            LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+                               << ", Unknown reason.  Not retrying."
+                               << LL_ENDL;
+            LLMutexLock lock(thread->mMutex);
+            thread->mSkinUnavailableQ.emplace_back(mesh_id);
+        };
+
     if ((!MESH_SKIN_INFO_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size) == MESH_OK)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        // good fetch from sim, write to cache
-        // <FS:Ansariel> Fix asset caching
-        //LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-        LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-        S32 offset = mOffset;
-        S32 size = mRequestedBytes;
-
-        if (file.getSize() >= offset+size)
-        {
-            LLMeshRepository::sCacheBytesWritten += size;
-            ++LLMeshRepository::sCacheWrites;
-            file.seek(offset);
-            file.write(data, size);
-        }
+        thread->decodeFetched(mesh_id, mOffset, mRequestedBytes, data, data_size,
+            [thread, mesh_id](U8* data, S32 data_size)
+            {
+                return thread->skinInfoReceived(mesh_id, data, data_size);
+            },
+            on_failure);
     }
     else
     {
-        LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mMeshID
-                           << ", Unknown reason.  Not retrying."
-                           << LL_ENDL;
-        LLMutexLock lock(gMeshRepo.mThread->mMutex);
-        gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
+        on_failure(MESH_UNKNOWN);
     }
 }
 
@@ -3350,32 +3595,29 @@ void LLMeshDecompositionHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
                                              U8 * data, S32 data_size)
 {
+    const LLUUID mesh_id = mMeshID;
+    auto on_failure = [mesh_id](EMeshProcessingResult)
+        {
+            LL_WARNS(LOG_MESH) << "Error during mesh decomposition processing.  ID:  " << mesh_id
+                               << ", Unknown reason.  Not retrying."
+                               << LL_ENDL;
+            // *TODO:  Mark mesh unavailable on error
+        };
+
     if ((!MESH_DECOMP_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size) == MESH_OK)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        // good fetch from sim, write to cache
-        // <FS:Ansariel> Fix asset caching
-        //LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-        LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-        S32 offset = mOffset;
-        S32 size = mRequestedBytes;
-
-        if (file.getSize() >= offset+size)
-        {
-            LLMeshRepository::sCacheBytesWritten += size;
-            ++LLMeshRepository::sCacheWrites;
-            file.seek(offset);
-            file.write(data, size);
-        }
+        LLMeshRepoThread* thread = gMeshRepo.mThread;
+        thread->decodeFetched(mesh_id, mOffset, mRequestedBytes, data, data_size,
+            [thread, mesh_id](U8* data, S32 data_size)
+            {
+                return thread->decompositionReceived(mesh_id, data, data_size);
+            },
+            on_failure);
     }
     else
     {
-        LL_WARNS(LOG_MESH) << "Error during mesh decomposition processing.  ID:  " << mMeshID
-                           << ", Unknown reason.  Not retrying."
-                           << LL_ENDL;
-        // *TODO:  Mark mesh unavailable on error
+        on_failure(MESH_UNKNOWN);
     }
 }
 
@@ -3399,32 +3641,29 @@ void LLMeshPhysicsShapeHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
                                             U8 * data, S32 data_size)
 {
+    const LLUUID mesh_id = mMeshID;
+    auto on_failure = [mesh_id](EMeshProcessingResult)
+        {
+            LL_WARNS(LOG_MESH) << "Error during mesh physics shape processing.  ID:  " << mesh_id
+                               << ", Unknown reason.  Not retrying."
+                               << LL_ENDL;
+            // *TODO:  Mark mesh unavailable on error
+        };
+
     if ((!MESH_PHYS_SHAPE_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->physicsShapeReceived(mMeshID, data, data_size) == MESH_OK)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        // good fetch from sim, write to cache for caching
-        // <FS:Ansariel> Fix asset caching
-        //LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-        LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-        S32 offset = mOffset;
-        S32 size = mRequestedBytes;
-
-        if (file.getSize() >= offset+size)
-        {
-            LLMeshRepository::sCacheBytesWritten += size;
-            ++LLMeshRepository::sCacheWrites;
-            file.seek(offset);
-            file.write(data, size);
-        }
+        LLMeshRepoThread* thread = gMeshRepo.mThread;
+        thread->decodeFetched(mesh_id, mOffset, mRequestedBytes, data, data_size,
+            [thread, mesh_id](U8* data, S32 data_size)
+            {
+                return thread->physicsShapeReceived(mesh_id, data, data_size);
+            },
+            on_failure);
     }
     else
     {
-        LL_WARNS(LOG_MESH) << "Error during mesh physics shape processing.  ID:  " << mMeshID
-                           << ", Unknown reason.  Not retrying."
-                           << LL_ENDL;
-        // *TODO:  Mark mesh unavailable on error
+        on_failure(MESH_UNKNOWN);
     }
 }
 
@@ -3435,7 +3674,7 @@ LLMeshRepository::LLMeshRepository()
   mThread(NULL),
   mLegacyGetMeshVersion(0)
 {
-    mSkinInfoCullTimer.resetWithExpiry(10.f);
+    mDecodedCacheTimer.resetWithExpiry(1.f);
 }
 
 void LLMeshRepository::init()
@@ -3661,6 +3900,9 @@ void LLMeshRepository::notifyLoadedMeshes()
 { //called from main thread
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK; //LL_RECORD_BLOCK_TIME(FTM_MESH_FETCH);
 
+    static const LLCachedControl<bool> binary_lod_cache(gSavedSettings, "MeshBinaryLODCache", true);
+    LLMeshRepoThread::sBinaryLODCache = binary_lod_cache;
+
     // GetMesh2 operation with keepalives, etc.  With pipelining,
     // we'll increase this.  See llappcorehttp and llcorehttp for
     // discussion on connection strategies.
@@ -3769,26 +4011,9 @@ void LLMeshRepository::notifyLoadedMeshes()
     //call completed callbacks on finished decompositions
     mDecompThread->notifyCompleted();
 
-    if (mSkinInfoCullTimer.checkExpirationAndReset(10.f))
+    if (mDecodedCacheTimer.checkExpirationAndReset(1.f))
     {
-        //// Clean up dead skin info
-        //U64Bytes skinbytes(0);
-        for (auto iter = mSkinMap.begin(), ender = mSkinMap.end(); iter != ender;)
-        {
-            auto copy_iter = iter++;
-
-            //skinbytes += U64Bytes(sizeof(LLMeshSkinInfo));
-            //skinbytes += U64Bytes(copy_iter->second->mJointNames.size() * sizeof(std::string));
-            //skinbytes += U64Bytes(copy_iter->second->mJointNums.size() * sizeof(S32));
-            //skinbytes += U64Bytes(copy_iter->second->mJointNames.size() * sizeof(LLMatrix4a));
-            //skinbytes += U64Bytes(copy_iter->second->mJointNames.size() * sizeof(LLMatrix4));
-
-            if (copy_iter->second->getNumRefs() == 1)
-            {
-                mSkinMap.erase(copy_iter);
-            }
-        }
-        //LL_INFOS() << "Skin info cache elements:" << mSkinMap.size() << " Memory: " << U64Kilobytes(skinbytes) << LL_ENDL;
+        updateDecodedCache();
     }
 
     // For major operations, attempt to get the required locks
@@ -3849,7 +4074,10 @@ void LLMeshRepository::notifyLoadedMeshes()
             mUploadErrorQ.pop();
         }
 
-        S32 active_count = LLMeshRepoThread::sActiveHeaderRequests + LLMeshRepoThread::sActiveLODRequests;
+        // Count decodes still waiting on the pool so a decode backlog
+        // throttles new requests the way a slow network does.
+        S32 active_count = LLMeshRepoThread::sActiveHeaderRequests + LLMeshRepoThread::sActiveLODRequests
+                           + mThread->getDecodesPending();
         if (active_count < LLMeshRepoThread::sRequestLowWater)
         {
             S32 push_count = LLMeshRepoThread::sRequestHighWater - active_count;
@@ -3927,12 +4155,18 @@ void LLMeshRepository::notifyLoadedMeshes()
         mThread->notifyLoadedMeshes();
     }
 
+    sample(LLStatViewer::MESH_REQUEST_QUEUE, LLMeshRepository::sLODPending + LLMeshRepository::sLODProcessing);
+    sample(LLStatViewer::MESH_HTTP_REQUESTS, LLMeshRepoThread::sRequestWaterLevel);
+    sample(LLStatViewer::MESH_DECODE_QUEUE, mThread->getDecodesPending());
+    sample(LLStatViewer::MESH_DECODED_MEMORY, (F64)mDecodedCache.getBytes() / (1024.0 * 1024.0));
+
     mThread->mSignal->signal();
 }
 
 void LLMeshRepository::notifySkinInfoReceived(LLMeshSkinInfo* info)
 {
     mSkinMap[info->mMeshID] = info; // Cache into LLPointer
+    mDecodedCache.touch(info->mMeshID, LLMeshDecodedCache::KIND_SKIN, info->sizeBytes());
     // Alternative: We can get skin size from header
     sCacheBytesSkins += info->sizeBytes();
 
@@ -3975,6 +4209,7 @@ void LLMeshRepository::notifyDecompositionReceived(std::unique_ptr<LLModel::Deco
     { //just insert decomp into map
         mLoadingDecompositions.erase(decomp->mMeshID);
         sCacheBytesDecomps += decomp->sizeBytes();
+        mDecodedCache.touch(decomp->mMeshID, LLMeshDecodedCache::KIND_DECOMPOSITION, decomp->sizeBytes());
         mDecompositionMap[decomp->mMeshID] = std::move(decomp);
     }
     else
@@ -3982,6 +4217,7 @@ void LLMeshRepository::notifyDecompositionReceived(std::unique_ptr<LLModel::Deco
         sCacheBytesDecomps -= iter->second->sizeBytes();
         iter->second->merge(decomp.get());
         sCacheBytesDecomps += iter->second->sizeBytes();
+        mDecodedCache.touch(decomp->mMeshID, LLMeshDecodedCache::KIND_DECOMPOSITION, iter->second->sizeBytes());
 
         mLoadingDecompositions.erase(decomp->mMeshID);
     }
@@ -3994,6 +4230,7 @@ void LLMeshRepository::notifyPhysicsReceived(std::unique_ptr<LLModel::Decomposit
     { //just insert decomp into map
         mLoadingPhysicsShapes.erase(decomp->mMeshID);
         sCacheBytesDecomps += decomp->sizeBytes();
+        mDecodedCache.touch(decomp->mMeshID, LLMeshDecodedCache::KIND_DECOMPOSITION, decomp->sizeBytes());
         mDecompositionMap[decomp->mMeshID] = std::move(decomp);
     }
     else
@@ -4001,6 +4238,7 @@ void LLMeshRepository::notifyPhysicsReceived(std::unique_ptr<LLModel::Decomposit
         sCacheBytesDecomps -= iter->second->sizeBytes();
         iter->second->merge(decomp.get());
         sCacheBytesDecomps += iter->second->sizeBytes();
+        mDecodedCache.touch(decomp->mMeshID, LLMeshDecodedCache::KIND_DECOMPOSITION, iter->second->sizeBytes());
 
         mLoadingPhysicsShapes.erase(decomp->mMeshID);
     }
@@ -4029,6 +4267,7 @@ void LLMeshRepository::notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVol
             {
                 sys_volume->copyVolumeFaces(volume);
                 sys_volume->setMeshAssetLoaded(true);
+                trackDecodedLOD(mesh_params, detail);
                 LLPrimitive::getVolumeManager()->unrefVolume(sys_volume);
             }
             else
@@ -4091,6 +4330,196 @@ void LLMeshRepository::notifyMeshUnavailable(const LLVolumeParams& mesh_params,
     }
 }
 
+// Roughly what a decoded volume holds on to
+static U64 get_volume_bytes(const LLVolume* volume)
+{
+    U64 bytes(0);
+    for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+    {
+        const LLVolumeFace& face = volume->getVolumeFace(i);
+        const U64 vertices = face.mNumAllocatedVertices;
+        bytes += vertices * (sizeof(LLVector4a) * 2 + sizeof(LLVector2));
+        if (face.mTangents)
+        {
+            bytes += vertices * sizeof(LLVector4a);
+        }
+        if (face.mWeights)
+        {
+            bytes += vertices * sizeof(LLVector4a);
+        }
+        bytes += face.mNumIndices * sizeof(U16) + face.mEdge.size() * sizeof(S32);
+        if (face.getOctree())
+        {
+            bytes += (face.mNumIndices / 3) * sizeof(LLVolumeTriangle);
+        }
+    }
+    return bytes;
+}
+
+// Bytes of the loaded lod of every variant whose group is still around
+static U64 get_decoded_lod_bytes(const std::vector<LLVolumeParams>& variants, S32 lod)
+{
+    U64 bytes(0);
+    for (const LLVolumeParams& params : variants)
+    {
+        LLVolumeLODGroup* group = LLPrimitive::getVolumeManager()->getGroup(params);
+        LLVolume* volume = group ? group->peekLOD(lod) : NULL;
+        if (volume && volume->isMeshAssetLoaded())
+        {
+            bytes += get_volume_bytes(volume);
+        }
+    }
+    return bytes;
+}
+
+void LLMeshRepository::trackDecodedLOD(const LLVolumeParams& mesh_params, S32 lod)
+{
+    const LLUUID& mesh_id = mesh_params.getSculptID();
+    std::vector<LLVolumeParams>& variants = mDecodedLODParams[mesh_id];
+    if (std::find(variants.begin(), variants.end(), mesh_params) == variants.end())
+    {
+        variants.push_back(mesh_params);
+    }
+    mDecodedCache.touch(mesh_id, lod, get_decoded_lod_bytes(variants, lod));
+}
+
+void LLMeshRepository::touchDecodedLOD(const LLUUID& mesh_id, S32 lod)
+{
+    mDecodedCache.touch(mesh_id, lod);
+}
+
+bool LLMeshRepository::hasOtherDecodedLODs(const LLUUID& mesh_id, S32 lod) const
+{
+    for (S32 other = LLMeshDecodedCache::KIND_LOD_LOWEST; other <= LLMeshDecodedCache::KIND_LOD_HIGH; ++other)
+    {
+        if (other != lod && mDecodedCache.has(mesh_id, other))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+U64 LLMeshRepository::measureDecoded(const LLMeshDecodedCache::Key& key, U64 bytes)
+{
+    if (key.mKind == LLMeshDecodedCache::KIND_SKIN)
+    {
+        return mSkinMap.count(key.mID) ? bytes : 0;
+    }
+
+    if (key.mKind == LLMeshDecodedCache::KIND_DECOMPOSITION)
+    {
+        return mDecompositionMap.count(key.mID) ? bytes : 0;
+    }
+
+    decoded_params_map::iterator iter = mDecodedLODParams.find(key.mID);
+    if (iter == mDecodedLODParams.end())
+    {
+        return 0;
+    }
+
+    // LLVolumeMgr deletes a group along with the last volume using it,
+    // without telling anyone
+    std::vector<LLVolumeParams>& variants = iter->second;
+    variants.erase(std::remove_if(variants.begin(), variants.end(), [](const LLVolumeParams& params)
+        {
+            return LLPrimitive::getVolumeManager()->getGroup(params) == NULL;
+        }), variants.end());
+    if (variants.empty())
+    {
+        mDecodedLODParams.erase(iter);
+        return 0;
+    }
+    return get_decoded_lod_bytes(variants, key.mKind);
+}
+
+U64 LLMeshRepository::evictDecoded(const LLMeshDecodedCache::Key& key, U64 bytes)
+{
+    if (key.mKind == LLMeshDecodedCache::KIND_SKIN)
+    {
+        skin_map::iterator iter = mSkinMap.find(key.mID);
+        if (iter != mSkinMap.end())
+        {
+            if (iter->second->getNumRefs() > 1)
+            { // an object still has it
+                return bytes;
+            }
+            mSkinMap.erase(iter);
+        }
+        return 0;
+    }
+
+    if (key.mKind == LLMeshDecodedCache::KIND_DECOMPOSITION)
+    {
+        LLMutexLock lock(mMeshMutex);
+        if (mLoadingDecompositions.count(key.mID) || mLoadingPhysicsShapes.count(key.mID))
+        { // more is on the way to be merged in
+            return bytes;
+        }
+        mDecompositionMap.erase(key.mID);
+        return 0;
+    }
+
+    decoded_params_map::iterator iter = mDecodedLODParams.find(key.mID);
+    if (iter == mDecodedLODParams.end())
+    {
+        return 0;
+    }
+
+    // Variants still drawn at this LOD keep theirs
+    for (const LLVolumeParams& params : iter->second)
+    {
+        LLVolumeLODGroup* group = LLPrimitive::getVolumeManager()->getGroup(params);
+        if (group)
+        {
+            group->evictLOD(key.mKind);
+        }
+    }
+
+    const U64 kept = get_decoded_lod_bytes(iter->second, key.mKind);
+    if (kept == 0 && !hasOtherDecodedLODs(key.mID, key.mKind))
+    {
+        mDecodedLODParams.erase(iter);
+    }
+    return kept;
+}
+
+void LLMeshRepository::updateDecodedCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_MEMORY;
+
+    static LLCachedControl<U32> cache_size(gSavedSettings, "MeshDecodedCacheSize", 256);
+    static LLCachedControl<U32> low_memory(gSavedSettings, "MeshDecodedCacheLowMemory", 1024);
+
+    // Below MeshDecodedCacheLowMemory of free memory the budget shrinks
+    // along with it, until only what's in use is kept
+    U64 budget = (U64)cache_size * 1024 * 1024;
+    if (low_memory > 0)
+    {
+        LLMemory::updateMemoryInfo();
+        const U64 available_mb = LLMemory::getAvailableMemKB().value() / 1024;
+        if (available_mb < low_memory)
+        {
+            budget = budget * available_mb / low_memory;
+        }
+    }
+    mDecodedCache.setBudget(budget);
+
+    mDecodedCache.refresh([this](const LLMeshDecodedCache::Key& key, U64 bytes)
+        {
+            return measureDecoded(key, bytes);
+        });
+    const U64 freed = mDecodedCache.trim([this](const LLMeshDecodedCache::Key& key, U64 bytes)
+        {
+            return evictDecoded(key, bytes);
+        });
+    if (freed > 0)
+    {
+        LL_DEBUGS(LOG_MESH) << "Evicted " << freed << " bytes of decoded mesh data, "
+                            << mDecodedCache.getBytes() << " of " << budget << " left" << LL_ENDL;
+    }
+}
+
 S32 LLMeshRepository::getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 {
     return mThread->getActualMeshLOD(mesh_params, lod);
@@ -4104,6 +4533,7 @@ LLMeshSkinInfo* LLMeshRepository::getSkinInfo(const LLUUID& mesh_id, LLVOVolume*
         skin_map::iterator iter = mSkinMap.find(mesh_id);
         if (iter != mSkinMap.end())
         {
+            mDecodedCache.touch(mesh_id, LLMeshDecodedCache::KIND_SKIN);
             return iter->second.get();
         }
 
@@ -4146,6 +4576,7 @@ void LLMeshRepository::fetchPhysicsShape(const LLUUID& mesh_id)
         if (iter != mDecompositionMap.end())
         {
             decomp = iter->second.get();
+            mDecodedCache.touch(mesh_id, LLMeshDecodedCache::KIND_DECOMPOSITION);
         }
 
         // physics block hasn't been fetched yet
@@ -4175,6 +4606,7 @@ LLModel::Decomposition* LLMeshRepository::getDecomposition(const LLUUID& mesh_id
         if (iter != mDecompositionMap.end())
         {
             ret = iter->second.get();
+            mDecodedCache.touch(mesh_id, LLMeshDecodedCache::KIND_DECOMPOSITION);
         }
 
         //decomposition block hasn't been fetched yet
@@ -27,8 +27,11 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <atomic>
+#include <functional>
 #include <unordered_map>
 #include "llassettype.h"
+#include "llmeshdecodedcache.h"
 #include "llmodel.h"
 #include "lluuid.h"
 #include "llviewertexture.h"
@@ -40,9 +43,11 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool.h"
 
 #include "boost/unordered/unordered_map.hpp"
 #include "boost/unordered/unordered_flat_map.hpp"
+#include "boost/unordered/unordered_flat_set.hpp"
 #include "boost/unordered/unordered_node_map.hpp"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
@@ -265,6 +270,7 @@ class LLMeshRepoThread final : public LLThread
     static S32 sRequestLowWater;
     static S32 sRequestHighWater;
     static S32 sRequestWaterLevel;          // Stats-use only, may read outside of thread
+    static bool sBinaryLODCache;            // Set from MeshBinaryLODCache by main thread
 
     LLMutex*    mMutex;
     LLMutex*    mHeaderMutex;
@@ -398,11 +404,32 @@ class LLMeshRepoThread final : public LLThread
     typedef boost::unordered_map<LLUUID, std::vector<S32>> pending_lod_map;
     pending_lod_map mPendingLOD;
 
+    // Decoding of LOD, skin, decomposition and physics data runs on the
+    // "MeshDecode" thread pool so one large mesh doesn't hold up requests
+    // behind it.  Headers are still parsed on the repo thread.
+    std::unique_ptr<LL::ThreadPool> mDecodePool;
+    std::atomic<S32> mDecodesPending;
+
+    // meshes whose cached data failed to decode, fetched from the simulator from now on
+    boost::unordered_flat_set<LLUUID> mCacheFailures;
+
     // llcorehttp library interface objects.
     LLCore::HttpStatus                  mHttpStatus;
     LLCore::HttpRequest *               mHttpRequest;
-    LLCore::HttpOptions::ptr_t          mHttpOptions;
-    LLCore::HttpOptions::ptr_t          mHttpLargeOptions;
+    // What a fetch is for, which sets its HTTP/2 stream weight when the
+    // mesh classes multiplex (HttpMultiplexStreams)
+    enum EFetchPriority
+    {
+        FETCH_HEADER = 0,       // everything else about the mesh waits on it
+        FETCH_SKIN,
+        FETCH_LOD_LOW,          // lowest and low LODs, so something shows soon
+        FETCH_LOD_HIGH,         // medium and high LODs
+        FETCH_PHYSICS,          // decomposition and physics shape
+        FETCH_PRIORITY_COUNT
+    };
+
+    LLCore::HttpOptions::ptr_t          mHttpOptions[FETCH_PRIORITY_COUNT];
+    LLCore::HttpOptions::ptr_t          mHttpLargeOptions[FETCH_PRIORITY_COUNT];
     LLCore::HttpHeaders::ptr_t          mHttpHeaders;
     LLCore::HttpRequest::policy_t       mHttpPolicyClass;
     LLCore::HttpRequest::policy_t       mHttpLegacyPolicyClass;
@@ -435,7 +462,37 @@ class LLMeshRepoThread final : public LLThread
     bool hasSkinInfoInHeader(const LLUUID& mesh_id);
     bool hasHeader(const LLUUID& mesh_id);
 
-    bool loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn);
+    typedef std::function<EMeshProcessingResult(U8* data, S32 data_size)> decode_fn_t;
+
+    // Read a mesh component from the cache and decode it on the decode pool.
+    // Returns false if the cache can't supply it.  If decoding fails, retry
+    // is invoked (on a pool thread) to put the request back in its queue so
+    // that it is fetched from the simulator instead.
+    //
+    // Threads:  repo
+    bool loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, decode_fn_t decode, std::function<void()> retry);
+
+    // Copy fetched data and decode it on the decode pool, writing it to the
+    // cache if it decodes.  on_failure is invoked on a pool thread if not.
+    //
+    // Threads:  repo
+    void decodeFetched(const LLUUID& mesh_id, S32 offset, S32 size, const U8* data, S32 data_size,
+                       decode_fn_t decode, std::function<void(EMeshProcessingResult)> on_failure);
+
+    // Decode jobs posted but not yet finished
+    S32 getDecodesPending() const { return mDecodesPending; }
+
+    // Besides the asset itself, the disk cache keeps a binary copy of each
+    // decoded LOD (see LLVolume::packBinaryFaces()) under an id derived
+    // from the mesh id, LOD and mirror/invert flags.  Loading one skips the
+    // inflate, LLSD parse, unpack and cache optimize of the asset.
+    static LLUUID getBinaryLODCacheID(const LLVolumeParams& mesh_params, S32 lod);
+
+    // Threads:  repo
+    bool loadLODFromBinaryCache(const LLVolumeParams& mesh_params, S32 lod);
+
+    // Threads:  decode
+    void writeLODToBinaryCache(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume);
 
     void notifyLoadedMeshes(); // Only call from main thread.
     S32 getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
@@ -471,6 +528,10 @@ class LLMeshRepoThread final : public LLThread
     void constructUrl(LLUUID mesh_id, std::string * url, int * legacy_version);
 
 private:
+    // Run decode on the decode pool, keeping mDecodesPending current.
+    // Returns false if the pool has shut down.
+    bool postDecode(std::function<void()> decode);
+
     // Issue a GET request to a URL with 'Range' header using
     // the correct policy class and other attributes.  If an invalid
     // handle is returned, the request failed and caller must retry
@@ -478,7 +539,7 @@ class LLMeshRepoThread final : public LLThread
     //
     // Threads:  Repo thread only
     LLCore::HttpHandle getByteRange(const std::string & url, int legacy_cap_version,
-                                    size_t offset, size_t len,
+                                    size_t offset, size_t len, EFetchPriority priority,
                                     const LLCore::HttpHandler::ptr_t &handler);
 };
 
@@ -644,12 +705,14 @@ class LLMeshRepository
     static U32 sLODPending;
     static U32 sLODProcessing;
     static U32 sCacheBytesRead;
-    static U32 sCacheBytesWritten;
+    static std::atomic<U32> sCacheBytesWritten;     // Written from the decode pool
     static U32 sCacheBytesHeaders;
     static U32 sCacheBytesSkins;
     static U32 sCacheBytesDecomps;
     static U32 sCacheReads;
-    static U32 sCacheWrites;
+    static std::atomic<U32> sCacheWrites;
+    static std::atomic<U32> sBinaryCacheHits;   // LODs loaded from their binary cache entry
+    static std::atomic<U32> sBinaryCacheWrites;
     static U32 sMaxLockHoldoffs;                // Maximum sequential locking failures
 
     static LLDeadmanTimer sQuiescentTimer;      // Time-to-complete-mesh-downloads after significant events
@@ -676,6 +739,8 @@ class LLMeshRepository
     void notifyLoadedMeshes();
     void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume);
     void notifyMeshUnavailable(const LLVolumeParams& mesh_params, S32 lod);
+    // An object switched to a LOD that was already loaded
+    void touchDecodedLOD(const LLUUID& mesh_id, S32 lod);
     void notifySkinInfoReceived(LLMeshSkinInfo* info);
     void notifySkinInfoUnavailable(const LLUUID& info);
     void notifyDecompositionReceived(std::unique_ptr<LLModel::Decomposition> info);
@@ -750,7 +815,22 @@ class LLMeshRepository
 
     LLPhysicsDecomp* mDecompThread;
 
-    LLFrameTimer     mSkinInfoCullTimer;
+    // Decoded LODs, skin info and decompositions in use order.  Once a
+    // second anything over MeshDecodedCacheSize that no object is using is
+    // dropped, to be loaded from the disk cache again when it's next asked
+    // for.  The budget shrinks when the system runs low on memory.
+    LLMeshDecodedCache mDecodedCache;
+    LLFrameTimer     mDecodedCacheTimer;
+
+    // Volume params each mesh's decoded LODs were loaded for, usually one
+    typedef boost::unordered_flat_map<LLUUID, std::vector<LLVolumeParams>> decoded_params_map;
+    decoded_params_map mDecodedLODParams;
+
+    void updateDecodedCache();
+    void trackDecodedLOD(const LLVolumeParams& mesh_params, S32 lod);
+    bool hasOtherDecodedLODs(const LLUUID& mesh_id, S32 lod) const;
+    U64 measureDecoded(const LLMeshDecodedCache::Key& key, U64 bytes);
+    U64 evictDecoded(const LLMeshDecodedCache::Key& key, U64 bytes);
 
     class inventory_data
     {
@@ -1854,8 +1854,8 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         mModel[lod].resize(mBaseModel.size());
         mVertexBuffer[lod].clear();
 
-
-        for (U32 mdl_idx = 0; mdl_idx < mBaseModel.size(); ++mdl_idx)
+        // Each model only writes to its own slot, so simplify them side by side
+        LLModelLoader::forEachParallel(mBaseModel.size(), [&](size_t mdl_idx)
         {
             LLModel* base = mBaseModel[mdl_idx];
 
@@ -2043,7 +2043,7 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
             {
                 LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
             }
-        }
+        });
 
         //rebuild scene based on mBaseScene
         mScene[lod].clear();
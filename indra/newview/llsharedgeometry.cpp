@@ -0,0 +1,88 @@
+/**
+ * @file llsharedgeometry.cpp
+ * @brief Vertex buffers shared between identical rigged mesh faces
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llsharedgeometry.h"
+
+#include "llmodel.h"
+#include "llvertexbuffer.h"
+#include "llvolume.h"
+
+std::size_t hash_value(const LLSharedGeometryCache::Key& key)
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.mVolume);
+    boost::hash_combine(seed, key.mSkinInfo);
+    boost::hash_combine(seed, key.mFace);
+    boost::hash_combine(seed, key.mMask);
+    boost::hash_combine(seed, key.mColor);
+    boost::hash_combine(seed, key.mMaterialHash);
+    boost::hash_combine(seed, key.mOffsetS);
+    boost::hash_combine(seed, key.mOffsetT);
+    return seed;
+}
+
+bool LLSharedGeometryCache::Key::operator==(const Key& rhs) const
+{
+    return mVolume == rhs.mVolume && mSkinInfo == rhs.mSkinInfo && mFace == rhs.mFace && mMask == rhs.mMask &&
+        mColor == rhs.mColor && mShiny == rhs.mShiny && mGlow == rhs.mGlow && mInAlphaPool == rhs.mInAlphaPool &&
+        mMaterialHash == rhs.mMaterialHash && mRotation == rhs.mRotation &&
+        mOffsetS == rhs.mOffsetS && mOffsetT == rhs.mOffsetT && mScaleS == rhs.mScaleS && mScaleT == rhs.mScaleT;
+}
+
+LLSharedGeometryCache::Entry* LLSharedGeometryCache::find(const Key& key, U32 num_verts, U32 num_indices)
+{
+    entry_map_t::iterator iter = mEntries.find(key);
+    if (iter == mEntries.end() ||
+        iter->second.mBuffer->getNumVerts() < num_verts ||
+        iter->second.mBuffer->getNumIndices() < num_indices)
+    {
+        return nullptr;
+    }
+    return &iter->second;
+}
+
+void LLSharedGeometryCache::add(const Key& key, LLVertexBuffer* buffer, const LLVector2* tex_extents)
+{
+    Entry& entry = mEntries[key];
+    entry.mBuffer = buffer;
+    entry.mVolume = const_cast<LLVolume*>(key.mVolume);
+    entry.mSkinInfo = key.mSkinInfo;
+    entry.mTexExtents[0] = tex_extents[0];
+    entry.mTexExtents[1] = tex_extents[1];
+}
+
+void LLSharedGeometryCache::clear()
+{
+    mEntries.clear();
+}
+
+void LLSharedGeometryCache::sweep()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+    boost::unordered::erase_if(mEntries, [](const entry_map_t::value_type& entry)
+        {
+            return entry.second.mBuffer->getNumRefs() == 1;
+        });
+}
@@ -0,0 +1,97 @@
+/**
+ * @file llsharedgeometry.h
+ * @brief Vertex buffers shared between identical rigged mesh faces
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSHAREDGEOMETRY_H
+#define LL_LLSHAREDGEOMETRY_H
+
+#include "llpointer.h"
+#include "lluuid.h"
+#include "v2math.h"
+
+#include "boost/unordered/unordered_flat_map.hpp"
+
+class LLMeshSkinInfo;
+class LLVertexBuffer;
+class LLVolume;
+
+// Rigged faces are built in bind space rather than where they're worn, so
+// every copy of a mesh worn with the same texture entry produces the same
+// vertex data.  Those faces draw from one shared buffer; the avatar and
+// skin that make each copy different are already per draw info.
+//
+// Only rigged faces qualify.  Static prims and unrigged meshes are baked
+// into region space, so no two of them have the same vertex data.
+class LLSharedGeometryCache
+{
+public:
+    // Everything a rigged face's vertex data depends on
+    struct Key
+    {
+        const LLVolume* mVolume = nullptr;
+        const LLMeshSkinInfo* mSkinInfo = nullptr;
+        S32 mFace = 0;
+        U32 mMask = 0;
+        U32 mColor = 0;
+        U8 mShiny = 0;
+        U8 mGlow = 0;
+        bool mInAlphaPool = false;
+        LLUUID mMaterialHash;
+        F32 mRotation = 0.f;
+        F32 mOffsetS = 0.f;
+        F32 mOffsetT = 0.f;
+        F32 mScaleS = 1.f;
+        F32 mScaleT = 1.f;
+
+        friend std::size_t hash_value(const Key& key);
+        bool operator==(const Key& rhs) const;
+    };
+
+    struct Entry
+    {
+        LLPointer<LLVertexBuffer> mBuffer;
+        // keep the key's volume and skin alive so their addresses can't be reused
+        LLPointer<LLVolume> mVolume;
+        LLConstPointer<LLMeshSkinInfo> mSkinInfo;
+        LLVector2 mTexExtents[2];
+    };
+
+    // The entry for key, if its buffer holds at least num_verts vertices
+    // and num_indices indices
+    Entry* find(const Key& key, U32 num_verts, U32 num_indices);
+
+    // Share buffer, filled for key, with the faces that come after
+    void add(const Key& key, LLVertexBuffer* buffer, const LLVector2* tex_extents);
+
+    // Forget buffers no face draws from anymore, along with the volumes
+    // and skins they keep alive
+    void sweep();
+
+    void clear();
+    U32 size() const { return (U32)mEntries.size(); }
+
+private:
+    typedef boost::unordered_flat_map<Key, Entry> entry_map_t;
+    entry_map_t mEntries;
+};
+
+#endif // LL_LLSHAREDGEOMETRY_H
@@ -0,0 +1,278 @@
+/**
+ * @file llskinningkernel.cpp
+ * @brief Block skinning of rigged mesh positions
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+// The LLSkinningUtil functions that only need a matrix palette, kept apart
+// from the ones that need an avatar so they can be tested on their own
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llskinningutil.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+void LLSkinningUtil::applyBindShapeMatrix(LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape)
+{
+    for (U32 j = 0; j < count; ++j)
+    {
+        LLMatrix4a joint_mat = mat[j];
+        mat[j].setMul(joint_mat, bind_shape);
+    }
+}
+
+namespace
+{
+    const U32 BLOCK_SIZE = LLSkinningUtil::SKIN_BLOCK_SIZE;
+
+    // Joint indices and normalized weights of one block of vertices
+    struct SkinBlock
+    {
+        alignas(16) F32 mWeight[4][BLOCK_SIZE];     // [influence][vertex]
+        alignas(16) S32 mJoint[BLOCK_SIZE][4];      // [vertex][influence]
+    };
+
+    // Same unpacking as getPerVertexSkinMatrixUnchecked(), but transposed
+    // so the weights of four vertices are normalized together
+    void unpack_block(const LLVector4a* weights, SkinBlock& block)
+    {
+        const LLIVector4a max_joint_count((S16)(LLSkinningUtil::getMaxJointCount() - 1));
+        LLVector4a w[4];
+        for (U32 v = 0; v < BLOCK_SIZE; ++v)
+        {
+            LLIVector4a joint;
+            joint.setFloatTrunc(weights[v]);
+            w[v].setSub(weights[v], joint);
+            joint.min16(max_joint_count);
+            joint.max16(LLIVector4a::getZero());
+            joint.store128a(block.mJoint[v]);
+        }
+
+        LLQuad w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3];
+        _MM_TRANSPOSE4_PS(w0, w1, w2, w3);
+
+        LLVector4a lo, hi, scale;
+        lo.setAdd(LLVector4a(w0), LLVector4a(w2));
+        hi.setAdd(LLVector4a(w1), LLVector4a(w3));
+        scale.setAdd(lo, hi);
+
+        LLVector4a weight;
+        weight.setDiv(LLVector4a(w0), scale);
+        weight.store4a(block.mWeight[0]);
+        weight.setDiv(LLVector4a(w1), scale);
+        weight.store4a(block.mWeight[1]);
+        weight.setDiv(LLVector4a(w2), scale);
+        weight.store4a(block.mWeight[2]);
+        weight.setDiv(LLVector4a(w3), scale);
+        weight.store4a(block.mWeight[3]);
+    }
+
+    inline void skin_vertex(const LLVector4a& pos, const SkinBlock& block, U32 v, const LLMatrix4a* mat, LLVector4a& dst)
+    {
+        const S32* joint = block.mJoint[v];
+        LLMatrix4a final_mat;
+        final_mat.setMul(mat[joint[0]], block.mWeight[0][v]);
+        final_mat.setMulAdd(mat[joint[1]], LLVector4a(block.mWeight[1][v]));
+        final_mat.setMulAdd(mat[joint[2]], LLVector4a(block.mWeight[2][v]));
+        final_mat.setMulAdd(mat[joint[3]], LLVector4a(block.mWeight[3][v]));
+        final_mat.affineTransform(pos, dst);
+    }
+
+#if defined(__AVX2__)
+    inline __m256 lanes(LLQuad lo, LLQuad hi)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    // Vertices v and v + 1 of a block, one per 128 bit lane.  The operations
+    // are the same as skin_vertex() so both paths give the same results.
+    inline void skin_vertex_pair(const LLVector4a* pos, const SkinBlock& block, U32 v, const LLMatrix4a* mat, LLVector4a* dst)
+    {
+        const S32* joint_a = block.mJoint[v];
+        const S32* joint_b = block.mJoint[v + 1];
+        __m256 col[4];
+        for (U32 k = 0; k < 4; ++k)
+        {
+            const __m256 w = lanes(_mm_set1_ps(block.mWeight[k][v]), _mm_set1_ps(block.mWeight[k][v + 1]));
+            const LLMatrix4a& mat_a = mat[joint_a[k]];
+            const LLMatrix4a& mat_b = mat[joint_b[k]];
+            for (U32 c = 0; c < 4; ++c)
+            {
+                const __m256 m = _mm256_mul_ps(lanes(mat_a.mMatrix[c], mat_b.mMatrix[c]), w);
+                col[c] = k == 0 ? m : _mm256_add_ps(col[c], m);
+            }
+        }
+
+        const __m256 p = lanes(pos[0], pos[1]);
+        __m256 x = _mm256_mul_ps(_mm256_permute_ps(p, 0x00), col[0]);
+        const __m256 y = _mm256_mul_ps(_mm256_permute_ps(p, 0x55), col[1]);
+        __m256 z = _mm256_mul_ps(_mm256_permute_ps(p, 0xaa), col[2]);
+        x = _mm256_add_ps(x, y);
+        z = _mm256_add_ps(z, col[3]);
+        const __m256 res = _mm256_add_ps(x, z);
+        dst[0] = _mm256_castps256_ps128(res);
+        dst[1] = _mm256_extractf128_ps(res, 1);
+    }
+#endif
+
+    inline void skin_block(const LLVector4a* pos, const SkinBlock& block, const LLMatrix4a* mat, LLVector4a* dst)
+    {
+#if defined(__AVX2__)
+        skin_vertex_pair(pos, block, 0, mat, dst);
+        skin_vertex_pair(pos + 2, block, 2, mat, dst + 2);
+#else
+        for (U32 v = 0; v < BLOCK_SIZE; ++v)
+        {
+            skin_vertex(pos[v], block, v, mat, dst[v]);
+        }
+#endif
+    }
+
+    // Skins block b of count vertices, padding a partial last block with
+    // copies of its first vertex.  Returns how many of dst are real.
+    U32 skin_block_at(const LLVector4a* pos, const LLVector4a* weights, U32 count, U32 b, const LLMatrix4a* mat, LLVector4a* dst)
+    {
+        const U32 first = b * BLOCK_SIZE;
+        const U32 num = llmin(count - first, BLOCK_SIZE);
+        SkinBlock block;
+        if (num == BLOCK_SIZE)
+        {
+            unpack_block(weights + first, block);
+            skin_block(pos + first, block, mat, dst);
+        }
+        else
+        {
+            LLVector4a tail_pos[BLOCK_SIZE];
+            LLVector4a tail_weights[BLOCK_SIZE];
+            for (U32 v = 0; v < BLOCK_SIZE; ++v)
+            {
+                tail_pos[v] = pos[first + (v < num ? v : 0)];
+                tail_weights[v] = weights[first + (v < num ? v : 0)];
+            }
+            unpack_block(tail_weights, block);
+            skin_block(tail_pos, block, mat, dst);
+        }
+        return num;
+    }
+}
+
+void LLSkinningUtil::skinPositions(const LLVector4a* pos, const LLVector4a* weights, U32 count, const LLMatrix4a* mat, LLVector4a* dst)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    const U32 full_blocks = count / BLOCK_SIZE;
+    for (U32 b = 0; b < full_blocks; ++b)
+    {
+        SkinBlock block;
+        unpack_block(weights + b * BLOCK_SIZE, block);
+        skin_block(pos + b * BLOCK_SIZE, block, mat, dst + b * BLOCK_SIZE);
+    }
+
+    if (full_blocks * BLOCK_SIZE < count)
+    {
+        LLVector4a tail[BLOCK_SIZE];
+        const U32 num = skin_block_at(pos, weights, count, full_blocks, mat, tail);
+        for (U32 v = 0; v < num; ++v)
+        {
+            dst[full_blocks * BLOCK_SIZE + v] = tail[v];
+        }
+    }
+}
+
+void LLSkinningUtil::getExtremeVertices(const LLVector4a* pos, U32 count, U32* extremes)
+{
+    for (U32 i = 0; i < NUM_EXTREME_VERTICES; ++i)
+    {
+        extremes[i] = 0;
+    }
+    for (U32 j = 1; j < count; ++j)
+    {
+        const F32* p = pos[j].getF32ptr();
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            if (p[axis] < pos[extremes[axis * 2]][axis])
+            {
+                extremes[axis * 2] = j;
+            }
+            if (p[axis] > pos[extremes[axis * 2 + 1]][axis])
+            {
+                extremes[axis * 2 + 1] = j;
+            }
+        }
+    }
+}
+
+void LLSkinningUtil::getSkinnedExtents(const LLVector4a* pos, const LLVector4a* weights, U32 count, const LLMatrix4a* mat,
+                                       U32 block_stride, LLVector4a& min, LLVector4a& max,
+                                       const U32* extra_vertices, U32 extra_count)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    if (count == 0)
+    {
+        min.clear();
+        max.clear();
+        return;
+    }
+
+    const U32 num_blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    block_stride = llmax(block_stride, 1U);
+
+    // A padded partial block repeats a real vertex, so all of it counts
+    LLVector4a skinned[BLOCK_SIZE];
+    skin_block_at(pos, weights, count, 0, mat, skinned);
+    min = skinned[0];
+    max = skinned[0];
+    for (U32 b = 0; ; )
+    {
+        for (U32 v = 0; v < BLOCK_SIZE; ++v)
+        {
+            min.setMin(min, skinned[v]);
+            max.setMax(max, skinned[v]);
+        }
+
+        if (b == num_blocks - 1)
+        {
+            break;
+        }
+        // Sampling always finishes on the last block
+        b = llmin(b + block_stride, num_blocks - 1);
+        skin_block_at(pos, weights, count, b, mat, skinned);
+    }
+
+    for (U32 i = 0; i < extra_count; ++i)
+    {
+        const U32 b = extra_vertices[i] / BLOCK_SIZE;
+        if (extra_vertices[i] >= count || b % block_stride == 0 || b == num_blocks - 1)
+        {
+            // Out of range or already sampled
+            continue;
+        }
+        skin_block_at(pos, weights, count, b, mat, skinned);
+        for (U32 v = 0; v < BLOCK_SIZE; ++v)
+        {
+            min.setMin(min, skinned[v]);
+            max.setMax(max, skinned[v]);
+        }
+    }
+}
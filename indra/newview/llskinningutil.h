@@ -154,6 +154,35 @@ namespace LLSkinningUtil
         final_mat.setMulAdd(mat[idx[3]], weight.getVectorAt<3>());
     }
 
+    // Folds the bind shape matrix into a palette from initSkinningMatrixPalette(),
+    // so that skinPositions() needs one transform per vertex instead of two
+    void applyBindShapeMatrix(LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape);
+
+    // Batch form of getPerVertexSkinMatrixUnchecked() plus the position
+    // transform.  Vertices are skinned SKIN_BLOCK_SIZE at a time, unpacking
+    // and normalizing the weights of a whole block at once; AVX2 builds
+    // blend two vertices per instruction.  mat must have been through
+    // applyBindShapeMatrix() and the weights through checkSkinWeights().
+    const U32 SKIN_BLOCK_SIZE = 4;
+    void skinPositions(const LLVector4a* pos, const LLVector4a* weights, U32 count, const LLMatrix4a* mat, LLVector4a* dst);
+
+    // Indices of the vertices with the smallest and largest x, y and z, in
+    // that order
+    const U32 NUM_EXTREME_VERTICES = 6;
+    void getExtremeVertices(const LLVector4a* pos, U32 count, U32* extremes);
+
+    // Extents of the skinned positions without storing them.  A block_stride
+    // above 1 only skins every block_stride'th block, plus the last block
+    // and the blocks holding the extra vertices, which gives a cheaper
+    // estimate the caller is expected to pad.  Passing the bind pose
+    // extremes from getExtremeVertices() makes the estimate exact when the
+    // whole face moves as one under a positive scale and translation;
+    // joints moving apart or rotating can still take a skipped vertex
+    // outside of it.
+    void getSkinnedExtents(const LLVector4a* pos, const LLVector4a* weights, U32 count, const LLMatrix4a* mat,
+                           U32 block_stride, LLVector4a& min, LLVector4a& max,
+                           const U32* extra_vertices = nullptr, U32 extra_count = 0);
+
     // This is used for extracting rotation from a bind shape matrix that
     // already has scales baked in
     inline LLQuaternion getUnscaledQuaternion(const LLMatrix4& mat4)
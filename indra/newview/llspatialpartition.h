@@ -665,6 +665,12 @@ class LLVolumeGeometryManager: public LLGeometryManager
     U32 genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace** faces, U32 face_count, BOOL distance_sort = FALSE, BOOL batch_textures = FALSE, BOOL rigged = FALSE);
     void registerFace(LLSpatialGroup* group, LLFace* facep, U32 type);
 
+    // Drop all vertex buffers shared between identical rigged faces
+    static void clearSharedGeometry();
+    // Once a frame: at most once a second, drop the shared buffers no face
+    // uses anymore
+    static void sweepSharedGeometry();
+
 private:
     void allocateFaces(U32 pMaxFaceCount);
     void freeFaces();
@@ -67,6 +67,7 @@
 #include "llmd5.h"
 #include "llmemorystream.h"
 #include "llmessageconfig.h"
+#include "llmessagelog.h"
 #include "llmoveview.h"
 #include "llfloaterimcontainer.h"
 #include "llfloaterimnearbychat.h"
@@ -650,6 +651,19 @@ bool idle_startup()
                 msg->startLogging();
             }
 
+            const std::string capture_file = gSavedSettings.getString("MessageCaptureFile");
+            if (!capture_file.empty())
+            {
+                if (LLMessageLog::startCapture(capture_file))
+                {
+                    LL_INFOS("AppInit") << "Capturing message traffic to " << capture_file << LL_ENDL;
+                }
+                else
+                {
+                    LL_WARNS("AppInit") << "Unable to capture message traffic to " << capture_file << LL_ENDL;
+                }
+            }
+
             // start the xfer system. by default, choke the downloads
             // a lot...
             const S32 VIEWER_MAX_XFER = 3;
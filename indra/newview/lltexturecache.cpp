@@ -33,6 +33,8 @@
 #include "llimage.h"
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
+#include "lltexturedecodedcache.h"
+#include "lltextureslabstore.h"
 #include "llviewercontrol.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
@@ -46,6 +48,10 @@
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
+// cache/textures/slabs/
+//  Or, with TextureCacheSlabStore, all bodies packed in memory mapped slabs
+// cache/textures/decoded/[0-F]/UUID_discard.dec
+//  Decoded pixels, see LLTextureDecodedCache
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
@@ -448,8 +454,7 @@ bool LLTextureCacheRemoteWorker::doRead()
     // Fourth state / stage : read the rest of the data from the UUID based cached file
     if (!done && (mState == BODY))
     {
-        std::string filename = mCache->getTextureFileName(mID);
-        S32 filesize = LLAPRFile::size(filename, mCache->getLocalAPRFilePool());
+        S32 filesize = mCache->getBodySize(mID, mCache->getLocalAPRFilePool());
 
         if (filesize && (filesize + TEXTURE_CACHE_ENTRY_SIZE) > mOffset)
         {
@@ -490,10 +495,10 @@ bool LLTextureCacheRemoteWorker::doRead()
                 mReadData = data;
 
                 // Read the data at last
-                S32 bytes_read = LLAPRFile::readEx(filename,
-                                                 mReadData + data_offset,
-                                                 file_offset, file_size,
-                                                 mCache->getLocalAPRFilePool());
+                S32 bytes_read = mCache->readBody(mID,
+                                                  mReadData + data_offset,
+                                                  file_offset, file_size,
+                                                  mCache->getLocalAPRFilePool());
                 if (bytes_read != file_size)
                 {
                     LL_WARNS() << "LLTextureCacheWorker: "  << mID
@@ -519,7 +524,7 @@ bool LLTextureCacheRemoteWorker::doRead()
         {
             // No body, we're done.
             mDataSize = llmax(TEXTURE_CACHE_ENTRY_SIZE - mOffset, 0);
-            LL_DEBUGS() << "No body file for: " << filename << LL_ENDL;
+            LL_DEBUGS() << "No body file for: " << mID << LL_ENDL;
         }
         // Nothing else to do at that point...
         done = true;
@@ -683,13 +688,10 @@ bool LLTextureCacheRemoteWorker::doWrite()
             S32 file_size = mDataSize - TEXTURE_CACHE_ENTRY_SIZE;
 
             {
-                // build the cache file name from the UUID
-                std::string filename = mCache->getTextureFileName(mID);
-                //          LL_INFOS() << "Writing Body: " << filename << " Bytes: " << file_offset+file_size << LL_ENDL;
-                S32 bytes_written = LLAPRFile::writeEx(filename,
-                                                       mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
-                                                       0, file_size,
-                                                       mCache->getLocalAPRFilePool());
+                S32 bytes_written = mCache->writeBody(mID,
+                                                      mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
+                                                      file_size,
+                                                      mCache->getLocalAPRFilePool());
                 if (bytes_written <= 0)
                 {
                     LL_WARNS() << "LLTextureCacheWorker: " << mID
@@ -815,6 +817,7 @@ LLTextureCache::~LLTextureCache()
 {
     clearDeleteList() ;
     writeUpdatedEntries() ;
+    mSlabStore.reset();
     delete mFastCachep;
     delete mFastCachePoolp;
     delete mHeaderAPRFilePoolp;
@@ -854,6 +857,11 @@ size_t LLTextureCache::update(F32 max_time_ms)
         responder->completed(success);
     }
 
+    if (mSlabStore)
+    {
+        dropEvictedBodies();
+    }
+
     if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
     {
         timer.reset() ;
@@ -881,6 +889,94 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
     return fmt::format(FMT_COMPILE("{}{}{}{}{}.texture"), mTexturesDirName, delem, std::string_view(&idstr[0], 1), delem, idstr);
 }
 
+std::string LLTextureCache::getSlabDirName()
+{
+    return mTexturesDirName + gDirUtilp->getDirDelimiter() + slabs_dirname;
+}
+
+std::string LLTextureCache::getDecodedDirName()
+{
+    return mTexturesDirName + gDirUtilp->getDirDelimiter() + decoded_dirname;
+}
+
+// Body accessors, the pool is only used by the per file layout.
+S32 LLTextureCache::getBodySize(const LLUUID& id, LLVolatileAPRPool* pool)
+{
+    if (mSlabStore)
+    {
+        return mSlabStore->getSize(id);
+    }
+    return LLAPRFile::size(getTextureFileName(id), pool);
+}
+
+S32 LLTextureCache::readBody(const LLUUID& id, U8* data, S32 offset, S32 size, LLVolatileAPRPool* pool)
+{
+    if (mSlabStore)
+    {
+        return mSlabStore->read(id, data, offset, size);
+    }
+    return LLAPRFile::readEx(getTextureFileName(id), data, offset, size, pool);
+}
+
+S32 LLTextureCache::writeBody(const LLUUID& id, U8* data, S32 size, LLVolatileAPRPool* pool)
+{
+    if (mSlabStore)
+    {
+        return mSlabStore->write(id, data, size);
+    }
+    return LLAPRFile::writeEx(getTextureFileName(id), data, 0, size, pool);
+}
+
+// mHeaderMutex must be locked, mHeaderAPRFilePoolp is safe to use under it
+// but getLocalAPRFilePool() is not, it might be in use by a worker.
+bool LLTextureCache::bodyExists(const LLUUID& id)
+{
+    if (mSlabStore)
+    {
+        return mSlabStore->getSize(id) > 0;
+    }
+    return LLAPRFile::isExist(getTextureFileName(id), mHeaderAPRFilePoolp);
+}
+
+void LLTextureCache::removeBody(const LLUUID& id)
+{
+    if (mSlabStore)
+    {
+        mSlabStore->remove(id);
+    }
+    else
+    {
+        LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
+    }
+}
+
+// Bodies the slab store dropped to make room; clear their entries' body
+// size so the next read stops at the header and refetches the rest.
+void LLTextureCache::dropEvictedBodies()
+{
+    std::vector<LLUUID> evicted;
+    mSlabStore->takeEvicted(evicted);
+    if (evicted.empty() || mReadOnly)
+    {
+        return;
+    }
+
+    LLMutexLock lock(&mHeaderMutex);
+    for (const LLUUID& id : evicted)
+    {
+        Entry entry;
+        S32 idx = openAndReadEntry(id, entry, false);
+        // Skip ids a worker has written again since the eviction.
+        if (idx >= 0 && entry.mBodySize > 0 && !mSlabStore->getSize(id))
+        {
+            mTexturesSizeTotal -= entry.mBodySize;
+            mTexturesSizeMap.erase(id);
+            entry.mBodySize = 0;
+            writeEntryToHeaderImmediately(idx, entry);
+        }
+    }
+}
+
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id)
 {
@@ -949,6 +1045,8 @@ const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
 const char* fast_cache_filename = "FastCache.cache";
+const char* slabs_dirname = "slabs";
+const char* decoded_dirname = "decoded";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -1028,6 +1126,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
         }
     }
 
+    bool layout_changed = false;
     if (!mReadOnly)
     {
         LLFile::mkdir(mTexturesDirName);
@@ -1038,6 +1137,50 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
             std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[i];
             LLFile::mkdir(dirname);
         }
+
+        if (gSavedSettings.getBOOL("TextureCacheSlabStore"))
+        {
+            std::unique_ptr<LLTextureSlabStore> store(new LLTextureSlabStore(getSlabDirName(), sCacheMaxTexturesSize));
+            // Entries written by the per file layout (or a differently sized
+            // store) point at bodies the store doesn't have.
+            layout_changed = !store->open();
+            if (store->isOpen())
+            {
+                mSlabStore = std::move(store);
+            }
+            else
+            {
+                LL_WARNS("TextureCache") << "Could not map the texture slab store, using per texture files" << LL_ENDL;
+                layout_changed = false;
+            }
+        }
+        else if (LLFile::isdir(getSlabDirName()))
+        {
+            gDirUtilp->deleteDirAndContents(getSlabDirName());
+            layout_changed = true;
+        }
+    }
+    if (layout_changed)
+    {
+        LL_INFOS("TextureCache") << "Texture body storage changed, purging." << LL_ENDL;
+        LLMutexLock lock(&mHeaderMutex);
+        purgeAllTextures(false);
+    }
+
+    // Decoded mips get their own budget on top of the texture cache size.
+    const S64 decoded_size = (S64)gSavedSettings.getU32("TextureCacheDecodedSize") * 1024 * 1024;
+    if (!mReadOnly && decoded_size > 0)
+    {
+        if (!mDecodedCache)
+        {
+            mDecodedCache.reset(new LLTextureDecodedCache(getDecodedDirName(), decoded_size));
+            mDecodedCache->init();
+            mDecodedCache->startWriter();
+        }
+    }
+    else if (!mReadOnly && LLFile::isdir(getDecodedDirName()))
+    {
+        gDirUtilp->deleteDirAndContents(getDecodedDirName());
     }
     readHeaderCache();
     purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
@@ -1192,8 +1335,7 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
             LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
 
             //erase this entry and the cached texture from the cache.
-            std::string tex_filename = getTextureFileName(id);
-            removeEntry(idx, entry, tex_filename) ;
+            removeEntry(idx, entry, id) ;
             mUpdatedEntryMap.erase(idx) ;
             idx = -1 ;
         }
@@ -1538,8 +1680,7 @@ void LLTextureCache::readHeaderCache()
                 LLTimer timer;
                 for (U32 idx : purge_list)
                 {
-                    std::string tex_filename = getTextureFileName(entries[idx].mID);
-                    removeEntry((S32)idx, entries[idx], tex_filename);
+                    removeEntry((S32)idx, entries[idx], entries[idx].mID);
 
                     //make sure that pruning entries doesn't take too much time
                     if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
@@ -1609,6 +1750,25 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
             PeekMessage(&msg, 0, 0, 0, PM_NOREMOVE | PM_NOYIELD);
 #endif
         }
+        // The decode pool may be holding on to the decoded cache, so
+        // it's emptied rather than destroyed.
+        if (mDecodedCache)
+        {
+            mDecodedCache->clear();
+        }
+        else if (purge_directories)
+        {
+            gDirUtilp->deleteDirAndContents(getDecodedDirName());
+        }
+        if (mSlabStore && !purge_directories)
+        {
+            mSlabStore->clear();
+        }
+        else
+        {
+            mSlabStore.reset();
+            gDirUtilp->deleteDirAndContents(getSlabDirName());
+        }
         gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
         if (purge_directories)
         {
@@ -1635,7 +1795,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
         return;
     }
 
-    if (!mThreaded)
+    if (!mThreaded && LLAppViewer::instance())
     {
         LLAppViewer::instance()->pauseMainloopTimeout();
     }
@@ -1705,8 +1865,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
             id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
             if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
             {
-                std::string tex_filename = getTextureFileName(entry.mID);
-                removeEntry(idx, entry, tex_filename);
+                removeEntry(idx, entry, entry.mID);
                 writeEntryToHeaderImmediately(idx, entry);
             }
         }
@@ -1720,7 +1879,7 @@ void LLTextureCache::purgeTextures(bool validate)
         return;
     }
 
-    if (!mThreaded)
+    if (!mThreaded && LLAppViewer::instance())
     {
         // *FIX:Mani - watchdog off.
         LLAppViewer::instance()->pauseMainloopTimeout();
@@ -1789,13 +1948,12 @@ void LLTextureCache::purgeTextures(bool validate)
             U32 uuididx = entries[idx].mID.mData[0];
             if (uuididx == validate_idx)
             {
-                std::string filename = getTextureFileName(entries[idx].mID);
-                LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
+                LL_DEBUGS("TextureCache") << "Validating: " << entries[idx].mID << "Size: " << entries[idx].mBodySize << LL_ENDL;
                 // mHeaderAPRFilePoolp because this is under header mutex in main thread
-                S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+                S32 bodysize = getBodySize(entries[idx].mID, mHeaderAPRFilePoolp);
                 if (bodysize != entries[idx].mBodySize)
                 {
-                    LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
+                    LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << entries[idx].mID << LL_ENDL;
                     purge_entry = true;
                 }
             }
@@ -1808,10 +1966,9 @@ void LLTextureCache::purgeTextures(bool validate)
         if (purge_entry)
         {
             purge_count++;
-            std::string filename = getTextureFileName(entries[idx].mID);
-            LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+            LL_DEBUGS("TextureCache") << "PURGING: " << entries[idx].mID << LL_ENDL;
             cache_size -= entries[idx].mBodySize;
-            removeEntry(idx, entries[idx], filename) ;
+            removeEntry(idx, entries[idx], entries[idx].mID) ;
         }
     }
 
@@ -1819,8 +1976,12 @@ void LLTextureCache::purgeTextures(bool validate)
 
     writeEntriesAndClose(entries);
 
-    // *FIX:Mani - watchdog back on.
-    LLAppViewer::instance()->resumeMainloopTimeout();
+    // *FIX:Mani - watchdog back on.  There is no viewer, nor watchdog,
+    // in lltexturefetch_libtest.
+    if (LLAppViewer::instance())
+    {
+        LLAppViewer::instance()->resumeMainloopTimeout();
+    }
 
     LL_INFOS("TextureCache") << "TEXTURE CACHE:"
             << " PURGED: " << purge_count
@@ -2232,13 +2393,11 @@ void LLTextureCache::removeCachedTexture(const LLUUID& id)
         mTexturesSizeMap.erase(id);
     }
     mHeaderIDMap.erase(id);
-    // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-    // but getLocalAPRFilePool() is not safe, it might be in use by worker
-    LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
+    removeBody(id);
 }
 
 //called after mHeaderMutex is locked.
-void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
+void LLTextureCache::removeEntry(S32 idx, Entry& entry, const LLUUID& id)
 {
     bool file_maybe_exists = true;  // Always attempt to remove when idx is invalid.
 
@@ -2247,11 +2406,9 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
         if (entry.mBodySize == 0)   // Always attempt to remove when mBodySize > 0.
         {
           // Sanity check. Shouldn't exist when body size is 0.
-          // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-          // but getLocalAPRFilePool() is not safe, it might be in use by worker
-          if (LLAPRFile::isExist(filename, mHeaderAPRFilePoolp))
+          if (bodyExists(id))
           {
-              LL_WARNS("TextureCache") << "Entry has body size of zero but file " << filename << " exists. Deleting this file, too." << LL_ENDL;
+              LL_WARNS("TextureCache") << "Entry has body size of zero but body for " << id << " exists. Deleting it, too." << LL_ENDL;
           }
           else
           {
@@ -2269,7 +2426,7 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 
     if (file_maybe_exists)
     {
-        LLAPRFile::remove(filename, mHeaderAPRFilePoolp);
+        removeBody(id);
     }
 }
 
@@ -2283,8 +2440,11 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 
         Entry entry;
         S32 idx = openAndReadEntry(id, entry, false);
-        std::string tex_filename = getTextureFileName(id);
-        removeEntry(idx, entry, tex_filename) ;
+        removeEntry(idx, entry, id) ;
+        if (mDecodedCache)
+        {
+            mDecodedCache->remove(id);
+        }
         if (idx >= 0)
         {
             writeEntryToHeaderImmediately(idx, entry);
@@ -36,8 +36,12 @@
 
 #include <boost/unordered/unordered_flat_map.hpp>
 
+#include <memory>
+
 class LLImageFormatted;
 class LLTextureCacheWorker;
+class LLTextureDecodedCache;
+class LLTextureSlabStore;
 class LLImageRaw;
 
 class LLTextureCache final : public LLWorkerThread
@@ -135,6 +139,9 @@ class LLTextureCache final : public LLWorkerThread
 
     bool removeFromCache(const LLUUID& id);
 
+    // Null unless TextureCacheDecodedSize is set; lives as long as the cache.
+    LLTextureDecodedCache* getDecodedCache() { return mDecodedCache.get(); }
+
     // For LLTextureCacheWorker::Responder
     LLTextureCacheWorker* getReader(handle_t handle);
     LLTextureCacheWorker* getWriter(handle_t handle);
@@ -155,6 +162,9 @@ class LLTextureCache final : public LLWorkerThread
     // Accessed by LLTextureCacheWorker
     std::string getLocalFileName(const LLUUID& id);
     std::string getTextureFileName(const LLUUID& id);
+    S32 getBodySize(const LLUUID& id, LLVolatileAPRPool* pool);
+    S32 readBody(const LLUUID& id, U8* data, S32 offset, S32 size, LLVolatileAPRPool* pool);
+    S32 writeBody(const LLUUID& id, U8* data, S32 size, LLVolatileAPRPool* pool);
     void addCompleted(Responder* responder, bool success);
 
 protected:
@@ -179,8 +189,13 @@ class LLTextureCache final : public LLWorkerThread
     void writeEntriesAndClose(const std::vector<Entry>& entries);
     void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
     void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
-    void removeEntry(S32 idx, Entry& entry, std::string& filename);
+    void removeEntry(S32 idx, Entry& entry, const LLUUID& id);
     void removeCachedTexture(const LLUUID& id) ;
+    std::string getSlabDirName();
+    std::string getDecodedDirName();
+    bool bodyExists(const LLUUID& id);
+    void removeBody(const LLUUID& id);
+    void dropEvictedBodies();
     S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
     S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
     void writeUpdatedEntries() ;
@@ -236,6 +251,10 @@ class LLTextureCache final : public LLWorkerThread
 
     // BODIES (TEXTURES minus headers)
     std::string mTexturesDirName;
+    std::unique_ptr<LLTextureSlabStore> mSlabStore; // null when bodies are per texture files
+
+    // DECODED (pixels of previously decoded mips)
+    std::unique_ptr<LLTextureDecodedCache> mDecodedCache;
     typedef boost::unordered_map<LLUUID,S32> size_map_t;
     size_map_t mTexturesSizeMap;
     S64 mTexturesSizeTotal;
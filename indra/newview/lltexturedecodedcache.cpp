@@ -0,0 +1,441 @@
+/**
+ * @file lltexturedecodedcache.cpp
+ * @brief On disk cache of decoded texture mips
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturedecodedcache.h"
+
+#include "hbxxh.h"
+#include "lldir.h"
+#include "llfile.h"
+#include "threadpool.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <atomic>
+
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib/zlib.h"
+#endif
+
+static const U32 DECODED_MAGIC = 0x43454454;  // 'TDEC'
+static const U32 DECODED_VERSION = 1;
+static const char* DECODED_EXT = ".dec";
+// Pixels waiting for the writer, beyond this stores are dropped
+static const S64 MAX_PENDING_BYTES = 32 * 1024 * 1024;
+
+namespace
+{
+    struct DecodedHeader
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U16 mWidth;
+        U16 mHeight;
+        U8 mComponents;
+        U8 mCompressed;
+        S16 mDiscard;
+        S32 mDataSize;
+        U32 mStoredSize;
+        U64 mHash;
+    };
+
+    std::atomic<U32> sTempCounter(0);
+}
+
+LLTextureDecodedCache::LLTextureDecodedCache(const std::string& dirname, S64 max_size)
+:   mDirName(dirname),
+    mMaxSize(max_size),
+    mUsage(0),
+    mPendingBytes(0)
+{
+}
+
+LLTextureDecodedCache::~LLTextureDecodedCache()
+{
+    stopWriter();
+}
+
+void LLTextureDecodedCache::startWriter()
+{
+    if (!mWriter)
+    {
+        // Closed by stopWriter() rather than on the app's shutdown event:
+        // the queued writes still need this cache
+        mWriter.reset(new LL::ThreadPool("TextureDecodedWrite", 1, 1024 * 1024, false));
+        mWriter->start();
+    }
+}
+
+void LLTextureDecodedCache::stopWriter()
+{
+    if (mWriter)
+    {
+        // Drains the queue before joining
+        mWriter->close();
+        mWriter.reset();
+    }
+}
+
+std::string LLTextureDecodedCache::getFileName(const LLUUID& id, S32 discard) const
+{
+    std::string idstr = id.asString();
+    const std::string& delem = gDirUtilp->getDirDelimiter();
+    return llformat("%s%s%c%s%s_%d%s", mDirName.c_str(), delem.c_str(), idstr[0], delem.c_str(),
+                    idstr.c_str(), discard, DECODED_EXT);
+}
+
+void LLTextureDecodedCache::init()
+{
+    LLFile::mkdir(mDirName);
+    const char* subdirs = "0123456789abcdef";
+    for (S32 i = 0; i < 16; ++i)
+    {
+        LLFile::mkdir(mDirName + gDirUtilp->getDirDelimiter() + subdirs[i]);
+    }
+
+    typedef std::pair<std::time_t, std::pair<key_t, S64> > file_info_t;
+    std::vector<file_info_t> file_info;
+    std::vector<boost::filesystem::path> stale;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    boost::filesystem::path cache_path(ll_convert_string_to_wide(mDirName));
+#else
+    boost::filesystem::path cache_path(mDirName);
+#endif
+    boost::filesystem::recursive_directory_iterator dir_iter(cache_path, ec);
+    if (!ec.failed())
+    {
+        for (auto& entry : boost::make_iterator_range(dir_iter, {}))
+        {
+            if (!boost::filesystem::is_regular_file(entry, ec) || ec.failed())
+            {
+                continue;
+            }
+            // <uuid>_<discard>.dec, anything else is a leftover temp file
+            const std::string name = entry.path().filename().string();
+            S32 discard = -1;
+            LLUUID id;
+            if (name.size() > UUID_STR_LENGTH && name[UUID_STR_LENGTH - 1] == '_'
+                && name.compare(name.size() - strlen(DECODED_EXT), std::string::npos, DECODED_EXT) == 0
+                && LLUUID::validate(name.substr(0, UUID_STR_LENGTH - 1))
+                && sscanf(name.c_str() + UUID_STR_LENGTH, "%d", &discard) == 1
+                && discard >= 0 && discard <= MAX_DISCARD_LEVEL)
+            {
+                id.set(name.substr(0, UUID_STR_LENGTH - 1));
+                const uintmax_t file_size = boost::filesystem::file_size(entry, ec);
+                const std::time_t file_time = ec.failed() ? 0 : boost::filesystem::last_write_time(entry, ec);
+                if (!ec.failed())
+                {
+                    file_info.push_back(file_info_t(file_time, { { id, discard }, (S64)file_size }));
+                    continue;
+                }
+            }
+            stale.push_back(entry.path());
+        }
+    }
+
+    for (const boost::filesystem::path& path : stale)
+    {
+        boost::filesystem::remove(path, ec);
+    }
+
+    std::sort(file_info.begin(), file_info.end(),
+              [](const file_info_t& x, const file_info_t& y) { return x.first < y.first; });
+
+    LLMutexLock lock(&mMutex);
+    for (const file_info_t& info : file_info)
+    {
+        insertRecord(info.second.first, info.second.second, 0);
+    }
+    trim();
+
+    LL_INFOS("TextureCache") << "Decoded texture cache: " << mRecords.size() << " mips, "
+                             << mUsage / (1024 * 1024) << " MB of " << mMaxSize / (1024 * 1024) << " MB" << LL_ENDL;
+}
+
+// mMutex must be locked
+void LLTextureDecodedCache::insertRecord(const key_t& key, S64 size, S32 data_size)
+{
+    record_map_t::iterator iter = mRecords.find(key);
+    if (iter != mRecords.end())
+    {
+        mUsage -= iter->second.mSize;
+        mLRU.erase(iter->second.mLRU);
+    }
+    else
+    {
+        iter = mRecords.emplace(key, Record()).first;
+    }
+    iter->second.mSize = size;
+    iter->second.mDataSize = data_size;
+    iter->second.mLRU = mLRU.insert(mLRU.end(), key);
+    mUsage += size;
+}
+
+// mMutex must be locked
+void LLTextureDecodedCache::eraseRecord(record_map_t::iterator iter)
+{
+    LLFile::remove(getFileName(iter->first.first, iter->first.second), ENOENT);
+    mUsage -= iter->second.mSize;
+    mLRU.erase(iter->second.mLRU);
+    mRecords.erase(iter);
+}
+
+// mMutex must be locked
+void LLTextureDecodedCache::trim()
+{
+    while (mUsage > mMaxSize && !mLRU.empty())
+    {
+        eraseRecord(mRecords.find(mLRU.front()));
+    }
+}
+
+LLPointer<LLImageRaw> LLTextureDecodedCache::load(const LLUUID& id, S32 discard, S32 data_size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const key_t key(id, discard);
+    {
+        LLMutexLock lock(&mMutex);
+        record_map_t::iterator iter = mRecords.find(key);
+        if (iter == mRecords.end())
+        {
+            return nullptr;
+        }
+        if (iter->second.mDataSize && iter->second.mDataSize < data_size)
+        {
+            // Decoded from less data than we now have; let the decoder
+            // produce a better one.
+            return nullptr;
+        }
+        mLRU.splice(mLRU.end(), mLRU, iter->second.mLRU);
+    }
+
+    // File IO and inflate happen unlocked; if the record gets evicted
+    // meanwhile the open or the header check fails and we miss.
+    const std::string filename = getFileName(id, discard);
+    LLPointer<LLImageRaw> raw;
+    bool valid = false;
+    S32 stored_data_size = 0;
+    LLFILE* fp = LLFile::fopen(filename, "rb");
+    if (fp)
+    {
+        DecodedHeader header;
+        if (fread(&header, sizeof(header), 1, fp) == 1
+            && header.mMagic == DECODED_MAGIC
+            && header.mVersion == DECODED_VERSION
+            && header.mDiscard == discard
+            && header.mWidth > 0 && header.mHeight > 0
+            && header.mComponents > 0 && header.mComponents <= 4)
+        {
+            stored_data_size = header.mDataSize;
+            const U32 raw_size = (U32)header.mWidth * header.mHeight * header.mComponents;
+            const bool sane = header.mCompressed ? header.mStoredSize < raw_size : header.mStoredSize == raw_size;
+            std::vector<U8> stored(sane ? header.mStoredSize : 0);
+            if (sane && header.mDataSize >= data_size
+                && fread(stored.data(), 1, stored.size(), fp) == stored.size()
+                && HBXXH64::digest(stored.data(), stored.size()) == header.mHash)
+            {
+                raw = new LLImageRaw(header.mWidth, header.mHeight, header.mComponents);
+                if (raw->getData())
+                {
+                    if (header.mCompressed)
+                    {
+                        uLongf dest_len = raw_size;
+                        valid = uncompress(raw->getData(), &dest_len, stored.data(), (uLong)stored.size()) == Z_OK
+                                && dest_len == raw_size;
+                    }
+                    else
+                    {
+                        memcpy(raw->getData(), stored.data(), raw_size);
+                        valid = true;
+                    }
+                }
+            }
+        }
+        LLFile::close(fp);
+    }
+
+    LLMutexLock lock(&mMutex);
+    record_map_t::iterator iter = mRecords.find(key);
+    if (valid)
+    {
+        if (iter != mRecords.end())
+        {
+            iter->second.mDataSize = stored_data_size;
+        }
+        return raw;
+    }
+    if (iter != mRecords.end() && (!stored_data_size || stored_data_size >= data_size))
+    {
+        // Unreadable or corrupt, as opposed to merely stale
+        LL_WARNS("TextureCache") << "Dropping bad decoded cache file " << filename << LL_ENDL;
+        eraseRecord(iter);
+    }
+    else if (iter != mRecords.end())
+    {
+        iter->second.mDataSize = stored_data_size;
+    }
+    return nullptr;
+}
+
+void LLTextureDecodedCache::store(const LLUUID& id, S32 discard, S32 data_size, const LLImageRaw* raw)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (!raw || !raw->getData() || discard < 0 || mMaxSize <= 0)
+    {
+        return;
+    }
+
+    const S64 raw_size = (S64)raw->getWidth() * raw->getHeight() * raw->getComponents();
+    if (!raw_size || raw_size > mMaxSize / 16)
+    {
+        return;
+    }
+
+    if (!mWriter)
+    {
+        write(id, discard, data_size, raw);
+        return;
+    }
+
+    if (mPendingBytes.fetch_add(raw_size) + raw_size > MAX_PENDING_BYTES)
+    {
+        // The disk is behind, this one gets decoded again next time
+        mPendingBytes -= raw_size;
+        return;
+    }
+
+    // The caller keeps its image, the writer gets a copy
+    LLPointer<LLImageRaw> copy = new LLImageRaw(raw->getData(), raw->getWidth(), raw->getHeight(),
+                                                raw->getComponents());
+    bool posted = copy->getData() && mWriter->getQueue().post(
+        [this, id, discard, data_size, copy, raw_size]()
+        {
+            write(id, discard, data_size, copy);
+            mPendingBytes -= raw_size;
+        });
+    if (!posted)
+    {
+        mPendingBytes -= raw_size;
+    }
+}
+
+void LLTextureDecodedCache::write(const LLUUID& id, S32 discard, S32 data_size, const LLImageRaw* raw)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const U32 raw_size = (U32)raw->getWidth() * raw->getHeight() * raw->getComponents();
+
+    DecodedHeader header;
+    memset(&header, 0, sizeof(header));
+    header.mMagic = DECODED_MAGIC;
+    header.mVersion = DECODED_VERSION;
+    header.mWidth = raw->getWidth();
+    header.mHeight = raw->getHeight();
+    header.mComponents = raw->getComponents();
+    header.mDiscard = discard;
+    header.mDataSize = data_size;
+
+    // Textures with flat or repeating areas deflate well even at level 1;
+    // noisy ones are stored as is, reading them is cheaper than inflating.
+    std::vector<U8> deflated(compressBound(raw_size));
+    uLongf deflated_size = (uLongf)deflated.size();
+    const U8* payload = raw->getData();
+    header.mStoredSize = raw_size;
+    if (compress2(deflated.data(), &deflated_size, raw->getData(), raw_size, Z_BEST_SPEED) == Z_OK
+        && deflated_size < raw_size - raw_size / 8)
+    {
+        payload = deflated.data();
+        header.mStoredSize = (U32)deflated_size;
+        header.mCompressed = 1;
+    }
+    header.mHash = HBXXH64::digest(payload, header.mStoredSize);
+
+    // Write aside and move into place so readers never see a partial file.
+    const std::string filename = getFileName(id, discard);
+    const std::string tmp_filename = llformat("%s.%u.tmp", filename.c_str(),
+                                              ++sTempCounter);
+    LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+    if (!fp)
+    {
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+              && fwrite(payload, 1, header.mStoredSize, fp) == header.mStoredSize;
+    ok = (LLFile::close(fp) == 0) && ok;
+
+    LLMutexLock lock(&mMutex);
+    if (ok)
+    {
+        LLFile::remove(filename, ENOENT);
+        ok = LLFile::rename(tmp_filename, filename) == 0;
+    }
+    if (!ok)
+    {
+        LLFile::remove(tmp_filename, ENOENT);
+        return;
+    }
+    insertRecord(key_t(id, discard), sizeof(header) + header.mStoredSize, data_size);
+    trim();
+}
+
+bool LLTextureDecodedCache::has(const LLUUID& id, S32 discard)
+{
+    LLMutexLock lock(&mMutex);
+    return mRecords.find(key_t(id, discard)) != mRecords.end();
+}
+
+void LLTextureDecodedCache::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    record_map_t::iterator iter = mRecords.lower_bound(key_t(id, 0));
+    while (iter != mRecords.end() && iter->first.first == id)
+    {
+        eraseRecord(iter++);
+    }
+}
+
+void LLTextureDecodedCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+    while (!mRecords.empty())
+    {
+        eraseRecord(mRecords.begin());
+    }
+}
+
+S64 LLTextureDecodedCache::getUsage()
+{
+    LLMutexLock lock(&mMutex);
+    return mUsage;
+}
+
+U32 LLTextureDecodedCache::getCount()
+{
+    LLMutexLock lock(&mMutex);
+    return (U32)mRecords.size();
+}
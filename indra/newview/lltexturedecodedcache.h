@@ -0,0 +1,110 @@
+/**
+ * @file lltexturedecodedcache.h
+ * @brief On disk cache of decoded texture mips
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREDECODEDCACHE_H
+#define LL_LLTEXTUREDECODEDCACHE_H
+
+#include "llimageworker.h"
+#include "llmutex.h"
+#include "threadpool_fwd.h"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+
+// Keeps the output of J2C decodes on disk, one file per texture and
+// discard level, so a warm start reads pixels instead of running the
+// decoder again.  Payloads are deflated at the fastest level when that
+// actually saves space.
+//
+// Plugged into LLImageDecodeThread, which looks a texture up before
+// decoding it and stores the result after.  A record only satisfies
+// requests whose codestream is no larger than the one it was decoded
+// from, so partially downloaded textures get decoded again once more
+// data arrives.  Least recently used records are dropped to stay
+// under the size limit.
+//
+// Once startWriter() is called, store() only copies the pixels and a
+// single "TextureDecodedWrite" thread deflates and writes them, so the
+// decode pool never waits on the disk.  Stores that would push the
+// queued pixels over 32MB (MAX_PENDING_BYTES) are dropped: the texture
+// simply gets decoded again next time.  Without the writer, store() writes
+// in the calling thread.
+class LLTextureDecodedCache : public LLImageDecodeThread::DecodedCache
+{
+public:
+    LLTextureDecodedCache(const std::string& dirname, S64 max_size);
+    ~LLTextureDecodedCache();
+
+    // Create the directories and index what a previous session left.
+    void init();
+    // Move writes off the calling threads, see above.
+    void startWriter();
+    // Finish the queued writes and go back to writing in store().
+    void stopWriter();
+
+    /*virtual*/ LLPointer<LLImageRaw> load(const LLUUID& id, S32 discard, S32 data_size) override;
+    /*virtual*/ void store(const LLUUID& id, S32 discard, S32 data_size, const LLImageRaw* raw) override;
+
+    // Whether a record exists for id at discard.  Cheap, no file IO, so
+    // callers can skip reading the codestream when load() will likely
+    // hit; load() still verifies the file.
+    bool has(const LLUUID& id, S32 discard);
+    // Forget every discard level of id.
+    void remove(const LLUUID& id);
+    void clear();
+
+    S64 getUsage();
+    U32 getCount();
+
+private:
+    typedef std::pair<LLUUID, S32> key_t;
+    typedef std::list<key_t> lru_list_t;
+
+    struct Record
+    {
+        S64 mSize;
+        S32 mDataSize;      // codestream bytes it was decoded from, 0 if unknown
+        lru_list_t::iterator mLRU;
+    };
+    typedef std::map<key_t, Record> record_map_t;
+
+    std::string getFileName(const LLUUID& id, S32 discard) const;
+    void write(const LLUUID& id, S32 discard, S32 data_size, const LLImageRaw* raw);
+    void insertRecord(const key_t& key, S64 size, S32 data_size);
+    void eraseRecord(record_map_t::iterator iter);
+    void trim();
+
+    LLMutex mMutex;
+    std::string mDirName;
+    S64 mMaxSize;
+    S64 mUsage;
+    record_map_t mRecords;
+    lru_list_t mLRU;        // oldest first
+
+    std::unique_ptr<LL::ThreadPool> mWriter;
+    std::atomic<S64> mPendingBytes;     // pixels queued on mWriter
+};
+
+#endif // LL_LLTEXTUREDECODEDCACHE_H
@@ -42,6 +42,7 @@
 
 #include "llagent.h"
 #include "lltexturecache.h"
+#include "lltexturedecodedcache.h"
 #include "llviewercontrol.h"
 #include "llviewertexturelist.h"
 #include "llviewertexture.h"
@@ -156,6 +157,10 @@ const std::string sTesterName("TextureFetchTester");
 // 6.  Mwc      Mutex covering LLWorkerClass's members (base class of
 //              LLTextureFetchWorker).  One per request.
 // 7.  Mw       LLTextureFetchWorker's mutex.  One per request.
+// 8.  Mfp      LLTextureFetch's mutex covering the priority updates not
+//              yet published to the scheduler.
+// 9.  Ms       LLTextureFetchScheduler's mutex, taken inside its methods.
+// 10. Mft      LLTextureFetch's mutex covering the request trace file.
 //
 //
 // Lock Ordering Rules
@@ -165,6 +170,7 @@ const std::string sTesterName("TextureFetchTester");
 // acquiring 'B'.
 //
 // 1.    Mw < Mfnq
+// 2.    Mw < Ms
 // (there are many more...)
 //
 //
@@ -243,6 +249,12 @@ static const S32 HTTP_REQUESTS_RANGE_END_MAX = 20000000;
 static const S32 MAX_CAP_MISSING_RETRIES = 720;
 static const S32 CAP_MISSING_EXPIRATION_DELAY = 1; // seconds
 
+// HTTP/2 stream weights by texture priority (max virtual size in pixels),
+// so what's large on screen gets most of a multiplexed connection.  Only
+// used when the texture class multiplexes, see HttpMultiplexStreams.
+static const F32 HTTP_WEIGHT_MIN_PRIORITY[LLTextureFetch::HTTP_WEIGHT_LEVELS] = { 0.f, 64.f * 64.f, 256.f * 256.f, 1024.f * 1024.f };
+static const S32 HTTP_WEIGHTS[LLTextureFetch::HTTP_WEIGHT_LEVELS] = { 8, 16, 64, 256 };
+
 //////////////////////////////////////////////////////////////////////////////
 namespace
 {
@@ -579,6 +591,8 @@ class LLTextureFetchWorker : public LLWorkerClass, public LLCore::HttpHandler
     BOOL mInLocalCache;
     BOOL mInCache;
     bool                        mCanUseHTTP;
+    bool mDecodedCacheOnly;     // decoding an empty image, the pixels come from the decoded cache
+    bool mSkipDecodedCache;     // that failed, read the codestream
     S32 mRetryAttempt;
     S32 mActiveCount;
     LLCore::HttpStatus mGetStatus;
@@ -919,6 +933,8 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mInLocalCache(FALSE),
       mInCache(FALSE),
       mCanUseHTTP(true),
+      mDecodedCacheOnly(false),
+      mSkipDecodedCache(false),
       mRetryAttempt(0),
       mActiveCount(0),
       mWorkMutex(),
@@ -1171,6 +1187,13 @@ bool LLTextureFetchWorker::doWork(S32 param)
         mCacheWriteHandle = LLTextureCache::nullHandle();
         setState(LOAD_FROM_TEXTURE_CACHE);
         mInCache = FALSE;
+        if (mDecodedCacheOnly)
+        {
+            // Aborted before the decoded pixels arrived, drop the empty image
+            mFormattedImage = NULL;
+            mDecodedCacheOnly = false;
+        }
+        mSkipDecodedCache = false;
         mDesiredSize = llmax(mDesiredSize, TEXTURE_CACHE_ENTRY_SIZE); // min desired size is TEXTURE_CACHE_ENTRY_SIZE
 #ifdef SHOW_DEBUG
         LL_DEBUGS(LOG_TXT) << mID << ": Priority: " << llformat("%8.0f",mImagePriority)
@@ -1209,6 +1232,22 @@ bool LLTextureFetchWorker::doWork(S32 param)
             }
             else if ((mUrl.empty() || mFTType==FTT_SERVER_BAKE) && mFetcher->canLoadFromCache())
             {
+                LLTextureDecodedCache* decoded_cache = mFetcher->mTextureCache->getDecodedCache();
+                if (offset == 0 && mDesiredDiscard >= 0 && !mSkipDecodedCache && !mInLocalCache && decoded_cache
+                    && decoded_cache->has(mID, mDesiredDiscard) && mFetcher->mTextureCache->isInCache(mID))
+                {
+                    // The pixels are already on disk, don't read the
+                    // codestream just to have the decode pool skip it
+                    mFormattedImage = new LLImageJ2C;
+                    mDecodedCacheOnly = true;
+                    mLoadedDiscard = mDesiredDiscard;
+                    mInCache = TRUE;
+                    mWriteToCacheState = NOT_WRITE;
+                    add(LLTextureFetch::sCacheHit, 1.0);
+                    record(LLTextureFetch::sCacheHitRate, LLUnits::Ratio::fromValue(1));
+                    setState(DECODE_IMAGE);
+                    return doWork(param);
+                }
                 ++mCacheReadCount;
                 CacheReadResponder* responder = new CacheReadResponder(mFetcher, mID, mFormattedImage);
                 mCacheReadTimer.reset();
@@ -1413,6 +1452,17 @@ bool LLTextureFetchWorker::doWork(S32 param)
     if (mState == WAIT_HTTP_RESOURCE2)
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_THREAD("tfwdw - WAIT_HTTP_RESOURCE2");
+        if (!mFetcher->isHttpWaiter(mID))
+        {
+            // Dropped from the waiters by a priority of zero.  Give up
+            // if nobody wants it anymore, otherwise get back in line.
+            if (mImagePriority < F_ALMOST_ZERO)
+            {
+                setState(INIT);
+                return true; // abort
+            }
+            mFetcher->addHttpWaiter(mID);
+        }
         // Just idle it if we make it to the head...
         return false;
     }
@@ -1503,7 +1553,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 
         // Will call callbackHttpGet when curl request completes
         // Only server bake images use the returned headers currently, for getting retry-after field.
-        LLCore::HttpOptions::ptr_t options = (mFTType == FTT_SERVER_BAKE) ? mFetcher->mHttpOptionsWithHeaders: mFetcher->mHttpOptions;
+        LLCore::HttpOptions::ptr_t options = (mFTType == FTT_SERVER_BAKE) ? mFetcher->mHttpOptionsWithHeaders: mFetcher->getHttpOptions(mImagePriority);
         if (disable_range_req)
         {
             // 'Range:' requests may be disabled in which case all HTTP
@@ -1696,7 +1746,20 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 mRequestedOffset += src_offset;
             }
 
-            U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            // If nothing is cached and the response landed in a single
+            // reserved block, take the block over rather than copying.
+            U8 * buffer(NULL);
+            if (0 == cur_size && 0 == src_offset)
+            {
+                size_t detached_size(0);
+                buffer = (U8 *) mHttpBufferArray->detachContiguous(&detached_size);
+                llassert_always(! buffer || S32(detached_size) == total_size);
+            }
+            const bool copy_body(NULL == buffer);
+            if (copy_body)
+            {
+                buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            }
             if (!buffer)
             {
                 // abort. If we have no space for packet, we have not enough space to decode image
@@ -1731,7 +1794,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 // Copy previously collected data into buffer
                 memcpy(buffer, mFormattedImage->getData(), cur_size);
             }
-            mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
+            if (copy_body)
+            {
+                mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
+            }
 
             // NOTE: setData releases current data and owns new data (buffer)
             mFormattedImage->setData(buffer, total_size);
@@ -1792,7 +1858,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
             return true;
         }
 
-        if (mFormattedImage->getDataSize() <= 0)
+        if (mFormattedImage->getDataSize() <= 0 && !mDecodedCacheOnly)
         {
             LL_WARNS(LOG_TXT) << "Decode entered with invalid mFormattedImage. ID = " << mID << LL_ENDL;
 
@@ -1814,11 +1880,23 @@ bool LLTextureFetchWorker::doWork(S32 param)
 #endif
             return true;
         }
+        if (getFlags(LLWorkerClass::WCF_DELETE_REQUESTED))
+        {
+            // Nobody left to hand the pixels to
+            setState(DONE);
+            return true;
+        }
+        if (!mFetcher->mScheduler.acquire(mID, LLTextureFetchScheduler::STAGE_DECODE))
+        {
+            // Over the decode budget, or more important textures are
+            // waiting for the free slots
+            return false;
+        }
         mDecodeTimer.reset();
         mRawImage = NULL;
         mAuxImage = NULL;
         llassert_always(mFormattedImage.notNull());
-        S32 discard = mHaveAllData ? 0 : mLoadedDiscard;
+        S32 discard = (mHaveAllData && !mDecodedCacheOnly) ? 0 : mLoadedDiscard;
         mDecoded  = FALSE;
         setState(DECODE_IMAGE_UPDATE);
 #ifdef SHOW_DEBUG
@@ -1828,14 +1906,19 @@ bool LLTextureFetchWorker::doWork(S32 param)
         // In case worked manages to request decode, be shut down,
         // then init and request decode again with first decode
         // still in progress, assign a sufficiently unique id
-        mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage,
-                                                                       discard,
-                                                                       mNeedsAux,
-                                                                       new DecodeResponder(mFetcher, mID, this));
+        // Let the decode pool serve the pixels from the decoded cache when
+        // it can; local files may change under the same id so skip those.
+        const LLUUID& cache_id = (mInLocalCache || mUrl.compare(0, 7, "file://") == 0) ? LLUUID::null : mID;
+        mDecodeHandle = mFetcher->mImageDecodeThread->decodeImage(mFormattedImage,
+                                                                  discard,
+                                                                  mNeedsAux,
+                                                                  new DecodeResponder(mFetcher, mID, this),
+                                                                  cache_id);
         if (mDecodeHandle == 0)
         {
             // Abort, failed to put into queue.
             // Happens if viewer is shutting down
+            mFetcher->mScheduler.release(mID, LLTextureFetchScheduler::STAGE_DECODE);
             setState(DONE);
             LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE abort: failed to post for decoding" << LL_ENDL;
             return true;
@@ -1850,7 +1933,18 @@ bool LLTextureFetchWorker::doWork(S32 param)
         {
             mDecodeTime = mDecodeTimer.getElapsedTimeF32();
 
-            if (mDecodedDiscard < 0)
+            if (mDecodedDiscard < 0 && mDecodedCacheOnly)
+            {
+                // The decoded record was dropped meanwhile, read the codestream
+                mFormattedImage = NULL;
+                mDecodedCacheOnly = false;
+                mSkipDecodedCache = true;
+                mLoadedDiscard = -1;
+                mInCache = FALSE;
+                setState(LOAD_FROM_TEXTURE_CACHE);
+                return doWork(param);
+            }
+            else if (mDecodedDiscard < 0)
             {
                 if (mCachedSize > 0 && !mInLocalCache && mRetryAttempt == 0)
                 {
@@ -1880,6 +1974,13 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 LL_DEBUGS(LOG_TXT) << mID << ": Decoded. Discard: " << mDecodedDiscard
                                    << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
 #endif
+                if (mDecodedCacheOnly)
+                {
+                    // Nothing to append more data to, a later request for
+                    // a lower discard reads the codestream from the start
+                    mFormattedImage = NULL;
+                    mDecodedCacheOnly = false;
+                }
                 setState(WRITE_TO_CACHE);
             }
             // fall through
@@ -2100,6 +2201,7 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
     {
         // LL::ThreadPool has no operation to cancel a particular work item
         mDecodeHandle = 0;
+        mFetcher->mScheduler.release(mID, LLTextureFetchScheduler::STAGE_DECODE);
     }
     mFormattedImage = NULL;
 }
@@ -2372,6 +2474,7 @@ void LLTextureFetchWorker::callbackDecoded(bool success, const std::string &erro
         LL_DEBUGS(LOG_TXT) << mID << " received obsolete decode's callback" << LL_ENDL;
         return; // ignore
     }
+    mFetcher->mScheduler.release(mID, LLTextureFetchScheduler::STAGE_DECODE);
     if (mState != DECODE_IMAGE_UPDATE)
     {
         LL_DEBUGS(LOG_TXT) << "Decode callback for " << mID << " with state = " << mState << LL_ENDL;
@@ -2387,6 +2490,8 @@ void LLTextureFetchWorker::callbackDecoded(bool success, const std::string &erro
         mRawImage = raw;
         mAuxImage = aux;
         mDecodedDiscard = mFormattedImage->getDiscardLevel();
+        // Counts against the upload budget until the main thread takes it
+        mFetcher->mScheduler.hold(mID, LLTextureFetchScheduler::STAGE_UPLOAD);
 #ifdef SHOW_DEBUG
         LL_DEBUGS(LOG_TXT) << mID << ": Decode Finished. Discard: " << mDecodedDiscard
                            << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
@@ -2394,8 +2499,16 @@ void LLTextureFetchWorker::callbackDecoded(bool success, const std::string &erro
     }
     else
     {
-        LL_WARNS(LOG_TXT) << "DECODE FAILED: " << mID << " Discard: " << (S32)mFormattedImage->getDiscardLevel() << ", reason: " << error_message << LL_ENDL;
-        removeFromCache();
+        if (mDecodedCacheOnly)
+        {
+            // Only the decoded record was missing, the codestream is fine
+            LL_DEBUGS(LOG_TXT) << mID << ": " << error_message << LL_ENDL;
+        }
+        else
+        {
+            LL_WARNS(LOG_TXT) << "DECODE FAILED: " << mID << " Discard: " << (S32)mFormattedImage->getDiscardLevel() << ", reason: " << error_message << LL_ENDL;
+            removeFromCache();
+        }
         mDecodedDiscard = -1; // Redundant, here for clarity and paranoia
     }
     mDecoded = TRUE;
@@ -2472,7 +2585,7 @@ std::string LLTextureFetch::getStateString(S32 state)
     return e_state_name[state];
 }
 
-LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mode)
+LLTextureFetch::LLTextureFetch(LLTextureCache* cache, LLImageDecodeThread* imagedecodethread, bool threaded, bool qa_mode)
     : LLWorkerThread("TextureFetch", threaded, true),
       mDebugCount(0),
       mDebugPause(FALSE),
@@ -2481,13 +2594,13 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
       mQueueMutex(),
       mNetworkQueueMutex(),
       mTextureCache(cache),
+      mImageDecodeThread(imagedecodethread),
       mTextureBandwidth(0),
       mHTTPTextureBits((U32Bits)0),
       mTotalHTTPRequests(0),
       mCommandsSize(0),
       mQAMode(qa_mode),
       mHttpRequest(NULL),
-      mHttpOptions(),
       mHttpOptionsWithHeaders(),
       mHttpHeaders(),
       mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
@@ -2507,21 +2620,39 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
     mTextureInfo.setLogging(true);
 #endif
 
-    LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
     mHttpRequest            = new LLCore::HttpRequest;
-    mHttpOptions            = std::make_shared<LLCore::HttpOptions>();
+    for (S32 i = 0; i < HTTP_WEIGHT_LEVELS; ++i)
+    {
+        mHttpOptions[i] = std::make_shared<LLCore::HttpOptions>();
+        mHttpOptions[i]->setStreamWeight(HTTP_WEIGHTS[i]);
+    }
+    // Server bakes are whole avatars, give them the top weight
     mHttpOptionsWithHeaders = std::make_shared<LLCore::HttpOptions>();
     mHttpOptionsWithHeaders->setWantHeaders(true);
+    mHttpOptionsWithHeaders->setStreamWeight(HTTP_WEIGHTS[HTTP_WEIGHT_LEVELS - 1]);
     mHttpHeaders = std::make_shared<LLCore::HttpHeaders>();
     mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_IMAGE_X_J2C);
-    mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_TEXTURE);
     mHttpMetricsHeaders = std::make_shared<LLCore::HttpHeaders>();
     mHttpMetricsHeaders->append(HTTP_OUT_HEADER_CONTENT_TYPE, HTTP_CONTENT_LLSD_XML);
-    mHttpMetricsPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_REPORTING);
+    // Without the viewer (lltexturefetch_libtest) the default policy is used
+    if (LLAppViewer::instance())
+    {
+        LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
+        mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_TEXTURE);
+        mHttpMetricsPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_REPORTING);
+    }
     mHttpHighWater = HTTP_NONPIPE_REQUESTS_HIGH_WATER;
     mHttpLowWater = HTTP_NONPIPE_REQUESTS_LOW_WATER;
     mHttpSemaphore = 0;
 
+    // Request trace for lltexturefetch_libtest to replay
+    const std::string trace_file = gSavedSettings.getString("TextureFetchTraceFile");
+    if (!trace_file.empty())
+    {
+        mTraceFile.open(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, trace_file).c_str());
+        mTraceTimer.reset();
+    }
+
     // If that test log has ben requested but not yet created, create it
     if (LLMetricPerformanceTesterBasic::isMetricLogRequested(sTesterName) && !LLMetricPerformanceTesterBasic::getTester(sTesterName))
     {
@@ -2546,7 +2677,7 @@ LLTextureFetch::~LLTextureFetch()
     }
     mCommandsSize = 0;
 
-    mHttpWaitResource.clear();
+    mScheduler.clear();
 
     delete mHttpRequest;
     mHttpRequest = NULL;
@@ -2554,6 +2685,16 @@ LLTextureFetch::~LLTextureFetch()
     // ~LLQueuedThread() called here
 }
 
+LLCore::HttpOptions::ptr_t LLTextureFetch::getHttpOptions(F32 priority) const
+{
+    S32 level = HTTP_WEIGHT_LEVELS - 1;
+    while (level > 0 && priority < HTTP_WEIGHT_MIN_PRIORITY[level])
+    {
+        --level;
+    }
+    return mHttpOptions[level];
+}
+
 S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
                                    S32 w, S32 h, S32 c, S32 desired_discard, bool needs_aux, bool can_use_http)
 {
@@ -2646,6 +2787,7 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
         worker->mActiveCount++;
         worker->mNeedsAux = needs_aux;
         worker->setImagePriority(priority);
+        mScheduler.addRequest(id, priority);
         worker->setDesiredDiscard(desired_discard, desired_size);
         worker->setCanUseHTTP(can_use_http);
 
@@ -2665,6 +2807,7 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
     }
     else
     {
+        mScheduler.addRequest(id, priority);
         worker = new LLTextureFetchWorker(this, f_type, url, id, host, priority, desired_discard, desired_size);
         lockQueue();                                                    // +Mfq
         mRequestMap[id] = worker;
@@ -2681,6 +2824,7 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
     LL_DEBUGS(LOG_TXT) << "REQUESTED: " << id << " f_type " << fttype_to_string(f_type)
                        << " Discard: " << desired_discard << " size " << desired_size << LL_ENDL;
 #endif
+    recordTrace(id, priority);
     return desired_discard;
 }
 // Threads:  T*
@@ -2749,6 +2893,7 @@ void LLTextureFetch::removeRequest(LLTextureFetchWorker* worker, bool cancel)
     llassert_always(erased_1 > 0) ;
     llassert_always(!(worker->getFlags(LLWorkerClass::WCF_DELETE_REQUESTED))) ;
 
+    mScheduler.removeRequest(worker->mID);
     worker->scheduleDelete();
 }
 
@@ -2836,6 +2981,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
     {
         if (worker->wasAborted())
         {
+            mScheduler.release(id, LLTextureFetchScheduler::STAGE_UPLOAD);
             res = true;
         }
         else if (!worker->haveWork())
@@ -2880,6 +3026,9 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 #endif
             worker->unlockWorkMutex();                                  // -Mw
 
+            // Whatever was decoded is the main thread's now
+            mScheduler.release(id, LLTextureFetchScheduler::STAGE_UPLOAD);
+
             sample(sTexDecodeLatency, decode_time);
             sample(sTexFetchLatency, fetch_time);
             sample(sCacheReadLatency, cache_read_time);
@@ -2908,6 +3057,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
                 discard_level = worker->mDecodedDiscard;
                 raw = worker->mRawImage;
                 aux = worker->mAuxImage;
+                mScheduler.release(id, LLTextureFetchScheduler::STAGE_UPLOAD);
             }
             worker->unlockWorkMutex();                                  // -Mw
         }
@@ -2921,20 +3071,72 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 
 // Threads:  T*
 bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
+{
+    LLMutexLock lock(&mPriorityMutex);                                  // +Mfp
+    mPriorityUpdates.emplace_back(id, priority);
+    return true;
+}                                                                       // -Mfp
+
+// Threads:  Tmain
+void LLTextureFetch::publishRequestPriorities()
 {
     LL_PROFILE_ZONE_SCOPED;
-    mRequestQueue.tryPost([=]()
+    LLTextureFetchScheduler::priority_batch_t batch;
+    {
+        LLMutexLock lock(&mPriorityMutex);                              // +Mfp
+        if (mPriorityUpdates.empty())
         {
-            LLTextureFetchWorker* worker = getWorker(id);
-            if (worker)
-            {
-                worker->lockWorkMutex();                                        // +Mw
-                worker->setImagePriority(priority);
-                worker->unlockWorkMutex();                                      // -Mw
-            }
+            return;
+        }
+        batch.swap(mPriorityUpdates);
+        mPriorityUpdates.reserve(batch.size());
+    }                                                                   // -Mfp
+
+    if (mTraceFile.is_open())
+    {
+        for (const auto& update : batch)
+        {
+            recordTrace(update.first, update.second);
+        }
+    }
+
+    mRequestQueue.tryPost([this, batch = std::move(batch)]()
+        {
+            applyRequestPriorities(batch);
         });
+}
 
-    return true;
+// Threads:  T*
+void LLTextureFetch::recordTrace(const LLUUID& id, F32 priority)
+{
+    // Only opened by the constructor, so safe to test unlocked
+    if (mTraceFile.is_open())
+    {
+        LLMutexLock lock(&mTraceMutex);                                 // +Mft
+        mTraceFile << llformat("%.1f ", mTraceTimer.getElapsedTimeF64() * 1000.0) << id << " " << priority << "\n";
+    }                                                                   // -Mft
+}
+
+// Threads:  Ttf
+void LLTextureFetch::applyRequestPriorities(const LLTextureFetchScheduler::priority_batch_t& batch)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    // The scheduler re-sifts only the entries whose priority moved and
+    // tells us which ones those were, the rest of the workers aren't
+    // touched.
+    LLTextureFetchScheduler::priority_batch_t changed;
+    mScheduler.publish(batch, changed);
+
+    for (const auto& update : changed)
+    {
+        LLTextureFetchWorker* worker = getWorker(update.first);
+        if (worker)
+        {
+            worker->lockWorkMutex();                                    // +Mw
+            worker->setImagePriority(update.second);
+            worker->unlockWorkMutex();                                  // -Mw
+        }
+    }
 }
 
 // Replicates and expands upon the base class's
@@ -2997,7 +3199,7 @@ void LLTextureFetch::commonUpdate()
     // Update low/high water levels based on pipelining.  We pick
     // up setting eventually, so the semaphore/request level can
     // fall outside the [0..HIGH_WATER] range.  Expect that.
-    if (LLAppViewer::instance()->getAppCoreHttp().isPipelined(LLAppCoreHttp::AP_TEXTURE))
+    if (LLAppViewer::instance() && LLAppViewer::instance()->getAppCoreHttp().isPipelined(LLAppCoreHttp::AP_TEXTURE))
     {
         mHttpHighWater = HTTP_PIPE_REQUESTS_HIGH_WATER;
         mHttpLowWater = HTTP_PIPE_REQUESTS_LOW_WATER;
@@ -3008,6 +3210,11 @@ void LLTextureFetch::commonUpdate()
         mHttpLowWater = HTTP_NONPIPE_REQUESTS_LOW_WATER;
     }
 
+    static LLCachedControl<U32> decode_budget(gSavedSettings, "TextureFetchDecodeBudget", 32);
+    static LLCachedControl<U32> upload_budget(gSavedSettings, "TextureFetchUploadBudget", 128);
+    mScheduler.setBudget(LLTextureFetchScheduler::STAGE_DECODE, decode_budget);
+    mScheduler.setBudget(LLTextureFetchScheduler::STAGE_UPLOAD, upload_budget);
+
     // Release waiters
     releaseHttpWaiters();
 
@@ -3039,6 +3246,8 @@ size_t LLTextureFetch::update(F32 max_time_ms)
         add(LLStatViewer::TEXTURE_NETWORK_DATA_RECEIVED, mHTTPTextureBits.exchange((U32Bits)0));
     }
 
+    publishRequestPriorities();
+
     size_t res = LLWorkerThread::update(max_time_ms);
 
     if (!mThreaded)
@@ -3283,11 +3492,11 @@ void LLTextureFetch::dump()
     }
 
     LL_INFOS(LOG_TXT) << "LLTextureFetch WAIT_HTTP_RESOURCE:" << LL_ENDL;
-    for (wait_http_res_queue_t::const_iterator iter(mHttpWaitResource.begin());
-         mHttpWaitResource.end() != iter;
-         ++iter)
+    std::vector<LLUUID> waiters;
+    mScheduler.getTopWaiters(LLTextureFetchScheduler::STAGE_HTTP, getHttpWaitersCount(), waiters);
+    for (const LLUUID& id : waiters)
     {
-        LL_INFOS(LOG_TXT) << " ID: " << (*iter) << LL_ENDL;
+        LL_INFOS(LOG_TXT) << " ID: " << id << LL_ENDL;
     }
 }
 
@@ -3298,43 +3507,28 @@ void LLTextureFetch::dump()
 // Threads:  Ttf
 void LLTextureFetch::addHttpWaiter(const LLUUID & tid)
 {
-    mNetworkQueueMutex.lock();                                          // +Mfnq
-    mHttpWaitResource.insert(tid);
-    mNetworkQueueMutex.unlock();                                        // -Mfnq
+    mScheduler.wait(tid, LLTextureFetchScheduler::STAGE_HTTP);
 }
 
 // Threads:  Ttf
 void LLTextureFetch::removeHttpWaiter(const LLUUID & tid)
 {
-    mNetworkQueueMutex.lock();                                          // +Mfnq
-    wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-    if (mHttpWaitResource.end() != iter)
-    {
-        mHttpWaitResource.erase(iter);
-    }
-    mNetworkQueueMutex.unlock();                                        // -Mfnq
+    mScheduler.cancelWait(tid, LLTextureFetchScheduler::STAGE_HTTP);
 }
 
 // Threads:  T*
 bool LLTextureFetch::isHttpWaiter(const LLUUID & tid)
 {
-    mNetworkQueueMutex.lock();                                          // +Mfnq
-    wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-    const bool ret(mHttpWaitResource.end() != iter);
-    mNetworkQueueMutex.unlock();                                        // -Mfnq
-    return ret;
+    return mScheduler.isWaiting(tid, LLTextureFetchScheduler::STAGE_HTTP);
 }
 
 // Release as many requests as permitted from the WAIT_HTTP_RESOURCE2
 // state to the SEND_HTTP_REQ state based on their current priority.
 //
-// This data structures and code associated with this looks a bit
-// indirect and naive but it's done in the name of safety.  An
-// ordered container may become invalid from time to time due to
-// priority changes caused by actions in other threads.  State itself
-// could also suffer the same fate with canceled operations.  Even
-// done this way, I'm not fully trusting we're truly safe.  This
-// module is due for a major refactoring and we'll deal with it then.
+// The waiters are kept in priority order by the scheduler, so this only
+// looks at as many of them as there are free slots.  They stay on the
+// waiter list until they have been released: deleteOK() relies on that
+// to keep a worker alive while we hold a pointer to it.
 //
 // Threads:  Ttf
 // Locks:  -Mw (must not hold any worker when called)
@@ -3354,67 +3548,27 @@ void LLTextureFetch::releaseHttpWaiters()
         return;
     }
 
-    // Quickly make a copy of all the LLUIDs.  Get off the
-    // mutex as early as possible.
-    typedef std::vector<LLUUID> uuid_vec_t;
-    uuid_vec_t tids;
-
-    {
-        LLMutexLock lock(&mNetworkQueueMutex);                          // +Mfnq
+    std::vector<LLUUID> tids;
+    mScheduler.getTopWaiters(LLTextureFetchScheduler::STAGE_HTTP, needed, tids);
 
-        if (mHttpWaitResource.empty())
-            return;
-        tids.reserve(mHttpWaitResource.size());
-        tids.assign(mHttpWaitResource.begin(), mHttpWaitResource.end());
-    }                                                                   // -Mfnq
-
-    // Now lookup the UUUIDs to find valid requests and sort
-    // them in priority order, highest to lowest.  We're going
-    // to modify priority later as a side-effect of releasing
-    // these objects.  That, in turn, would violate the partial
-    // ordering assumption of std::set, std::map, etc. so we
-    // don't use those containers.  We use a vector and an explicit
-    // sort to keep the containers valid later.
-    typedef std::vector<LLTextureFetchWorker *> worker_list_t;
-    worker_list_t tids2;
-
-    tids2.reserve(tids.size());
-    for (uuid_vec_t::iterator iter(tids.begin());
-         tids.end() != iter;
-         ++iter)
+    // Release workers up to the high water mark.  Since we aren't
+    // holding any locks at this point, we can be in competition
+    // with other callers.  Do defensive things like getting
+    // refreshed counts of requests and checking if someone else
+    // has moved any worker state around....
+    for (const LLUUID& tid : tids)
     {
-        LLTextureFetchWorker * worker(getWorker(* iter));
-        if (worker)
-        {
-            tids2.push_back(worker);
-        }
-        else
+        LLTextureFetchWorker * worker(getWorker(tid));
+        if (! worker)
         {
             // If worker isn't found, this should be due to a request
             // for deletion.  We signal our recognition that this
             // uuid shouldn't be used for resource waiting anymore by
             // erasing it from the resource waiter list.  That allows
             // deleteOK to do final deletion on the worker.
-            removeHttpWaiter(* iter);
+            removeHttpWaiter(tid);
+            continue;
         }
-    }
-    tids.clear();
-
-    // Sort into priority order, if necessary and only as much as needed
-    if (tids2.size() > needed)
-    {
-        LLTextureFetchWorker::Compare compare;
-        std::partial_sort(tids2.begin(), tids2.begin() + needed, tids2.end(), compare);
-    }
-
-    // Release workers up to the high water mark.  Since we aren't
-    // holding any locks at this point, we can be in competition
-    // with other callers.  Do defensive things like getting
-    // refreshed counts of requests and checking if someone else
-    // has moved any worker state around....
-    for (worker_list_t::iterator iter2(tids2.begin()); tids2.end() != iter2; ++iter2)
-    {
-        LLTextureFetchWorker * worker(* iter2);
 
         worker->lockWorkMutex();                                        // +Mw
         if (LLTextureFetchWorker::WAIT_HTTP_RESOURCE2 != worker->mState)
@@ -3446,18 +3600,13 @@ void LLTextureFetch::releaseHttpWaiters()
 // Threads:  T*
 void LLTextureFetch::cancelHttpWaiters()
 {
-    mNetworkQueueMutex.lock();                                          // +Mfnq
-    mHttpWaitResource.clear();
-    mNetworkQueueMutex.unlock();                                        // -Mfnq
+    mScheduler.clearWaiting(LLTextureFetchScheduler::STAGE_HTTP);
 }
 
 // Threads:  T*
 int LLTextureFetch::getHttpWaitersCount()
 {
-    mNetworkQueueMutex.lock();                                          // +Mfnq
-    int ret(mHttpWaitResource.size());
-    mNetworkQueueMutex.unlock();                                        // -Mfnq
-    return ret;
+    return mScheduler.getWaitingCount(LLTextureFetchScheduler::STAGE_HTTP);
 }
 
 
@@ -41,6 +41,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "lltrace.h"
+#include "lltexturefetchscheduler.h"
 #include "llviewertexture.h"
 
 class LLViewerTexture;
@@ -60,7 +61,7 @@ class LLTextureFetch final : public LLWorkerThread
 public:
     static std::string getStateString(S32 state);
 
-    LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mode);
+    LLTextureFetch(LLTextureCache* cache, LLImageDecodeThread* imagedecodethread, bool threaded, bool qa_mode);
     ~LLTextureFetch();
 
     class TFRequest;
@@ -99,6 +100,8 @@ class LLTextureFetch final : public LLWorkerThread
                             LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux,
                             LLCore::HttpStatus& last_http_get_status);
 
+    // Queues the new priority, the whole frame's worth of them is handed
+    // to the fetch thread in one go by update().
     // Threads:  T*
     bool updateRequestPriority(const LLUUID& id, F32 priority);
 
@@ -108,6 +111,14 @@ class LLTextureFetch final : public LLWorkerThread
     // Threads:  T* (but not safe)
     F32 getTextureBandwidth() { return mTextureBandwidth; }
 
+    // Levels of HTTP/2 stream weight textures are fetched with
+    static const S32 HTTP_WEIGHT_LEVELS = 4;
+
+    // Options for an HTTP GET of a texture of the given priority, with a
+    // stream weight that grows with it.
+    // Threads:  Ttf
+    LLCore::HttpOptions::ptr_t getHttpOptions(F32 priority) const;
+
     // Threads:  T*
     BOOL isFromLocalCache(const LLUUID& id);
 
@@ -236,6 +247,20 @@ class LLTextureFetch final : public LLWorkerThread
     // Threads:  T*
     void removeRequest(LLTextureFetchWorker* worker, bool cancel);
 
+    // Hands the priorities queued by updateRequestPriority() over to the
+    // fetch thread.
+    //
+    // Threads:  Tmain
+    void publishRequestPriorities();
+
+    // Threads:  Ttf
+    void applyRequestPriorities(const LLTextureFetchScheduler::priority_batch_t& batch);
+
+    // Appends "<ms> <id> <priority>" to the TextureFetchTraceFile, if any.
+    //
+    // Threads:  T*
+    void recordTrace(const LLUUID& id, F32 priority);
+
     // Overrides from the LLThread tree
     // Locks:  Ct
     bool runCondition() override;
@@ -309,6 +334,7 @@ class LLTextureFetch final : public LLWorkerThread
     LLMutex mNetworkQueueMutex; //to protect mHTTPTextureQueue
 
     LLTextureCache* mTextureCache;
+    LLImageDecodeThread* mImageDecodeThread;
 
     // Map of all requests by UUID
     typedef boost::unordered_map<LLUUID,LLTextureFetchWorker*> map_t;
@@ -347,7 +373,7 @@ class LLTextureFetch final : public LLWorkerThread
     // to make our HTTP requests.  These replace the various
     // LLCurl interfaces used in the past.
     LLCore::HttpRequest *               mHttpRequest;                   // Ttf
-    LLCore::HttpOptions::ptr_t          mHttpOptions;                   // Ttf
+    LLCore::HttpOptions::ptr_t          mHttpOptions[HTTP_WEIGHT_LEVELS]; // Ttf
     LLCore::HttpOptions::ptr_t          mHttpOptionsWithHeaders;        // Ttf
     LLCore::HttpHeaders::ptr_t          mHttpHeaders;                   // Ttf
     LLCore::HttpRequest::policy_t       mHttpPolicyClass;               // T*
@@ -369,8 +395,18 @@ class LLTextureFetch final : public LLWorkerThread
     // exceed the high water level (but not go below zero).
     LLAtomicS32                         mHttpSemaphore;                 // Ttf
 
-    typedef std::set<LLUUID> wait_http_res_queue_t;
-    wait_http_res_queue_t               mHttpWaitResource;              // Mfnq
+    // Orders the requests waiting in WAIT_HTTP_RESOURCE2 and those
+    // waiting to decode, and budgets decodes and uploads.
+    LLTextureFetchScheduler             mScheduler;                     // T*
+
+    // Priorities set since the last publishRequestPriorities()
+    LLMutex                             mPriorityMutex;
+    LLTextureFetchScheduler::priority_batch_t mPriorityUpdates;         // Mfp
+
+    // Request trace, see recordTrace()
+    LLMutex                             mTraceMutex;
+    llofstream                          mTraceFile;                     // Mft
+    LLTimer                             mTraceTimer;                    // Mft
 
     // Cumulative stats on the states/requests issued by
     // textures running through here.
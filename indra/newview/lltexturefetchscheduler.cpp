@@ -0,0 +1,462 @@
+/**
+ * @file lltexturefetchscheduler.cpp
+ * @brief Priority heaps and stage budgets for texture fetch requests
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturefetchscheduler.h"
+
+#include <algorithm>
+
+static const S32 DEFAULT_DECODE_BUDGET = 32;
+static const S32 DEFAULT_UPLOAD_BUDGET = 128;
+
+LLTextureFetchScheduler::LLTextureFetchScheduler()
+{
+    for (S32 i = 0; i < STAGE_COUNT; ++i)
+    {
+        mBudget[i] = 0;
+        mActive[i] = 0;
+    }
+    mBudget[STAGE_DECODE] = DEFAULT_DECODE_BUDGET;
+    mBudget[STAGE_UPLOAD] = DEFAULT_UPLOAD_BUDGET;
+}
+
+void LLTextureFetchScheduler::setBudget(EStage stage, S32 budget)
+{
+    LLMutexLock lock(&mMutex);
+    mBudget[stage] = llmax(budget, 1);
+}
+
+S32 LLTextureFetchScheduler::getBudget(EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    return mBudget[stage];
+}
+
+S32 LLTextureFetchScheduler::getActiveCount(EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    return mActive[stage];
+}
+
+S32 LLTextureFetchScheduler::getWaitingCount(EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    return (S32)mHeaps[stage].size();
+}
+
+void LLTextureFetchScheduler::addRequest(const LLUUID& id, F32 priority)
+{
+    LLMutexLock lock(&mMutex);
+    Entry& entry = getEntry(id);
+    entry.mRegistered = true;
+    if (entry.mPriority != priority)
+    {
+        entry.mPriority = priority;
+        for (S32 i = 0; i < STAGE_COUNT; ++i)
+        {
+            heapUpdate((EStage)i, entry);
+        }
+    }
+}
+
+void LLTextureFetchScheduler::removeRequest(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    Entry* entry = findEntry(id);
+    if (!entry)
+    {
+        return;
+    }
+
+    entry->mRegistered = false;
+    for (S32 i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (entry->mHolds[i])
+        {
+            entry->mHolds[i] = false;
+            --mActive[i];
+        }
+        if (i != STAGE_HTTP)
+        {
+            heapRemove((EStage)i, *entry);
+        }
+    }
+    pruneEntry(*entry);
+}
+
+void LLTextureFetchScheduler::clear()
+{
+    LLMutexLock lock(&mMutex);
+    for (S32 i = 0; i < STAGE_COUNT; ++i)
+    {
+        mHeaps[i].clear();
+        mActive[i] = 0;
+    }
+    mEntries.clear();
+}
+
+void LLTextureFetchScheduler::publish(const priority_batch_t& batch, priority_batch_t& changed)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    LLMutexLock lock(&mMutex);
+    for (const auto& update : batch)
+    {
+        Entry* entry = findEntry(update.first);
+        if (!entry || entry->mPriority == update.second)
+        {
+            continue;
+        }
+
+        entry->mPriority = update.second;
+        changed.push_back(update);
+        if (update.second < F_ALMOST_ZERO)
+        {
+            // Stale, nobody is looking at it.  Stop it from competing and
+            // free the slot its decoded image was holding.
+            for (S32 i = 0; i < STAGE_COUNT; ++i)
+            {
+                heapRemove((EStage)i, *entry);
+            }
+            if (entry->mHolds[STAGE_UPLOAD])
+            {
+                entry->mHolds[STAGE_UPLOAD] = false;
+                --mActive[STAGE_UPLOAD];
+            }
+            pruneEntry(*entry);
+        }
+        else
+        {
+            for (S32 i = 0; i < STAGE_COUNT; ++i)
+            {
+                heapUpdate((EStage)i, *entry);
+            }
+        }
+    }
+}
+
+F32 LLTextureFetchScheduler::getPriority(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    Entry* entry = findEntry(id);
+    return entry ? entry->mPriority : 0.f;
+}
+
+bool LLTextureFetchScheduler::acquire(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    Entry& entry = getEntry(id);
+    if (entry.mHolds[stage])
+    {
+        return true;
+    }
+
+    // A slot is ours if there are more of them free than there are more
+    // important requests waiting for one.  Counting rather than insisting
+    // on being the head keeps the stage moving when the head is slow to
+    // come back for its slot.
+    const S32 free_slots = getFreeSlots(stage);
+    if (free_slots > 0 && countHigher(stage, entry.mPriority, free_slots) < free_slots)
+    {
+        heapRemove(stage, entry);
+        entry.mHolds[stage] = true;
+        ++mActive[stage];
+        return true;
+    }
+
+    heapInsert(stage, entry);
+    return false;
+}
+
+void LLTextureFetchScheduler::hold(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    Entry& entry = getEntry(id);
+    heapRemove(stage, entry);
+    if (!entry.mHolds[stage])
+    {
+        entry.mHolds[stage] = true;
+        ++mActive[stage];
+    }
+}
+
+void LLTextureFetchScheduler::release(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    Entry* entry = findEntry(id);
+    if (entry && entry->mHolds[stage])
+    {
+        entry->mHolds[stage] = false;
+        --mActive[stage];
+        pruneEntry(*entry);
+    }
+}
+
+void LLTextureFetchScheduler::wait(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    heapInsert(stage, getEntry(id));
+}
+
+void LLTextureFetchScheduler::cancelWait(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    Entry* entry = findEntry(id);
+    if (entry)
+    {
+        heapRemove(stage, *entry);
+        pruneEntry(*entry);
+    }
+}
+
+bool LLTextureFetchScheduler::isWaiting(const LLUUID& id, EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    Entry* entry = findEntry(id);
+    return entry && entry->mHeapIndex[stage] >= 0;
+}
+
+void LLTextureFetchScheduler::clearWaiting(EStage stage)
+{
+    LLMutexLock lock(&mMutex);
+    heap_t heap;
+    heap.swap(mHeaps[stage]);
+    for (Entry* entry : heap)
+    {
+        entry->mHeapIndex[stage] = -1;
+        pruneEntry(*entry);
+    }
+}
+
+void LLTextureFetchScheduler::getTopWaiters(EStage stage, S32 count, std::vector<LLUUID>& ids)
+{
+    LLMutexLock lock(&mMutex);
+    const heap_t& heap = mHeaps[stage];
+    if (heap.empty() || count <= 0)
+    {
+        return;
+    }
+
+    // Walk the heap best first without disturbing it: the next best
+    // entry is always a child of one already taken.
+    auto worse = [&heap](S32 a, S32 b) { return heap[a]->mPriority < heap[b]->mPriority; };
+    std::vector<S32> frontier;
+    frontier.reserve(count + 1);
+    frontier.push_back(0);
+    while (!frontier.empty() && count > 0)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), worse);
+        const S32 index = frontier.back();
+        frontier.pop_back();
+        ids.push_back(heap[index]->mID);
+        --count;
+
+        for (S32 child = index * 2 + 1; child <= index * 2 + 2 && child < (S32)heap.size(); ++child)
+        {
+            frontier.push_back(child);
+            std::push_heap(frontier.begin(), frontier.end(), worse);
+        }
+    }
+}
+
+// Locks:  mMutex
+LLTextureFetchScheduler::Entry& LLTextureFetchScheduler::getEntry(const LLUUID& id)
+{
+    auto result = mEntries.emplace(id, Entry());
+    Entry& entry = result.first->second;
+    if (result.second)
+    {
+        entry.mID = id;
+        entry.mPriority = 0.f;
+        for (S32 i = 0; i < STAGE_COUNT; ++i)
+        {
+            entry.mHeapIndex[i] = -1;
+            entry.mHolds[i] = false;
+        }
+        entry.mRegistered = false;
+    }
+    return entry;
+}
+
+// Locks:  mMutex
+LLTextureFetchScheduler::Entry* LLTextureFetchScheduler::findEntry(const LLUUID& id)
+{
+    auto it = mEntries.find(id);
+    return it != mEntries.end() ? &it->second : nullptr;
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::pruneEntry(Entry& entry)
+{
+    if (entry.mRegistered)
+    {
+        return;
+    }
+    for (S32 i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (entry.mHolds[i] || entry.mHeapIndex[i] >= 0)
+        {
+            return;
+        }
+    }
+    mEntries.erase(entry.mID);
+}
+
+// Locks:  mMutex
+S32 LLTextureFetchScheduler::getFreeSlots(EStage stage) const
+{
+    S32 free_slots = mBudget[stage] - mActive[stage];
+    if (stage == STAGE_DECODE)
+    {
+        // Don't decode what the main thread has no room to take
+        free_slots = llmin(free_slots, mBudget[STAGE_UPLOAD] - mActive[STAGE_UPLOAD] - mActive[STAGE_DECODE]);
+    }
+    return free_slots;
+}
+
+// Number of waiters in stage more important than priority, counting no
+// further than limit.  Only visits entries that are counted, plus their
+// children.
+//
+// Locks:  mMutex
+S32 LLTextureFetchScheduler::countHigher(EStage stage, F32 priority, S32 limit) const
+{
+    const heap_t& heap = mHeaps[stage];
+    S32 count = 0;
+    std::vector<S32> pending;
+    if (!heap.empty())
+    {
+        pending.push_back(0);
+    }
+    while (!pending.empty() && count < limit)
+    {
+        const S32 index = pending.back();
+        pending.pop_back();
+        if (heap[index]->mPriority <= priority)
+        {
+            continue;
+        }
+        ++count;
+        for (S32 child = index * 2 + 1; child <= index * 2 + 2 && child < (S32)heap.size(); ++child)
+        {
+            pending.push_back(child);
+        }
+    }
+    return count;
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::heapInsert(EStage stage, Entry& entry)
+{
+    if (entry.mHeapIndex[stage] >= 0)
+    {
+        return;
+    }
+    heap_t& heap = mHeaps[stage];
+    heap.push_back(&entry);
+    entry.mHeapIndex[stage] = (S32)heap.size() - 1;
+    siftUp(stage, entry.mHeapIndex[stage]);
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::heapRemove(EStage stage, Entry& entry)
+{
+    const S32 index = entry.mHeapIndex[stage];
+    if (index < 0)
+    {
+        return;
+    }
+    heap_t& heap = mHeaps[stage];
+    Entry* last = heap.back();
+    heap.pop_back();
+    entry.mHeapIndex[stage] = -1;
+    if (last != &entry)
+    {
+        heapSet(stage, index, last);
+        heapUpdate(stage, *last);
+    }
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::heapUpdate(EStage stage, Entry& entry)
+{
+    const S32 index = entry.mHeapIndex[stage];
+    if (index < 0)
+    {
+        return;
+    }
+    siftUp(stage, index);
+    siftDown(stage, entry.mHeapIndex[stage]);
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::siftUp(EStage stage, S32 index)
+{
+    heap_t& heap = mHeaps[stage];
+    Entry* entry = heap[index];
+    while (index > 0)
+    {
+        const S32 parent = (index - 1) / 2;
+        if (heap[parent]->mPriority >= entry->mPriority)
+        {
+            break;
+        }
+        heapSet(stage, index, heap[parent]);
+        index = parent;
+    }
+    heapSet(stage, index, entry);
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::siftDown(EStage stage, S32 index)
+{
+    heap_t& heap = mHeaps[stage];
+    const S32 size = (S32)heap.size();
+    Entry* entry = heap[index];
+    while (true)
+    {
+        S32 child = index * 2 + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && heap[child + 1]->mPriority > heap[child]->mPriority)
+        {
+            ++child;
+        }
+        if (heap[child]->mPriority <= entry->mPriority)
+        {
+            break;
+        }
+        heapSet(stage, index, heap[child]);
+        index = child;
+    }
+    heapSet(stage, index, entry);
+}
+
+// Locks:  mMutex
+void LLTextureFetchScheduler::heapSet(EStage stage, S32 index, Entry* entry)
+{
+    mHeaps[stage][index] = entry;
+    entry->mHeapIndex[stage] = index;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file lltexturefetchscheduler.h
+ * @brief Priority heaps and stage budgets for texture fetch requests
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREFETCHSCHEDULER_H
+#define LL_LLTEXTUREFETCHSCHEDULER_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <vector>
+
+// Decides which texture fetch requests get to move through the expensive
+// stages of a fetch, and in what order.
+//
+// Every request has an importance (the texture's decode priority, roughly
+// its screen space size).  A request that wants a stage which is over
+// budget waits in that stage's heap, which is indexed so a change of
+// importance only re-sifts the one entry instead of re-sorting everyone.
+// The main thread hands over new importance values in one batch per frame
+// through publish().
+//
+// Stages:
+//  - HTTP: only the waiting order lives here, the number of requests in
+//    flight is counted by LLTextureFetch's HTTP semaphore.
+//  - DECODE: decodes posted to the image decode pool.
+//  - UPLOAD: decoded images the main thread has not collected yet.  These
+//    are never refused, instead new decodes are held back while the total
+//    would go over the upload budget.
+//
+// A request whose importance drops to zero is stale: it leaves the waiting
+// heaps at once and gives back its upload slot.
+//
+// All methods are thread safe.
+class LLTextureFetchScheduler
+{
+public:
+    enum EStage
+    {
+        STAGE_HTTP = 0,
+        STAGE_DECODE,
+        STAGE_UPLOAD,
+        STAGE_COUNT
+    };
+
+    typedef std::vector<std::pair<LLUUID, F32> > priority_batch_t;
+
+    LLTextureFetchScheduler();
+
+    void setBudget(EStage stage, S32 budget);
+    S32 getBudget(EStage stage);
+    S32 getActiveCount(EStage stage);
+    S32 getWaitingCount(EStage stage);
+
+    // Register a request or refresh its importance.
+    void addRequest(const LLUUID& id, F32 priority);
+    // Release everything id holds and stop it waiting, except for HTTP:
+    // LLTextureFetch drops HTTP waiters itself once it is safe to.
+    void removeRequest(const LLUUID& id);
+    void clear();
+
+    // Apply new importance values.  Entries for unknown ids are ignored.
+    // The ones that actually changed are appended to changed.
+    void publish(const priority_batch_t& batch, priority_batch_t& changed);
+    F32 getPriority(const LLUUID& id);
+
+    // Take a slot in stage if one is free for a request of this
+    // importance, otherwise wait in the stage's heap and return false.
+    // Calling again while holding the slot also returns true.
+    bool acquire(const LLUUID& id, EStage stage);
+    // Take a slot regardless of the budget.
+    void hold(const LLUUID& id, EStage stage);
+    // Give back a slot taken by acquire() or hold(), if any.
+    void release(const LLUUID& id, EStage stage);
+
+    // Waiting without a slot, for stages whose slots are counted elsewhere.
+    void wait(const LLUUID& id, EStage stage);
+    void cancelWait(const LLUUID& id, EStage stage);
+    bool isWaiting(const LLUUID& id, EStage stage);
+    void clearWaiting(EStage stage);
+    // Up to count waiters of stage, most important first.  They stay in
+    // the heap.
+    void getTopWaiters(EStage stage, S32 count, std::vector<LLUUID>& ids);
+
+private:
+    struct Entry
+    {
+        LLUUID mID;
+        F32 mPriority;
+        S32 mHeapIndex[STAGE_COUNT];    // -1 when not waiting
+        bool mHolds[STAGE_COUNT];
+        bool mRegistered;               // between addRequest and removeRequest
+    };
+    typedef std::vector<Entry*> heap_t;
+
+    Entry& getEntry(const LLUUID& id);
+    Entry* findEntry(const LLUUID& id);
+    void pruneEntry(Entry& entry);
+    S32 getFreeSlots(EStage stage) const;
+    S32 countHigher(EStage stage, F32 priority, S32 limit) const;
+
+    void heapInsert(EStage stage, Entry& entry);
+    void heapRemove(EStage stage, Entry& entry);
+    void heapUpdate(EStage stage, Entry& entry);
+    void siftUp(EStage stage, S32 index);
+    void siftDown(EStage stage, S32 index);
+    void heapSet(EStage stage, S32 index, Entry* entry);
+
+    LLMutex mMutex;
+    boost::unordered_map<LLUUID, Entry> mEntries;   // node based, pointers stay valid
+    heap_t mHeaps[STAGE_COUNT];                     // max heaps on mPriority
+    S32 mBudget[STAGE_COUNT];
+    S32 mActive[STAGE_COUNT];
+};
+
+#endif // LL_LLTEXTUREFETCHSCHEDULER_H
@@ -0,0 +1,721 @@
+/**
+ * @file lltextureslabstore.cpp
+ * @brief Memory mapped slab storage for texture cache bodies
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltextureslabstore.h"
+
+#include "hbxxh.h"
+#include "lldir.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bip = boost::interprocess;
+
+static const U32 SLAB_RECORD_MAGIC = 0x424c5354;     // 'TSLB'
+static const U32 SLAB_JOURNAL_MAGIC = 0x4c4e524a;    // 'JRNL'
+static const U32 SLAB_INDEX_MAGIC = 0x58444e49;      // 'INDX'
+static const U32 SLAB_FILE_VERSION = 1;
+
+// Bound the slab count so a huge cache setting doesn't map thousands of files.
+static const U32 SLAB_COUNT_MAX = 1024;
+// Fold the journal into a checkpoint after this many operations.
+static const U32 JOURNAL_OPS_MAX = 65536;
+
+static const char* JOURNAL_FILENAME = "slabs.journal";
+static const char* INDEX_FILENAME = "slabs.index";
+
+namespace
+{
+    // Prefixed to every record in a slab.
+    struct RecordHeader
+    {
+        U32 mMagic;
+        U32 mSize;
+        LLUUID mID;
+        U64 mHash;
+    };
+    static_assert(sizeof(RecordHeader) == 32, "slab record header layout changed");
+
+    struct FileHeader
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U32 mSlabSize;
+        U32 mSlabCount;
+    };
+
+    struct IndexHeader
+    {
+        FileHeader mFile;
+        U32 mHead;
+        U32 mEntries;
+    };
+}
+
+struct LLTextureSlabStore::JournalOp
+{
+    enum { PUT = 1, DEL, RECYCLE };
+
+    U32 mOp;
+    U32 mSlab;
+    U32 mOffset;
+    U32 mSize;
+    U64 mHash;
+    LLUUID mID;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+LLTextureSlabStore::Index::Index()
+:   mCount(0),
+    mTombstones(0)
+{
+}
+
+size_t LLTextureSlabStore::Index::probe(const LLUUID& id) const
+{
+    // UUIDs are random enough that any 8 bytes make a good hash.
+    U64 hash;
+    memcpy(&hash, id.mData, sizeof(hash));
+
+    const size_t mask = mSlots.size() - 1;
+    size_t idx = hash & mask;
+    size_t first_free = mSlots.size();
+    while (true)
+    {
+        const Slot& slot = mSlots[idx];
+        if (slot.mState == EMPTY)
+        {
+            return first_free < mSlots.size() ? first_free : idx;
+        }
+        if (slot.mState == TOMBSTONE)
+        {
+            if (first_free == mSlots.size())
+            {
+                first_free = idx;
+            }
+        }
+        else if (slot.mID == id)
+        {
+            return idx;
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
+void LLTextureSlabStore::Index::rehash(size_t capacity)
+{
+    std::vector<Slot> old_slots(capacity);
+    old_slots.swap(mSlots);
+    mCount = 0;
+    mTombstones = 0;
+    for (const Slot& slot : old_slots)
+    {
+        if (slot.mState == FULL)
+        {
+            insert(slot.mID, slot.mLoc);
+        }
+    }
+}
+
+LLTextureSlabStore::Location* LLTextureSlabStore::Index::find(const LLUUID& id)
+{
+    if (mSlots.empty())
+    {
+        return nullptr;
+    }
+    Slot& slot = mSlots[probe(id)];
+    return slot.mState == FULL ? &slot.mLoc : nullptr;
+}
+
+void LLTextureSlabStore::Index::insert(const LLUUID& id, const Location& loc)
+{
+    // Keep the load factor, tombstones included, under 70%.
+    if ((mCount + mTombstones + 1) * 10 > mSlots.size() * 7)
+    {
+        size_t capacity = llmax(mSlots.size(), (size_t)64);
+        while ((mCount + 1) * 10 > capacity * 4)
+        {
+            capacity *= 2;
+        }
+        rehash(capacity);
+    }
+
+    Slot& slot = mSlots[probe(id)];
+    if (slot.mState != FULL)
+    {
+        if (slot.mState == TOMBSTONE)
+        {
+            --mTombstones;
+        }
+        slot.mID = id;
+        slot.mState = FULL;
+        ++mCount;
+    }
+    slot.mLoc = loc;
+}
+
+bool LLTextureSlabStore::Index::erase(const LLUUID& id, Location* old_loc)
+{
+    if (mSlots.empty())
+    {
+        return false;
+    }
+    Slot& slot = mSlots[probe(id)];
+    if (slot.mState != FULL)
+    {
+        return false;
+    }
+    if (old_loc)
+    {
+        *old_loc = slot.mLoc;
+    }
+    slot.mState = TOMBSTONE;
+    --mCount;
+    ++mTombstones;
+    return true;
+}
+
+void LLTextureSlabStore::Index::clear()
+{
+    mSlots.clear();
+    mCount = 0;
+    mTombstones = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+LLTextureSlabStore::LLTextureSlabStore(const std::string& dirname, S64 max_size, U32 slab_size)
+:   mDirName(dirname),
+    mSlabSize(slab_size),
+    mSlabCount(1),
+    mHead(0),
+    mLiveBytes(0),
+    mJournal(nullptr),
+    mJournalOps(0)
+{
+    llassert(mSlabSize > sizeof(RecordHeader));
+    if (max_size > 0)
+    {
+        mSlabCount = (U32)llclamp((max_size + mSlabSize - 1) / mSlabSize, (S64)1, (S64)SLAB_COUNT_MAX);
+    }
+}
+
+LLTextureSlabStore::~LLTextureSlabStore()
+{
+    close();
+}
+
+// static
+U32 LLTextureSlabStore::recordBytes(U32 size)
+{
+    return (U32)((sizeof(RecordHeader) + size + 15) & ~15);
+}
+
+bool LLTextureSlabStore::open()
+{
+    LLMutexLock lock(&mMutex);
+    if (isOpen())
+    {
+        return true;
+    }
+
+    LLFile::mkdir(mDirName);
+    if (!mapSlabs())
+    {
+        unmapSlabs();
+        return false;
+    }
+
+    resetState();
+    const std::string index_filename = mDirName + gDirUtilp->getDirDelimiter() + INDEX_FILENAME;
+    bool restored = loadCheckpoint(index_filename) || loadCheckpoint(index_filename + ".tmp");
+    if (restored)
+    {
+        replayJournal();
+        validateIndex();
+    }
+    else
+    {
+        resetState();
+    }
+
+    checkpoint();
+
+    LL_INFOS("TextureCache") << "Slab store " << mDirName << ": " << mSlabCount << " x " << (mSlabSize >> 20)
+                             << "MB slabs, " << mIndex.size() << " bodies, " << mLiveBytes << " bytes"
+                             << (restored ? "" : " (new)") << LL_ENDL;
+    return restored;
+}
+
+void LLTextureSlabStore::close()
+{
+    LLMutexLock lock(&mMutex);
+    if (!isOpen())
+    {
+        return;
+    }
+    checkpoint();
+    if (mJournal)
+    {
+        LLFile::close(mJournal);
+        mJournal = nullptr;
+    }
+    unmapSlabs();
+    // The index points into the slabs just unmapped
+    resetState();
+}
+
+bool LLTextureSlabStore::mapSlabs()
+{
+    const std::string delem = gDirUtilp->getDirDelimiter();
+    mSlabs.reserve(mSlabCount);
+    for (U32 i = 0; i < mSlabCount; ++i)
+    {
+        const std::string filename = llformat("%s%sslab_%02u.dat", mDirName.c_str(), delem.c_str(), i);
+        try
+        {
+            if (!LLFile::isfile(filename))
+            {
+                LLFILE* fp = LLFile::fopen(filename, "wb");
+                if (!fp)
+                {
+                    LL_WARNS("TextureCache") << "Unable to create " << filename << LL_ENDL;
+                    return false;
+                }
+                LLFile::close(fp);
+            }
+            // Sparse where the filesystem allows, so an empty cache costs nothing.
+            if (boost::filesystem::file_size(filename) != mSlabSize)
+            {
+                boost::filesystem::resize_file(filename, mSlabSize);
+            }
+            bip::file_mapping mapping(filename.c_str(), bip::read_write);
+            mSlabs.emplace_back(new bip::mapped_region(mapping, bip::read_write, 0, mSlabSize));
+        }
+        catch (const std::exception& e)
+        {
+            LL_WARNS("TextureCache") << "Unable to map " << filename << ": " << e.what() << LL_ENDL;
+            return false;
+        }
+    }
+    return true;
+}
+
+void LLTextureSlabStore::unmapSlabs()
+{
+    for (auto& slab : mSlabs)
+    {
+        slab->flush(0, 0, true);
+    }
+    mSlabs.clear();
+}
+
+void LLTextureSlabStore::resetState()
+{
+    mIndex.clear();
+    mSlabUsed.assign(mSlabCount, 0);
+    mSlabLive.assign(mSlabCount, 0);
+    mHead = 0;
+    mLiveBytes = 0;
+}
+
+bool LLTextureSlabStore::loadCheckpoint(const std::string& filename)
+{
+    LLFILE* fp = LLFile::fopen(filename, "rb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    bool ok = false;
+    IndexHeader header;
+    if (fread(&header, sizeof(header), 1, fp) == 1
+        && header.mFile.mMagic == SLAB_INDEX_MAGIC
+        && header.mFile.mVersion == SLAB_FILE_VERSION
+        && header.mFile.mSlabSize == mSlabSize
+        && header.mFile.mSlabCount == mSlabCount
+        && header.mHead < mSlabCount
+        && fread(mSlabUsed.data(), sizeof(U32), mSlabCount, fp) == mSlabCount)
+    {
+        mHead = header.mHead;
+        ok = true;
+        JournalOp op;
+        for (U32 i = 0; i < header.mEntries; ++i)
+        {
+            if (fread(&op, sizeof(op), 1, fp) != 1)
+            {
+                ok = false;
+                break;
+            }
+            applyOp(op);
+        }
+    }
+    LLFile::close(fp);
+
+    if (!ok)
+    {
+        LL_WARNS("TextureCache") << "Discarding unusable slab index " << filename << LL_ENDL;
+        resetState();
+    }
+    return ok;
+}
+
+void LLTextureSlabStore::replayJournal()
+{
+    const std::string filename = mDirName + gDirUtilp->getDirDelimiter() + JOURNAL_FILENAME;
+    LLFILE* fp = LLFile::fopen(filename, "rb");
+    if (!fp)
+    {
+        return;
+    }
+
+    FileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) == 1
+        && header.mMagic == SLAB_JOURNAL_MAGIC
+        && header.mVersion == SLAB_FILE_VERSION
+        && header.mSlabSize == mSlabSize
+        && header.mSlabCount == mSlabCount)
+    {
+        // The checkpoint may already include some of these operations if
+        // we died between writing it and truncating the journal; applying
+        // them again in order ends up in the same state.  A torn final op
+        // is simply not read.
+        U32 count = 0;
+        JournalOp op;
+        while (fread(&op, sizeof(op), 1, fp) == 1)
+        {
+            applyOp(op);
+            ++count;
+        }
+        if (count)
+        {
+            LL_INFOS("TextureCache") << "Replayed " << count << " slab journal entries" << LL_ENDL;
+        }
+    }
+    LLFile::close(fp);
+}
+
+void LLTextureSlabStore::applyOp(const JournalOp& op)
+{
+    if (op.mSlab >= mSlabCount)
+    {
+        return;
+    }
+
+    switch (op.mOp)
+    {
+    case JournalOp::PUT:
+        if (op.mOffset + recordBytes(op.mSize) <= mSlabSize)
+        {
+            mIndex.insert(op.mID, { op.mSlab, op.mOffset, op.mSize, op.mHash });
+            mSlabUsed[op.mSlab] = llmax(mSlabUsed[op.mSlab], op.mOffset + recordBytes(op.mSize));
+            mHead = op.mSlab;
+        }
+        break;
+    case JournalOp::DEL:
+        mIndex.erase(op.mID);
+        break;
+    case JournalOp::RECYCLE:
+    {
+        const U32 slab = op.mSlab;
+        mIndex.eraseIf([slab](const LLUUID&, const Location& loc) { return loc.mSlab == slab; });
+        mSlabUsed[slab] = 0;
+        mHead = slab;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LLTextureSlabStore::validateIndex()
+{
+    // Make sure what the index points at is actually there; the slab
+    // pages and the journal are flushed independently.
+    U32 dropped = 0;
+    mIndex.eraseIf([this, &dropped](const LLUUID& id, const Location& loc)
+        {
+            bool valid = false;
+            if (loc.mOffset + recordBytes(loc.mSize) <= mSlabUsed[loc.mSlab])
+            {
+                const RecordHeader* header =
+                    reinterpret_cast<const RecordHeader*>((U8*)mSlabs[loc.mSlab]->get_address() + loc.mOffset);
+                valid = header->mMagic == SLAB_RECORD_MAGIC && header->mSize == loc.mSize
+                        && header->mID == id && header->mHash == loc.mHash;
+            }
+            dropped += valid ? 0 : 1;
+            return !valid;
+        });
+    if (dropped)
+    {
+        LL_WARNS("TextureCache") << "Dropped " << dropped << " invalid slab records" << LL_ENDL;
+    }
+
+    mSlabLive.assign(mSlabCount, 0);
+    mLiveBytes = 0;
+    mIndex.forEach([this](const LLUUID&, const Location& loc)
+        {
+            mSlabLive[loc.mSlab] += recordBytes(loc.mSize);
+            mLiveBytes += loc.mSize;
+        });
+}
+
+void LLTextureSlabStore::openJournal(bool truncate)
+{
+    if (mJournal)
+    {
+        LLFile::close(mJournal);
+        mJournal = nullptr;
+    }
+
+    const std::string filename = mDirName + gDirUtilp->getDirDelimiter() + JOURNAL_FILENAME;
+    mJournal = LLFile::fopen(filename, truncate ? "wb" : "ab");
+    if (!mJournal)
+    {
+        LL_WARNS("TextureCache") << "Unable to open slab journal " << filename << LL_ENDL;
+        return;
+    }
+    if (truncate)
+    {
+        FileHeader header = { SLAB_JOURNAL_MAGIC, SLAB_FILE_VERSION, mSlabSize, mSlabCount };
+        fwrite(&header, sizeof(header), 1, mJournal);
+        fflush(mJournal);
+    }
+    mJournalOps = 0;
+}
+
+void LLTextureSlabStore::appendJournal(const JournalOp& op)
+{
+    if (mJournal)
+    {
+        fwrite(&op, sizeof(op), 1, mJournal);
+        fflush(mJournal);
+    }
+    if (++mJournalOps >= JOURNAL_OPS_MAX)
+    {
+        checkpoint();
+    }
+}
+
+void LLTextureSlabStore::checkpoint()
+{
+    // Slab contents must reach the disk before an index that refers to them.
+    for (auto& slab : mSlabs)
+    {
+        slab->flush(0, 0, false);
+    }
+
+    const std::string filename = mDirName + gDirUtilp->getDirDelimiter() + INDEX_FILENAME;
+    const std::string tmp_filename = filename + ".tmp";
+    LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+    if (!fp)
+    {
+        LL_WARNS("TextureCache") << "Unable to write slab index " << tmp_filename << LL_ENDL;
+        return;
+    }
+
+    IndexHeader header = { { SLAB_INDEX_MAGIC, SLAB_FILE_VERSION, mSlabSize, mSlabCount }, mHead, mIndex.size() };
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+              && fwrite(mSlabUsed.data(), sizeof(U32), mSlabCount, fp) == mSlabCount;
+    mIndex.forEach([fp, &ok](const LLUUID& id, const Location& loc)
+        {
+            JournalOp op = { JournalOp::PUT, loc.mSlab, loc.mOffset, loc.mSize, loc.mHash, id };
+            ok = ok && fwrite(&op, sizeof(op), 1, fp) == 1;
+        });
+    ok = (LLFile::close(fp) == 0) && ok;
+    if (!ok)
+    {
+        LL_WARNS("TextureCache") << "Failed writing slab index " << tmp_filename << LL_ENDL;
+        LLFile::remove(tmp_filename);
+        return;
+    }
+
+    LLFile::remove(filename, ENOENT);
+    if (LLFile::rename(tmp_filename, filename) != 0)
+    {
+        // loadCheckpoint() falls back on the .tmp file
+        return;
+    }
+    openJournal(true);
+}
+
+void LLTextureSlabStore::dropLocation(const Location& loc)
+{
+    mSlabLive[loc.mSlab] -= recordBytes(loc.mSize);
+    mLiveBytes -= loc.mSize;
+}
+
+void LLTextureSlabStore::recycleSlab(U32 slab)
+{
+    mIndex.eraseIf([this, slab](const LLUUID& id, const Location& loc)
+        {
+            if (loc.mSlab != slab)
+            {
+                return false;
+            }
+            mEvicted.push_back(id);
+            mLiveBytes -= loc.mSize;
+            return true;
+        });
+    mSlabUsed[slab] = 0;
+    mSlabLive[slab] = 0;
+
+    JournalOp op = { JournalOp::RECYCLE, slab, 0, 0, 0, LLUUID::null };
+    appendJournal(op);
+}
+
+S32 LLTextureSlabStore::getSize(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    if (!isOpen())
+    {
+        return 0;
+    }
+    const Location* loc = mIndex.find(id);
+    return loc ? (S32)loc->mSize : 0;
+}
+
+S32 LLTextureSlabStore::read(const LLUUID& id, U8* dst, S32 offset, S32 size)
+{
+    LLMutexLock lock(&mMutex);
+    if (!isOpen())
+    {
+        return -1;
+    }
+    Location* loc = mIndex.find(id);
+    if (!loc || offset < 0 || size < 0 || (U32)offset > loc->mSize)
+    {
+        return -1;
+    }
+
+    const U8* record = (const U8*)mSlabs[loc->mSlab]->get_address() + loc->mOffset;
+    const RecordHeader* header = reinterpret_cast<const RecordHeader*>(record);
+    const U8* data = record + sizeof(RecordHeader);
+    if (header->mMagic != SLAB_RECORD_MAGIC || header->mID != id || header->mSize != loc->mSize
+        || HBXXH64::digest(data, loc->mSize) != loc->mHash)
+    {
+        LL_WARNS("TextureCache") << "Corrupt slab record for " << id << ", dropping it" << LL_ENDL;
+        Location old_loc = *loc;
+        mIndex.erase(id);
+        dropLocation(old_loc);
+        JournalOp op = { JournalOp::DEL, old_loc.mSlab, old_loc.mOffset, 0, 0, id };
+        appendJournal(op);
+        return -1;
+    }
+
+    const S32 bytes = llmin(size, (S32)loc->mSize - offset);
+    memcpy(dst, data + offset, bytes);
+    return bytes;
+}
+
+S32 LLTextureSlabStore::write(const LLUUID& id, const U8* src, S32 size)
+{
+    LLMutexLock lock(&mMutex);
+    if (!isOpen() || size <= 0)
+    {
+        return -1;
+    }
+    const U32 bytes = recordBytes(size);
+    if (bytes > mSlabSize)
+    {
+        return -1;
+    }
+
+    // Release the previous copy first so recycling below doesn't report
+    // it as evicted.
+    Location old_loc;
+    if (mIndex.erase(id, &old_loc))
+    {
+        dropLocation(old_loc);
+    }
+
+    if (mSlabUsed[mHead] + bytes > mSlabSize)
+    {
+        mHead = (mHead + 1) % mSlabCount;
+        recycleSlab(mHead);
+    }
+
+    const U32 offset = mSlabUsed[mHead];
+    U8* record = (U8*)mSlabs[mHead]->get_address() + offset;
+    RecordHeader header = { SLAB_RECORD_MAGIC, (U32)size, id, HBXXH64::digest(src, size) };
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), src, size);
+
+    Location loc = { mHead, offset, (U32)size, header.mHash };
+    mIndex.insert(id, loc);
+    mSlabUsed[mHead] += bytes;
+    mSlabLive[mHead] += bytes;
+    mLiveBytes += size;
+
+    JournalOp op = { JournalOp::PUT, loc.mSlab, loc.mOffset, loc.mSize, loc.mHash, id };
+    appendJournal(op);
+    return size;
+}
+
+bool LLTextureSlabStore::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    Location old_loc;
+    if (!isOpen() || !mIndex.erase(id, &old_loc))
+    {
+        return false;
+    }
+    dropLocation(old_loc);
+    JournalOp op = { JournalOp::DEL, old_loc.mSlab, old_loc.mOffset, 0, 0, id };
+    appendJournal(op);
+    return true;
+}
+
+void LLTextureSlabStore::clear()
+{
+    LLMutexLock lock(&mMutex);
+    resetState();
+    mEvicted.clear();
+    if (isOpen())
+    {
+        checkpoint();
+    }
+}
+
+void LLTextureSlabStore::takeEvicted(std::vector<LLUUID>& ids)
+{
+    LLMutexLock lock(&mMutex);
+    ids.clear();
+    ids.swap(mEvicted);
+}
+
+S64 LLTextureSlabStore::getUsage()
+{
+    LLMutexLock lock(&mMutex);
+    return mLiveBytes;
+}
+
+U32 LLTextureSlabStore::getCount()
+{
+    LLMutexLock lock(&mMutex);
+    return mIndex.size();
+}
@@ -0,0 +1,182 @@
+/**
+ * @file lltextureslabstore.h
+ * @brief Memory mapped slab storage for texture cache bodies
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTURESLABSTORE_H
+#define LL_LLTEXTURESLABSTORE_H
+
+#include "llfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <memory>
+#include <vector>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+// Stores texture cache bodies in a handful of large memory mapped slab
+// files instead of one file per texture.
+//
+// Records are appended to the current head slab.  When the head slab is
+// full the store moves on to the next one, round robin, and evicts
+// whatever is still live in it; evicted ids are queued for the owner to
+// collect with takeEvicted().  Each record carries its id, size and a
+// hash of its payload so torn or stale data is detected on read.
+//
+// The index lives in memory.  Every put, delete and slab recycle is
+// appended to a journal, and the journal is folded into a checkpoint
+// file on close() and whenever it grows large, so a crash loses at most
+// records whose journal entry never made it to disk.
+//
+// All methods are thread safe.
+class LLTextureSlabStore
+{
+public:
+    static const U32 DEFAULT_SLAB_SIZE = 64 * 1024 * 1024;
+
+    LLTextureSlabStore(const std::string& dirname, S64 max_size, U32 slab_size = DEFAULT_SLAB_SIZE);
+    ~LLTextureSlabStore();
+
+    // Map the slabs and rebuild the index.  Returns false when the
+    // previous contents could not be used (first run, layout change,
+    // unreadable checkpoint) and the store started out empty.
+    bool open();
+    // Checkpoint the index and unmap the slabs.
+    void close();
+    bool isOpen() const { return !mSlabs.empty(); }
+
+    // Body size for id, 0 if not stored.
+    S32 getSize(const LLUUID& id);
+    // Copy size bytes starting at offset into dst.  Returns the number
+    // of bytes copied, or -1 if the record is missing or corrupt.
+    S32 read(const LLUUID& id, U8* dst, S32 offset, S32 size);
+    // Store (or replace) the body for id.  Returns size on success,
+    // -1 on failure.
+    S32 write(const LLUUID& id, const U8* src, S32 size);
+    bool remove(const LLUUID& id);
+    // Drop every record, keeping the slab files around for reuse.
+    void clear();
+
+    // Ids whose bodies were evicted by slab recycling since last call.
+    void takeEvicted(std::vector<LLUUID>& ids);
+
+    S64 getUsage();
+    U32 getCount();
+    U32 getSlabCount() const { return mSlabCount; }
+
+private:
+    struct Location
+    {
+        U32 mSlab;
+        U32 mOffset;
+        U32 mSize;
+        U64 mHash;
+    };
+
+    // Open addressed (linear probing) UUID -> Location table
+    class Index
+    {
+    public:
+        Index();
+        Location* find(const LLUUID& id);
+        void insert(const LLUUID& id, const Location& loc);
+        bool erase(const LLUUID& id, Location* old_loc = nullptr);
+        void clear();
+        U32 size() const { return mCount; }
+
+        template <typename FUNC>
+        void forEach(FUNC func) const
+        {
+            for (const Slot& slot : mSlots)
+            {
+                if (slot.mState == FULL)
+                {
+                    func(slot.mID, slot.mLoc);
+                }
+            }
+        }
+
+        template <typename PRED>
+        void eraseIf(PRED pred)
+        {
+            for (Slot& slot : mSlots)
+            {
+                if (slot.mState == FULL && pred(slot.mID, slot.mLoc))
+                {
+                    slot.mState = TOMBSTONE;
+                    --mCount;
+                    ++mTombstones;
+                }
+            }
+        }
+
+    private:
+        enum { EMPTY = 0, FULL, TOMBSTONE };
+        struct Slot
+        {
+            LLUUID mID;
+            Location mLoc;
+            U8 mState;
+        };
+        size_t probe(const LLUUID& id) const;
+        void rehash(size_t capacity);
+
+        std::vector<Slot> mSlots;
+        U32 mCount;
+        U32 mTombstones;
+    };
+
+    struct JournalOp;
+
+    bool mapSlabs();
+    void unmapSlabs();
+    bool loadCheckpoint(const std::string& filename);
+    void replayJournal();
+    void applyOp(const JournalOp& op);
+    void validateIndex();
+    void appendJournal(const JournalOp& op);
+    void openJournal(bool truncate);
+    void checkpoint();
+    void resetState();
+    void recycleSlab(U32 slab);
+    void dropLocation(const Location& loc);
+    static U32 recordBytes(U32 size);
+
+    LLMutex mMutex;
+    std::string mDirName;
+    U32 mSlabSize;
+    U32 mSlabCount;
+
+    std::vector<std::unique_ptr<boost::interprocess::mapped_region>> mSlabs;
+    std::vector<U32> mSlabUsed;     // append offset per slab
+    std::vector<U32> mSlabLive;     // bytes of live records per slab
+    U32 mHead;
+    S64 mLiveBytes;
+
+    Index mIndex;
+    std::vector<LLUUID> mEvicted;
+
+    LLFILE* mJournal;
+    U32 mJournalOps;
+};
+
+#endif // LL_LLTEXTURESLABSTORE_H
@@ -82,6 +82,7 @@
 #include "llappviewer.h"
 #include "llfloaterperms.h"
 #include "llvocache.h"
+#include "llcoproceduremanager.h"
 #include "llcorehttputil.h"
 #include "llstartup.h"
 
@@ -1133,8 +1134,35 @@ void LLViewerObjectList::fetchObjectCosts()
 
             if (!url.empty())
             {
-                LLCoros::instance().launch("LLViewerObjectList::fetchObjectCostsCoro",
-                    boost::bind(&LLViewerObjectList::fetchObjectCostsCoro, this, url, region.second));
+                uuid_set_t diff;
+                for (const auto& objectId : region.second)
+                {
+                    if (mPendingObjectCost.find(objectId) == mPendingObjectCost.end())
+                    {
+                        diff.insert(objectId);
+                    }
+                }
+
+                if (diff.empty())
+                {
+                    continue;
+                }
+
+                // Objects already in flight were filtered out above, so
+                // there's nothing for a keyed request to coalesce with
+                LLSD idList(LLSD::emptyArray());
+                for (const LLUUID& objectId : diff)
+                {
+                    idList.append(objectId);
+                }
+
+                mPendingObjectCost.insert(diff.begin(), diff.end());
+
+                LLCoprocedureManager::instance().enqueueCoprocedure("ObjectCost", "LLViewerObjectList::fetchObjectCostsCoro",
+                    [this, url, idList](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, const LLUUID &)
+                    {
+                        onObjectCostsFetched(idList, fetchObjectCostsCoro(httpAdapter, url, idList));
+                    });
             }
             else
             {
@@ -1158,40 +1186,20 @@ void LLViewerObjectList::reportObjectCostFailure(LLSD &objectList)
 }
 
 
-void LLViewerObjectList::fetchObjectCostsCoro(std::string url, uuid_hash_set_t staleObjects)
+/*static*/
+LLSD LLViewerObjectList::fetchObjectCostsCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, std::string url, LLSD idList)
 {
-    LLCore::HttpRequest::policy_t httpPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID);
-    LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t
-        httpAdapter(std::make_shared<LLCoreHttpUtil::HttpCoroutineAdapter>("genericPostCoro", httpPolicy));
     LLCore::HttpRequest::ptr_t httpRequest(std::make_shared<LLCore::HttpRequest>());
 
-    uuid_set_t diff;
-
-    std::set_difference(staleObjects.begin(), staleObjects.end(),
-        mPendingObjectCost.begin(), mPendingObjectCost.end(),
-        std::inserter(diff, diff.begin()));
-
-    if (diff.empty())
-    {
-        //LL_INFOS() << "No outstanding object IDs to request. Pending count: " << mPendingObjectCost.size() << LL_ENDL;
-        return;
-    }
-
-    LLSD idList(LLSD::emptyArray());
-
-    for (uuid_set_t::iterator it = diff.begin(); it != diff.end(); ++it)
-    {
-        idList.append(*it);
-    }
-
-    mPendingObjectCost.insert(diff.begin(), diff.end());
-
     LLSD postData = LLSD::emptyMap();
 
     postData["object_ids"] = idList;
 
-    LLSD result = httpAdapter->postAndSuspend(httpRequest, url, postData);
+    return httpAdapter->postAndSuspend(httpRequest, url, postData);
+}
 
+void LLViewerObjectList::onObjectCostsFetched(LLSD idList, const LLSD &result)
+{
     LLSD httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
     LLCore::HttpStatus status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
 
@@ -38,6 +38,7 @@
 #include "llviewerobject.h"
 #include "lleventcoro.h"
 #include "llcoros.h"
+#include "llcorehttputil.h"
 
 // system includes
 #include <boost/unordered/unordered_flat_map.hpp>
@@ -235,7 +236,8 @@ class LLViewerObjectList
 
 private:
     static void reportObjectCostFailure(LLSD &objectList);
-    void fetchObjectCostsCoro(std::string url, uuid_hash_set_t staleObjects);
+    static LLSD fetchObjectCostsCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, std::string url, LLSD idList);
+    void onObjectCostsFetched(LLSD idList, const LLSD &result);
 
     static void reportPhysicsFlagFailure(LLSD &obejectList);
     void fetchPhisicsFlagsCoro(std::string url);
@@ -187,6 +187,10 @@ SimMeasurement<LLUnit<F64, LLUnits::Percent> >
 LLTrace::SampleStatHandle<> FPS_SAMPLE("fpssample"),
                             NUM_IMAGES("numimagesstat"),
                             NUM_RAW_IMAGES("numrawimagesstat"),
+                            MESH_REQUEST_QUEUE("meshrequestqueuestat", "Mesh LODs waiting for the repo thread"),
+                            MESH_HTTP_REQUESTS("meshhttprequestsstat", "Mesh HTTP requests in flight"),
+                            MESH_DECODE_QUEUE("meshdecodequeuestat", "Mesh decodes waiting for or running on the MeshDecode pool"),
+                            MESH_DECODED_MEMORY("meshdecodedmemorystat", "Megabytes of decoded mesh LODs, skin info and decompositions"),
                             NUM_MATERIALS("nummaterials"),
                             NUM_OBJECTS("numobjectsstat"),
                             NUM_ACTIVE_OBJECTS("numactiveobjectsstat"),
@@ -203,7 +207,8 @@ LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> >
 static LLTrace::SampleStatHandle<bool>
                             CHAT_BUBBLES("chatbubbles", "Chat Bubbles Enabled");
 
-LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM("formattedmemstat");
+LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM("formattedmemstat"),
+                                        BLOCK_COMPRESSION_SAVED_MEM("blockcompressionsavedstat", "Texture memory saved by CPU block compression");
 LLTrace::SampleStatHandle<F64Kilobytes >    DELTA_BANDWIDTH("deltabandwidth", "Increase/Decrease in bandwidth based on packet loss"),
                                                             MAX_BANDWIDTH("maxbandwidth", "Max bandwidth setting");
 
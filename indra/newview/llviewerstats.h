@@ -179,6 +179,10 @@ extern SimMeasurement<LLUnit<F64, LLUnits::Percent> >   SIM_PERCENTAGE_SCRIPTS_R
 extern LLTrace::SampleStatHandle<>      FPS_SAMPLE,
                                         NUM_IMAGES,
                                         NUM_RAW_IMAGES,
+                                        MESH_REQUEST_QUEUE,
+                                        MESH_HTTP_REQUESTS,
+                                        MESH_DECODE_QUEUE,
+                                        MESH_DECODED_MEMORY,
                                         NUM_OBJECTS,
                                         NUM_MATERIALS,
                                         NUM_ACTIVE_OBJECTS,
@@ -192,7 +196,8 @@ extern LLTrace::SampleStatHandle<>      FPS_SAMPLE,
 
 extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PERCENT;
 
-extern LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM;
+extern LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM,
+                                                BLOCK_COMPRESSION_SAVED_MEM;
 
 extern LLTrace::SampleStatHandle<F64Kilobytes > DELTA_BANDWIDTH,
                                                                     MAX_BANDWIDTH;
@@ -1581,11 +1581,64 @@ BOOL LLViewerFetchedTexture::createTexture(S32 usename/*= 0*/)
         return FALSE;
     }
 
+    updateCompressionPolicy();
     BOOL res = mGLTexturep->createGLTexture(mRawDiscardLevel, mRawImage, usename, TRUE, mBoostLevel);
 
     return res;
 }
 
+void LLViewerFetchedTexture::updateCompressionPolicy()
+{
+    // UI, HUD and map textures are drawn close to 1:1 and stay exact
+    LLImageGL::ECompressionPolicy policy = LLImageGL::COMPRESS_NONE;
+    if (mBoostLevel < BOOST_HUD)
+    {
+        policy = mIsNormalMap ? LLImageGL::COMPRESS_NORMAL : LLImageGL::COMPRESS_COLOR;
+    }
+    mGLTexturep->setCompressionPolicy(policy);
+}
+
+// Copies the raw image into the texture upload ring on the "General" pool,
+// then queues the texture for creation, which uploads from that copy.
+// Returns false if the image can't be staged and must be queued as is.
+bool LLViewerFetchedTexture::stageUpload()
+{
+    updateCompressionPolicy();
+    auto mainq = mMainQueue.lock();
+    if (!mainq || !mGLTexturep->canStageUpload(mRawImage))
+    {
+        return false;
+    }
+
+    // The raw image is not modified while creation is pending, so the
+    // worker can read it and the copy stays a copy of it.
+    LLPointer<LLImageRaw> raw = mRawImage;
+    ref();
+    bool posted = mainq->postTo(
+        LL::WorkQueue::getInstance("General"),
+        // work to be done on the general pool
+        [raw]()
+        {
+            LLTextureUploadRing* ring = LLTextureUploadRing::getInstance();
+            return ring ? ring->stage(raw->getData(), raw->getDataSize()) : LLTextureUploadRing::Region();
+        },
+        // callback to be run on main thread
+        [this, raw](LLTextureUploadRing::Region region)
+        {
+            if (region.isValid())
+            {
+                mGLTexturep->setStagedUpload(region, raw);
+            }
+            gTextureList.mCreateTextureList.insert(this);
+            unref();
+        });
+    if (!posted)
+    {
+        unref();
+    }
+    return posted;
+}
+
 void LLViewerFetchedTexture::postCreateTexture()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
@@ -1676,7 +1729,7 @@ void LLViewerFetchedTexture::scheduleCreateTexture()
                         unref();
                     });
             }
-            else
+            else if (!stageUpload())
             {
                 gTextureList.mCreateTextureList.insert(this);
             }
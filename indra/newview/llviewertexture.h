@@ -359,6 +359,9 @@ class LLViewerFetchedTexture : public LLViewerTexture
     void setIsMissingAsset(BOOL is_missing = true);
     /*virtual*/ BOOL isMissingAsset() const override { return mIsMissingAsset; }
 
+    // Normal maps are only block compressed when RenderBlockCompressNormalMaps is set
+    void setIsNormalMap(bool normal_map)    { mIsNormalMap = normal_map; }
+
     // returns dimensions of original image for local files (before power of two scaling)
     // and returns 0 for all asset system images
     S32 getOriginalWidth() { return mOrigWidth; }
@@ -433,6 +436,9 @@ class LLViewerFetchedTexture : public LLViewerTexture
     void saveRawImage() ;
     void setCachedRawImage() ;
 
+    void updateCompressionPolicy();
+    bool stageUpload();
+
     //for atlas
     void resetFaceAtlas() ;
     void invalidateAtlas(BOOL rebuild_geom) ;
@@ -523,6 +529,7 @@ class LLViewerFetchedTexture : public LLViewerTexture
 
     BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
     BOOL   mIsFetched ; //is loaded from remote or from cache, not generated locally.
+    bool   mIsNormalMap = false; //a flag if the texture is used as a normal map.
 
     std::map<S8, std::string> mComment;
 
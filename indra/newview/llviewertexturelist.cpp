@@ -824,6 +824,7 @@ void LLViewerTextureList::updateImages(F32 max_time)
         sample(NUM_IMAGES, sNumImages);
         sample(NUM_RAW_IMAGES, LLImageRaw::sRawImageCount);
         sample(FORMATTED_MEM, F64Bytes(LLImageFormatted::sGlobalFormattedMemory));
+        sample(BLOCK_COMPRESSION_SAVED_MEM, F64Bytes(LLImageGL::getBlockCompressionSavedBytes()));
     }
 
     // make sure each call below gets at least its "fair share" of time
@@ -1049,6 +1050,12 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
     // decoded, but haven't been pushed into GL).
     //
 
+    // Besides the time limit, cap the bytes pushed to GL in one frame so a
+    // burst of large textures is spread out rather than stalling the frame.
+    static LLCachedControl<U32> upload_budget_kb(gSavedSettings, "RenderTextureUploadBudgetKB", 16384);
+    const S64 upload_budget = (S64)upload_budget_kb * 1024;
+    S64 uploaded = 0;
+
     LLTimer create_timer;
     image_list_t::iterator enditer = mCreateTextureList.begin();
     for (image_list_t::iterator iter = mCreateTextureList.begin();
@@ -1057,10 +1064,14 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
         image_list_t::iterator curiter = iter++;
         enditer = iter;
         LLViewerFetchedTexture *imagep = *curiter;
+        if (imagep->getRawImage())
+        {
+            uploaded += imagep->getRawImage()->getDataSize();
+        }
         imagep->createTexture();
         imagep->postCreateTexture();
 
-        if (create_timer.getElapsedTimeF32() > max_time)
+        if (create_timer.getElapsedTimeF32() > max_time || (upload_budget > 0 && uploaded >= upload_budget))
         {
             break;
         }
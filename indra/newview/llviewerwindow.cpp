@@ -798,7 +798,13 @@ class LLDebugText
                 addText(xpos, ypos, llformat("%d/%d Mesh LOD Pending/Processing", LLMeshRepository::sLODPending, LLMeshRepository::sLODProcessing));
                 ypos += y_inc;
 
-                addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
+                addText(xpos, ypos, llformat("%d Mesh Decodes Queued", gMeshRepo.mThread ? gMeshRepo.mThread->getDecodesPending() : 0));
+                ypos += y_inc;
+
+                addText(xpos, ypos, llformat("%u/%u Mesh Binary LOD Cache Hits/Writes", LLMeshRepository::sBinaryCacheHits.load(), LLMeshRepository::sBinaryCacheWrites.load()));
+                ypos += y_inc;
+
+                addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten.load()/(1024.f*1024.f)));
                 ypos += y_inc;
 
                 addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Skins/Decompositions Memory", LLMeshRepository::sCacheBytesSkins / (1024.f*1024.f), LLMeshRepository::sCacheBytesDecomps / (1024.f*1024.f)));
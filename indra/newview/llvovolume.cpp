@@ -55,6 +55,7 @@
 #include "llspatialpartition.h"
 #include "llhudmanager.h"
 #include "llflexibleobject.h"
+#include "llsharedgeometry.h"
 #include "llskinningutil.h"
 #include "llsky.h"
 #include "lltexturefetch.h"
@@ -110,6 +111,7 @@ S32 LLVOVolume::mRenderComplexity_last = 0;
 S32 LLVOVolume::mRenderComplexity_current = 0;
 LLPointer<LLObjectMediaDataClient> LLVOVolume::sObjectMediaClient = NULL;
 LLPointer<LLObjectMediaNavigateClient> LLVOVolume::sObjectMediaNavigateClient = NULL;
+std::vector<LLPointer<LLVOVolume> > LLVOVolume::sVolumeWaiters;
 
 extern BOOL gCubeSnapshot;
 
@@ -351,6 +353,7 @@ void LLVOVolume::cleanupClass()
 {
     sObjectMediaClient = NULL;
     sObjectMediaNavigateClient = NULL;
+    sVolumeWaiters.clear();
 }
 
 U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
@@ -893,7 +896,8 @@ void LLVOVolume::updateTextureVirtualSize(bool forced)
 
             if (texture_discard >= 0 && //texture has some data available
                 (texture_discard < current_discard || //texture has more data than last rebuild
-                current_discard < 0)) //no previous rebuild
+                current_discard < 0) && //no previous rebuild
+                !mWaitingForVolume) //not already being sculpted
             {
                 gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME);
                 mSculptChanged = TRUE;
@@ -1097,6 +1101,16 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 
     }
 
+    // Prims and sculpts are generated on the VolumeGen threads.  Keep the
+    // volume we have until the one for the new LOD is ready; a new object
+    // starts out with the lowest LOD, which is quick to generate in place.
+    if (NO_LOD != lod && !mVolumeImpl && !volume_params.isMeshSculpt()
+        && (mVolumep.notNull() ? mVolumep->getParams() == volume_params : lod > 0)
+        && !requestGeneratedVolume(volume_params, lod))
+    {
+        lod = mVolumep.notNull() ? last_lod : 0;
+    }
+
     if ((LLPrimitive::setVolume(volume_params, lod, (mVolumeImpl && mVolumeImpl->isVolumeUnique()))) || mSculptChanged)
     {
         mFaceMappingChanged = TRUE;
@@ -1128,6 +1142,12 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
                         LLPrimitive::setVolume(volume_params, available_lod);
                     }
                 }
+                else
+                {
+                    // keep the decoded LOD we just switched to from being evicted first
+                    gMeshRepo.touchDecodedLOD(volume_params.getSculptID(),
+                                              LLVolumeLODGroup::getVolumeDetailFromScale(getVolume()->getDetail()));
+                }
 
                 if (!mSkinInfo && !mSkinInfoUnavaliable)
                 {
@@ -1340,6 +1360,14 @@ void LLVOVolume::sculpt()
         if (current_discard == discard_level)  // no work to do here
             return;
 
+        LLVolume* volume = getVolume();
+        if (!volume->isUnique() && !requestGeneratedVolume(volume->getParams(),
+                                                           LLVolumeLODGroup::getVolumeDetailFromScale(volume->getDetail())))
+        {
+            // Sculpted on the VolumeGen threads, see updateGeneratedVolumes()
+            return;
+        }
+
         if(!raw_image)
         {
             llassert(discard_level < 0) ;
@@ -1368,15 +1396,156 @@ void LLVOVolume::sculpt()
         }
         getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level, mSculptTexture->isMissingAsset());
 
-        //notify rebuild any other VOVolumes that reference this sculpty volume
-        for (S32 i = 0; i < mSculptTexture->getNumVolumes(LLRender::SCULPT_TEX); ++i)
+        rebuildSculptSharers();
+    }
+}
+
+// notify rebuild any other VOVolumes that reference this sculpty volume
+void LLVOVolume::rebuildSculptSharers()
+{
+    for (S32 i = 0; i < mSculptTexture->getNumVolumes(LLRender::SCULPT_TEX); ++i)
+    {
+        LLVOVolume* volume = (*(mSculptTexture->getVolumeList(LLRender::SCULPT_TEX)))[i];
+        if (volume != this && volume->getVolume() == getVolume())
+        {
+            gPipeline.markRebuild(volume->mDrawable, LLDrawable::REBUILD_GEOMETRY);
+        }
+    }
+}
+
+// Copy of what sculpt() would feed LLVolume::sculpt(), false if the sculpt
+// texture has nothing usable yet
+static bool get_sculpt_map(LLViewerFetchedTexture* sculpt_texture, LLVolumeMgr::SculptMap& map)
+{
+    S32 discard_level = llmin(sculpt_texture->getCachedRawImageLevel(), (S32)sculpt_texture->getMaxDiscardLevel());
+    if (discard_level > MAX_DISCARD_LEVEL)
+    {
+        return false;
+    }
+
+    map.mLevel = discard_level;
+    map.mVisiblePlaceholder = sculpt_texture->isMissingAsset();
+
+    LLImageRaw* raw_image = sculpt_texture->getCachedRawImage();
+    if (raw_image && raw_image->getData())
+    {
+        map.mWidth = raw_image->getWidth();
+        map.mHeight = raw_image->getHeight();
+        map.mComponents = raw_image->getComponents();
+        map.mData.assign(raw_image->getData(), raw_image->getData() + raw_image->getDataSize());
+    }
+    return true;
+}
+
+// True if any face will ask its volume for tangents when it's built,
+// see LLFace::getGeometryVolume()
+static bool needs_tangents(LLViewerObject* object)
+{
+    for (U8 i = 0; i < object->getNumTEs(); ++i)
+    {
+        const LLTextureEntry* te = object->getTE(i);
+        if (te && (te->getBumpmap()
+                   || te->getGLTFRenderMaterial()
+                   || (te->getMaterialParams().notNull() && te->getMaterialParams()->getNormalID().notNull())))
         {
-            LLVOVolume* volume = (*(mSculptTexture->getVolumeList(LLRender::SCULPT_TEX)))[i];
-            if (volume != this && volume->getVolume() == getVolume())
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns true if the volume for these params and LOD can be had from
+// LLPrimitive::setVolume() or sculpt() right away.  Otherwise it is being
+// generated and this object is rebuilt once it is in.
+bool LLVOVolume::requestGeneratedVolume(const LLVolumeParams& volume_params, S32 lod)
+{
+    LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+    if (!volume_mgr->hasGenerateThreads())
+    {
+        return true;
+    }
+
+    bool ready;
+    if (volume_mgr->isGenerating(volume_params, lod))
+    {
+        ready = false;
+    }
+    else if (volume_params.isSculpt())
+    {
+        // Without a map only the placeholder is made, quick to do in place
+        LLVolumeMgr::SculptMap map;
+        ready = mSculptTexture.isNull()
+            || mSculptTexture->getID() != volume_params.getSculptID()
+            || !get_sculpt_map(mSculptTexture, map)
+            || volume_mgr->requestVolume(volume_params, lod, &map, needs_tangents(this));
+    }
+    else
+    {
+        ready = volume_mgr->requestVolume(volume_params, lod, NULL, needs_tangents(this));
+    }
+
+    if (!ready)
+    {
+        waitForGeneratedVolume();
+    }
+    return ready;
+}
+
+void LLVOVolume::waitForGeneratedVolume()
+{
+    if (!mWaitingForVolume)
+    {
+        mWaitingForVolume = true;
+        sVolumeWaiters.push_back(this);
+    }
+}
+
+//static
+void LLVOVolume::updateGeneratedVolumes()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+    volume_mgr->updateGenerated();
+    if (sVolumeWaiters.empty())
+    {
+        return;
+    }
+
+    std::vector<LLPointer<LLVOVolume> > waiters;
+    waiters.swap(sVolumeWaiters);
+    for (LLVOVolume* vobj : waiters)
+    {
+        vobj->mWaitingForVolume = false;
+        LLVolume* volume = vobj->getVolume();
+        if (vobj->isDead() || vobj->mDrawable.isNull() || !volume)
+        {
+            continue;
+        }
+
+        const LLVolumeParams& params = volume->getParams();
+        const S32 current_lod = LLVolumeLODGroup::getVolumeDetailFromScale(volume->getDetail());
+        const S32 wanted_lod = llclamp(vobj->mLOD, 0, LLVolumeLODGroup::NUM_LODS - 1);
+        if (volume_mgr->isGenerating(params, current_lod) || volume_mgr->isGenerating(params, wanted_lod))
+        {
+            vobj->waitForGeneratedVolume();
+            continue;
+        }
+
+        // Generated, or given up on at shutdown; setVolume() takes it from here
+        if (params.isSculpt())
+        {
+            vobj->mSculptChanged = TRUE;
+            if (vobj->mSculptTexture.notNull())
             {
-                gPipeline.markRebuild(volume->mDrawable, LLDrawable::REBUILD_GEOMETRY);
+                vobj->rebuildSculptSharers();
             }
         }
+        else
+        {
+            vobj->mLODChanged = TRUE;
+        }
+        gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_VOLUME);
     }
 }
 
@@ -1783,7 +1952,7 @@ BOOL LLVOVolume::genBBoxes(BOOL force_global, BOOL should_update_octree_bounds)
         // updates needed, set REBUILD_RIGGED accordingly.
 
         // Without the flag, this will remove unused rigged volumes, which we are not currently very aggressive about.
-        updateRiggedVolume(false);
+        updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_BOUNDS);
     }
 
     LLVolume* volume = mRiggedVolume;
@@ -2042,7 +2211,7 @@ BOOL LLVOVolume::updateGeometry(LLDrawable *drawable)
 
     if (mDrawable->isState(LLDrawable::REBUILD_RIGGED))
     {
-        updateRiggedVolume(false);
+        updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_BOUNDS);
         genBBoxes(FALSE);
         mDrawable->clearState(LLDrawable::REBUILD_RIGGED);
     }
@@ -2105,7 +2274,7 @@ BOOL LLVOVolume::updateGeometry(LLDrawable *drawable)
 
         if(drawable->isState(LLDrawable::REBUILD_RIGGED | LLDrawable::RIGGED))
         {
-            updateRiggedVolume(false);
+            updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_BOUNDS);
         }
     }
     // it has its own drawable (it's moved) or it has changed UVs or it has changed xforms from global<->local
@@ -4990,11 +5159,29 @@ void LLRiggedVolume::update(
     LLMatrix4a mat[kMaxJoints];
     U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
-    const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
+    LLSkinningUtil::applyBindShapeMatrix(mat, maxJoints, skin->mBindShapeMatrix);
+
+    // Bounds only updates skin about this many blocks of each face, plus
+    // the blocks holding its bind pose extremes, and pad the result to
+    // cover the vertices in between
+    static const U32 BOUNDS_SAMPLE_BLOCKS = 256;
+    static const F32 BOUNDS_SAMPLE_PAD = 0.05f;
+    const bool bounds_only = face_index == UPDATE_ALL_BOUNDS;
+    if (bounds_only && mExtremesVolume.get() != volume)
+    {
+        mExtremesVolume = volume;
+        mFaceExtremes.clear();
+    }
+    if (bounds_only)
+    {
+        mFaceExtremes.resize(vol_num_faces);
+    }
 
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
+    box_min.clear();
+    box_max.clear();
     S32 face_begin;
     S32 face_end;
     if (face_index == DO_NOT_UPDATE_FACES)
@@ -5002,7 +5189,7 @@ void LLRiggedVolume::update(
         face_begin = 0;
         face_end = 0;
     }
-    else if (face_index == UPDATE_ALL_FACES)
+    else if (face_index == UPDATE_ALL_FACES || bounds_only)
     {
         face_begin = 0;
         face_end = vol_num_faces;
@@ -5026,54 +5213,75 @@ void LLRiggedVolume::update(
 
             LLVector4a* pos = dst_face.mPositions;
 
-            if (pos && dst_face.mExtents)
+            if (pos && dst_face.mExtents && dst_face.mNumVertices > 0)
             {
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
 
+                //update bounding box
+                // VFExtents change
+                LLVector4a& min = dst_face.mExtents[0];
+                LLVector4a& max = dst_face.mExtents[1];
+
+                if (bounds_only)
                 {
-                    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
+                    const U32 num_blocks = (dst_face.mNumVertices + LLSkinningUtil::SKIN_BLOCK_SIZE - 1) / LLSkinningUtil::SKIN_BLOCK_SIZE;
+                    const U32 block_stride = (num_blocks + BOUNDS_SAMPLE_BLOCKS - 1) / BOUNDS_SAMPLE_BLOCKS;
+                    FaceExtremes& extremes = mFaceExtremes[i];
+                    if (block_stride > 1 &&
+                        (extremes.mPositions != vol_face.mPositions || extremes.mNumVertices != dst_face.mNumVertices))
                     {
-                        LLMatrix4a final_mat;
-                        LLSkinningUtil::getPerVertexSkinMatrixUnchecked(weight[j], mat, final_mat);
-
-                        LLVector4a& v = vol_face.mPositions[j];
-                        LLVector4a t;
-                        LLVector4a dst;
-                        bind_shape_matrix.affineTransform(v, t);
-                        final_mat.affineTransform(t, dst);
-                        pos[j] = dst;
+                        LLSkinningUtil::getExtremeVertices(vol_face.mPositions, dst_face.mNumVertices, extremes.mVertices);
+                        extremes.mPositions = vol_face.mPositions;
+                        extremes.mNumVertices = dst_face.mNumVertices;
+                    }
+                    LLSkinningUtil::getSkinnedExtents(vol_face.mPositions, weight, dst_face.mNumVertices, mat, block_stride, min, max,
+                                                      extremes.mVertices, block_stride > 1 ? LLSkinningUtil::NUM_EXTREME_VERTICES : 0);
+                    if (block_stride > 1)
+                    {
+                        LLVector4a pad;
+                        pad.setSub(max, min);
+                        pad.mul(BOUNDS_SAMPLE_PAD);
+                        min.sub(pad);
+                        max.add(pad);
                     }
                 }
+                else
+                {
+                    LLSkinningUtil::skinPositions(vol_face.mPositions, weight, dst_face.mNumVertices, mat, pos);
 
-                //update bounding box
-                // VFExtents change
-                LLVector4a& min = dst_face.mExtents[0];
-                LLVector4a& max = dst_face.mExtents[1];
+                    min = pos[0];
+                    max = pos[0];
+                    for (U32 j = 1; j < dst_face.mNumVertices; ++j)
+                    {
+                        min.setMin(min, pos[j]);
+                        max.setMax(max, pos[j]);
+                    }
+                }
 
-                min = pos[0];
-                max = pos[1];
-                if (i==0)
+                if (rigged_face_count == 1)
                 {
                     box_min = min;
                     box_max = max;
                 }
-
-                for (U32 j = 1; j < dst_face.mNumVertices; ++j)
+                else
                 {
-                    min.setMin(min, pos[j]);
-                    max.setMax(max, pos[j]);
+                    box_min.setMin(min, box_min);
+                    box_max.setMax(max, box_max);
                 }
 
-                box_min.setMin(min,box_min);
-                box_max.setMax(max,box_max);
-
                 dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
                 dst_face.mCenter->mul(0.5f);
 
             }
 
-            if (rebuild_face_octrees)
+            if (bounds_only)
+            {
+                // Built from positions that no longer match the pose, picking
+                // builds a new one after skinning the face in full
+                dst_face.destroyOctree();
+            }
+            else if (rebuild_face_octrees)
             {
                 dst_face.destroyOctree();
                 dst_face.createOctree();
@@ -6127,6 +6335,17 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
                         LLFace* face = drawablep->getFace(i);
                         if (face)
                         {
+                            if (face->isState(LLFace::SHARED_GEOMETRY))
+                            { // other faces draw from this buffer and positions can't have changed,
+                              // anything else gets the face a buffer matching its new state
+                                if (drawablep->isState(LLDrawable::REBUILD_VOLUME | LLDrawable::REBUILD_COLOR | LLDrawable::REBUILD_TCOORD))
+                                {
+                                    group->dirtyGeom();
+                                    gPipeline.markRebuild(group);
+                                }
+                                continue;
+                            }
+
                             LLVertexBuffer* buff = face->getVertexBuffer();
                             if (buff)
                             {
@@ -6233,6 +6452,75 @@ struct CompareBatchBreakerRigged
     }
 };
 
+static LLSharedGeometryCache sSharedGeometry;
+static LLFrameTimer sSharedGeometrySweepTimer;
+const F32 SHARED_GEOMETRY_SWEEP_INTERVAL = 1.f; // seconds
+
+// Fill in key if facep's vertex data depends on nothing but the key
+static bool get_shared_geometry_key(LLFace* facep, U32 mask, LLSharedGeometryCache::Key& key)
+{
+    if (!facep->isState(LLFace::RIGGED) || facep->isState(LLFace::TEXTURE_ANIM) || !facep->mSkinInfo)
+    {
+        return false;
+    }
+
+    LLVOVolume* vobj = facep->getDrawable()->getVOVolume();
+    LLVolume* volume = vobj ? vobj->getVolume() : nullptr;
+    const LLTextureEntry* te = facep->getTextureEntry();
+    // meshes are the same data for the same params once loaded, sculpts and
+    // flexis are rebuilt in place
+    if (!volume || !te || volume->isUnique() || !volume->isMeshAssetLoaded() || vobj->mTextureAnimp ||
+        facep->getTEOffset() >= volume->getNumVolumeFaces())
+    {
+        return false;
+    }
+
+    // bump offsets follow the sun and planar mapping follows the object's scale
+    if (te->getBumpmap() || te->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)
+    {
+        return false;
+    }
+
+    LLGLTFMaterial* gltf_mat = te->getGLTFRenderMaterial();
+    LLMaterial* mat = te->getMaterialParams().get();
+    LLColor4U color = te->getColor();
+
+    key.mVolume = volume;
+    key.mSkinInfo = facep->mSkinInfo;
+    key.mFace = facep->getTEOffset();
+    key.mMask = mask;
+    key.mColor = color.asRGBA();
+    key.mShiny = te->getShiny();
+    key.mGlow = (U8) llclamp((S32) (te->getGlow() * 255), 0, 255);
+    key.mInAlphaPool = facep->isInAlphaPool();
+    key.mMaterialHash = gltf_mat ? gltf_mat->getHash() : (mat ? mat->getHash() : LLUUID::null);
+    key.mRotation = te->getRotation();
+    key.mOffsetS = te->mOffsetS;
+    key.mOffsetT = te->mOffsetT;
+    key.mScaleS = te->mScaleS;
+    key.mScaleT = te->mScaleT;
+    return true;
+}
+
+//static
+void LLVolumeGeometryManager::clearSharedGeometry()
+{
+    sSharedGeometry.clear();
+    sSharedGeometrySweepTimer.reset();
+}
+
+//static
+void LLVolumeGeometryManager::sweepSharedGeometry()
+{
+    if (sSharedGeometrySweepTimer.getElapsedTimeF32() < SHARED_GEOMETRY_SWEEP_INTERVAL)
+    {
+        return;
+    }
+    sSharedGeometrySweepTimer.reset();
+
+    sSharedGeometry.sweep();
+}
+
 U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace** faces, U32 face_count, BOOL distance_sort, BOOL batch_textures, BOOL rigged)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -6244,6 +6532,9 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
     U32 max_vertices = (max_vbo_size * 1024)/LLVertexBuffer::calcVertexSize(group->getSpatialPartition()->mVertexDataMask);
     max_vertices = llmin(max_vertices, (U32) 65535);
 
+    static LLCachedControl<bool> share_rigged_geometry(gSavedSettings, "RenderShareRiggedGeometry", true);
+    const bool share_geometry = rigged && !distance_sort && share_rigged_geometry;
+
     {
         LL_PROFILE_ZONE_NAMED("genDrawInfo - sort");
 
@@ -6309,6 +6600,12 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
         LLFace** i = face_iter;
         ++i;
 
+        //a face that can share its geometry is a batch of its own
+        LLSharedGeometryCache::Key shared_key;
+        const bool shared = share_geometry && get_shared_geometry_key(facep, mask, shared_key);
+        LLSharedGeometryCache::Entry* shared_geometry =
+            shared ? sSharedGeometry.find(shared_key, facep->getGeomCount(), facep->getIndicesCount()) : nullptr;
+
         const U32 MAX_TEXTURE_COUNT = 32;
         LLViewerTexture* texture_list[MAX_TEXTURE_COUNT];
 
@@ -6316,7 +6613,14 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
         {
             LL_PROFILE_ZONE_NAMED("genDrawInfo - face size");
-            if (batch_textures)
+            if (shared)
+            {
+                if (batch_textures)
+                {
+                    facep->setTextureIndex(0);
+                }
+            }
+            else if (batch_textures)
             {
                 U8 cur_tex = 0;
                 facep->setTextureIndex(cur_tex);
@@ -6434,6 +6738,11 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
         //create vertex buffer
         LLPointer<LLVertexBuffer> buffer;
 
+        if (shared_geometry)
+        {
+            buffer = shared_geometry->mBuffer;
+        }
+        else
         {
             LL_PROFILE_ZONE_NAMED("genDrawInfo - allocate");
             buffer = new LLVertexBuffer(mask);
@@ -6448,7 +6757,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
         if (buffer)
         {
-            geometryBytes += buffer->getSize() + buffer->getIndicesSize();
+            if (!shared_geometry)
+            {
+                geometryBytes += buffer->getSize() + buffer->getIndicesSize();
+            }
             buffer_map[mask][*face_iter].push_back(buffer);
         }
 
@@ -6474,6 +6786,15 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
             facep->setGeomIndex(index_offset);
             facep->setVertexBuffer(buffer);
 
+            if (shared)
+            {
+                facep->setState(LLFace::SHARED_GEOMETRY);
+            }
+            else
+            {
+                facep->clearState(LLFace::SHARED_GEOMETRY);
+            }
+
             if (batch_textures && facep->getTextureIndex() == FACE_DO_NOT_BATCH_TEXTURES)
             {
                 LL_ERRS() << "Invalid texture index." << LL_ENDL;
@@ -6483,6 +6804,20 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
                 //for debugging, set last time face was updated vs moved
                 facep->updateRebuildFlags();
 
+                if (shared_geometry)
+                { //geometry is already in the shared buffer, just pick up what building it would have set
+                    facep->mTexExtents[0] = shared_geometry->mTexExtents[0];
+                    facep->mTexExtents[1] = shared_geometry->mTexExtents[1];
+                    if (facep->getDrawable()->isStatic())
+                    {
+                        facep->setState(LLFace::GLOBAL);
+                    }
+                    else
+                    {
+                        facep->clearState(LLFace::GLOBAL);
+                    }
+                }
+                else
                 { //copy face geometry into vertex buffer
                     LLDrawable* drawablep = facep->getDrawable();
                     LLVOVolume* vobj = drawablep->getVOVolume();
@@ -6500,6 +6835,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
                     {
                         LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
                     }
+                    else if (shared)
+                    {
+                        sSharedGeometry.add(shared_key, buffer, facep->mTexExtents);
+                    }
 
                     if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
                     {
@@ -6852,7 +7191,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
             ++face_iter;
         }
 
-        if (buffer)
+        if (buffer && !shared_geometry)
         {
             buffer->unmapBuffer();
         }
@@ -32,6 +32,7 @@
 #include "llviewermedia.h"
 #include "llframetimer.h"
 #include "lllocalbitmaps.h"
+#include "llskinningutil.h"
 #include "m3math.h"     // LLMatrix3
 #include "m4math.h"     // LLMatrix4
 #include <unordered_map>
@@ -68,6 +69,9 @@ class LLRiggedVolume final : public LLVolume
     using FaceIndex = S32;
     static const FaceIndex UPDATE_ALL_FACES = -1;
     static const FaceIndex DO_NOT_UPDATE_FACES = -2;
+    // Only the extents of every face, from a sample of each face's vertices.
+    // Positions are left alone and face octrees dropped until a full update.
+    static const FaceIndex UPDATE_ALL_BOUNDS = -3;
     void update(
         const LLMeshSkinInfo* skin,
         LLVOAvatar* avatar,
@@ -76,6 +80,19 @@ class LLRiggedVolume final : public LLVolume
         bool rebuild_face_octrees = true);
 
     std::string mExtraDebugText;
+
+private:
+    // Bind pose vertices with the smallest and largest x, y and z of each
+    // face of mExtremesVolume, always skinned by bounds only updates.  The
+    // volume is held so its address can't be reused by another one.
+    struct FaceExtremes
+    {
+        const LLVector4a* mPositions = nullptr;
+        U32 mNumVertices = 0;
+        U32 mVertices[LLSkinningUtil::NUM_EXTREME_VERTICES];
+    };
+    LLConstPointer<LLVolume> mExtremesVolume;
+    std::vector<FaceExtremes> mFaceExtremes;
 };
 
 // Base class for implementations of the volume - Primitive, Flexible Object, etc.
@@ -235,6 +252,9 @@ class LLVOVolume final : public LLViewerObject
                 void    updateSculptTexture();
                 void    setIndexInTex(U32 ch, S32 index) { mIndexInTex[ch] = index ;}
                 void    sculpt();
+    // Picks up volumes finished on the VolumeGen threads and rebuilds the
+    // objects that were waiting for them.  Once a frame.
+    static      void    updateGeneratedVolumes();
      static     void    rebuildMeshAssetCallback(const LLUUID& asset_uuid,
                                                  LLAssetType::EType type,
                                                  void* user_data, S32 status, LLExtStat ext_status);
@@ -496,6 +516,14 @@ class LLVOVolume final : public LLViewerObject
     S32 mFetchingSkinInfo = 0;
     bool mSkinInfoUnavaliable;
     LLConstPointer<LLMeshSkinInfo> mSkinInfo;
+
+    // Waiting for the VolumeGen threads to generate a LOD or sculpt
+    bool mWaitingForVolume = false;
+    bool requestGeneratedVolume(const LLVolumeParams& volume_params, S32 lod);
+    void waitForGeneratedVolume();
+    void rebuildSculptSharers();
+    static std::vector<LLPointer<LLVOVolume> > sVolumeWaiters;
+
     // statics
 public:
     static F32 sLODSlopDistanceFactor;// Changing this to zero, effectively disables the LOD transition slop
@@ -667,6 +667,8 @@ void LLPipeline::cleanup()
 
     releaseGLBuffers();
 
+    LLVolumeGeometryManager::clearSharedGeometry();
+
     mFaceSelectImagep = NULL;
 
     mMovedList.clear();
@@ -698,6 +700,8 @@ void LLPipeline::destroyGL()
 
     releaseGLBuffers();
 
+    LLVolumeGeometryManager::clearSharedGeometry();
+
     if (mMeshDirtyQueryObject)
     {
         glDeleteQueries(1, &mMeshDirtyQueryObject);
@@ -2746,6 +2750,7 @@ void LLPipeline::rebuildPriorityGroups()
     assertInitialized();
 
     gMeshRepo.notifyLoadedMeshes();
+    LLVOVolume::updateGeneratedVolumes();
 
     mGroupQ1Locked = true;
     // Iterate through all drawables on the priority build queue,
@@ -2777,6 +2782,7 @@ void LLPipeline::updateGeom(F32 max_dtime)
     // notify various object types to reset internal cost metrics, etc.
     // for now, only LLVOVolume does this to throttle LOD changes
     LLVOVolume::preUpdateGeom();
+    LLVolumeGeometryManager::sweepSharedGeometry();
 
     // Iterate through all drawables on the priority build queue,
     for (LLDrawable::drawable_list_t::iterator iter = mBuildQ1.begin();
@@ -0,0 +1,209 @@
+/**
+ * @file llmeshdecodedcache_test.cpp
+ * @brief Tests for the decoded mesh data LRU
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llmeshdecodedcache.h"
+
+#include "../test/lltut.h"
+
+#include <set>
+
+namespace tut
+{
+    struct meshdecodedcache_data
+    {
+        meshdecodedcache_data()
+        {
+            for (LLUUID& id : mIds)
+            {
+                id.generate();
+            }
+        }
+
+        // Evicts everything but the pinned ids, in the order offered
+        U64 trim(LLMeshDecodedCache& cache, const std::set<LLUUID>& pinned)
+        {
+            return cache.trim([&](const LLMeshDecodedCache::Key& key, U64 bytes) -> U64
+                {
+                    if (pinned.count(key.mID))
+                    {
+                        return bytes;
+                    }
+                    mEvicted.push_back(key);
+                    return 0;
+                });
+        }
+
+        LLUUID mIds[8];
+        std::vector<LLMeshDecodedCache::Key> mEvicted;
+    };
+    typedef test_group<meshdecodedcache_data> meshdecodedcache_test;
+    typedef meshdecodedcache_test::object meshdecodedcache_object;
+    tut::meshdecodedcache_test meshdecodedcache_testcase("LLMeshDecodedCache");
+
+    template<> template<>
+    void meshdecodedcache_object::test<1>()
+    {
+        set_test_name("least recently used goes first");
+
+        LLMeshDecodedCache cache;
+        for (S32 i = 0; i < 4; ++i)
+        {
+            cache.touch(mIds[i], LLMeshDecodedCache::KIND_LOD_HIGH, 100);
+        }
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH);
+        ensure_equals("bytes", cache.getBytes(), 400ULL);
+
+        cache.setBudget(250);
+        ensure_equals("freed", trim(cache, {}), 200ULL);
+        ensure_equals("evicted", mEvicted.size(), 2U);
+        ensure("oldest first", mEvicted[0].mID == mIds[1] && mEvicted[1].mID == mIds[2]);
+        ensure("touched one kept", cache.has(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH));
+        ensure_equals("count", cache.getCount(), 2);
+        ensure_equals("within budget", cache.getBytes(), 200ULL);
+    }
+
+    template<> template<>
+    void meshdecodedcache_object::test<2>()
+    {
+        set_test_name("pinned data stays and becomes recent");
+
+        LLMeshDecodedCache cache;
+        for (S32 i = 0; i < 4; ++i)
+        {
+            cache.touch(mIds[i], LLMeshDecodedCache::KIND_SKIN, 100);
+        }
+
+        cache.setBudget(0);
+        ensure_equals("freed", trim(cache, { mIds[0], mIds[2] }), 200ULL);
+        ensure_equals("pinned bytes", cache.getBytes(), 200ULL);
+        ensure("pinned kept", cache.has(mIds[0], LLMeshDecodedCache::KIND_SKIN) &&
+                              cache.has(mIds[2], LLMeshDecodedCache::KIND_SKIN));
+
+        // Once unpinned, the one refused last is the most recent
+        cache.touch(mIds[4], LLMeshDecodedCache::KIND_SKIN, 100);
+        cache.setBudget(100);
+        mEvicted.clear();
+        trim(cache, {});
+        ensure_equals("evicted", mEvicted.size(), 2U);
+        ensure("refused first is older", mEvicted[0].mID == mIds[0] && mEvicted[1].mID == mIds[2]);
+    }
+
+    template<> template<>
+    void meshdecodedcache_object::test<3>()
+    {
+        set_test_name("sizes and kinds are accounted separately");
+
+        LLMeshDecodedCache cache;
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_LOD_LOWEST, 10);
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH, 1000);
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_DECOMPOSITION, 50);
+        ensure_equals("count", cache.getCount(), 3);
+        ensure_equals("bytes", cache.getBytes(), 1060ULL);
+
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_DECOMPOSITION, 80);
+        ensure_equals("resized", cache.getBytes(), 1090ULL);
+
+        cache.touch(mIds[1], LLMeshDecodedCache::KIND_SKIN);
+        ensure("unknown touch ignored", !cache.has(mIds[1], LLMeshDecodedCache::KIND_SKIN));
+
+        cache.remove(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH);
+        ensure_equals("removed", cache.getBytes(), 90ULL);
+        ensure("other kinds kept", cache.has(mIds[0], LLMeshDecodedCache::KIND_LOD_LOWEST));
+
+        cache.setBudget(100);
+        ensure_equals("nothing to do within budget", trim(cache, {}), 0ULL);
+        ensure("nothing offered", mEvicted.empty());
+
+        cache.clear();
+        ensure_equals("cleared", cache.getBytes(), 0ULL);
+        ensure_equals("cleared count", cache.getCount(), 0);
+    }
+
+    template<> template<>
+    void meshdecodedcache_object::test<4>()
+    {
+        set_test_name("data freed behind the cache's back stops counting");
+
+        LLMeshDecodedCache cache;
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH, 300);
+        cache.touch(mIds[1], LLMeshDecodedCache::KIND_LOD_HIGH, 100);
+        cache.touch(mIds[2], LLMeshDecodedCache::KIND_LOD_HIGH, 200);
+
+        // The group holding the oldest was deleted along with its last
+        // volume, and one of the two variants of the newest went with it
+        std::set<LLUUID> freed = { mIds[0] };
+        ensure_equals("gone", cache.refresh([&](const LLMeshDecodedCache::Key& key, U64 bytes) -> U64
+            {
+                if (freed.count(key.mID))
+                {
+                    return 0;
+                }
+                return key.mID == mIds[2] ? bytes / 2 : bytes;
+            }), 400ULL);
+        ensure("freed one dropped", !cache.has(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH));
+        ensure_equals("count", cache.getCount(), 2);
+        ensure_equals("bytes", cache.getBytes(), 200ULL);
+
+        // Counting the freed bytes would have evicted the live unused one
+        cache.setBudget(250);
+        ensure_equals("nothing to free", trim(cache, {}), 0ULL);
+        ensure("nothing offered", mEvicted.empty());
+
+        // The use order is unchanged
+        cache.setBudget(150);
+        trim(cache, {});
+        ensure_equals("evicted", mEvicted.size(), 1U);
+        ensure("oldest live first", mEvicted[0].mID == mIds[1]);
+    }
+
+    template<> template<>
+    void meshdecodedcache_object::test<5>()
+    {
+        set_test_name("partial evictions count what was freed");
+
+        LLMeshDecodedCache cache;
+        cache.touch(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH, 300);
+        cache.touch(mIds[1], LLMeshDecodedCache::KIND_LOD_HIGH, 100);
+
+        // One variant of the oldest is still drawn, the other goes
+        cache.setBudget(250);
+        U64 freed = cache.trim([&](const LLMeshDecodedCache::Key& key, U64) -> U64
+            {
+                mEvicted.push_back(key);
+                return key.mID == mIds[0] ? 120 : 0;
+            });
+        ensure_equals("freed", freed, 180ULL);
+        ensure_equals("bytes", cache.getBytes(), 220ULL);
+        ensure_equals("offered", mEvicted.size(), 1U);
+        ensure("in use part kept", cache.has(mIds[0], LLMeshDecodedCache::KIND_LOD_HIGH));
+
+        // and is now the most recent, at its new size
+        cache.setBudget(150);
+        mEvicted.clear();
+        ensure_equals("freed next", trim(cache, {}), 100ULL);
+        ensure("other goes first", mEvicted.size() == 1 && mEvicted[0].mID == mIds[1]);
+        ensure_equals("kept bytes", cache.getBytes(), 120ULL);
+    }
+}
@@ -0,0 +1,164 @@
+/**
+ * @file llsharedgeometry_test.cpp
+ * @brief Tests for the rigged geometry sharing cache
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llsharedgeometry.h"
+
+#include "llmodel.h"
+#include "llvertexbuffer.h"
+#include "llvolume.h"
+
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: the cache only sizes and counts references to its buffers, so
+// they need no GL behind them.
+LLVertexBuffer::LLVertexBuffer(U32 typemask)
+    : LLRefCount(),
+    mTypeMask(typemask)
+{
+}
+LLVertexBuffer::~LLVertexBuffer() { }
+bool LLVertexBuffer::allocateBuffer(U32 nverts, U32 nindices)
+{
+    mNumVerts = nverts;
+    mNumIndices = nindices;
+    return true;
+}
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+namespace tut
+{
+    struct sharedgeometry_data
+    {
+        sharedgeometry_data()
+        {
+            LLVolumeParams params;
+            params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+            mVolume = new LLVolume(params, 1.f);
+            mOtherVolume = new LLVolume(params, 1.f);
+            mSkin = new LLMeshSkinInfo();
+            mTexExtents[0].set(0.f, 0.f);
+            mTexExtents[1].set(1.f, 1.f);
+        }
+
+        LLSharedGeometryCache::Key makeKey(const LLVolume* volume, const LLMeshSkinInfo* skin, U32 mask)
+        {
+            LLSharedGeometryCache::Key key;
+            key.mVolume = volume;
+            key.mSkinInfo = skin;
+            key.mFace = 0;
+            key.mMask = mask;
+            key.mColor = 0xffffffff;
+            return key;
+        }
+
+        LLPointer<LLVertexBuffer> makeBuffer(U32 mask, U32 verts, U32 indices)
+        {
+            LLPointer<LLVertexBuffer> buffer = new LLVertexBuffer(mask);
+            buffer->allocateBuffer(verts, indices);
+            return buffer;
+        }
+
+        LLPointer<LLVolume> mVolume;
+        LLPointer<LLVolume> mOtherVolume;
+        LLPointer<LLMeshSkinInfo> mSkin;
+        LLVector2 mTexExtents[2];
+        LLSharedGeometryCache mCache;
+    };
+    typedef test_group<sharedgeometry_data> sharedgeometry_test;
+    typedef sharedgeometry_test::object sharedgeometry_object;
+    tut::sharedgeometry_test sharedgeometry_testcase("LLSharedGeometryCache");
+
+    template<> template<>
+    void sharedgeometry_object::test<1>()
+    {
+        set_test_name("The same volume, skin and mask find the same entry");
+
+        const U32 mask = LLVertexBuffer::MAP_VERTEX | LLVertexBuffer::MAP_NORMAL;
+        LLPointer<LLVertexBuffer> buffer = makeBuffer(mask, 100, 300);
+        mCache.add(makeKey(mVolume, mSkin, mask), buffer, mTexExtents);
+
+        // a key built again from the same state, as the next copy's face does
+        LLSharedGeometryCache::Entry* entry = mCache.find(makeKey(mVolume, mSkin, mask), 100, 300);
+        ensure("found", entry != nullptr);
+        ensure("same buffer", entry->mBuffer.get() == buffer.get());
+        ensure("same extents", entry->mTexExtents[1] == mTexExtents[1]);
+        ensure("found again", mCache.find(makeKey(mVolume, mSkin, mask), 50, 150) == entry);
+
+        ensure("other volume", !mCache.find(makeKey(mOtherVolume, mSkin, mask), 100, 300));
+        LLPointer<LLMeshSkinInfo> other_skin = new LLMeshSkinInfo();
+        ensure("other skin", !mCache.find(makeKey(mVolume, other_skin, mask), 100, 300));
+        ensure("other mask", !mCache.find(makeKey(mVolume, mSkin, mask | LLVertexBuffer::MAP_COLOR), 100, 300));
+        LLSharedGeometryCache::Key other_face = makeKey(mVolume, mSkin, mask);
+        other_face.mFace = 1;
+        ensure("other face", !mCache.find(other_face, 100, 300));
+        LLSharedGeometryCache::Key other_color = makeKey(mVolume, mSkin, mask);
+        other_color.mColor = 0xff0000ff;
+        ensure("other color", !mCache.find(other_color, 100, 300));
+
+        ensure("too few vertices", !mCache.find(makeKey(mVolume, mSkin, mask), 101, 300));
+        ensure("too few indices", !mCache.find(makeKey(mVolume, mSkin, mask), 100, 301));
+        ensure_equals("one entry", mCache.size(), 1U);
+
+        // adding the same key again replaces the entry rather than growing
+        LLPointer<LLVertexBuffer> bigger = makeBuffer(mask, 200, 600);
+        mCache.add(makeKey(mVolume, mSkin, mask), bigger, mTexExtents);
+        ensure_equals("still one entry", mCache.size(), 1U);
+        entry = mCache.find(makeKey(mVolume, mSkin, mask), 200, 600);
+        ensure("replaced", entry && entry->mBuffer.get() == bigger.get());
+    }
+
+    template<> template<>
+    void sharedgeometry_object::test<2>()
+    {
+        set_test_name("sweep releases entries no face draws from, and what they keep alive");
+
+        const U32 mask = LLVertexBuffer::MAP_VERTEX;
+        LLPointer<LLVertexBuffer> used = makeBuffer(mask, 10, 30);
+        LLPointer<LLVertexBuffer> unused = makeBuffer(mask, 10, 30);
+        mCache.add(makeKey(mVolume, mSkin, mask), used, mTexExtents);
+        mCache.add(makeKey(mOtherVolume, mSkin, mask), unused, mTexExtents);
+        ensure_equals("volume held", mOtherVolume->getNumRefs(), 2);
+
+        // the last face drawing from it went away
+        LLVertexBuffer* unused_buffer = unused.get();
+        unused = NULL;
+        ensure_equals("cache holds the buffer", unused_buffer->getNumRefs(), 1);
+
+        mCache.sweep();
+        ensure_equals("one entry left", mCache.size(), 1U);
+        ensure("used kept", mCache.find(makeKey(mVolume, mSkin, mask), 10, 30) != nullptr);
+        ensure("unused dropped", !mCache.find(makeKey(mOtherVolume, mSkin, mask), 10, 30));
+        ensure_equals("volume released", mOtherVolume->getNumRefs(), 1);
+        ensure_equals("skin still held by the used entry", mSkin->getNumRefs(), 2);
+
+        used = NULL;
+        mCache.sweep();
+        ensure_equals("empty", mCache.size(), 0U);
+        ensure_equals("volume released", mVolume->getNumRefs(), 1);
+        ensure_equals("skin released", mSkin->getNumRefs(), 1);
+    }
+}
@@ -0,0 +1,241 @@
+/**
+ * @file llskinningkernel_test.cpp
+ * @brief Tests for block skinning against the per vertex skin matrix
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llskinningutil.h"
+
+#include "llformat.h"
+
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace tut
+{
+    struct skinningkernel_data
+    {
+        static const U32 NUM_JOINTS = 8;
+
+        skinningkernel_data()
+            : mSeed(1)
+        {
+            for (U32 j = 0; j < NUM_JOINTS; ++j)
+            {
+                mPalette[j] = randomAffine();
+            }
+            mBindShape = randomAffine();
+        }
+
+        F32 random(F32 low, F32 high)
+        {
+            mSeed = mSeed * 1103515245 + 12345;
+            return low + (high - low) * (F32)((mSeed >> 8) & 0xffff) / 65535.f;
+        }
+
+        LLMatrix4a randomAffine()
+        {
+            LLMatrix4a mat;
+            for (U32 c = 0; c < 3; ++c)
+            {
+                mat.mMatrix[c].set(random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f), 0.f);
+            }
+            mat.mMatrix[3].set(random(-2.f, 2.f), random(-2.f, 2.f), random(-2.f, 2.f), 1.f);
+            return mat;
+        }
+
+        // Four influences packed the way LLVolumeFace stores them, joint
+        // index plus weight
+        void makeVertices(U32 count)
+        {
+            mPositions.resize(count);
+            mWeights.resize(count);
+            for (U32 v = 0; v < count; ++v)
+            {
+                mPositions[v].set(random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f), 1.f);
+                F32 packed[4];
+                for (U32 k = 0; k < 4; ++k)
+                {
+                    packed[k] = (F32)((v + k * 3) % NUM_JOINTS) + random(0.1f, 0.9f);
+                }
+                mWeights[v].set(packed[0], packed[1], packed[2], packed[3]);
+            }
+        }
+
+        // What LLRiggedVolume::update() did per vertex before block skinning
+        void skinScalar(std::vector<LLVector4a>& dst)
+        {
+            dst.resize(mPositions.size());
+            for (U32 v = 0; v < mPositions.size(); ++v)
+            {
+                LLMatrix4a final_mat;
+                LLSkinningUtil::getPerVertexSkinMatrixUnchecked(mWeights[v], mPalette, final_mat);
+                LLVector4a t;
+                mBindShape.affineTransform(mPositions[v], t);
+                final_mat.affineTransform(t, dst[v]);
+            }
+        }
+
+        void skinBlocks(std::vector<LLVector4a>& dst)
+        {
+            LLMatrix4a mat[NUM_JOINTS];
+            for (U32 j = 0; j < NUM_JOINTS; ++j)
+            {
+                mat[j] = mPalette[j];
+            }
+            LLSkinningUtil::applyBindShapeMatrix(mat, NUM_JOINTS, mBindShape);
+
+            // Guard the vertex after the last one against partial block writes
+            dst.assign(mPositions.size() + 1, LLVector4a(123.f, 456.f, 789.f, 0.f));
+            LLSkinningUtil::skinPositions(mPositions.data(), mWeights.data(), (U32)mPositions.size(), mat, dst.data());
+        }
+
+        void getExtents(const std::vector<LLVector4a>& pos, LLVector4a& min, LLVector4a& max)
+        {
+            min = pos[0];
+            max = pos[0];
+            for (U32 v = 1; v < pos.size(); ++v)
+            {
+                min.setMin(min, pos[v]);
+                max.setMax(max, pos[v]);
+            }
+        }
+
+        void ensureClose(const std::string& msg, const LLVector4a& expected, const LLVector4a& actual)
+        {
+            for (S32 i = 0; i < 3; ++i)
+            {
+                const F32 tolerance = 1.e-4f * llmax(1.f, fabsf(expected[i]));
+                ensure(msg + " component " + std::to_string(i), fabsf(expected[i] - actual[i]) <= tolerance);
+            }
+        }
+
+        void ensureSame(const std::string& msg, const LLVector4a& expected, const LLVector4a& actual)
+        {
+            for (S32 i = 0; i < 3; ++i)
+            {
+                ensure_equals(msg + " component " + std::to_string(i), actual[i], expected[i]);
+            }
+        }
+
+        U32 mSeed;
+        LLMatrix4a mPalette[NUM_JOINTS];
+        LLMatrix4a mBindShape;
+        std::vector<LLVector4a> mPositions;
+        std::vector<LLVector4a> mWeights;
+    };
+    typedef test_group<skinningkernel_data> skinningkernel_test;
+    typedef skinningkernel_test::object skinningkernel_object;
+    tut::skinningkernel_test skinningkernel_testcase("LLSkinningKernel");
+
+    template<> template<>
+    void skinningkernel_object::test<1>()
+    {
+        set_test_name("skinPositions matches the per vertex skin matrix, partial blocks included");
+
+        for (U32 count = 1; count <= 3 * LLSkinningUtil::SKIN_BLOCK_SIZE + 1; ++count)
+        {
+            makeVertices(count);
+            std::vector<LLVector4a> expected, actual;
+            skinScalar(expected);
+            skinBlocks(actual);
+
+            for (U32 v = 0; v < count; ++v)
+            {
+                ensureClose(llformat("%u vertices, vertex %u", count, v), expected[v], actual[v]);
+            }
+            ensureSame(llformat("%u vertices, past the end", count), LLVector4a(123.f, 456.f, 789.f, 0.f), actual[count]);
+        }
+    }
+
+    template<> template<>
+    void skinningkernel_object::test<2>()
+    {
+        set_test_name("getSkinnedExtents without sampling covers every skinned vertex");
+
+        LLMatrix4a mat[NUM_JOINTS];
+        for (U32 count = 1; count <= 3 * LLSkinningUtil::SKIN_BLOCK_SIZE + 1; ++count)
+        {
+            makeVertices(count);
+            std::vector<LLVector4a> skinned;
+            skinBlocks(skinned);
+            skinned.pop_back();
+            LLVector4a expected_min, expected_max;
+            getExtents(skinned, expected_min, expected_max);
+
+            for (U32 j = 0; j < NUM_JOINTS; ++j)
+            {
+                mat[j] = mPalette[j];
+            }
+            LLSkinningUtil::applyBindShapeMatrix(mat, NUM_JOINTS, mBindShape);
+            LLVector4a min, max;
+            LLSkinningUtil::getSkinnedExtents(mPositions.data(), mWeights.data(), count, mat, 1, min, max);
+
+            ensureSame(llformat("%u vertices, min", count), expected_min, min);
+            ensureSame(llformat("%u vertices, max", count), expected_max, max);
+        }
+    }
+
+    template<> template<>
+    void skinningkernel_object::test<3>()
+    {
+        set_test_name("getSkinnedExtents always samples the bind pose extremes");
+
+        // Every joint scales and moves the face the same way, so its
+        // skinned extremes are its bind pose ones
+        LLMatrix4a mat[NUM_JOINTS];
+        for (U32 j = 0; j < NUM_JOINTS; ++j)
+        {
+            mat[j].setIdentity();
+            mat[j].mMatrix[0].set(2.f, 0.f, 0.f, 0.f);
+            mat[j].mMatrix[1].set(0.f, 0.5f, 0.f, 0.f);
+            mat[j].mMatrix[3].set(1.f, -3.f, 0.5f, 1.f);
+        }
+
+        const U32 block_stride = 8;
+        const U32 count = 100 * LLSkinningUtil::SKIN_BLOCK_SIZE + 3;
+        makeVertices(count);
+        // Spikes in blocks the stride skips
+        mPositions[5 * LLSkinningUtil::SKIN_BLOCK_SIZE + 1].set(10.f, 0.f, 0.f, 1.f);
+        mPositions[13 * LLSkinningUtil::SKIN_BLOCK_SIZE + 2].set(0.f, -10.f, 0.f, 1.f);
+        mPositions[42 * LLSkinningUtil::SKIN_BLOCK_SIZE + 3].set(0.f, 0.f, 10.f, 1.f);
+
+        LLVector4a expected_min, expected_max;
+        LLSkinningUtil::getSkinnedExtents(mPositions.data(), mWeights.data(), count, mat, 1, expected_min, expected_max);
+
+        LLVector4a min, max;
+        LLSkinningUtil::getSkinnedExtents(mPositions.data(), mWeights.data(), count, mat, block_stride, min, max);
+        ensure("sampling alone misses the spikes", max[0] < expected_max[0] && min[1] > expected_min[1] && max[2] < expected_max[2]);
+
+        U32 extremes[LLSkinningUtil::NUM_EXTREME_VERTICES];
+        LLSkinningUtil::getExtremeVertices(mPositions.data(), count, extremes);
+        ensure_equals("max x", extremes[1], 5 * LLSkinningUtil::SKIN_BLOCK_SIZE + 1);
+        ensure_equals("min y", extremes[2], 13 * LLSkinningUtil::SKIN_BLOCK_SIZE + 2);
+        ensure_equals("max z", extremes[5], 42 * LLSkinningUtil::SKIN_BLOCK_SIZE + 3);
+
+        LLSkinningUtil::getSkinnedExtents(mPositions.data(), mWeights.data(), count, mat, block_stride, min, max,
+                                          extremes, LLSkinningUtil::NUM_EXTREME_VERTICES);
+        ensureSame("min", expected_min, min);
+        ensureSame("max", expected_max, max);
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @file lltexturedecodedcache_test.cpp
+ * @brief Tests for the decoded texture mip cache
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltexturedecodedcache.h"
+
+#include "../test/lltut.h"
+
+#include <boost/filesystem.hpp>
+
+namespace tut
+{
+    struct decodedcache_data
+    {
+        decodedcache_data()
+        {
+            mDir = (boost::filesystem::temp_directory_path()
+                    / boost::filesystem::unique_path("decodedcache-%%%%-%%%%")).string();
+        }
+
+        ~decodedcache_data()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        LLPointer<LLImageRaw> makeImage(U16 size, bool noisy)
+        {
+            LLPointer<LLImageRaw> raw = new LLImageRaw(size, size, 4);
+            U8* data = raw->getData();
+            U32 seed = 12345;
+            for (S32 i = 0; i < raw->getDataSize(); ++i)
+            {
+                seed = seed * 1103515245 + 12345;
+                data[i] = noisy ? (U8)(seed >> 16) : (U8)(i / 64);
+            }
+            return raw;
+        }
+
+        bool samePixels(const LLImageRaw* a, const LLImageRaw* b)
+        {
+            return a->getWidth() == b->getWidth() && a->getHeight() == b->getHeight()
+                   && a->getComponents() == b->getComponents()
+                   && memcmp(a->getData(), b->getData(), a->getDataSize()) == 0;
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<decodedcache_data> decodedcache_test;
+    typedef decodedcache_test::object decodedcache_object;
+    tut::decodedcache_test decodedcache_testcase("LLTextureDecodedCache");
+
+    template<> template<>
+    void decodedcache_object::test<1>()
+    {
+        set_test_name("store and load");
+
+        LLTextureDecodedCache cache(mDir, 64 * 1024 * 1024);
+        cache.init();
+
+        LLUUID flat_id, noisy_id;
+        flat_id.generate();
+        noisy_id.generate();
+        LLPointer<LLImageRaw> flat = makeImage(64, false);
+        LLPointer<LLImageRaw> noisy = makeImage(64, true);
+        cache.store(flat_id, 2, 5000, flat);
+        cache.store(noisy_id, 0, 9000, noisy);
+        ensure_equals("count", cache.getCount(), 2U);
+        ensure("flat data compressed", cache.getUsage() < flat->getDataSize() + noisy->getDataSize());
+
+        LLPointer<LLImageRaw> raw = cache.load(flat_id, 2, 5000);
+        ensure("flat hit", raw.notNull());
+        ensure("flat pixels", samePixels(raw, flat));
+
+        raw = cache.load(noisy_id, 0, 9000);
+        ensure("noisy hit", raw.notNull());
+        ensure("noisy pixels", samePixels(raw, noisy));
+
+        ensure("other discard misses", cache.load(flat_id, 1, 5000).isNull());
+        ensure("more codestream misses", cache.load(flat_id, 2, 6000).isNull());
+        ensure("less codestream hits", cache.load(flat_id, 2, 4000).notNull());
+
+        cache.remove(flat_id);
+        ensure("removed", cache.load(flat_id, 2, 5000).isNull());
+        ensure_equals("count after remove", cache.getCount(), 1U);
+    }
+
+    template<> template<>
+    void decodedcache_object::test<2>()
+    {
+        set_test_name("size limit and reopen");
+
+        // Room for about three noisy 64x64 mips
+        const S64 limit = 3 * (64 * 64 * 4 + 256);
+        std::vector<LLUUID> ids(5);
+        {
+            LLTextureDecodedCache cache(mDir, limit * 16);
+            cache.init();
+            for (LLUUID& id : ids)
+            {
+                id.generate();
+                cache.store(id, 0, 100, makeImage(64, true));
+            }
+            ensure_equals("all stored", cache.getCount(), 5U);
+        }
+
+        LLTextureDecodedCache cache(mDir, limit);
+        cache.init();
+        ensure("trimmed to limit", cache.getUsage() <= limit);
+        ensure_equals("kept what fits", cache.getCount(), 3U);
+
+        U32 hits = 0;
+        LLPointer<LLImageRaw> expected = makeImage(64, true);
+        for (const LLUUID& id : ids)
+        {
+            LLPointer<LLImageRaw> raw = cache.load(id, 0, 100);
+            if (raw.notNull())
+            {
+                ++hits;
+                ensure("reopened pixels", samePixels(raw, expected));
+            }
+        }
+        ensure_equals("hits after reopen", hits, 3U);
+
+        cache.clear();
+        ensure_equals("cleared", cache.getCount(), 0U);
+        for (const LLUUID& id : ids)
+        {
+            ensure("nothing left", cache.load(id, 0, 100).isNull());
+        }
+    }
+    template<> template<>
+    void decodedcache_object::test<3>()
+    {
+        set_test_name("background writer");
+
+        LLTextureDecodedCache cache(mDir, 64 * 1024 * 1024);
+        cache.init();
+        cache.startWriter();
+
+        LLUUID id;
+        id.generate();
+        LLPointer<LLImageRaw> flat = makeImage(64, false);
+        cache.store(id, 1, 5000, flat);
+        // The writer has its own copy
+        memset(flat->getData(), 0, flat->getDataSize());
+
+        cache.stopWriter();
+        ensure("written", cache.has(id, 1));
+        ensure("other discard", !cache.has(id, 0));
+        LLPointer<LLImageRaw> raw = cache.load(id, 1, 5000);
+        ensure("hit", raw.notNull());
+        ensure("pixels as stored", samePixels(raw, makeImage(64, false)));
+
+        cache.remove(id);
+        ensure("removed", !cache.has(id, 1));
+    }
+}
@@ -0,0 +1,163 @@
+/**
+ * @file lltexturefetchscheduler_test.cpp
+ * @brief Tests for the texture fetch priority heaps and budgets
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltexturefetchscheduler.h"
+
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <map>
+
+namespace tut
+{
+    struct fetchscheduler_data
+    {
+        fetchscheduler_data()
+        {
+            for (LLUUID& id : mIds)
+            {
+                id.generate();
+            }
+        }
+
+        LLUUID mIds[64];
+    };
+    typedef test_group<fetchscheduler_data> fetchscheduler_test;
+    typedef fetchscheduler_test::object fetchscheduler_object;
+    tut::fetchscheduler_test fetchscheduler_testcase("LLTextureFetchScheduler");
+
+    template<> template<>
+    void fetchscheduler_object::test<1>()
+    {
+        set_test_name("waiters come out most important first");
+
+        LLTextureFetchScheduler scheduler;
+        std::map<LLUUID, F32> expected;
+        for (S32 i = 0; i < 64; ++i)
+        {
+            // Scrambled but distinct priorities
+            const F32 priority = (F32)((i * 37) % 64 + 1);
+            scheduler.addRequest(mIds[i], priority);
+            scheduler.wait(mIds[i], LLTextureFetchScheduler::STAGE_HTTP);
+            expected[mIds[i]] = priority;
+        }
+
+        // Move a few, drop one to zero
+        LLTextureFetchScheduler::priority_batch_t batch, changed;
+        batch.emplace_back(mIds[3], 1000.f);
+        batch.emplace_back(mIds[10], 0.5f);
+        batch.emplace_back(mIds[20], 0.f);
+        batch.emplace_back(mIds[30], expected[mIds[30]]);
+        scheduler.publish(batch, changed);
+        ensure_equals("unchanged priorities are not reported", changed.size(), 3U);
+        expected[mIds[3]] = 1000.f;
+        expected[mIds[10]] = 0.5f;
+        expected.erase(mIds[20]);
+
+        ensure_equals("stale request stopped waiting", scheduler.getWaitingCount(LLTextureFetchScheduler::STAGE_HTTP), 63);
+        ensure("stale request is not a waiter", !scheduler.isWaiting(mIds[20], LLTextureFetchScheduler::STAGE_HTTP));
+
+        std::vector<LLUUID> top;
+        scheduler.getTopWaiters(LLTextureFetchScheduler::STAGE_HTTP, 63, top);
+        ensure_equals("top waiters", top.size(), 63U);
+        ensure("raised request first", top.front() == mIds[3]);
+        ensure("lowered request last", top.back() == mIds[10]);
+        for (size_t i = 1; i < top.size(); ++i)
+        {
+            ensure("descending order", expected[top[i - 1]] >= expected[top[i]]);
+        }
+        ensure_equals("getTopWaiters leaves the heap alone", scheduler.getWaitingCount(LLTextureFetchScheduler::STAGE_HTTP), 63);
+
+        scheduler.cancelWait(mIds[3], LLTextureFetchScheduler::STAGE_HTTP);
+        top.clear();
+        scheduler.getTopWaiters(LLTextureFetchScheduler::STAGE_HTTP, 1, top);
+        ensure("cancelled waiter is gone", top.size() == 1 && top[0] != mIds[3]);
+    }
+
+    template<> template<>
+    void fetchscheduler_object::test<2>()
+    {
+        set_test_name("decode slots go to the most important waiter");
+
+        LLTextureFetchScheduler scheduler;
+        scheduler.setBudget(LLTextureFetchScheduler::STAGE_DECODE, 2);
+        scheduler.setBudget(LLTextureFetchScheduler::STAGE_UPLOAD, 8);
+        for (S32 i = 0; i < 4; ++i)
+        {
+            scheduler.addRequest(mIds[i], (F32)(i + 1));
+        }
+
+        ensure("first slot", scheduler.acquire(mIds[0], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("second slot", scheduler.acquire(mIds[1], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("holder asking again", scheduler.acquire(mIds[1], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("over budget", !scheduler.acquire(mIds[2], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("over budget, more important", !scheduler.acquire(mIds[3], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure_equals("waiting", scheduler.getWaitingCount(LLTextureFetchScheduler::STAGE_DECODE), 2);
+
+        scheduler.release(mIds[0], LLTextureFetchScheduler::STAGE_DECODE);
+        ensure("less important waiter can't jump the queue", !scheduler.acquire(mIds[2], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("most important waiter gets the slot", scheduler.acquire(mIds[3], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure_equals("active", scheduler.getActiveCount(LLTextureFetchScheduler::STAGE_DECODE), 2);
+
+        scheduler.removeRequest(mIds[1]);
+        ensure_equals("removal frees the slot", scheduler.getActiveCount(LLTextureFetchScheduler::STAGE_DECODE), 1);
+        ensure("remaining waiter", scheduler.acquire(mIds[2], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure_equals("nobody waiting", scheduler.getWaitingCount(LLTextureFetchScheduler::STAGE_DECODE), 0);
+    }
+
+    template<> template<>
+    void fetchscheduler_object::test<3>()
+    {
+        set_test_name("uncollected uploads hold back decodes");
+
+        LLTextureFetchScheduler scheduler;
+        scheduler.setBudget(LLTextureFetchScheduler::STAGE_DECODE, 4);
+        scheduler.setBudget(LLTextureFetchScheduler::STAGE_UPLOAD, 3);
+        for (S32 i = 0; i < 4; ++i)
+        {
+            scheduler.addRequest(mIds[i], 1.f);
+        }
+
+        scheduler.hold(mIds[0], LLTextureFetchScheduler::STAGE_UPLOAD);
+        scheduler.hold(mIds[1], LLTextureFetchScheduler::STAGE_UPLOAD);
+        ensure("room for one more", scheduler.acquire(mIds[2], LLTextureFetchScheduler::STAGE_DECODE));
+        ensure("uploads full", !scheduler.acquire(mIds[3], LLTextureFetchScheduler::STAGE_DECODE));
+
+        // The main thread collecting one makes room
+        scheduler.release(mIds[0], LLTextureFetchScheduler::STAGE_UPLOAD);
+        ensure("collected", scheduler.acquire(mIds[3], LLTextureFetchScheduler::STAGE_DECODE));
+        scheduler.release(mIds[3], LLTextureFetchScheduler::STAGE_DECODE);
+
+        // So does the texture going stale
+        scheduler.hold(mIds[3], LLTextureFetchScheduler::STAGE_UPLOAD);
+        LLTextureFetchScheduler::priority_batch_t batch, changed;
+        batch.emplace_back(mIds[1], 0.f);
+        scheduler.publish(batch, changed);
+        ensure_equals("stale upload released", scheduler.getActiveCount(LLTextureFetchScheduler::STAGE_UPLOAD), 1);
+
+        scheduler.release(mIds[1], LLTextureFetchScheduler::STAGE_UPLOAD);
+        ensure_equals("release is idempotent", scheduler.getActiveCount(LLTextureFetchScheduler::STAGE_UPLOAD), 1);
+    }
+}
@@ -0,0 +1,195 @@
+/**
+ * @file lltextureslabstore_test.cpp
+ * @brief Tests for the memory mapped texture body store
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltextureslabstore.h"
+
+#include "../test/lltut.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace tut
+{
+    struct slabstore_data
+    {
+        slabstore_data()
+        {
+            mDir = (boost::filesystem::temp_directory_path()
+                    / boost::filesystem::unique_path("slabstore-%%%%-%%%%")).string();
+        }
+
+        ~slabstore_data()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        std::vector<U8> makeBody(U8 fill, S32 size)
+        {
+            std::vector<U8> body(size);
+            for (S32 i = 0; i < size; ++i)
+            {
+                body[i] = (U8)(fill + i);
+            }
+            return body;
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<slabstore_data> slabstore_test;
+    typedef slabstore_test::object slabstore_object;
+    tut::slabstore_test slabstore_testcase("LLTextureSlabStore");
+
+    template<> template<>
+    void slabstore_object::test<1>()
+    {
+        set_test_name("put, get, replace and remove");
+
+        LLTextureSlabStore store(mDir, 4 * 65536, 65536);
+        ensure("fresh store reports no prior contents", !store.open());
+        ensure("open", store.isOpen());
+        ensure_equals("slab count", store.getSlabCount(), 4U);
+
+        LLUUID id;
+        id.generate();
+        std::vector<U8> body = makeBody(7, 1000);
+        ensure_equals("write", store.write(id, body.data(), (S32)body.size()), 1000);
+        ensure_equals("size", store.getSize(id), 1000);
+
+        std::vector<U8> out(1000);
+        ensure_equals("read", store.read(id, out.data(), 0, 1000), 1000);
+        ensure("contents", out == body);
+
+        ensure_equals("partial read clamps", store.read(id, out.data(), 900, 500), 100);
+        ensure_equals("partial contents", out[0], body[900]);
+
+        std::vector<U8> body2 = makeBody(40, 300);
+        store.write(id, body2.data(), (S32)body2.size());
+        ensure_equals("replaced size", store.getSize(id), 300);
+        ensure_equals("one record", store.getCount(), 1U);
+        ensure_equals("usage", store.getUsage(), 300);
+
+        ensure("remove", store.remove(id));
+        ensure_equals("removed size", store.getSize(id), 0);
+        ensure_equals("read missing", store.read(id, out.data(), 0, 10), -1);
+        ensure("remove again", !store.remove(id));
+    }
+
+    template<> template<>
+    void slabstore_object::test<2>()
+    {
+        set_test_name("recycling evicts the oldest slab");
+
+        LLTextureSlabStore store(mDir, 2 * 65536, 65536);
+        store.open();
+
+        // Three 30000 byte bodies fill the first slab with two and spill
+        // into the second; two more wrap around onto the first.
+        std::vector<LLUUID> ids(5);
+        std::vector<U8> body = makeBody(1, 30000);
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+            ensure_equals("write", store.write(id, body.data(), (S32)body.size()), 30000);
+        }
+
+        std::vector<LLUUID> evicted;
+        store.takeEvicted(evicted);
+        ensure_equals("evicted count", evicted.size(), 2U);
+        ensure("first evicted", std::find(evicted.begin(), evicted.end(), ids[0]) != evicted.end());
+        ensure("second evicted", std::find(evicted.begin(), evicted.end(), ids[1]) != evicted.end());
+        ensure_equals("evicted is gone", store.getSize(ids[0]), 0);
+        ensure_equals("newest kept", store.getSize(ids[4]), 30000);
+        ensure_equals("live records", store.getCount(), 3U);
+
+        store.takeEvicted(evicted);
+        ensure("evictions reported once", evicted.empty());
+    }
+
+    template<> template<>
+    void slabstore_object::test<3>()
+    {
+        set_test_name("reopen restores the index");
+
+        LLUUID kept, removed;
+        kept.generate();
+        removed.generate();
+        std::vector<U8> body = makeBody(3, 5000);
+        {
+            LLTextureSlabStore store(mDir, 4 * 65536, 65536);
+            store.open();
+            store.write(kept, body.data(), (S32)body.size());
+            store.write(removed, body.data(), (S32)body.size());
+            store.remove(removed);
+        }
+
+        {
+            LLTextureSlabStore store(mDir, 4 * 65536, 65536);
+            ensure("restored", store.open());
+            ensure_equals("kept size", store.getSize(kept), 5000);
+            ensure_equals("removed stays removed", store.getSize(removed), 0);
+            std::vector<U8> out(5000);
+            ensure_equals("read", store.read(kept, out.data(), 0, 5000), 5000);
+            ensure("contents", out == body);
+        }
+
+        {
+            // A different slab layout can't reuse the old records.
+            LLTextureSlabStore store(mDir, 8 * 65536, 65536);
+            ensure("layout change starts empty", !store.open());
+            ensure_equals("nothing kept", store.getCount(), 0U);
+        }
+    }
+
+    template<> template<>
+    void slabstore_object::test<4>()
+    {
+        set_test_name("closed store holds nothing");
+
+        LLUUID id;
+        id.generate();
+        std::vector<U8> body = makeBody(9, 2000);
+
+        LLTextureSlabStore store(mDir, 4 * 65536, 65536);
+        store.open();
+        store.write(id, body.data(), (S32)body.size());
+        store.close();
+
+        ensure("closed", !store.isOpen());
+        ensure_equals("no size", store.getSize(id), 0);
+        std::vector<U8> out(2000);
+        ensure_equals("no read", store.read(id, out.data(), 0, 2000), -1);
+        ensure("no remove", !store.remove(id));
+        ensure_equals("no records", store.getCount(), 0U);
+        ensure_equals("no usage", store.getUsage(), 0);
+        ensure_equals("no write", store.write(id, body.data(), (S32)body.size()), -1);
+
+        ensure("reopen restores", store.open());
+        ensure_equals("size after reopen", store.getSize(id), 2000);
+        ensure_equals("read after reopen", store.read(id, out.data(), 0, 2000), 2000);
+        ensure("contents", out == body);
+    }
+}
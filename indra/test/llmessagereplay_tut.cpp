@@ -0,0 +1,160 @@
+/**
+ * @file llmessagereplay_tut.cpp
+ * @brief LLMessageReplay test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "namedtempfile.h"
+
+#include "llapr.h"
+#include "llmessagecapture.h"
+#include "llmessagereplay.h"
+#include "llmessagetemplate.h"
+#include "lltemplatemessagebuilder.h"
+#include "message.h"
+#include "message_prehash.h"
+
+namespace
+{
+    std::vector<U32> sReceived;
+
+    void handle_test_message(LLMessageSystem* msg, void**)
+    {
+        U32 value = 0;
+        msg->getU32Fast(_PREHASH_Test0, _PREHASH_Test0, value);
+        sReceived.push_back(value);
+    }
+}
+
+namespace tut
+{
+    struct LLMessageReplayTestData
+    {
+        LLMessageTemplate* mTemplate;
+        LLHost mSim;
+
+        LLMessageReplayTestData()
+        :   mTemplate(NULL),
+            mSim(0x0100007f, 13000)
+        {
+            static bool init = false;
+            if (!init)
+            {
+                ll_init_apr();
+                init = true;
+            }
+
+            start_messaging_system("notafile", 13037,
+                                   1,
+                                   0,
+                                   0,
+                                   FALSE,
+                                   "notasharedsecret",
+                                   NULL,
+                                   false,
+                                   5.f,
+                                   100.f);
+
+            // The real template isn't needed, one high frequency message
+            // with a U32 in it is enough to go through checkMessages()
+            mTemplate = new LLMessageTemplate(_PREHASH_TestMessage, 1, MFT_HIGH);
+            LLMessageBlock* block = new LLMessageBlock(_PREHASH_Test0, MBT_SINGLE);
+            block->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+            mTemplate->addBlock(block);
+            gMessageSystem->mMessageTemplates[mTemplate->mName] = mTemplate;
+            gMessageSystem->mMessageNumbers[mTemplate->mMessageNumber] = mTemplate;
+            gMessageSystem->setHandlerFuncFast(_PREHASH_TestMessage, handle_test_message);
+
+            sReceived.clear();
+        }
+
+        ~LLMessageReplayTestData()
+        {
+            // not end_messaging_system(), and the system doesn't own templates
+            delete static_cast<LLMessageSystem*>(gMessageSystem);
+            gMessageSystem = NULL;
+            delete mTemplate;
+        }
+
+        LLMessageCaptureRecord makePacket(U32 packet_id, U32 value)
+        {
+            LLTemplateMessageBuilder builder(gMessageSystem->mMessageTemplates);
+            builder.newMessage(_PREHASH_TestMessage);
+            builder.nextBlock(_PREHASH_Test0);
+            builder.addU32(_PREHASH_Test0, value);
+
+            U8 buffer[64];
+            memset(buffer, 0, LL_PACKET_ID_SIZE);
+            const U32 size = builder.buildMessage(buffer, sizeof(buffer), 0);
+            const U32 net_id = htonl(packet_id);
+            memcpy(&buffer[PHL_PACKET_ID], &net_id, sizeof(net_id));
+
+            LLMessageCaptureRecord record;
+            record.mType = LLMessageCaptureRecord::TEMPLATE;
+            record.mInbound = true;
+            record.mFromHost = mSim;
+            record.mToHost = LLHost(0x0100007f, 13037);
+            record.mData.assign(buffer, buffer + size);
+            return record;
+        }
+    };
+
+    typedef test_group<LLMessageReplayTestData> LLMessageReplayTestGroup;
+    typedef LLMessageReplayTestGroup::object LLMessageReplayTestObject;
+    LLMessageReplayTestGroup messageReplayTestGroup("LLMessageReplay");
+
+    template<> template<>
+    void LLMessageReplayTestObject::test<1>()
+        // captured packets reach the registered handler
+    {
+        NamedTempFile file("msgcap", "");
+        {
+            LLMessageCapture capture;
+            ensure("open", capture.open(file.getName()));
+            capture.write(makePacket(1, 42));
+
+            LLMessageCaptureRecord outbound(makePacket(2, 7));
+            outbound.mInbound = false;
+            capture.write(outbound);
+
+            capture.write(makePacket(3, 43));
+        }
+
+        {
+            LLMessageReplay replay(gMessageSystem, LLMessageReplay::PACE_MAX_SPEED);
+            ensure("load", replay.load(file.getName()));
+            replay.run();
+            ensure("done", replay.isDone());
+
+            const LLSD stats = replay.getStats();
+            ensure_equals("packets injected", stats["packets"].asInteger(), 2);
+            ensure_equals("outbound skipped", stats["skipped"].asInteger(), 1);
+            ensure_equals("messages decoded", stats["messages"].asInteger(), 2);
+        }
+
+        ensure_equals("handler calls", sReceived.size(), 2U);
+        ensure_equals("first value", sReceived[0], 42U);
+        ensure_equals("second value", sReceived[1], 43U);
+        ensure("replay left the ring live", !gMessageSystem->mPacketRing.getReplayMode());
+    }
+}